@@ -0,0 +1,51 @@
+#    IdealIRC - Internet Relay Chat client
+#    Copyright (C) 2014  Tom-Andre Barstad
+#
+#    This program is free software; you can redistribute it and/or modify
+#    it under the terms of the GNU General Public License as published by
+#    the Free Software Foundation; either version 2 of the License, or
+#    (at your option) any later version.
+#
+#    This program is distributed in the hope that it will be useful,
+#    but WITHOUT ANY WARRANTY; without even the implied warranty of
+#    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#    GNU General Public License for more details.
+#
+#    You should have received a copy of the GNU General Public License along
+#    with this program; if not, write to the Free Software Foundation, Inc.,
+#    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+# Headless front end for the benchmark tools: the IRC core plus windows that throw their text away,
+# and the benchmark plumbing the client doesn't carry (ReplayServer and the allocation counter).
+# Included by the tool projects in bench/, each adding its own main.cpp.
+
+QT       = core gui network
+
+QMAKE_CXXFLAGS += -std=c++11
+
+CONFIG += console
+CONFIG -= app_bundle
+
+# The core's qDebug() calls (script commands, loading, ...) would be timed along with the work
+DEFINES += QT_NO_DEBUG_OUTPUT
+
+include(../core.pri)
+
+INCLUDEPATH += $$PWD
+
+SOURCES += \
+    $$PWD/headlesswindow.cpp \
+    $$PWD/headlessfrontend.cpp \
+    $$PWD/replayserver.cpp
+
+HEADERS += \
+    $$PWD/headlesswindow.h \
+    $$PWD/headlessfrontend.h \
+    $$PWD/replayserver.h
+
+# Peak RSS in ReplayServer
+win32: LIBS += -lpsapi
+
+# Count allocations in the replay and the script profiler: qmake CONFIG+=alloccount
+# Replaces the global operator new in the tools, see ReplayServer.
+alloccount: DEFINES += IIRC_COUNT_ALLOCS
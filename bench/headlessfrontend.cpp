@@ -0,0 +1,160 @@
+/*
+ *   IdealIRC - Internet Relay Chat client
+ *   Copyright (C) 2014  Tom-Andre Barstad
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "headlessfrontend.h"
+#include "replayserver.h"
+#include "iperf.h"
+
+/*!
+ * \param v Windows write their text to stdout
+ * \param parent Parent object
+ */
+HeadlessFrontEnd::HeadlessFrontEnd(bool v, QObject *parent) :
+    QObject(parent),
+    verbose(v),
+    ignores(&conf),
+    winreg(&winlist),
+    activeWid(-1),
+    activeConn(-1),
+    widCount(1),
+    scriptParent(this, this, &conf, &conlist, &winlist, &winreg, &activeWid, &activeConn)
+{
+    conf.rehash();
+    ignores.load();
+
+    IPerf::setAllocCounter(ReplayServer::allocations);
+
+    connect(&scriptParent, SIGNAL(RequestWindow(QString,int,int,bool)),
+            this, SLOT(createWindow(QString,int,int,bool)));
+}
+
+HeadlessFrontEnd::~HeadlessFrontEnd()
+{
+    QHashIterator<int,IConnection*> ic(conlist);
+    while (ic.hasNext())
+        delete ic.next().value();
+
+    QHashIterator<int,ICoreWindow*> iw(windows);
+    while (iw.hasNext())
+        delete iw.next().value();
+}
+
+/*!
+ * Creates a status window, and with it a new connection.
+ * \return The connection.
+ */
+IConnection* HeadlessFrontEnd::newConnection()
+{
+    int wid = createWindow("Status", WT_STATUS, 0);
+    return conlist.value(wid, NULL);
+}
+
+/*!
+ * \param cid Connection ID, the same as its status window ID
+ * \return A new connection.
+ */
+IConnection* HeadlessFrontEnd::newConnectionObject(int cid)
+{
+    return new IConnection(this, this, cid, &conf, &scriptParent);
+}
+
+/*!
+ * \param name Window name
+ * \param type Window type (see constants.h for WT_*)
+ * \param connection Connection the window belongs to, NULL for custom windows
+ * \return A new window, throwing its text away (or printing it, if verbose).
+ */
+ICoreWindow* HeadlessFrontEnd::newWindowObject(QString name, int type, IConnection *)
+{
+    return new HeadlessWindow(name, type, verbose);
+}
+
+/*!
+ * \param caption Dialog caption
+ * \param label Text above the input box
+ * \param ok Set to false, nobody can push OK
+ * \return Empty.
+ */
+QString HeadlessFrontEnd::getText(const QString &, const QString &, bool *ok)
+{
+    if (ok != NULL)
+        *ok = false;
+
+    return "";
+}
+
+/*!
+ * \param name Window name
+ * \param type Window type (see constants.h for WT_*)
+ * \param parent Parent ID (connection ID, WP_CUSTOM for custom windows)
+ * \param activate Unused, there's no window switching
+ *
+ * Mirrors IdealIRC::CreateSubWindow(), with windows from newWindowObject().
+ * \return -1 if failed, otherwise Window ID
+ */
+int HeadlessFrontEnd::createWindow(QString name, int type, int parent, bool)
+{
+    if ((type >= WT_DCCSEND) && (type <= WT_DCCCHAT))
+        return -1;
+
+    if ((type != WT_STATUS) && winreg.exists(parent, name))
+        return -1;
+
+    int wid = widCount++;
+
+    IConnection *connection = conlist.value(parent, NULL);
+    if (type == WT_STATUS) {
+        connection = newConnectionObject(wid);
+        connection->setActiveInfo(&activeWname, &activeConn);
+        connection->setIgnoreList(&ignores);
+    }
+
+    ICoreWindow *w = newWindowObject(name, type, connection);
+    windows.insert(wid, w);
+
+    subwindow_t wt = SW_EMPTY_SET;
+    wt.connection = connection;
+    wt.parent = parent;
+    wt.type = type;
+    wt.wid = wid;
+    wt.window = w;
+    wt.highlight = HL_NONE;
+
+    winlist.insert(wid, wt);
+    winreg.add(wt);
+
+    if (activeWid == -1) {
+        activeWid = wid;
+        activeWname = name;
+        activeConn = (connection != NULL) ? wid : -1;
+    }
+
+    if (type == WT_STATUS) {
+        conlist.insert(wid, connection);
+        connection->addWindow("STATUS", wt);
+        connect(connection, SIGNAL(RequestWindow(QString,int,int,bool)),
+                this, SLOT(createWindow(QString,int,int,bool)));
+    }
+
+    if (connection != NULL)
+        connection->addWindow(name, wt);
+
+    return wid;
+}
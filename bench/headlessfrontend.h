@@ -0,0 +1,91 @@
+/*
+ *   IdealIRC - Internet Relay Chat client
+ *   Copyright (C) 2014  Tom-Andre Barstad
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/*! \class HeadlessFrontEnd
+ *  \brief A front end without any GUI, for the benchmark tools.
+ *
+ * Owns what IdealIRC owns for the core (config, window list, connections and the script parent),
+ * creates HeadlessWindow for every window the core asks for, and answers every dialog with "nobody
+ * is there". DCC windows are not created.\n
+ * A tool may subclass it to create its own connection or window objects, see newConnectionObject()
+ * and newWindowObject().
+ */
+
+#ifndef HEADLESSFRONTEND_H
+#define HEADLESSFRONTEND_H
+
+#include <QObject>
+#include <QHash>
+
+#include "config.h"
+#include "constants.h"
+#include "icoreevents.h"
+#include "iconnection.h"
+#include "iwindowregistry.h"
+#include "ignorelist.h"
+#include "script/tscriptparent.h"
+#include "headlesswindow.h"
+
+class HeadlessFrontEnd : public QObject, public ICoreFrontEnd
+{
+  Q_OBJECT
+
+public:
+    explicit HeadlessFrontEnd(bool v, QObject *parent = 0);
+    ~HeadlessFrontEnd();
+    IConnection* newConnection();
+    TScriptParent* getScriptParent() { return &scriptParent; } //!< \return Pointer to the script parent.
+    config* getConfPtr() { return &conf; } //!< \return Pointer to the config class (iirc.ini)
+
+    // ICoreFrontEnd
+    void renameWindow(int, const QString &) {}
+    void showMotd(int, const QStringList &) {}
+    bool channelListVisible() { return false; } //!< \return false, there's no channel list dialog.
+    void channelListItem(const QString &, const QString &, const QString &) {}
+    void dccResume(const QString &, const QString &, quint16, qint64) {}
+    bool dccPassiveAnswer(const QString &, const QString &, const QString &, quint16) { return false; } //!< \return false, we never offer anything.
+    void showDccTransfers() {}
+    QString getOpenFileName(const QString &) { return ""; } //!< \return Empty, nobody to ask.
+    QString messageBox(const QString &, const QString &, const QString &, const QString &) { return ""; } //!< \return Empty, nobody to push a button.
+    QString getText(const QString &caption, const QString &label, bool *ok);
+    ICoreScriptDialog* createScriptDialog(TScript *, const QString &) { return NULL; } //!< \return NULL, dialogs are skipped.
+
+protected:
+    virtual IConnection* newConnectionObject(int cid);
+    virtual ICoreWindow* newWindowObject(QString name, int type, IConnection *connection);
+
+    bool verbose; //!< Windows write their text to stdout.
+    config conf; //!< Read from iirc.ini, like the client.
+    IgnoreList ignores; //!< Ignored users, like the client.
+    QHash<int,subwindow_t> winlist; //!< Key: Window ID\n Value: Subwindow.
+    IWindowRegistry winreg; //!< Name lookup of winlist.
+    QHash<int,IConnection*> conlist; //!< Key: Connection ID, the same as its status window ID\n Value: Connection.
+    QHash<int,ICoreWindow*> windows; //!< Key: Window ID\n Value: The window, owned by us.
+    int activeWid; //!< Active window ID. The first status window, since nothing switches windows.
+    QString activeWname; //!< Active window name.
+    int activeConn; //!< Active connection ID.
+    int widCount; //!< Window ID counter. Never decreases.
+    TScriptParent scriptParent; //!< Script parent, where scripts are loaded and events are pushed into.
+
+public slots:
+    int createWindow(QString name, int type, int parent, bool activate = false);
+};
+
+#endif // HEADLESSFRONTEND_H
@@ -0,0 +1,137 @@
+/*
+ *   IdealIRC - Internet Relay Chat client
+ *   Copyright (C) 2014  Tom-Andre Barstad
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <iostream>
+#include "headlesswindow.h"
+
+/*!
+ * \param wname Window name
+ * \param WindowType Window type, see WT_* in constants.h
+ * \param v Write text to stdout
+ */
+HeadlessWindow::HeadlessWindow(QString wname, int WindowType, bool v) :
+    name(wname),
+    target(wname),
+    type(WindowType),
+    verbose(v)
+{
+    if (type == WT_STATUS)
+        target = "status";
+}
+
+/*!
+ * \param sender Sender
+ * \param text Text
+ * \param ptype Print type, see PT_* in constants.h
+ * \param ts Timestamp, 0 for now
+ *
+ * Throws the text away, unless verbose.
+ */
+void HeadlessWindow::print(const QString &sender, const QString &text, const int, qint64)
+{
+    if (! verbose)
+        return;
+
+    std::cout << "[" << name.toStdString() << "] " << sender.toStdString() << " "
+              << text.toStdString() << std::endl;
+}
+
+/*!
+ * \param event ME_JOIN, ME_PART or ME_QUIT
+ * \param nickname Who it was
+ * \param text Text
+ * \param ptype Print type
+ * \param ts Timestamp, 0 for now
+ *
+ * Member events are printed like any other text, there's nothing to collapse them into.
+ */
+void HeadlessWindow::printMemberEvent(int, const QString &, const QString &text, const int ptype, qint64 ts)
+{
+    print("***", text, ptype, ts);
+}
+
+/*!
+ * \param batch Lines from chathistory or a bouncer playback
+ */
+void HeadlessWindow::printHistory(QVector<t_text> batch)
+{
+    QVectorIterator<t_text> i(batch);
+    while (i.hasNext()) {
+        t_text t = i.next();
+        print(t.sender, t.text, t.type, t.ts);
+    }
+}
+
+/*!
+ * \param nickname Nickname
+ * \param mt Member data
+ * \param sort Unused, the list isn't shown anywhere
+ */
+void HeadlessWindow::insertMember(QString nickname, member_t mt, bool)
+{
+    members.insert(nickname, mt);
+}
+
+/*!
+ * \param nickname Nickname
+ * \param sort Unused, the list isn't shown anywhere
+ */
+void HeadlessWindow::removeMember(QString nickname, bool)
+{
+    members.remove(nickname);
+}
+
+/*!
+ * \param nickname Who changes their nickname
+ * \param newnick The new nickname
+ */
+void HeadlessWindow::memberSetNick(QString nickname, QString newnick)
+{
+    member_t m = members.value(nickname);
+    m.nickname = newnick;
+    members.remove(nickname);
+    members.insert(newnick, m);
+}
+
+/*!
+ * \param nickname Nickname
+ * \param mode Mode letter, like @ or +
+ */
+void HeadlessWindow::MemberSetMode(QString nickname, char mode)
+{
+    if (! members.contains(nickname))
+        return;
+
+    member_t &m = members[nickname];
+    if (! m.mode.contains(mode))
+        m.mode << mode;
+}
+
+/*!
+ * \param nickname Nickname
+ * \param mode Mode letter, like @ or +
+ */
+void HeadlessWindow::MemberUnsetMode(QString nickname, char mode)
+{
+    if (! members.contains(nickname))
+        return;
+
+    members[nickname].mode.removeAll(mode);
+}
@@ -0,0 +1,77 @@
+/*
+ *   IdealIRC - Internet Relay Chat client
+ *   Copyright (C) 2014  Tom-Andre Barstad
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/*! \class HeadlessWindow
+ *  \brief A window without a widget, for the benchmark tools.
+ *
+ * Keeps what the core reads back from a window (members and topic) and throws the text away,
+ * so a benchmark measures the protocol and script handling rather than the text view.\n
+ * With verbose set, text is written to stdout instead.
+ */
+
+#ifndef HEADLESSWINDOW_H
+#define HEADLESSWINDOW_H
+
+#include <QHash>
+#include "icoreevents.h"
+
+class HeadlessWindow : public ICoreWindow
+{
+public:
+    HeadlessWindow(QString wname, int WindowType, bool v);
+    QString getName() { return name; } //!< \return Window name, as it was created with.
+    QString getTarget() { return target; } //!< \return Channel or nickname the window writes to.
+    int getType() { return type; } //!< \return Window type, see WT_* in constants.h
+    void print(const QString &sender, const QString &text, const int ptype = 0, qint64 ts = 0);
+    void printMemberEvent(int event, const QString &nickname, const QString &text, const int ptype, qint64 ts = 0);
+    void printHistory(QVector<t_text> batch);
+    qint64 getLastTimestamp() { return 0; } //!< \return Always 0, nothing is kept.
+    void markHighlight(int) {}
+    void clear() {}
+    void insertMember(QString nickname, member_t mt, bool sort = true);
+    void removeMember(QString nickname, bool sort = true);
+    bool memberExist(QString nickname) { return members.contains(nickname); } //!< \return true if nickname is in the member list.
+    void memberSetNick(QString nickname, QString newnick);
+    void sortMemberList(QString = "") {}
+    void resetMemberlist() { members.clear(); } //!< Empties the member list.
+    void MemberSetMode(QString nickname, char mode);
+    void MemberUnsetMode(QString nickname, char mode);
+    member_t ReadMember(QString nickname) { return members.value(nickname); } //!< \return Member data of nickname.
+    void setInputText(QString) {}
+    void setTopic(QString newTopic) { topic = newTopic; } //!< Stores the topic.
+    void execChanSettings() {}
+    ICoreChanSettings* chanSettings() { return NULL; } //!< \return NULL, there are no dialogs.
+    QStringList getSelectedMembers() { return QStringList(); } //!< \return Empty, nobody can select anything.
+    int getWidth() { return 0; }
+    int getHeight() { return 0; }
+    int listboxWidth() { return 0; }
+    int listboxHeight() { return 0; }
+    ICorePicture* picture() { return NULL; } //!< \return NULL, nothing to paint on.
+
+private:
+    QString name; //!< Window name.
+    QString target; //!< Channel or nickname, "status" for status windows.
+    int type; //!< Window type, see WT_* in constants.h
+    bool verbose; //!< Write text to stdout rather than throwing it away.
+    QHash<QString,member_t> members; //!< Key: Nickname\n Value: Member data.
+    QString topic; //!< Channel topic.
+};
+
+#endif // HEADLESSWINDOW_H
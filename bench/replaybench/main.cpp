@@ -0,0 +1,92 @@
+/*
+ *   IdealIRC - Internet Relay Chat client
+ *   Copyright (C) 2014  Tom-Andre Barstad
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/*
+ * replaybench [-v] [-widgets] transcript
+ *
+ * Replays a server transcript (see ReplayServer) through IConnection, with scripts from iirc.ini
+ * loaded, and prints how fast it was handled.
+ * By default the windows are headless and throw their text away, unless -v is given.
+ * With -widgets, the windows are real IWin with their text widgets, drawn on the offscreen platform,
+ * and the time to flush and paint the text is included.
+ */
+
+#include <QApplication>
+#include <QStringList>
+#include <QWidget>
+#include <iostream>
+
+#include "replayfrontend.h"
+#include "replayrunner.h"
+
+int main(int argc, char *argv[])
+{
+    bool widgets = false;
+    for (int i = 1; i < argc; ++i)
+        if (QString(argv[i]) == "-widgets")
+            widgets = true;
+
+    // config needs fonts, and the windows a screen, but there's nothing to show them on.
+    if (qgetenv("QT_QPA_PLATFORM").isEmpty())
+        qputenv("QT_QPA_PLATFORM", widgets ? "offscreen" : "minimal");
+
+    QApplication a(argc, argv);
+
+    QStringList args = a.arguments().mid(1);
+    args.removeAll("-widgets");
+    bool verbose = false;
+    if ((args.count() > 0) && (args[0] == "-v")) {
+        verbose = true;
+        args.removeFirst();
+    }
+
+    if (args.count() != 1) {
+        std::cerr << "Usage: replaybench [-v] [-widgets] transcript" << std::endl;
+        return 2;
+    }
+
+    // The windows' parent, declared first so it outlives them.
+    QWidget host;
+    if (widgets) {
+        host.resize(1024, 768);
+        host.show();
+    }
+
+    ReplayFrontEnd fe(verbose, widgets ? &host : NULL);
+    fe.getScriptParent()->loadAllScripts();
+    ReplayConnection *connection = qobject_cast<ReplayConnection*>(fe.newConnection());
+    ReplayRunner runner(connection, fe.getConfPtr(), widgets);
+
+    QString error;
+    if (! runner.start(args[0], &error)) {
+        std::cerr << "replaybench: " << error.toStdString() << std::endl;
+        return 1;
+    }
+
+    a.exec();
+
+    if (runner.getSummary().isEmpty()) {
+        std::cerr << "replaybench: Disconnected before the replay finished" << std::endl;
+        return 1;
+    }
+
+    std::cout << "[bench] " << runner.getSummary().toStdString() << std::endl;
+    return 0;
+}
@@ -0,0 +1,78 @@
+#    IdealIRC - Internet Relay Chat client
+#    Copyright (C) 2014  Tom-Andre Barstad
+#
+#    This program is free software; you can redistribute it and/or modify
+#    it under the terms of the GNU General Public License as published by
+#    the Free Software Foundation; either version 2 of the License, or
+#    (at your option) any later version.
+#
+#    This program is distributed in the hope that it will be useful,
+#    but WITHOUT ANY WARRANTY; without even the implied warranty of
+#    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#    GNU General Public License for more details.
+#
+#    You should have received a copy of the GNU General Public License along
+#    with this program; if not, write to the Free Software Foundation, Inc.,
+#    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+# Replays a server transcript through IConnection and prints how fast it was handled.
+# Usage: replaybench [-v] [-widgets] transcript
+# -widgets uses the client's real windows (IWin and IIRCView), so those are built in too.
+
+TARGET = replaybench
+TEMPLATE = app
+
+include(../headless.pri)
+
+QT += widgets
+
+ROOT = $$PWD/../..
+
+SOURCES += \
+    main.cpp \
+    replayconnection.cpp \
+    replayfrontend.cpp \
+    replayrunner.cpp \
+    $$ROOT/iwin.cpp \
+    $$ROOT/iircview.cpp \
+    $$ROOT/tpicturewindow.cpp \
+    $$ROOT/qmylineedit.cpp \
+    $$ROOT/qmylistwidget.cpp \
+    $$ROOT/ichanconfig.cpp \
+    $$ROOT/bantablemodel.cpp \
+    $$ROOT/unsupportedmodel.cpp \
+    $$ROOT/dcc/dcc.cpp \
+    $$ROOT/dcc/dccsend.cpp \
+    $$ROOT/dcc/dccrecv.cpp \
+    $$ROOT/dcc/dccchat.cpp \
+    $$ROOT/dcc/dcctransfer.cpp \
+    $$ROOT/dcc/dccmanager.cpp \
+    $$ROOT/dcc/dccmanagerdialog.cpp
+
+HEADERS += \
+    replayconnection.h \
+    replayfrontend.h \
+    replayrunner.h \
+    $$ROOT/iwin.h \
+    $$ROOT/iircview.h \
+    $$ROOT/tpicturewindow.h \
+    $$ROOT/qmylineedit.h \
+    $$ROOT/qmylistwidget.h \
+    $$ROOT/ichanconfig.h \
+    $$ROOT/bantablemodel.h \
+    $$ROOT/unsupportedmodel.h \
+    $$ROOT/dcc/dcc.h \
+    $$ROOT/dcc/dccsend.h \
+    $$ROOT/dcc/dccrecv.h \
+    $$ROOT/dcc/dccchat.h \
+    $$ROOT/dcc/dcc_protocols.h \
+    $$ROOT/dcc/dcctransfer.h \
+    $$ROOT/dcc/dccmanager.h \
+    $$ROOT/dcc/dccmanagerdialog.h
+
+FORMS += \
+    $$ROOT/iwin.ui \
+    $$ROOT/ichanconfig.ui
+
+RESOURCES += \
+    $$ROOT/resources.qrc
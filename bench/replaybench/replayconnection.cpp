@@ -0,0 +1,57 @@
+/*
+ *   IdealIRC - Internet Relay Chat client
+ *   Copyright (C) 2014  Tom-Andre Barstad
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <QElapsedTimer>
+#include "replayconnection.h"
+#include "iperf.h"
+
+/*!
+ * See IConnection::IConnection()
+ */
+ReplayConnection::ReplayConnection(QObject *parent, ICoreFrontEnd *fe, int connId, config *cfg, TScriptParent *sp) :
+    IConnection(parent, fe, connId, cfg, sp),
+    replay(NULL)
+{
+}
+
+/*!
+ * \param text Line from the server, decoded
+ *
+ * Times parse() and reports it to the ReplayServer. Unlike the client, the line isn't logged to stdout.\n
+ * The PING following the transcript isn't parsed, it emits replayEnded() instead.
+ */
+void ReplayConnection::lineReceived(QString &text)
+{
+    if (replay == NULL) {
+        IConnection::lineReceived(text);
+        return;
+    }
+
+    if (text == "PING :" REPLAY_END) {
+        emit replayEnded();
+        return;
+    }
+
+    QElapsedTimer t;
+    quint64 allocs = IPerf::allocations();
+    t.start();
+    parse( text );
+    replay->lineParsed(t.nsecsElapsed(), IPerf::allocations() - allocs);
+}
@@ -0,0 +1,51 @@
+/*
+ *   IdealIRC - Internet Relay Chat client
+ *   Copyright (C) 2014  Tom-Andre Barstad
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/*! \class ReplayConnection
+ *  \brief IConnection that times parse() for each line from a ReplayServer.
+ *
+ * Without a ReplayServer set, lines are handled like in the client.
+ */
+
+#ifndef REPLAYCONNECTION_H
+#define REPLAYCONNECTION_H
+
+#include "iconnection.h"
+#include "replayserver.h"
+
+class ReplayConnection : public IConnection
+{
+  Q_OBJECT
+
+public:
+    ReplayConnection(QObject *parent, ICoreFrontEnd *fe, int connId, config *cfg, TScriptParent *sp);
+    void setReplay(ReplayServer *r) { replay = r; } //!< Sets the server to report parse times to.
+
+protected:
+    void lineReceived(QString &text);
+
+private:
+    ReplayServer *replay; //!< Server we're replaying from, NULL if none.
+
+signals:
+    void replayEnded(); // Every line of the transcript is parsed.
+};
+
+#endif // REPLAYCONNECTION_H
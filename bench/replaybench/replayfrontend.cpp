@@ -0,0 +1,68 @@
+/*
+ *   IdealIRC - Internet Relay Chat client
+ *   Copyright (C) 2014  Tom-Andre Barstad
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "replayfrontend.h"
+#include "replayconnection.h"
+#include "iwin.h"
+
+/*!
+ * \param v Windows write their text to stdout, headless windows only
+ * \param h Parent of the IWin windows, NULL for headless windows
+ * \param parent Parent object
+ */
+ReplayFrontEnd::ReplayFrontEnd(bool v, QWidget *h, QObject *parent) :
+    HeadlessFrontEnd(v, parent),
+    host(h)
+{
+}
+
+/*!
+ * \param cid Connection ID, the same as its status window ID
+ * \return A new ReplayConnection.
+ */
+IConnection* ReplayFrontEnd::newConnectionObject(int cid)
+{
+    return new ReplayConnection(this, this, cid, &conf, &scriptParent);
+}
+
+/*!
+ * \param name Window name
+ * \param type Window type (see constants.h for WT_*)
+ * \param connection Connection the window belongs to, NULL for custom windows
+ *
+ * With a host widget, sets up an IWin the way IdealIRC::CreateSubWindow() does and puts it on top.
+ * \return The new window.
+ */
+ICoreWindow* ReplayFrontEnd::newWindowObject(QString name, int type, IConnection *connection)
+{
+    if (host == NULL)
+        return HeadlessFrontEnd::newWindowObject(name, type, connection);
+
+    IWin *s = new IWin(host, name, type, &conf, &scriptParent);
+    if (connection != NULL) {
+        s->setConnectionPtr(connection);
+        s->setSortRuleMap(connection->getSortRuleMapPtr());
+    }
+
+    s->show();
+    s->raise();
+
+    return s;
+}
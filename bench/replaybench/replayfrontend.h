@@ -0,0 +1,49 @@
+/*
+ *   IdealIRC - Internet Relay Chat client
+ *   Copyright (C) 2014  Tom-Andre Barstad
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/*! \class ReplayFrontEnd
+ *  \brief HeadlessFrontEnd with ReplayConnection, and optionally real IWin windows.
+ *
+ * Given a host widget, every window is a real IWin on it, as in the client. Only the window on top
+ * gets painted, like the active window in the client's MDI area.
+ */
+
+#ifndef REPLAYFRONTEND_H
+#define REPLAYFRONTEND_H
+
+#include <QWidget>
+#include "headlessfrontend.h"
+
+class ReplayFrontEnd : public HeadlessFrontEnd
+{
+  Q_OBJECT
+
+public:
+    ReplayFrontEnd(bool v, QWidget *h, QObject *parent = 0);
+
+protected:
+    IConnection* newConnectionObject(int cid);
+    ICoreWindow* newWindowObject(QString name, int type, IConnection *connection);
+
+private:
+    QWidget *host; //!< Parent of the IWin windows, NULL to use HeadlessWindow. Must outlive us.
+};
+
+#endif // REPLAYFRONTEND_H
@@ -0,0 +1,105 @@
+/*
+ *   IdealIRC - Internet Relay Chat client
+ *   Copyright (C) 2014  Tom-Andre Barstad
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <QCoreApplication>
+#include <QTimer>
+#include "replayrunner.h"
+#include "iperf.h"
+#include "iwin.h"
+
+/*!
+ * \param c Connection to replay on
+ * \param cfg Config the connection uses
+ * \param w The windows are real IWin
+ * \param parent Parent object
+ */
+ReplayRunner::ReplayRunner(ReplayConnection *c, config *cfg, bool w, QObject *parent) :
+    QObject(parent),
+    connection(c),
+    conf(cfg),
+    widgets(w)
+{
+    connect(connection, SIGNAL(replayEnded()),
+            this, SLOT(replayEnded()));
+
+    connect(connection, SIGNAL(connectionClosed()),
+            this, SLOT(connectionClosed()));
+}
+
+/*!
+ * \param filename Server transcript, see ReplayServer
+ * \param error Set to why the replay couldn't start
+ * \return false on error.
+ */
+bool ReplayRunner::start(QString filename, QString *error)
+{
+    if (! server.start(filename, error))
+        return false;
+
+    if (widgets)
+        IPerf::setEnabled(true); // For the paint timings.
+
+    connection->setReplay(&server);
+    conf->server = QString("127.0.0.1:%1").arg(server.getPort());
+    connection->tryConnect();
+    return true;
+}
+
+/*!
+ * Every line is parsed. With real windows, give them time to flush and paint first.
+ */
+void ReplayRunner::replayEnded()
+{
+    if (widgets)
+        QTimer::singleShot(IWIN_FLUSH_INTERVAL * 2, this, SLOT(drained()));
+    else
+        drained();
+}
+
+/*!
+ * Everything is handled, stops the clock and disconnects.
+ */
+void ReplayRunner::drained()
+{
+    QCoreApplication::sendPostedEvents(); // Paint events from the last flush.
+    server.finish();
+    summary = server.summary();
+
+    if (widgets) {
+        QString count, total;
+        IPerf::value("paint", "count", count);
+        IPerf::value("paint", "total", total);
+        summary += tr(", %1 paints in %2 ms (widgets)")
+                     .arg(count)
+                     .arg(total.toLongLong() / 1000);
+    }
+
+    connection->setReplay(NULL);
+    connection->closeConnection();
+    QCoreApplication::quit();
+}
+
+/*!
+ * The connection went away, whether the replay finished or not.
+ */
+void ReplayRunner::connectionClosed()
+{
+    QCoreApplication::quit();
+}
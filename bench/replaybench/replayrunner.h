@@ -0,0 +1,60 @@
+/*
+ *   IdealIRC - Internet Relay Chat client
+ *   Copyright (C) 2014  Tom-Andre Barstad
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/*! \class ReplayRunner
+ *  \brief Runs one replay on a connection and stops the event loop when it's done.
+ *
+ * Connects the usual way, with IConnection::tryConnect(), to a ReplayServer on 127.0.0.1.\n
+ * With real windows, the clock keeps running until the last lines are flushed into the text
+ * widgets and painted, so the result includes what it costs to get them on screen.
+ */
+
+#ifndef REPLAYRUNNER_H
+#define REPLAYRUNNER_H
+
+#include <QObject>
+#include <QString>
+#include "replayconnection.h"
+#include "replayserver.h"
+#include "config.h"
+
+class ReplayRunner : public QObject
+{
+  Q_OBJECT
+
+public:
+    ReplayRunner(ReplayConnection *c, config *cfg, bool w, QObject *parent = 0);
+    bool start(QString filename, QString *error);
+    QString getSummary() { return summary; } //!< \return Results of the replay, empty if it never finished.
+
+private:
+    ReplayConnection *connection; //!< Connection the transcript is replayed on.
+    config *conf; //!< Pointer to the config class (iirc.ini), where we point the connection to the replay server.
+    bool widgets; //!< The windows are real IWin, wait for them to flush and paint.
+    ReplayServer server; //!< Fake IRC server.
+    QString summary; //!< Results, set when the replay is finished.
+
+private slots:
+    void replayEnded();
+    void drained();
+    void connectionClosed();
+};
+
+#endif // REPLAYRUNNER_H
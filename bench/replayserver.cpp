@@ -0,0 +1,232 @@
+/*
+ *   IdealIRC - Internet Relay Chat client
+ *   Copyright (C) 2014  Tom-Andre Barstad
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+
+#include <QFile>
+#include <QHostAddress>
+#include <QAtomicInteger>
+#include <cstdlib>
+#include <new>
+#include <algorithm>
+
+#if defined(Q_OS_WIN)
+  #include <windows.h>
+  #include <psapi.h>
+#else
+  #include <sys/resource.h>
+#endif
+
+#include "replayserver.h"
+
+#ifdef IIRC_COUNT_ALLOCS
+static QAtomicInteger<quint64> allocTotal; //!< Allocations done through operator new since we started. Qt's worker threads allocate too, so it's atomic.
+
+void* operator new(std::size_t size)
+{
+    allocTotal.fetchAndAddRelaxed(1);
+    void *p = std::malloc(size > 0 ? size : 1);
+    if (p == NULL)
+        throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete[](void *p) noexcept
+{
+    operator delete(p);
+}
+#endif
+
+ReplayServer::ReplayServer(QObject *parent) :
+    QObject(parent),
+    client(NULL),
+    lineCount(0),
+    sent(false),
+    wallTime(0),
+    allocCount(0)
+{
+    connect(&server, SIGNAL(newConnection()),
+            this, SLOT(newConnection()));
+}
+
+/*!
+ * \param filename Transcript to replay
+ * \param error Set to why we couldn't start
+ *
+ * Loads the transcript and starts listening.
+ * \return false on error.
+ */
+bool ReplayServer::start(QString filename, QString *error)
+{
+    QFile f(filename);
+    if (! f.open(QIODevice::ReadOnly)) {
+        *error = f.errorString();
+        return false;
+    }
+
+    transcript.clear();
+    lineCount = 0;
+    while (! f.atEnd()) {
+        QByteArray line = f.readLine();
+        while (line.endsWith('\n') || line.endsWith('\r'))
+            line.chop(1);
+
+        if (line.startsWith("[in] "))
+            line = line.mid(5);
+        if (line.isEmpty() || line.startsWith('#') || line.startsWith("[out] "))
+            continue;
+
+        transcript.append(line).append("\r\n");
+        lineCount++;
+    }
+    transcript.append("PING :" REPLAY_END "\r\n");
+
+    if (lineCount == 0) {
+        *error = tr("The transcript has no lines");
+        return false;
+    }
+
+    if (! server.listen(QHostAddress::LocalHost, 0)) {
+        *error = server.errorString();
+        return false;
+    }
+
+    latency.reserve(lineCount);
+    return true;
+}
+
+/*!
+ * \param ns Nanoseconds the client spent on the line
+ * \param allocs Allocations the client did for the line
+ *
+ * Records one parsed line.
+ */
+void ReplayServer::lineParsed(qint64 ns, quint64 allocs)
+{
+    latency << ns;
+    allocCount += allocs;
+}
+
+/*!
+ * \return One line with the results so far.
+ */
+QString ReplayServer::summary()
+{
+    if (latency.isEmpty())
+        return tr("Replay: no lines parsed");
+
+    QVector<qint64> sorted = latency;
+    std::sort(sorted.begin(), sorted.end());
+    qint64 p50 = sorted.at(sorted.count() / 2);
+    qint64 p99 = sorted.at(qMin(sorted.count() - 1, (sorted.count() * 99) / 100));
+
+    double secs = wallTime / 1000000000.0;
+    double rate = (secs > 0) ? latency.count() / secs : 0;
+
+#ifdef IIRC_COUNT_ALLOCS
+    QString allocs = QString::number((double)allocCount / latency.count(), 'f', 1);
+#else
+    QString allocs = tr("n/a (build with CONFIG+=alloccount)");
+#endif
+
+    return tr("Replay: %1 lines in %2 ms, %3 lines/sec, p50 %4 us, p99 %5 us, allocations/line %6, peak RSS %7 KiB")
+             .arg(latency.count())
+             .arg(wallTime / 1000000)
+             .arg((qint64)rate)
+             .arg(p50 / 1000.0, 0, 'f', 1)
+             .arg(p99 / 1000.0, 0, 'f', 1)
+             .arg(allocs)
+             .arg(peakRss());
+}
+
+/*!
+ * \return Allocations done since we started, 0 unless built with IIRC_COUNT_ALLOCS.
+ */
+quint64 ReplayServer::allocations()
+{
+#ifdef IIRC_COUNT_ALLOCS
+    return allocTotal.load();
+#else
+    return 0;
+#endif
+}
+
+/*!
+ * \return Peak resident set size of this process in KiB, -1 if unknown.
+ */
+qint64 ReplayServer::peakRss()
+{
+#if defined(Q_OS_WIN)
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (! GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+        return -1;
+    return pmc.PeakWorkingSetSize / 1024;
+#else
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) != 0)
+        return -1;
+  #if defined(Q_OS_MAC)
+    return ru.ru_maxrss / 1024; // Bytes on OS X
+  #else
+    return ru.ru_maxrss;
+  #endif
+#endif
+}
+
+/*!
+ * The client connected. Only one client is served, others are turned away.
+ */
+void ReplayServer::newConnection()
+{
+    QTcpSocket *s = server.nextPendingConnection();
+    if (client != NULL) {
+        s->close();
+        s->deleteLater();
+        return;
+    }
+
+    client = s;
+    connect(client, SIGNAL(readyRead()),
+            this, SLOT(clientReadyRead()));
+}
+
+/*!
+ * The client sent us something. The first time, that's registration and we send the transcript.
+ */
+void ReplayServer::clientReadyRead()
+{
+    client->readAll(); // We don't care what the client says.
+
+    if (sent)
+        return;
+
+    sent = true;
+    clock.start();
+    client->write(transcript);
+}
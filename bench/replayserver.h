@@ -0,0 +1,77 @@
+/*
+ *   IdealIRC - Internet Relay Chat client
+ *   Copyright (C) 2014  Tom-Andre Barstad
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/*! \class ReplayServer
+ *  \brief Fake IRC server on the loopback interface, replaying a recorded transcript for benchmarking.
+ *
+ * The transcript is the "[in] " lines IConnection writes to stdout, or plain server lines.
+ * Lines starting with "[out] " or "#" and empty lines are skipped.\n
+ * When the client sends its first line (registration), the whole transcript is written to it,
+ * followed by "PING :" REPLAY_END so the client knows it has everything.\n
+ * The client reports the time it spent on each line with lineParsed() and calls finish() when it's done,
+ * and summary() gives lines/sec, per-line latency percentiles, allocations per line and peak RSS.\n
+ * Allocations are only counted when built with qmake CONFIG+=alloccount (IIRC_COUNT_ALLOCS), since that replaces
+ * the global operator new. This file is only built into the benchmark tools, never the client.
+ */
+
+#ifndef REPLAYSERVER_H
+#define REPLAYSERVER_H
+
+#include <QObject>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QByteArray>
+#include <QVector>
+#include <QElapsedTimer>
+
+#define REPLAY_END "iirc-replay-end" //!< Token of the PING following the transcript.
+
+class ReplayServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ReplayServer(QObject *parent = 0);
+    bool start(QString filename, QString *error);
+    quint16 getPort() { return server.serverPort(); } //!< \return Port we listen to on 127.0.0.1.
+    int getLineCount() { return lineCount; } //!< \return Lines in the transcript.
+    void lineParsed(qint64 ns, quint64 allocs);
+    void finish() { wallTime = clock.nsecsElapsed(); } //!< Stops the clock, the client has handled everything.
+    QString summary();
+    static quint64 allocations();
+    static qint64 peakRss();
+
+private:
+    QTcpServer server; //!< Listens on 127.0.0.1, random port.
+    QTcpSocket *client; //!< The connection we replay to.
+    QByteArray transcript; //!< All lines to send, CR+LF terminated.
+    int lineCount; //!< Lines in transcript.
+    bool sent; //!< transcript is written to client.
+    QElapsedTimer clock; //!< Started when we send the transcript.
+    qint64 wallTime; //!< Nanoseconds from sending until finish().
+    QVector<qint64> latency; //!< Nanoseconds the client spent on each line.
+    quint64 allocCount; //!< Allocations the client did while parsing.
+
+private slots:
+    void newConnection();
+    void clientReadyRead();
+};
+
+#endif // REPLAYSERVER_H
@@ -0,0 +1,62 @@
+/*
+ *   IdealIRC - Internet Relay Chat client
+ *   Copyright (C) 2014  Tom-Andre Barstad
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/*
+ * scriptbench script.iis [iterations]
+ *
+ * Runs every bench_ function of a script the given amount of times (default 1000), and prints
+ * the time per run. Each benchmsg_ function gives the text of a msg event, which is dispatched
+ * to the script's event handlers as many times. See script/bench/ for examples.
+ * The script runs against a TScriptParent on the headless front end, with one status window
+ * that never connects. Script errors are printed to stdout through that window.
+ */
+
+#include <QGuiApplication>
+#include <QStringList>
+#include <iostream>
+
+#include "headlessfrontend.h"
+
+int main(int argc, char *argv[])
+{
+    // config needs fonts, but there's nothing to show them on.
+    if (qgetenv("QT_QPA_PLATFORM").isEmpty())
+        qputenv("QT_QPA_PLATFORM", "minimal");
+
+    QGuiApplication a(argc, argv);
+
+    QStringList args = a.arguments().mid(1);
+    if ((args.count() < 1) || (args.count() > 2)) {
+        std::cerr << "Usage: scriptbench script.iis [iterations]" << std::endl;
+        return 2;
+    }
+
+    int iterations = 1000;
+    if (args.count() > 1)
+        iterations = qMax(1, args[1].toInt());
+
+    HeadlessFrontEnd fe(true);
+    fe.newConnection(); // Where echo and script errors go.
+
+    if (! fe.getScriptParent()->benchScript(args[0], iterations))
+        return 1;
+
+    return 0;
+}
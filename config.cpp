@@ -19,9 +19,10 @@
  */
 
 #include <QImage>
-#include <QApplication>
+#include <QCoreApplication>
 #include <QDesktopServices>
 #include <QDir>
+#include <QHashIterator>
 #include <iostream>
 
 #include "config.h"
@@ -29,6 +30,7 @@
 
 config::config(QObject *parent) :
     QObject(parent),
+    hlRevision(0),
     connectionActive(false)
 {
 
@@ -163,6 +165,11 @@ void config::rehash()
     else
         autoReJoin = stb(ini->ReadIni("Options", "AutoReJoin"));
 
+    if (ini->ReadIni("Options", "AutoReconnect").length() == 0)
+        autoReconnect = true;
+    else
+        autoReconnect = stb(ini->ReadIni("Options", "AutoReconnect"));
+
     if (ini->ReadIni("Options", "ShowTreeView").length() == 0)
         showTreeView = true;
     else
@@ -178,6 +185,59 @@ void config::rehash()
     else
         showMenubar = stb(ini->ReadIni("Options", "ShowMenubar"));
 
+    if (ini->ReadIni("Options", "IALWhoOnJoin").length() == 0)
+        ialWhoOnJoin = false;
+    else
+        ialWhoOnJoin = stb(ini->ReadIni("Options", "IALWhoOnJoin"));
+
+    if (ini->ReadIni("Options", "IALSnapshot").length() == 0)
+        ialSnapshot = true;
+    else
+        ialSnapshot = stb(ini->ReadIni("Options", "IALSnapshot"));
+
+    collapseMemberEvents = stb(ini->ReadIni("Options", "CollapseJoinPart"));
+
+    dccPath = ini->ReadIni("Options", "DCCPath");
+    if (dccPath.length() == 0)
+        dccPath = QString("%1/downloads").arg(CONF_PATH);
+    dccTurbo = stb(ini->ReadIni("Options", "DCCTurbo"));
+    dccAutoAccept = stb(ini->ReadIni("Options", "DCCAutoAccept"));
+
+    if (ini->ReadIni("Options", "DCCMaxTransfers").length() == 0)
+        dccMaxTransfers = 3; // Default value
+    else
+        dccMaxTransfers = ini->ReadIni("Options", "DCCMaxTransfers").toInt();
+    dccTransferLimit = ini->ReadIni("Options", "DCCTransferLimit").toInt();
+    dccGlobalLimit = ini->ReadIni("Options", "DCCGlobalLimit").toInt();
+    dccPortFirst = ini->ReadIni("Options", "DCCPortFirst").toInt();
+    dccPortLast = ini->ReadIni("Options", "DCCPortLast").toInt();
+    dccPassive = stb(ini->ReadIni("Options", "DCCPassive"));
+
+    hlWords = ini->ReadIni("Highlight", "Words").split(',', QString::SkipEmptyParts);
+
+    hlPatterns.clear();
+    int hlc = ini->CountItems("HighlightPatterns");
+    for (int i = 1; i <= hlc; ++i)
+        hlPatterns << ini->ReadIni("HighlightPatterns", i);
+
+    hlNicks.clear();
+    hlc = ini->CountItems("HighlightNicks");
+    for (int i = 1; i <= hlc; ++i)
+        hlNicks.insert( ini->ReadIniItem("HighlightNicks", i).toUpper(),
+                        ini->ReadIni("HighlightNicks", i).split(',', QString::SkipEmptyParts) );
+
+    ++hlRevision;
+
+    autoIgnoreLines = ini->ReadIni("Options", "AutoIgnoreLines").toInt(); // 0 (off) if empty
+
+    autoIgnoreSecs = ini->ReadIni("Options", "AutoIgnoreSecs").toInt();
+    if (autoIgnoreSecs <= 0)
+        autoIgnoreSecs = 5;
+
+    autoIgnoreTime = ini->ReadIni("Options", "AutoIgnoreTime").toInt();
+    if (autoIgnoreTime <= 0)
+        autoIgnoreTime = 300;
+
 
     trayNotify = stb(ini->ReadIni("Options", "TrayNotify"));
 
@@ -391,6 +451,106 @@ void config::rehash()
     if (listboxWidth > 200)
         listboxWidth = 200;
 
+    buildTheme();
+}
+
+/*!
+ * Parses the color options into the theme.\n
+ * Runs after rehash() and save(), widgets should then re-read what they need from it.
+ */
+void config::buildTheme()
+{
+    for (int i = 0; i < THEME_TEXTTYPES; ++i)
+        theme.text[i] = QColor(colDefault);
+
+    theme.text[PT_LOCALINFO] = QColor(colLocalInfo);
+    theme.text[PT_SERVINFO] = QColor(colServerInfo);
+    theme.text[PT_NOTICE] = QColor(colNotice);
+    theme.text[PT_ACTION] = QColor(colAction);
+    theme.text[PT_CTCP] = QColor(colCTCP);
+    theme.text[PT_OWNTEXT] = QColor(colOwntext);
+    theme.text[PT_HIGHLIGHT] = QColor(colHighlight);
+
+    for (int i = 0; i < THEME_TEXTTYPES; ++i)
+        theme.textPen[i] = QPen(theme.text[i]);
+
+    QColor mirc[THEME_MIRCCOLORS] = { C_WHITE, C_BLACK, C_BLUE, C_GREEN,
+                                      C_BRIGHTRED, C_RED, C_MAGENTA, C_BROWN,
+                                      C_YELLOW, C_BRIGHTGREEN, C_CYAN, C_BRIGHTCYAN,
+                                      C_BRIGHTBLUE, C_BRIGHTMAGENTA, C_DARKGRAY, C_LIGHTGRAY };
+
+    for (int i = 0; i < THEME_MIRCCOLORS; ++i) {
+        theme.mirc[i] = mirc[i];
+        theme.mircPen[i] = QPen(mirc[i]);
+    }
+
+    theme.background = QColor(colBackground);
+    theme.backgroundBrush = QBrush(theme.background);
+
+    // Bitwise XOR to invert colors.
+    theme.backgroundInverted = QColor(theme.background.red() ^ 255,
+                                      theme.background.green() ^ 255,
+                                      theme.background.blue() ^ 255);
+    theme.backgroundInvertedBrush = QBrush(theme.backgroundInverted);
+    theme.splitterPen = QPen(theme.backgroundInverted);
+
+    theme.linksPen = QPen(QColor(colLinks));
+    theme.ownTextBg = QColor(colOwntextBg);
+    theme.input = QColor(colInput);
+    theme.inputBackground = QColor(colInputBackground);
+    theme.listbox = QColor(colListbox);
+    theme.listboxBackground = QColor(colListboxBackground);
+    theme.windowlist = QColor(colWindowlist);
+    theme.windowlistBrush = QBrush(theme.windowlist);
+    theme.windowlistBackground = QColor(colWindowlistBackground);
+}
+
+/*!
+ * \param type Print type (see constants.h for PT_*)
+ * \return Text color of the print type. Unknown types gives the default color.
+ */
+const QColor& config::textColor(int type) const
+{
+    if ((type < 0) || (type >= THEME_TEXTTYPES))
+        type = PT_NORMAL;
+
+    return theme.text[type];
+}
+
+/*!
+ * \param type Print type (see constants.h for PT_*)
+ * \return Pen of the print type. Unknown types gives the default color.
+ */
+const QPen& config::textPen(int type) const
+{
+    if ((type < 0) || (type >= THEME_TEXTTYPES))
+        type = PT_NORMAL;
+
+    return theme.textPen[type];
+}
+
+/*!
+ * \param num mIRC color code
+ * \return The color. Codes out of range gives black.
+ */
+const QColor& config::mircColor(int num) const
+{
+    if ((num < 0) || (num >= THEME_MIRCCOLORS))
+        num = 1;
+
+    return theme.mirc[num];
+}
+
+/*!
+ * \param num mIRC color code
+ * \return Pen of the color. Codes out of range gives black.
+ */
+const QPen& config::mircPen(int num) const
+{
+    if ((num < 0) || (num >= THEME_MIRCCOLORS))
+        num = 1;
+
+    return theme.mircPen[num];
 }
 
 void config::save()
@@ -441,9 +601,42 @@ void config::save()
     ini->WriteIni("Options", "ShowMotd", QString::number(showMotd));
     ini->WriteIni("Options", "ShowToolBar", QString::number(showToolBar));
     ini->WriteIni("Options", "AutoReJoin", QString::number(autoReJoin));
+    ini->WriteIni("Options", "AutoReconnect", QString::number(autoReconnect));
     ini->WriteIni("Options", "ShowTreeView", QString::number(showTreeView));
     ini->WriteIni("Options", "ShowButtonbar", QString::number(showButtonbar));
     ini->WriteIni("Options", "ShowMenubar", QString::number(showMenubar));
+    ini->WriteIni("Options", "IALWhoOnJoin", QString::number(ialWhoOnJoin));
+    ini->WriteIni("Options", "IALSnapshot", QString::number(ialSnapshot));
+    ini->WriteIni("Options", "CollapseJoinPart", QString::number(collapseMemberEvents));
+    ini->WriteIni("Options", "DCCPath", dccPath);
+    ini->WriteIni("Options", "DCCTurbo", QString::number(dccTurbo));
+    ini->WriteIni("Options", "DCCAutoAccept", QString::number(dccAutoAccept));
+    ini->WriteIni("Options", "DCCMaxTransfers", QString::number(dccMaxTransfers));
+    ini->WriteIni("Options", "DCCTransferLimit", QString::number(dccTransferLimit));
+    ini->WriteIni("Options", "DCCGlobalLimit", QString::number(dccGlobalLimit));
+    ini->WriteIni("Options", "DCCPortFirst", QString::number(dccPortFirst));
+    ini->WriteIni("Options", "DCCPortLast", QString::number(dccPortLast));
+    ini->WriteIni("Options", "DCCPassive", QString::number(dccPassive));
+
+    ini->WriteIni("Options", "AutoIgnoreLines", QString::number(autoIgnoreLines));
+    ini->WriteIni("Options", "AutoIgnoreSecs", QString::number(autoIgnoreSecs));
+    ini->WriteIni("Options", "AutoIgnoreTime", QString::number(autoIgnoreTime));
+
+    ini->WriteIni("Highlight", "Words", hlWords.join(','));
+
+    ini->DelSection("HighlightPatterns");
+    for (int i = 0; i < hlPatterns.count(); ++i)
+        ini->WriteIni("HighlightPatterns", QString::number(i+1), hlPatterns[i]);
+
+    ini->DelSection("HighlightNicks");
+    QHashIterator<QString,QStringList> hln(hlNicks);
+    while (hln.hasNext()) {
+        hln.next();
+        ini->WriteIni("HighlightNicks", hln.key(), hln.value().join(','));
+    }
+
+    ++hlRevision;
+
     ini->WriteIni("Options", "Log", QString::number(logEnabled));
     ini->WriteIni("Options", "LogPath", logPath);
     ini->WriteIni("Options", "LogChan", QString::number(logChannel));
@@ -483,6 +676,8 @@ void config::save()
 
     ini->WriteIni("Editor", "FontName", editorFontName);
     ini->WriteIni("Editor", "FontSize", QString::number(editorFontSize));
+
+    buildTheme();
 }
 
 
@@ -38,8 +38,40 @@
 #include <QImage>
 #include <QRect>
 #include <QColor>
+#include <QPen>
+#include <QBrush>
+#include <QStringList>
+#include <QHash>
 #include "inifile.h"
 
+#define THEME_TEXTTYPES 9 //!< Amount of print types, PT_* in constants.h
+#define THEME_MIRCCOLORS 16 //!< Amount of mIRC control code colors
+
+/*!
+ * The color options parsed into paint objects.\n
+ * Rebuilt by config::buildTheme() when the config is loaded or saved, so widgets don't parse color strings while painting.
+ */
+typedef struct T_THEME {
+    QColor text[THEME_TEXTTYPES]; //!< Text color for each print type (PT_*)
+    QPen textPen[THEME_TEXTTYPES]; //!< Pens of the text colors
+    QColor mirc[THEME_MIRCCOLORS]; //!< mIRC control code colors, 0-15
+    QPen mircPen[THEME_MIRCCOLORS]; //!< Pens of the mIRC colors
+    QColor background;
+    QBrush backgroundBrush;
+    QColor backgroundInverted; //!< Background color XOR'ed, for the splitter and text selection.
+    QBrush backgroundInvertedBrush;
+    QPen splitterPen;
+    QPen linksPen;
+    QColor ownTextBg;
+    QColor input;
+    QColor inputBackground;
+    QColor listbox;
+    QColor listboxBackground;
+    QColor windowlist;
+    QBrush windowlistBrush;
+    QColor windowlistBackground;
+} theme_t;
+
 /*! \enum BgImageScale
  *
  * Defines how to scale background images within IdealIRC.
@@ -62,6 +94,12 @@ public:
     ~config();
     void rehash(); //!< Re-read iirc.ini and store the contents in the class. Shouldn't be run other times than when starting IdealIRC.
     void save(); //!< Saves the class data to iirc.ini.
+    void buildTheme();
+    const QColor& textColor(int type) const; // see constants.h for PT_*
+    const QPen& textPen(int type) const;
+    const QColor& mircColor(int num) const;
+    const QPen& mircPen(int num) const;
+    theme_t theme; //!< The colors, parsed. See buildTheme()
     IniFile *ini;
     QRect mainWinGeo;
     bool maximized;
@@ -98,9 +136,35 @@ public:
     bool showMotd;
     bool showToolBar;
     bool autoReJoin;
+    bool autoReconnect; //!< Reconnect by itself when the connection drops.
     bool showTreeView;
     bool showButtonbar;
     bool showMenubar;
+    bool ialWhoOnJoin; //!< Fill IAL with a WHO (WHOX if supported) when joining a channel.
+    bool ialSnapshot; //!< Save IAL hostnames on disconnect and load them on connect.
+    bool collapseMemberEvents; //!< Show joins, parts and quits following each other on one line per window.
+
+    // DCC
+    QString dccPath; //!< Folder received files are saved to.
+    bool dccTurbo; //!< Send files without waiting for acknowledgements.
+    bool dccAutoAccept; //!< Accept DCC offers without /dcc get or /dcc chat.
+    int dccMaxTransfers; //!< File transfers running at once, the rest are queued. 0 for no limit.
+    int dccTransferLimit; //!< KB/s per file transfer. 0 for no limit.
+    int dccGlobalLimit; //!< KB/s for all file transfers together. 0 for no limit.
+    int dccPortFirst; //!< First port to listen on for DCC. 0 lets the system pick.
+    int dccPortLast; //!< Last port to listen on for DCC.
+    bool dccPassive; //!< Make passive offers, the other end listens. For when we can't take incoming connections.
+
+    // Highlight
+    QStringList hlWords; //!< Words that highlight a message, besides our nickname.
+    QStringList hlPatterns; //!< Regular expressions that highlight a message.
+    QHash<QString,QStringList> hlNicks; //!< Other nicknames to highlight on per network.\n Key: Network name in upper case\n Value: Nicknames.
+    // Flood protection
+    int autoIgnoreLines; //!< Ignore a host temporarily when it sends more than this many messages within autoIgnoreSecs. 0 disables.
+    int autoIgnoreSecs;
+    int autoIgnoreTime; //!< Seconds a flood ignore lasts.
+
+    int hlRevision; //!< Counts up every time the highlight options are read or saved, so connections know to rebuild their HighlightEngine.
 
     // Background image
     bool bgImageEnabled;
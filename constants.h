@@ -36,6 +36,7 @@
  * Constants prepended with...\n
  * C_: Colors defined as QColor.\n
  * WT_: Window type defined as integer.\n
+ * WP_: Window parent ID defined as integer.\n
  * PT_: Print type defined as integer\n
  * HL_: Highlight type (window switcher (button bar and tree view) colors, essentially) defined as integer\n
  * CTRL_: Control codes defined as char, the actual char for, for example, bold or underline.\n
@@ -88,23 +89,23 @@
 
 
 #ifdef STANDALONE
-  #include <QApplication>
-  #define CONF_PATH QApplication::applicationDirPath()
+  #include <QCoreApplication>
+  #define CONF_PATH QCoreApplication::applicationDirPath()
 #endif
 
 #ifdef PACKAGED
   #include <QStandardPaths>
   #ifdef Q_OS_WIN32
-    #include <QApplication>
+    #include <QCoreApplication>
     #define CONF_PATH QStandardPaths::writableLocation(QStandardPaths::ConfigLocation)
-    #define COMMON_PATH QApplication::applicationDirPath()
+    #define COMMON_PATH QCoreApplication::applicationDirPath()
   #else
     #define CONF_PATH QString("%1/.idealirc").arg(QStandardPaths::writableLocation(QStandardPaths::HomeLocation))
     // Compilations meant to be stored in .deb .rpm or similar, should use the line below
     //#define COMMON_PATH "/usr/share/idealirc"
 
     // Pre-compiled "packaged" linux version is as of now, distributed in a tar.gz file to extract wherever the user wants.
-    #define COMMON_PATH QApplication::applicationDirPath()
+    #define COMMON_PATH QCoreApplication::applicationDirPath()
   #endif
   #define SKEL_PATH QString("%1/skel").arg(COMMON_PATH)
 #endif
@@ -115,6 +116,7 @@
 
 #define CONF_FILE QString("%1/iirc.ini").arg(CONF_PATH)
 #define SERV_FILE QString("%1/servers.ini").arg(CONF_PATH)
+#define PIN_FILE QString("%1/pins.ini").arg(CONF_PATH)
 
 
 /* Colors */
@@ -148,6 +150,8 @@
 #define WT_GRAPHIC  9  //!< Scriptable/Custom window. Graphic window
 #define WT_GWINPUT  10 //!< Scriptable/Custom window. Graphic window with input box
 
+#define WP_CUSTOM -1 //!< Parent ID of Scriptable/Custom windows.
+
 /* Print type */
 #define PT_NORMAL     0  //!< Normal text
 #define PT_LOCALINFO  1  //!< Information text from IIRC
@@ -222,7 +226,9 @@ enum e_iircevent {
     te_input,
     te_numeric,
     te_activate = 30,
-    te_deactivate
+    te_deactivate,
+    te_sockwritable,
+    te_highlight
 };
 
 /*! \enum e_scriptresult Results TScript::runf() can give. */
@@ -259,6 +265,7 @@ enum e_scriptresult {
 };
 
 class IWin;
+class ICoreWindow;
 class QMdiSubWindow;
 class QTreeWidgetItem;
 class IConnection;
@@ -268,6 +275,7 @@ class IConnection;
  */
 typedef struct SUBWINDOW_T {
   IWin *widget; //!< The widget that goes onto QMdiSubWindow
+  ICoreWindow *window; //!< The same widget, as the IRC core sees it. Core classes use this one, never widget.
   IConnection *connection; //!< IRC connection this window handles on. Customn windows set this to NULL.
   QMdiSubWindow *subwin; //!< The dialog
   QTreeWidgetItem *treeitem; //!< Tree widget item
@@ -277,7 +285,7 @@ typedef struct SUBWINDOW_T {
   int highlight; //!< Highlight type. See constants.h for HL_*
 } subwindow_t;
 
-#define SW_EMPTY_SET {nullptr, nullptr, nullptr, nullptr, -1, -1, WT_NOTHING, 0};
+#define SW_EMPTY_SET {nullptr, nullptr, nullptr, nullptr, nullptr, -1, -1, WT_NOTHING, 0};
 /* Construct an empty/"invalid" subwindow_t with this.
    for example:
      ...
@@ -0,0 +1,92 @@
+#    IdealIRC - Internet Relay Chat client
+#    Copyright (C) 2014  Tom-Andre Barstad
+#
+#    This program is free software; you can redistribute it and/or modify
+#    it under the terms of the GNU General Public License as published by
+#    the Free Software Foundation; either version 2 of the License, or
+#    (at your option) any later version.
+#
+#    This program is distributed in the hope that it will be useful,
+#    but WITHOUT ANY WARRANTY; without even the implied warranty of
+#    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#    GNU General Public License for more details.
+#
+#    You should have received a copy of the GNU General Public License along
+#    with this program; if not, write to the Free Software Foundation, Inc.,
+#    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+# The IRC core: connections, commands and the script engine. Everything here must build
+# without QtWidgets (QtGui is needed for the colors and fonts in config, and for painting
+# in script windows). Windows, dialogs and menus are reached through the interfaces in
+# icoreevents.h. Used by idealirc.pro, core.pro and the benchmark tools.
+
+INCLUDEPATH += $$PWD
+
+SOURCES += \
+    $$PWD/config.cpp \
+    $$PWD/inifile.cpp \
+    $$PWD/wildcardmatcher.cpp \
+    $$PWD/ial.cpp \
+    $$PWD/isupport.cpp \
+    $$PWD/ignorelist.cpp \
+    $$PWD/highlightengine.cpp \
+    $$PWD/ctcpresponder.cpp \
+    $$PWD/servermgr.cpp \
+    $$PWD/hostconnector.cpp \
+    $$PWD/icap.cpp \
+    $$PWD/itls.cpp \
+    $$PWD/iperf.cpp \
+    $$PWD/dcc/dccdetails.cpp \
+    $$PWD/iconnection.cpp \
+    $$PWD/icommand.cpp \
+    $$PWD/iwindowregistry.cpp \
+    $$PWD/script/tsockfactory.cpp \
+    $$PWD/script/tsock.cpp \
+    $$PWD/script/tscriptparent.cpp \
+    $$PWD/script/tscriptprofiler.cpp \
+    $$PWD/script/tscriptinternalfunctions.cpp \
+    $$PWD/script/tscript.cpp \
+    $$PWD/script/ttimer.cpp \
+    $$PWD/script/tscriptcommand.cpp \
+    $$PWD/script/tscript/commands.cpp \
+    $$PWD/script/tscript/containers.cpp \
+    $$PWD/script/tscript/dialogs.cpp \
+    $$PWD/script/tscript/events.cpp \
+    $$PWD/script/tscript/extracters.cpp \
+    $$PWD/script/tscript/loadscript.cpp \
+    $$PWD/script/tscript/menu.cpp \
+    $$PWD/script/tscript/runf.cpp \
+    $$PWD/script/tscript/solvers.cpp \
+    $$PWD/script/tscript/utils.cpp \
+    $$PWD/script/tscriptinternalfunctions/n.cpp
+
+HEADERS += \
+    $$PWD/constants.h \
+    $$PWD/numerics.h \
+    $$PWD/config.h \
+    $$PWD/inifile.h \
+    $$PWD/wildcardmatcher.h \
+    $$PWD/icoreevents.h \
+    $$PWD/ial.h \
+    $$PWD/isupport.h \
+    $$PWD/ignorelist.h \
+    $$PWD/highlightengine.h \
+    $$PWD/ctcpresponder.h \
+    $$PWD/servermgr.h \
+    $$PWD/hostconnector.h \
+    $$PWD/icap.h \
+    $$PWD/itls.h \
+    $$PWD/iperf.h \
+    $$PWD/dcc/dccdetails.h \
+    $$PWD/iconnection.h \
+    $$PWD/icommand.h \
+    $$PWD/iwindowregistry.h \
+    $$PWD/script/tsock.h \
+    $$PWD/script/tscriptparent.h \
+    $$PWD/script/tscriptprofiler.h \
+    $$PWD/script/tscriptinternalfunctions.h \
+    $$PWD/script/tscript.h \
+    $$PWD/script/tsockfactory.h \
+    $$PWD/script/ttimer.h \
+    $$PWD/script/exprtk/exprtk.hpp \
+    $$PWD/script/tscriptcommand.h
@@ -0,0 +1,159 @@
+/*
+ *   IdealIRC - Internet Relay Chat client
+ *   Copyright (C) 2014  Tom-Andre Barstad
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+
+#include <QDateTime>
+#include <QHashIterator>
+#include <QMutableHashIterator>
+#include <QStringList>
+
+#include "ctcpresponder.h"
+
+CtcpResponder::CtcpResponder(QObject *parent) :
+    QObject(parent),
+    received(0),
+    replied(0),
+    dropped(0),
+    coalesced(0),
+    pendingDropped(0)
+{
+    global.tokens = CTCP_GLOBAL_BURST;
+    global.last = QDateTime::currentMSecsSinceEpoch();
+
+    summaryTimer.setInterval(CTCP_SUMMARY_INTERVAL);
+    connect(&summaryTimer, SIGNAL(timeout()),
+            this, SLOT(summaryTimeout()));
+}
+
+/*!
+ * \param bucket Bucket to refill
+ * \param rate Tokens per second
+ * \param burst Max tokens
+ * \param now Milliseconds since epoch
+ *
+ * Adds the tokens earned since last time.
+ * \return true if there's at least one token in the bucket.
+ */
+bool CtcpResponder::refill(ctcpbucket_t &bucket, double rate, int burst, qint64 now)
+{
+    bucket.tokens += (now - bucket.last) * rate / 1000.0;
+    if (bucket.tokens > burst)
+        bucket.tokens = burst;
+    bucket.last = now;
+
+    return bucket.tokens >= 1.0;
+}
+
+/*!
+ * \param source Hostname of who sent the request
+ * \param ctcp CTCP type, e.g. VERSION
+ * \param show Set to true if the request should get its own status line
+ *
+ * Counts a CTCP request.
+ * \return true if we may reply.
+ */
+bool CtcpResponder::request(const QString &source, const QString &ctcp, bool *show)
+{
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    ++received;
+
+    if (! sources.contains(source)) {
+        if (sources.count() >= CTCP_SOURCE_MAX) {
+            // Hosts with a full bucket are the same as new ones, drop them.
+            QMutableHashIterator<QString,ctcpbucket_t> i(sources);
+            while (i.hasNext()) {
+                i.next();
+                refill(i.value(), CTCP_SOURCE_RATE, CTCP_SOURCE_BURST, now);
+                if (i.value().tokens >= CTCP_SOURCE_BURST)
+                    i.remove();
+            }
+
+            // Still full, many hosts are at it. The global bucket keeps us safe anyway.
+            if (sources.count() >= CTCP_SOURCE_MAX)
+                sources.clear();
+        }
+
+        ctcpbucket_t b;
+        b.tokens = CTCP_SOURCE_BURST;
+        b.last = now;
+        sources.insert(source, b);
+    }
+
+    ctcpbucket_t &src = sources[source];
+    bool allow = refill(src, CTCP_SOURCE_RATE, CTCP_SOURCE_BURST, now)
+              && refill(global, CTCP_GLOBAL_RATE, CTCP_GLOBAL_BURST, now);
+
+    if (allow) {
+        src.tokens -= 1.0;
+        global.tokens -= 1.0;
+        ++replied;
+    }
+    else
+        ++dropped;
+
+    if (! summaryTimer.isActive()) {
+        // First one in a while, show it.
+        *show = true;
+        summaryTimer.start();
+        return allow;
+    }
+
+    *show = false;
+    ++coalesced;
+    ++pending[ctcp];
+    pendingSources << source;
+    if (! allow)
+        ++pendingDropped;
+
+    return allow;
+}
+
+/*!
+ * Shows the summary of coalesced requests, if any. If there were none, we're done coalescing.
+ */
+void CtcpResponder::summaryTimeout()
+{
+    if (pending.isEmpty()) {
+        summaryTimer.stop();
+        return;
+    }
+
+    int count = 0;
+    QStringList types;
+    QHashIterator<QString,int> i(pending);
+    while (i.hasNext()) {
+        i.next();
+        count += i.value();
+        types << QString("%1 x%2").arg(i.key()).arg(i.value());
+    }
+
+    emit summary( tr("[CTCP] %1 more requests (%2) from %3 hosts, %4 not replied. Total: %5 received, %6 dropped.")
+                    .arg(count)
+                    .arg(types.join(", "))
+                    .arg(pendingSources.count())
+                    .arg(pendingDropped)
+                    .arg(received)
+                    .arg(dropped)
+                 );
+
+    pending.clear();
+    pendingSources.clear();
+    pendingDropped = 0;
+}
@@ -0,0 +1,88 @@
+/*
+ *   IdealIRC - Internet Relay Chat client
+ *   Copyright (C) 2014  Tom-Andre Barstad
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/*! \class CtcpResponder
+ *  \brief Rate limits CTCP replies and the status lines about CTCP requests.
+ *
+ * Replies are limited by two token buckets, one for everyone and one per source host, so a
+ * CTCP flood (even from many hosts) can't make us flood ourselves off the server.\n
+ * The first request in a while is shown as usual. Requests following it within
+ * CTCP_SUMMARY_INTERVAL are counted and shown as one summary line instead.
+ */
+
+#ifndef CTCPRESPONDER_H
+#define CTCPRESPONDER_H
+
+#include <QObject>
+#include <QString>
+#include <QHash>
+#include <QSet>
+#include <QTimer>
+
+#define CTCP_GLOBAL_BURST     5    //!< Replies we can send in a burst.
+#define CTCP_GLOBAL_RATE      1.0  //!< Replies per second we can send in the long run.
+#define CTCP_SOURCE_BURST     2    //!< Replies one host can get in a burst.
+#define CTCP_SOURCE_RATE      0.1  //!< Replies per second one host can get in the long run.
+#define CTCP_SOURCE_MAX       256  //!< Prune idle hosts when there's more than this.
+#define CTCP_SUMMARY_INTERVAL 3000 //!< Milliseconds to coalesce requests into one status line.
+
+/*!
+ * A token bucket.
+ */
+typedef struct T_CTCPBUCKET {
+    double tokens; //!< Replies available.
+    qint64 last; //!< Milliseconds since epoch tokens was last refilled.
+} ctcpbucket_t;
+
+class CtcpResponder : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit CtcpResponder(QObject *parent = 0);
+    bool request(const QString &source, const QString &ctcp, bool *show);
+    int getReceived() { return received; } //!< \return Amount of CTCP requests received.
+    int getReplied() { return replied; } //!< \return Amount of CTCP requests we were allowed to reply.
+    int getDropped() { return dropped; } //!< \return Amount of CTCP requests we didn't reply because of the rate limit.
+    int getCoalesced() { return coalesced; } //!< \return Amount of CTCP requests shown in a summary instead of their own status line.
+
+private:
+    ctcpbucket_t global; //!< Bucket for all replies.
+    QHash<QString,ctcpbucket_t> sources; //!< Bucket per host.\n Key: Hostname
+    int received;
+    int replied;
+    int dropped;
+    int coalesced;
+
+    QTimer summaryTimer; //!< Runs while we're coalescing requests.
+    QHash<QString,int> pending; //!< Requests since last status line.\n Key: CTCP type\n Value: Count
+    QSet<QString> pendingSources; //!< Hosts of requests since last status line.
+    int pendingDropped; //!< Requests since last status line that we didn't reply.
+
+    static bool refill(ctcpbucket_t &bucket, double rate, int burst, qint64 now);
+
+private slots:
+    void summaryTimeout();
+
+signals:
+    void summary(QString text); //!< A status line summarizing coalesced requests.
+};
+
+#endif // CTCPRESPONDER_H
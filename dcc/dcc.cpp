@@ -1,16 +1,86 @@
 #include "dcc.h"
+#include "dccmanager.h"
+#include "dccdetails.h"
 
 #include "iwin.h"
+#include "iconnection.h"
 
 DCC::DCC(IWin *sWin, QString dcc_details, QObject *parent) :
     QObject(parent),
     subwin(sWin),
     details(dcc_details),
-    tstar("***")
+    tstar("***"),
+    connection(sWin->getConnection()),
+    manager(sWin->getDccManager())
 {
 }
 
+DCC::~DCC()
+{
+    if ((manager != NULL) && (! token.isEmpty()))
+        manager->delPassive(token);
+}
+
+/*!
+ * \param ipv4 Their address
+ * \param port Their port
+ *
+ * The other end answered our passive offer. Deriving classes that make passive offers connect here.
+ */
+void DCC::connectTo(const QString &ipv4, quint16 port)
+{
+    Q_UNUSED(ipv4)
+    Q_UNUSED(port)
+}
+
+/*!
+ * \param server Server to listen with
+ *
+ * Listens on a free port within the configured DCC port range.
+ * \return true if listening.
+ */
+bool DCC::listen(QTcpServer *server)
+{
+    if (manager != NULL)
+        return manager->listen(server);
+
+    return server->listen(QHostAddress::AnyIPv4, 0);
+}
+
+/*!
+ * Registers us for an answer to a passive offer.
+ * \return Token to put in the offer.
+ */
+QString DCC::offerPassive()
+{
+    if (manager == NULL)
+        return QString();
+
+    token = manager->addPassive(this);
+    return token;
+}
+
 void DCC::print(QString sender, QString text, int type)
 {
     subwin->print(sender, text, type);
 }
+
+/*!
+ * \param details DCC details
+ *
+ * See DCCDetails::split()
+ */
+QStringList DCC::splitDetails(const QString &details)
+{
+    return DCCDetails::split(details);
+}
+
+/*!
+ * \param bytes Byte count
+ *
+ * See DCCDetails::formatSize()
+ */
+QString DCC::formatSize(qint64 bytes)
+{
+    return DCCDetails::formatSize(bytes);
+}
@@ -22,15 +22,32 @@
  *  \brief Parent class for all DCC.
  *
  * Creating new DCC protocols, this class must be inherited.\n
- * Note that DCC isn't implemented yet, so the structure of how it works, and all can change.
+ * The details string is the CTCP message without "DCC", prepended by our nickname and the target's nickname.\n
+ * Example: "me target SEND file.txt 3232235943 1024 163"\n
+ * Offers we make ourselves use the types CHATHOST and SENDHOST.\n\n
+ *
+ * Passive (reverse) DCC: an offer with port 0 and a token asks the other end to listen instead.\n
+ * They answer with the same offer, their address, port and our token, and we connect.\n
+ * DCCManager maps tokens to the DCC waiting for an answer, which gets it through connectTo().
  */
 
 #ifndef DCC_H
 #define DCC_H
 
 #include <QObject>
+#include <QStringList>
+#include <QTcpServer>
 #include "constants.h"
 
+#define DCC_CHUNK_SIZE        65536   //!< Bytes a file transfer writes to the socket at a time.
+#define DCC_SEND_WINDOW       4194304 //!< Bytes a file transfer sends ahead of the last acknowledgement.
+#define DCC_SOCKET_BUFFER     1048576 //!< Kernel socket buffer size requested for file transfers.
+#define DCC_RECV_BUFFER       524288  //!< Bytes a file receive collects before writing to disk.
+#define DCC_PROGRESS_INTERVAL 500     //!< Milliseconds between progress updates.
+
+class IConnection;
+class DCCManager;
+
 enum DCCType {
     DCC_UNKNOWN = 0,
     DCC_SEND,
@@ -43,8 +60,11 @@ class DCC : public QObject
     Q_OBJECT
 public:
     explicit DCC(IWin *sWin, QString dcc_details, QObject *parent = 0);
+    ~DCC();
 
     void print(QString sender, QString text, int type = PT_NORMAL);
+    static QStringList splitDetails(const QString &details);
+    static QString formatSize(qint64 bytes);
 
     DCCType get_type() { return type; }
     DCCType type;
@@ -53,9 +73,23 @@ public:
     QString details; // the dcc message in dcc-ctcp
 
     virtual void initialize() = 0; // Implement this in deriving classes.
+    virtual void connectTo(const QString &ipv4, quint16 port); // Answer to our passive offer.
+
+    QString getTarget() { return target; } //!< \return Nickname on the other end.
+    void detachManager() { manager = NULL; } //!< DCCManager is going away before us.
 
 protected:
     QString tstar;
+    IConnection *connection; //!< The IRC connection the DCC was negotiated on.
+    DCCManager *manager; //!< Port range, passive tokens and, for file transfers, queue and bandwidth.
+    QString target; //!< Nickname on the other end.
+    QString token; //!< Token of our passive offer, empty if none.
+
+    bool listen(QTcpServer *server);
+    QString offerPassive();
+
+signals:
+    void progress(qint64 done, qint64 size, qint64 bps); //!< Emitted by file transfers every DCC_PROGRESS_INTERVAL.
 };
 
 #endif // DCC_H
@@ -5,7 +5,8 @@
 
 DCCChat::DCCChat(DCCType t, IWin *parentWin, QString dcc_details) :
     DCC(parentWin, dcc_details),
-    socket(NULL)
+    socket(NULL),
+    codec(NULL)
 {
     type = t;
 }
@@ -18,91 +19,201 @@ DCCChat::~DCCChat()
 
 void DCCChat::initialize()
 {
-    QStringList dsplit = details.split(' ');
+    QStringList dsplit = splitDetails(details);
 
     me = dsplit[0];
     target = dsplit[1];
 
+    codec = QTextCodec::codecForName(subwin->getConfig()->charset.toStdString().c_str());
+    if (codec == NULL)
+        codec = QTextCodec::codecForName("UTF-8");
+
     if (dsplit[2] == "CHAT") {
-        unsigned int intipv4 = dsplit[4].toUInt();
-        QString ipv4 = subwin->getConnection()->intipv4toStr(intipv4);
-        print( tstar, tr("Trying to connect to %1 (%2:%3)...")
-                        .arg(target)
-                        .arg(ipv4)
-                        .arg(dsplit[5]),
-                PT_LOCALINFO
-              );
-
-        socket = new QTcpSocket();
-
-        connect(socket, SIGNAL(connected()),
-                this, SLOT(sockConnected()));
-        socket->connectToHost(ipv4, dsplit[5].toInt());
+        // me target CHAT chat ip port [token]
+        quint16 port = dsplit.value(5).toUShort();
+        QString token = dsplit.value(6);
+
+        if ((port == 0) && (! token.isEmpty())) {
+            // Passive offer, we listen.
+            quint32 address = connection->getLocalIPv4();
+            if ((address == 0) || (! listen(&server))) {
+                print(tstar, tr("Unable to listen for DCC connections."), PT_LOCALINFO);
+                return;
+            }
+
+            connect(&server, SIGNAL(newConnection()),
+                    this, SLOT(newConnection()));
+
+            connection->sockwrite( QString("PRIVMSG %1 :%2DCC CHAT chat %3 %4 %5%2")
+                                     .arg(target)
+                                     .arg(QChar(0x01))
+                                     .arg(address)
+                                     .arg(server.serverPort())
+                                     .arg(token)
+                                  );
+
+            print(tstar, tr("Waiting for %1 to connect...").arg(target), PT_LOCALINFO);
+            return;
+        }
+
+        connectTo(connection->intipv4toStr(dsplit[4].toUInt()), port);
     }
 
-    if (details.split(' ')[2] == "CHATHOST") {
+    if (dsplit[2] == "CHATHOST") {
         // Not an actual DCC type, but used to make this class listen
         // for DCC incoming connection (we request chatting)
+        quint32 address = connection->getLocalIPv4();
+        QString passive;
+        quint16 port = 0;
+
+        if (subwin->getConfig()->dccPassive)
+            passive = " " + offerPassive();
+        else {
+            if ((address == 0) || (! listen(&server))) {
+                print(tstar, tr("Unable to listen for DCC connections."), PT_LOCALINFO);
+                return;
+            }
+
+            port = server.serverPort();
+            connect(&server, SIGNAL(newConnection()),
+                    this, SLOT(newConnection()));
+        }
+
+        connection->sockwrite( QString("PRIVMSG %1 :%2DCC CHAT chat %3 %4%5%2")
+                                 .arg(target)
+                                 .arg(QChar(0x01))
+                                 .arg(address)
+                                 .arg(port)
+                                 .arg(passive)
+                              );
 
-        connect(&server, SIGNAL(newConnection()),
-                this, SLOT(newConnection()));
-        server.listen(QHostAddress::Any, 4455);
         print(tstar, tr("Waiting for connection..."), PT_LOCALINFO);
     }
 
 }
 
+/*!
+ * \param ipv4 Their address
+ * \param port Their port
+ *
+ * Connects to the other end. Used when accepting, and when they answer our passive offer.
+ */
+void DCCChat::connectTo(const QString &ipv4, quint16 port)
+{
+    if (socket != NULL)
+        return;
+
+    print( tstar, tr("Trying to connect to %1 (%2:%3)...")
+                    .arg(target)
+                    .arg(ipv4)
+                    .arg(port),
+            PT_LOCALINFO
+          );
+
+    socket = new QTcpSocket();
+
+    connect(socket, SIGNAL(connected()),
+            this, SLOT(sockConnected()));
+    connect(socket, SIGNAL(error(QAbstractSocket::SocketError)),
+            this, SLOT(sockError(QAbstractSocket::SocketError)));
+    socket->connectToHost(ipv4, port);
+}
+
 void DCCChat::inputEnterPushed(QString line)
 {
-    if (! socket->isOpen())
+    if ((socket == NULL) || (! socket->isOpen()))
         return;
 
     print(me, line);
 
-    QByteArray data;
-    data.append(line);
+    QByteArray data = codec->fromUnicode(line);
     data.append("\r\n");
     socket->write(data);
 }
 
-void DCCChat::sockConnected()
+/*!
+ * Listens to the connected socket.
+ */
+void DCCChat::attach()
 {
-    print(tstar, tr("Connected."), PT_LOCALINFO);
-
+    connect(socket, SIGNAL(disconnected()),
+            this, SLOT(sockDisconnected()));
     connect(socket, SIGNAL(readyRead()),
             this, SLOT(sockRead()));
 }
 
+void DCCChat::sockConnected()
+{
+    print(tstar, tr("Connected."), PT_LOCALINFO);
+    attach();
+}
+
 void DCCChat::sockDisconnected()
 {
+    if (inbuf.length() > 0) {
+        showLines(inbuf);
+        inbuf.clear();
+    }
+
     print(tstar, tr("Disconnected from DCC."), PT_LOCALINFO);
 }
 
+void DCCChat::sockError(QAbstractSocket::SocketError)
+{
+    if (socket->state() != QAbstractSocket::ConnectedState)
+        print(tstar, tr("DCC error: %1").arg(socket->errorString()), PT_LOCALINFO);
+}
+
+/*!
+ * Shows all whole lines that arrived, keeps the rest for next time.
+ */
 void DCCChat::sockRead()
 {
-    QByteArray buf = socket->readAll();
-    QString line;
-    for (int i = 0; i <= buf.length()-1; ++i) {
-        if (buf[i] == '\r')
-            continue;
-        if (buf[i] == '\n') {
-            print(target, line);
-            line.clear();
-            emit Highlight();
-            continue;
+    inbuf.append(socket->readAll());
+
+    int last = inbuf.lastIndexOf('\n');
+    if (last == -1) {
+        if (inbuf.length() > DCC_CHAT_MAXLINE) {
+            showLines(inbuf);
+            inbuf.clear();
         }
-        line += buf[i];
+        return;
+    }
+
+    showLines(inbuf.left(last));
+    inbuf.remove(0, last+1);
+}
+
+/*!
+ * \param data One or more lines, without the last newline
+ *
+ * Decodes and prints lines.
+ */
+void DCCChat::showLines(const QByteArray &data)
+{
+    QStringList lines = codec->toUnicode(data).split('\n');
+    for (int i = 0; i < lines.count(); ++i) {
+        QString line = lines[i];
+        if (line.endsWith('\r'))
+            line.chop(1);
+        print(target, line);
     }
+
+    emit Highlight();
 }
 
 void DCCChat::newConnection()
 {
-    if (socket != NULL)
+    QTcpSocket *s = server.nextPendingConnection();
+    if (socket != NULL) {
+        s->abort();
         return;
+    }
 
-    socket = server.nextPendingConnection();
-    connect(socket, SIGNAL(disconnected()),
-            this, SLOT(sockDisconnected()));
-    connect(socket, SIGNAL(readyRead()),
-            this, SLOT(sockRead()));
+    socket = s;
+    socket->setParent(0); // deleteLater() in destructor takes care of it.
+    server.close();
+
+    print(tstar, tr("Connected."), PT_LOCALINFO);
+    attach();
 }
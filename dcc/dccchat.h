@@ -20,6 +20,12 @@
 
 /*! \class DCCChat
  *  \brief DCC Chat
+ *
+ * Details type CHAT accepts an offer, CHATHOST makes one.\n
+ * Offers listen on a port from DCCManager's range, or with the DCCPassive option,
+ * are passive and the other end listens.\n
+ * Incoming data is split on newlines and each batch of whole lines is decoded at once
+ * with the charset option, same as the IRC connection.
  */
 
 #ifndef DCCCHAT_H
@@ -28,9 +34,12 @@
 #include <QObject>
 #include <QTcpServer>
 #include <QTcpSocket>
+#include <QTextCodec>
 
 #include "dcc.h"
 
+#define DCC_CHAT_MAXLINE 16384 //!< Longest line we buffer without a newline before showing it anyway.
+
 class IWin;
 
 class DCCChat : public DCC
@@ -40,20 +49,25 @@ public:
     explicit DCCChat(DCCType t, IWin *parentWin, QString dcc_details);
     ~DCCChat();
     void inputEnterPushed(QString line);
+    void connectTo(const QString &ipv4, quint16 port);
 
 private:
     QTcpSocket *socket;
     QTcpServer server;
+    QTextCodec *codec; //!< Encodes and decodes the chat, from the charset option.
+    QByteArray inbuf; //!< Received data after the last newline.
 
     // nicknames
-    QString target;
     QString me;
 
     void initialize();
+    void attach();
+    void showLines(const QByteArray &data);
 
 private slots:
     void sockConnected();
     void sockDisconnected();
+    void sockError(QAbstractSocket::SocketError);
     void sockRead();
 
     void newConnection();
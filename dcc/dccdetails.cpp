@@ -0,0 +1,73 @@
+/*
+ *   IdealIRC - Internet Relay Chat client
+ *   Copyright (C) 2015  Tom-Andre Barstad
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "dccdetails.h"
+
+/*!
+ * \param details DCC details
+ *
+ * Splits the details by spaces, but keeps file names within "quotes" as one item.
+ * \return List of items, with quotes removed
+ */
+QStringList DCCDetails::split(const QString &details)
+{
+    QStringList list;
+    QString item;
+    bool quoted = false;
+    bool started = false;
+
+    for (int i = 0; i < details.length(); ++i) {
+        QChar c = details[i];
+        if (c == '"') {
+            quoted = !quoted;
+            started = true;
+            continue;
+        }
+        if ((c == ' ') && (! quoted)) {
+            if (started)
+                list << item;
+            item.clear();
+            started = false;
+            continue;
+        }
+        item += c;
+        started = true;
+    }
+    if (started)
+        list << item;
+
+    return list;
+}
+
+/*!
+ * \param bytes Byte count
+ *
+ * \return Human readable size, like "1.5 MB"
+ */
+QString DCCDetails::formatSize(qint64 bytes)
+{
+    if (bytes < 1024)
+        return QString("%1 B").arg(bytes);
+    if (bytes < 1048576)
+        return QString("%1 KB").arg(bytes / 1024.0, 0, 'f', 1);
+    if (bytes < 1073741824)
+        return QString("%1 MB").arg(bytes / 1048576.0, 0, 'f', 1);
+    return QString("%1 GB").arg(bytes / 1073741824.0, 0, 'f', 2);
+}
@@ -0,0 +1,207 @@
+#include "dccmanager.h"
+#include "dcctransfer.h"
+#include "dccmanagerdialog.h"
+
+/*!
+ * \param cfg Pointer to config class (iirc.ini)
+ * \param parent Parent object
+ */
+DCCManager::DCCManager(config *cfg, QObject *parent) :
+    QObject(parent),
+    conf(cfg),
+    globalBudget(-1),
+    dialog(NULL),
+    nextPort(0),
+    tokenCount(0)
+{
+    ticker.setInterval(DCC_TICK_INTERVAL);
+    connect(&ticker, SIGNAL(timeout()),
+            this, SLOT(refill()));
+}
+
+DCCManager::~DCCManager()
+{
+    // Windows are deleted after us when IdealIRC closes.
+    QListIterator<DCCTransfer*> i(transfers);
+    while (i.hasNext())
+        i.next()->detachManager();
+
+    QHashIterator<QString,DCC*> p(passive);
+    while (p.hasNext())
+        p.next().value()->detachManager();
+
+    if (dialog != NULL)
+        delete dialog;
+}
+
+/*!
+ * \param t Transfer
+ *
+ * Registers a new transfer. Done by DCCTransfer itself.
+ */
+void DCCManager::add(DCCTransfer *t)
+{
+    transfers << t;
+    ticker.start();
+}
+
+/*!
+ * \param t Transfer
+ *
+ * Forgets a transfer, its window is closing.
+ */
+void DCCManager::remove(DCCTransfer *t)
+{
+    transfers.removeAll(t);
+    queue.removeAll(t);
+    if (running.removeAll(t) > 0)
+        startQueued();
+
+    if (transfers.isEmpty())
+        ticker.stop();
+}
+
+/*!
+ * \param t Transfer
+ *
+ * Asks for a slot. If there's none free, the transfer is queued and its start() runs later.
+ * \return true if the transfer may start now.
+ */
+bool DCCManager::request(DCCTransfer *t)
+{
+    if (running.contains(t))
+        return true;
+
+    int max = conf->dccMaxTransfers;
+    if ((max > 0) && (running.count() >= max)) {
+        if (! queue.contains(t))
+            queue << t;
+        return false;
+    }
+
+    running << t;
+    return true;
+}
+
+/*!
+ * \param t Transfer
+ *
+ * The transfer is over, gives its slot to the next in queue.
+ */
+void DCCManager::release(DCCTransfer *t)
+{
+    queue.removeAll(t);
+    if (running.removeAll(t) > 0)
+        startQueued();
+}
+
+void DCCManager::startQueued()
+{
+    int max = conf->dccMaxTransfers;
+    while ((! queue.isEmpty()) && ((max <= 0) || (running.count() < max))) {
+        DCCTransfer *t = queue.takeFirst();
+        running << t;
+        t->start();
+    }
+}
+
+/*!
+ * \param wanted Bytes a transfer would like to move
+ *
+ * Takes from the global bandwidth limit.
+ * \return Bytes it may move now.
+ */
+qint64 DCCManager::take(qint64 wanted)
+{
+    if (globalBudget < 0)
+        return wanted;
+
+    wanted = qMin(wanted, globalBudget);
+    globalBudget -= wanted;
+    return wanted;
+}
+
+/*!
+ * \param type DCC_SEND or DCC_RECV
+ * \param nickname Nickname on the other end
+ * \param port Port of the offer
+ *
+ * Finds the transfer a DCC RESUME or DCC ACCEPT is about.
+ * \return Transfer, NULL if not found.
+ */
+DCCTransfer* DCCManager::find(DCCType type, const QString &nickname, quint16 port)
+{
+    QListIterator<DCCTransfer*> i(transfers);
+    while (i.hasNext()) {
+        DCCTransfer *t = i.next();
+        if ((t->get_type() == type) && (t->getPort() == port) && (! t->isFinished())
+                && (t->getTarget().toUpper() == nickname.toUpper()))
+            return t;
+    }
+
+    return NULL;
+}
+
+/*!
+ * Shows the transfer manager window.
+ */
+void DCCManager::showDialog()
+{
+    if (dialog == NULL)
+        dialog = new DCCManagerDialog(this);
+
+    dialog->show();
+    dialog->raise();
+    dialog->activateWindow();
+}
+
+/*!
+ * \param server Server to listen with
+ *
+ * Listens on the next free port in the DCCPortFirst - DCCPortLast range.\n
+ * Without a range, the system picks a port.
+ * \return true if listening.
+ */
+bool DCCManager::listen(QTcpServer *server)
+{
+    int first = conf->dccPortFirst;
+    int last = conf->dccPortLast;
+    if ((first <= 0) || (last < first) || (last > 65535))
+        return server->listen(QHostAddress::AnyIPv4, 0);
+
+    int count = last - first + 1;
+    for (int i = 0; i < count; ++i) {
+        int n = (nextPort + i) % count;
+        if (server->listen(QHostAddress::AnyIPv4, first + n)) {
+            nextPort = (n + 1) % count;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*!
+ * \param dcc DCC making a passive offer
+ *
+ * \return Token for the offer. Answers with this token go to dcc->connectTo().
+ */
+QString DCCManager::addPassive(DCC *dcc)
+{
+    QString token = QString::number(++tokenCount);
+    passive.insert(token, dcc);
+    return token;
+}
+
+/*!
+ * Refills the global limit, then lets every transfer refill its own and continue.
+ */
+void DCCManager::refill()
+{
+    if (conf->dccGlobalLimit > 0)
+        globalBudget = (qint64)conf->dccGlobalLimit * 1024 * DCC_TICK_INTERVAL / 1000;
+    else
+        globalBudget = -1;
+
+    emit tick();
+}
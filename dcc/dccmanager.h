@@ -0,0 +1,93 @@
+/*
+ *   IdealIRC - Internet Relay Chat client
+ *   Copyright (C) 2015  Tom-Andre Barstad
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/*! \class DCCManager
+ *  \brief Queue and bandwidth limits for DCC file transfers.
+ *
+ * One instance is shared by all connections.\n
+ * At most DCCMaxTransfers transfers run at once, the rest wait in a queue.\n
+ * Bandwidth limits (DCCTransferLimit per transfer, DCCGlobalLimit for all, both in KB/s)
+ * are handed out every DCC_TICK_INTERVAL.\n\n
+ *
+ * It also hands out listening ports from the DCCPortFirst - DCCPortLast range, taking turns so
+ * many chats and transfers can wait for connections at once, and tokens for passive DCC.
+ */
+
+#ifndef DCCMANAGER_H
+#define DCCMANAGER_H
+
+#include <QObject>
+#include <QList>
+#include <QHash>
+#include <QTimer>
+#include <QTcpServer>
+#include "dcc.h"
+#include "config.h"
+
+#define DCC_TICK_INTERVAL 100 //!< Milliseconds between bandwidth refills.
+
+class DCCTransfer;
+class DCCManagerDialog;
+
+class DCCManager : public QObject
+{
+  Q_OBJECT
+public:
+    explicit DCCManager(config *cfg, QObject *parent = 0);
+    ~DCCManager();
+
+    void add(DCCTransfer *t);
+    void remove(DCCTransfer *t);
+    bool request(DCCTransfer *t);
+    void release(DCCTransfer *t);
+    qint64 take(qint64 wanted);
+    DCCTransfer* find(DCCType type, const QString &nickname, quint16 port);
+    QList<DCCTransfer*> getTransfers() { return transfers; } //!< \return All transfers with an open window.
+    int queuePosition(DCCTransfer *t) { return queue.indexOf(t); } //!< \return Place in queue, -1 if not queued.
+    int getRunning() { return running.count(); } //!< \return Amount of transfers going on.
+    void showDialog();
+
+    bool listen(QTcpServer *server);
+    QString addPassive(DCC *dcc);
+    void delPassive(const QString &token) { passive.remove(token); } //!< Stops waiting for an answer to a passive offer.
+    DCC* findPassive(const QString &token) { return passive.value(token, NULL); } //!< \return DCC waiting for an answer with this token, NULL if none.
+
+private:
+    config *conf;
+    QList<DCCTransfer*> transfers; //!< All transfers with an open window.
+    QList<DCCTransfer*> queue; //!< Transfers waiting for a free slot.
+    QList<DCCTransfer*> running; //!< Transfers holding a slot.
+    QTimer ticker;
+    qint64 globalBudget; //!< Bytes all transfers may move until next tick, -1 for no limit.
+    DCCManagerDialog *dialog;
+    QHash<QString,DCC*> passive; //!< Passive offers waiting for an answer.\n Key: token\n Value: DCC that made the offer.
+    int nextPort; //!< Where in the port range to try next.
+    int tokenCount; //!< Last passive token handed out.
+
+    void startQueued();
+
+private slots:
+    void refill();
+
+signals:
+    void tick();
+};
+
+#endif // DCCMANAGER_H
@@ -0,0 +1,73 @@
+#include "dccmanagerdialog.h"
+#include "dccmanager.h"
+#include "dcctransfer.h"
+
+#include <QGridLayout>
+#include <QHeaderView>
+
+/*!
+ * \param dm Transfer manager to list
+ * \param parent Parent widget
+ */
+DCCManagerDialog::DCCManagerDialog(DCCManager *dm, QWidget *parent) :
+    QDialog(parent),
+    manager(dm)
+{
+    setWindowTitle(tr("DCC transfers"));
+    resize(640, 240);
+
+    list.setRootIsDecorated(false);
+    list.setHeaderLabels(QStringList() << tr("File") << tr("Nickname") << tr("Direction")
+                                       << tr("Progress") << tr("Rate") << tr("Status"));
+    list.header()->setSectionResizeMode(0, QHeaderView::Stretch);
+    list.header()->setStretchLastSection(false);
+
+    QGridLayout *layout = new QGridLayout(this);
+    layout->addWidget(&list, 0, 0);
+
+    refreshTimer.setInterval(1000);
+    connect(&refreshTimer, SIGNAL(timeout()),
+            this, SLOT(refresh()));
+}
+
+void DCCManagerDialog::showEvent(QShowEvent *)
+{
+    refresh();
+    refreshTimer.start();
+}
+
+void DCCManagerDialog::hideEvent(QHideEvent *)
+{
+    refreshTimer.stop();
+}
+
+void DCCManagerDialog::refresh()
+{
+    QList<DCCTransfer*> transfers = manager->getTransfers();
+
+    while (list.topLevelItemCount() > transfers.count())
+        delete list.takeTopLevelItem(list.topLevelItemCount()-1);
+    while (list.topLevelItemCount() < transfers.count())
+        list.addTopLevelItem(new QTreeWidgetItem());
+
+    for (int i = 0; i < transfers.count(); ++i) {
+        DCCTransfer *t = transfers[i];
+        QTreeWidgetItem *item = list.topLevelItem(i);
+
+        QString status = t->getStatus();
+        int q = manager->queuePosition(t);
+        if (q > -1)
+            status = tr("Queued (#%1)").arg(q+1);
+
+        int percent = 100;
+        if (t->getSize() > 0)
+            percent = t->getTransferred() * 100 / t->getSize();
+
+        item->setText(0, t->getFileName());
+        item->setText(1, t->getTarget());
+        item->setText(2, t->get_type() == DCC_SEND ? tr("Send") : tr("Receive"));
+        item->setText(3, tr("%1% of %2").arg(percent).arg(DCC::formatSize(t->getSize())));
+        item->setText(4, t->isFinished() ? QString() : tr("%1/s").arg(DCC::formatSize(t->getRate())));
+        item->setText(5, status);
+    }
+}
@@ -0,0 +1,53 @@
+/*
+ *   IdealIRC - Internet Relay Chat client
+ *   Copyright (C) 2015  Tom-Andre Barstad
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/*! \class DCCManagerDialog
+ *  \brief Transfer manager window, lists all DCC file transfers.
+ */
+
+#ifndef DCCMANAGERDIALOG_H
+#define DCCMANAGERDIALOG_H
+
+#include <QDialog>
+#include <QTreeWidget>
+#include <QTimer>
+
+class DCCManager;
+
+class DCCManagerDialog : public QDialog
+{
+  Q_OBJECT
+public:
+    explicit DCCManagerDialog(DCCManager *dm, QWidget *parent = 0);
+
+protected:
+    void showEvent(QShowEvent *);
+    void hideEvent(QHideEvent *);
+
+private:
+    DCCManager *manager;
+    QTreeWidget list;
+    QTimer refreshTimer;
+
+private slots:
+    void refresh();
+};
+
+#endif // DCCMANAGERDIALOG_H
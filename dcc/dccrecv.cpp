@@ -1,12 +1,396 @@
 #include "dccrecv.h"
+#include "dccmanager.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QCryptographicHash>
+#include <QtEndian>
+
+#include "iwin.h"
+#include "iconnection.h"
 
 DCCRecv::DCCRecv(DCCType t, IWin *parentWin, QString dcc_details) :
-    DCC(parentWin, dcc_details)
+    DCCTransfer(parentWin, dcc_details),
+    socket(NULL),
+    partial(0),
+    position(0),
+    verifying(false)
 {
     type = t;
+
+    resumeTimer.setSingleShot(true);
+    resumeTimer.setInterval(DCC_RESUME_TIMEOUT);
+    connect(&resumeTimer, SIGNAL(timeout()),
+            this, SLOT(resumeTimeout()));
+}
+
+DCCRecv::~DCCRecv()
+{
+    if (socket != NULL)
+        socket->abort();
+    closeFile();
 }
 
 void DCCRecv::initialize()
 {
+    // me target SEND file ip port size [token]
+    QStringList dsplit = splitDetails(details);
+    if (dsplit.count() < 7) {
+        print(tstar, tr("Invalid DCC send request."), PT_LOCALINFO);
+        end(tr("Failed"));
+        return;
+    }
+
+    target = dsplit[1];
+    fileName = QFileInfo(dsplit[3]).fileName(); // Never let the sender pick the folder.
+    ipv4 = connection->intipv4toStr(dsplit[4].toUInt());
+    port = dsplit[5].toUShort();
+    size = dsplit[6].toLongLong();
+    if (port == 0)
+        passiveToken = dsplit.value(7);
+
+    if (fileName.isEmpty() || fileName.startsWith('.'))
+        fileName.prepend('_');
+
+    QString path = subwin->getConfig()->dccPath;
+    QDir().mkpath(path);
+
+    QString fn = QString("%1/%2").arg(path).arg(fileName);
+    qint64 existing = QFileInfo(fn).size();
+    if ((existing > 0) && (existing < size) && passiveToken.isEmpty())
+        partial = existing; // Resume this one.
+    else
+        for (int i = 1; QFile::exists(fn); ++i)
+            fn = QString("%1/%2.%3").arg(path).arg(fileName).arg(i);
+
+    file.setFileName(fn);
+    if (! file.open(partial > 0 ? QIODevice::ReadWrite : QIODevice::WriteOnly)) {
+        print(tstar, tr("Unable to open %1: %2")
+                       .arg(fn)
+                       .arg(file.errorString()),
+              PT_LOCALINFO);
+        end(tr("Failed"));
+        return;
+    }
+
+    if (partial > 0) {
+        position = qMax((qint64)0, partial - DCC_RESUME_OVERLAP);
+        overlapHash = hashRange(position, partial);
+        transferred = position;
+    }
+
+    // Preallocate, so the file system can lay the file out in one go.
+    // If the transfer is interrupted, closeFile() cuts it back to what we got.
+    if (size > 0)
+        file.resize(size);
+
+    buffer.reserve(DCC_RECV_BUFFER + DCC_CHUNK_SIZE);
+
+    if ((manager != NULL) && (! manager->request(this))) {
+        status = tr("Queued");
+        print(tstar, tr("%1 is queued, waiting for other transfers to finish.").arg(fileName), PT_LOCALINFO);
+        return;
+    }
+
+    start();
+}
+
+/*!
+ * Asks to resume, or connects to the sender.\n
+ * For passive offers, listens and tells the sender where.
+ */
+void DCCRecv::start()
+{
+    if (! passiveToken.isEmpty()) {
+        quint32 address = connection->getLocalIPv4();
+        if ((address == 0) || (! listen(&server))) {
+            fail(tr("Unable to listen for DCC connections."));
+            return;
+        }
+
+        connect(&server, SIGNAL(newConnection()),
+                this, SLOT(newConnection()));
+
+        QString name = fileName;
+        if (name.contains(' '))
+            name = QString("\"%1\"").arg(name);
+
+        connection->sockwrite( QString("PRIVMSG %1 :%2DCC SEND %3 %4 %5 %6 %7%2")
+                                 .arg(target)
+                                 .arg(QChar(0x01))
+                                 .arg(name)
+                                 .arg(address)
+                                 .arg(server.serverPort())
+                                 .arg(size)
+                                 .arg(passiveToken)
+                              );
+
+        status = tr("Waiting");
+        print( tstar, tr("Receiving %1 (%2) from %3, waiting for them to connect...")
+                        .arg(fileName)
+                        .arg(formatSize(size))
+                        .arg(target),
+               PT_LOCALINFO
+              );
+        return;
+    }
+
+    if (partial > 0) {
+        QString name = fileName;
+        if (name.contains(' '))
+            name = QString("\"%1\"").arg(name);
+
+        connection->sockwrite( QString("PRIVMSG %1 :%2DCC RESUME %3 %4 %5%2")
+                                 .arg(target)
+                                 .arg(QChar(0x01))
+                                 .arg(name)
+                                 .arg(port)
+                                 .arg(position)
+                              );
+
+        status = tr("Resuming");
+        print( tstar, tr("Asking %1 to resume %2 at %3 of %4...")
+                        .arg(target)
+                        .arg(fileName)
+                        .arg(formatSize(partial))
+                        .arg(formatSize(size)),
+               PT_LOCALINFO
+              );
+
+        resumeTimer.start();
+        return;
+    }
+
+    status = tr("Connecting");
+    print( tstar, tr("Receiving %1 (%2) from %3, connecting to %4:%5...")
+                    .arg(fileName)
+                    .arg(formatSize(size))
+                    .arg(target)
+                    .arg(ipv4)
+                    .arg(port),
+           PT_LOCALINFO
+          );
+
+    connectToSender();
+}
+
+/*!
+ * \param pos Position the sender accepted
+ *
+ * DCC ACCEPT arrived, connects to the sender.
+ */
+void DCCRecv::resume(qint64 pos)
+{
+    if ((partial == 0) || (! resumeTimer.isActive()))
+        return;
+
+    resumeTimer.stop();
+
+    if ((pos < 0) || (pos > partial)) {
+        fail(tr("%1 accepted resuming at an invalid position.").arg(target));
+        return;
+    }
+
+    if (pos != position) {
+        position = pos;
+        overlapHash = hashRange(position, partial);
+    }
+
+    transferred = position;
+    verifying = (position < partial);
+
+    status = tr("Connecting");
+    print(tstar, tr("Resume accepted, connecting to %1:%2...").arg(ipv4).arg(port), PT_LOCALINFO);
+    connectToSender();
+}
+
+void DCCRecv::connectToSender()
+{
+    socket = new QTcpSocket(this);
+    setupSocket();
+    socket->connectToHost(ipv4, port);
+}
+
+void DCCRecv::setupSocket()
+{
+    socket->setReadBufferSize(DCC_SOCKET_BUFFER); // Lets bandwidth limits push back on the sender.
+
+    connect(socket, SIGNAL(connected()),
+            this, SLOT(sockConnected()));
+    connect(socket, SIGNAL(readyRead()),
+            this, SLOT(sockRead()));
+    connect(socket, SIGNAL(disconnected()),
+            this, SLOT(sockDisconnected()));
+    connect(socket, SIGNAL(error(QAbstractSocket::SocketError)),
+            this, SLOT(sockError(QAbstractSocket::SocketError)));
+}
+
+/*!
+ * The sender connected to us, for passive offers.
+ */
+void DCCRecv::newConnection()
+{
+    QTcpSocket *s = server.nextPendingConnection();
+    if (socket != NULL) {
+        s->abort();
+        return;
+    }
+
+    socket = s;
+    server.close();
+    setupSocket();
+    sockConnected();
+}
+
+void DCCRecv::resumeTimeout()
+{
+    fail(tr("%1 didn't accept resuming %2. Rename or remove the partial file and ask for it again.")
+           .arg(target)
+           .arg(fileName));
+}
+
+/*!
+ * \param from First byte
+ * \param to Byte after the last one
+ *
+ * \return SHA-1 of a part of our file.
+ */
+QByteArray DCCRecv::hashRange(qint64 from, qint64 to)
+{
+    file.seek(from);
+    return QCryptographicHash::hash(file.read(to - from), QCryptographicHash::Sha1);
+}
+
+void DCCRecv::sockConnected()
+{
+    socket->setSocketOption(QAbstractSocket::ReceiveBufferSizeSocketOption, DCC_SOCKET_BUFFER);
+
+    print(tstar, tr("Connected, saving to %1").arg(file.fileName()), PT_LOCALINFO);
+
+    file.seek(position);
+    status = tr("Receiving");
+    begin();
+}
+
+/*!
+ * Reads as much as the bandwidth limits allow, tick() reads the rest.
+ */
+void DCCRecv::sockRead()
+{
+    if (finished || (! file.isOpen()))
+        return;
+
+    qint64 len = allowance(socket->bytesAvailable());
+    if (len <= 0)
+        return;
+
+    QByteArray data = socket->read(len);
+    buffer.append(data);
+    transferred += data.length();
+
+    if (verifying) {
+        qint64 overlap = partial - position;
+        if (buffer.length() < overlap)
+            return;
+
+        if (QCryptographicHash::hash(buffer.left(overlap), QCryptographicHash::Sha1) != overlapHash) {
+            transferred = partial;
+            buffer.resize(0);
+            fail(tr("The start of %1 from %2 doesn't match the partial file, not resuming.")
+                   .arg(fileName)
+                   .arg(target));
+            return;
+        }
+
+        print(tstar, tr("Partial file verified."), PT_LOCALINFO);
+        verifying = false;
+        buffer.remove(0, overlap);
+        file.seek(partial);
+    }
+
+    if (buffer.length() >= DCC_RECV_BUFFER)
+        writeBuffer();
+
+    uchar ack[4];
+    qToBigEndian<quint32>((quint32)transferred, ack);
+    socket->write((const char*)ack, 4);
+
+    if (transferred < size)
+        return;
+
+    closeFile();
+    end(tr("Complete"));
+    printResult();
+
+    socket->disconnectFromHost();
+}
+
+void DCCRecv::tick()
+{
+    DCCTransfer::tick();
+
+    if ((socket != NULL) && (socket->bytesAvailable() > 0))
+        sockRead();
+}
+
+void DCCRecv::writeBuffer()
+{
+    if (buffer.isEmpty() || verifying)
+        return;
+
+    file.write(buffer);
+    buffer.resize(0); // Keeps the reserved capacity, clear() would free it.
+}
+
+/*!
+ * Writes what's left in the buffer, and cuts away the preallocated space we didn't receive.
+ */
+void DCCRecv::closeFile()
+{
+    if (! file.isOpen())
+        return;
+
+    writeBuffer();
+    if (transferred < size)
+        file.resize(qMax(transferred, partial));
+    file.close();
+}
+
+/*!
+ * \param reason Message to show
+ *
+ * Stops the transfer, keeping what we've got.
+ */
+void DCCRecv::fail(const QString &reason)
+{
+    print(tstar, reason, PT_LOCALINFO);
+    closeFile();
+    end(tr("Failed"));
+    if (socket != NULL)
+        socket->abort(); // After end(), so sockDisconnected() keeps quiet.
+}
+
+void DCCRecv::sockDisconnected()
+{
+    if (finished)
+        return;
+
+    closeFile();
+    print(tstar, tr("Transfer of %1 interrupted at %2 of %3.")
+                   .arg(fileName)
+                   .arg(formatSize(transferred))
+                   .arg(formatSize(size)),
+          PT_LOCALINFO);
+    end(tr("Interrupted"));
+}
+
+void DCCRecv::sockError(QAbstractSocket::SocketError)
+{
+    if (finished)
+        return;
 
+    if (socket->state() != QAbstractSocket::ConnectedState)
+        fail(tr("DCC error: %1").arg(socket->errorString())); // Never connected, there won't be a disconnect.
+    else
+        print(tstar, tr("DCC error: %1").arg(socket->errorString()), PT_LOCALINFO);
 }
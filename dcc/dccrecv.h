@@ -20,21 +20,73 @@
 
 /*! \class DCCReceive
  *  \brief DCC file receive, not an actual DCC protocol.
+ *
+ * Connects to the sender of a DCC SEND and writes the file to the DCC download folder.\n
+ * The file is preallocated to its full size and written in DCC_RECV_BUFFER pieces.\n
+ * One acknowledgement is sent per socket read, not per packet.\n\n
+ *
+ * If a shorter file with the same name is there, we ask to resume it with DCC RESUME.\n
+ * We ask for DCC_RESUME_OVERLAP bytes we already have, and compare their hash to what
+ * arrives before writing anything. If they differ, the partial file isn't this file and
+ * the transfer stops, leaving the partial file as it was.\n\n
+ *
+ * A passive offer (port 0 and a token) makes us listen and answer with our address, the sender connects.
  */
 
 #ifndef DCCRECV_H
 #define DCCRECV_H
 
 #include <QObject>
-#include "dcc.h"
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QFile>
+#include <QTimer>
+#include "dcctransfer.h"
+
+#define DCC_RESUME_OVERLAP 65536 //!< Bytes of a partial file sent again when resuming, to check it's the same file.
+#define DCC_RESUME_TIMEOUT 30000 //!< Milliseconds to wait for DCC ACCEPT.
 
-class DCCRecv : public DCC
+class DCCRecv : public DCCTransfer
 {
   Q_OBJECT
 public:
     explicit DCCRecv(DCCType t, IWin *parentWin, QString dcc_details);
+    ~DCCRecv();
 
     void initialize();
+    void start();
+    void resume(qint64 position);
+
+private:
+    QTcpServer server; //!< Listens for the sender, for passive offers.
+    QTcpSocket *socket;
+    QString passiveToken; //!< Token of their passive offer, empty if they listen.
+    QFile file;
+    QByteArray buffer; //!< Received data not yet written to file.
+    QString ipv4; //!< Sender's address.
+    QTimer resumeTimer; //!< Gives up on DCC ACCEPT.
+    qint64 partial; //!< Size of the partial file we're resuming, 0 if not resuming.
+    qint64 position; //!< Where the sender starts.
+    QByteArray overlapHash; //!< Hash of our partial file from position to partial.
+    bool verifying; //!< The overlap hasn't arrived yet.
+
+    QByteArray hashRange(qint64 from, qint64 to);
+    void connectToSender();
+    void setupSocket();
+    void writeBuffer();
+    void closeFile();
+    void fail(const QString &reason);
+
+protected slots:
+    void tick();
+
+private slots:
+    void newConnection();
+    void sockConnected();
+    void sockRead();
+    void sockDisconnected();
+    void sockError(QAbstractSocket::SocketError);
+    void resumeTimeout();
 };
 
 #endif // DCCRECV_H
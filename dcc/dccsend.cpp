@@ -1,12 +1,335 @@
 #include "dccsend.h"
+#include "dccmanager.h"
+
+#include <QFileInfo>
+#include <QtEndian>
+
+#include "iwin.h"
+#include "iconnection.h"
 
 DCCSend::DCCSend(DCCType t, IWin *parentWin, QString dcc_details) :
-    DCC(parentWin, dcc_details)
+    DCCTransfer(parentWin, dcc_details),
+    socket(NULL),
+    map(NULL),
+    sent(0),
+    acked(0),
+    turbo(false)
 {
     type = t;
 }
 
+DCCSend::~DCCSend()
+{
+    if (socket != NULL)
+        socket->abort();
+
+    if (map != NULL)
+        file.unmap(map);
+}
+
 void DCCSend::initialize()
 {
+    // me target SENDHOST path
+    QStringList dsplit = splitDetails(details);
+    if (dsplit.count() < 4) {
+        print(tstar, tr("Invalid DCC send request."), PT_LOCALINFO);
+        end(tr("Failed"));
+        return;
+    }
+
+    target = dsplit[1];
+    file.setFileName(dsplit[3]);
+    fileName = QFileInfo(file).fileName();
+    turbo = subwin->getConfig()->dccTurbo;
+
+    if (! file.open(QIODevice::ReadOnly)) {
+        print(tstar, tr("Unable to open %1: %2")
+                       .arg(file.fileName())
+                       .arg(file.errorString()),
+              PT_LOCALINFO);
+        end(tr("Failed"));
+        return;
+    }
+
+    size = file.size();
+    if (size > 0)
+        map = file.map(0, size); // Falls back to reading if this fails.
+
+    if ((manager != NULL) && (! manager->request(this))) {
+        status = tr("Queued");
+        print(tstar, tr("%1 is queued, waiting for other transfers to finish.").arg(fileName), PT_LOCALINFO);
+        return;
+    }
+
+    start();
+}
+
+/*!
+ * Sends the offer and waits for the receiver to connect.
+ */
+void DCCSend::start()
+{
+    quint32 address = connection->getLocalIPv4();
+    QString passive;
+
+    if (subwin->getConfig()->dccPassive) {
+        port = 0;
+        passive = " " + offerPassive();
+    }
+    else {
+        if ((address == 0) || (! listen(&server))) {
+            print(tstar, tr("Unable to listen for DCC connections."), PT_LOCALINFO);
+            end(tr("Failed"));
+            return;
+        }
+
+        port = server.serverPort();
+        connect(&server, SIGNAL(newConnection()),
+                this, SLOT(newConnection()));
+    }
+
+    connection->sockwrite( QString("PRIVMSG %1 :%2DCC SEND %3 %4 %5 %6%7%2")
+                             .arg(target)
+                             .arg(QChar(0x01))
+                             .arg(quotedName())
+                             .arg(address)
+                             .arg(port)
+                             .arg(size)
+                             .arg(passive)
+                          );
+
+    status = tr("Offered");
+    print(tstar, tr("Offering %1 (%2) to %3, waiting for connection...")
+                   .arg(fileName)
+                   .arg(formatSize(size))
+                   .arg(target),
+          PT_LOCALINFO);
+}
+
+/*!
+ * \param position Where the receiver wants to continue from
+ *
+ * Answers a DCC RESUME with DCC ACCEPT. Only valid before the receiver connects.
+ */
+void DCCSend::resume(qint64 position)
+{
+    if ((socket != NULL) || finished || (position <= 0) || (position >= size))
+        return;
+
+    sent = position;
+    acked = position;
+    transferred = position;
+
+    QString passive;
+    if (! token.isEmpty())
+        passive = " " + token;
+
+    connection->sockwrite( QString("PRIVMSG %1 :%2DCC ACCEPT %3 %4 %5%6%2")
+                             .arg(target)
+                             .arg(QChar(0x01))
+                             .arg(quotedName())
+                             .arg(port)
+                             .arg(position)
+                             .arg(passive)
+                          );
+
+    print(tstar, tr("%1 resumes %2 at %3.")
+                   .arg(target)
+                   .arg(fileName)
+                   .arg(formatSize(position)),
+          PT_LOCALINFO);
+}
+
+/*!
+ * \return File name as used in DCC messages, quoted if it has spaces.
+ */
+QString DCCSend::quotedName()
+{
+    if (fileName.contains(' '))
+        return QString("\"%1\"").arg(fileName);
+    return fileName;
+}
+
+/*!
+ * \param ipv4 Receiver's address
+ * \param port Receiver's port
+ *
+ * The receiver answered our passive offer, connects to them.
+ */
+void DCCSend::connectTo(const QString &ipv4, quint16 port)
+{
+    if ((socket != NULL) || finished)
+        return;
+
+    socket = new QTcpSocket(this);
+    connect(socket, SIGNAL(connected()),
+            this, SLOT(sockConnected()));
+    connect(socket, SIGNAL(error(QAbstractSocket::SocketError)),
+            this, SLOT(sockError(QAbstractSocket::SocketError)));
+
+    print(tstar, tr("Connecting to %1 (%2:%3)...")
+                   .arg(target)
+                   .arg(ipv4)
+                   .arg(port),
+          PT_LOCALINFO);
+
+    socket->connectToHost(ipv4, port);
+}
+
+void DCCSend::sockConnected()
+{
+    attach();
+}
+
+void DCCSend::newConnection()
+{
+    QTcpSocket *s = server.nextPendingConnection();
+    if (socket != NULL) {
+        s->abort();
+        return;
+    }
+
+    socket = s;
+    server.close();
+    attach();
+}
+
+/*!
+ * The receiver is connected, starts sending.
+ */
+void DCCSend::attach()
+{
+    socket->setSocketOption(QAbstractSocket::SendBufferSizeSocketOption, DCC_SOCKET_BUFFER);
+
+    connect(socket, SIGNAL(bytesWritten(qint64)),
+            this, SLOT(fill()));
+    connect(socket, SIGNAL(readyRead()),
+            this, SLOT(readAck()));
+    connect(socket, SIGNAL(disconnected()),
+            this, SLOT(sockDisconnected()));
+    connect(socket, SIGNAL(error(QAbstractSocket::SocketError)),
+            this, SLOT(sockError(QAbstractSocket::SocketError)), Qt::UniqueConnection);
+
+    print(tstar, tr("Connected to %1 (%2), sending %3...")
+                   .arg(target)
+                   .arg(socket->peerAddress().toString())
+                   .arg(fileName),
+          PT_LOCALINFO);
+
+    status = tr("Sending");
+    begin();
+    fill();
+}
+
+/*!
+ * Writes the next chunks to the socket.\n
+ * Keeps at most four chunks in Qt's write buffer, and unless in turbo mode,
+ * at most DCC_SEND_WINDOW bytes ahead of the receiver.\n
+ * Bandwidth limits may stop it early, tick() continues.
+ */
+void DCCSend::fill()
+{
+    if ((socket == NULL) || finished)
+        return;
+
+    while (sent < size) {
+        if (socket->bytesToWrite() >= DCC_CHUNK_SIZE * 4)
+            break;
+
+        qint64 len = qMin((qint64)DCC_CHUNK_SIZE, size - sent);
+        if (! turbo) {
+            qint64 window = DCC_SEND_WINDOW - (sent - acked);
+            if (window <= 0)
+                break;
+            len = qMin(len, window);
+        }
+
+        len = allowance(len);
+        if (len <= 0)
+            break;
+
+        qint64 written;
+        if (map != NULL)
+            written = socket->write((const char*)map + sent, len);
+        else {
+            file.seek(sent);
+            written = socket->write(file.read(len));
+        }
+
+        if (written <= 0)
+            break;
+        sent += written;
+    }
+
+    if (turbo) {
+        transferred = sent - socket->bytesToWrite();
+        if (transferred == size)
+            finish();
+    }
+}
+
+/*!
+ * Reads acknowledgements, 32 bit network order byte counts.\n
+ * Files above 4 GB wrap the counter, so the high bits are taken from what we've sent.
+ */
+void DCCSend::readAck()
+{
+    while (socket->bytesAvailable() >= 4) {
+        char buf[4];
+        socket->read(buf, 4);
+
+        qint64 ack = (sent & Q_INT64_C(0x7FFFFFFF00000000)) | qFromBigEndian<quint32>((const uchar*)buf);
+        if (ack > sent)
+            ack -= Q_INT64_C(0x100000000);
+        if (ack > acked)
+            acked = ack;
+    }
+
+    if (turbo)
+        return;
+
+    transferred = acked;
+    if (acked >= size)
+        finish();
+    else
+        fill();
+}
+
+void DCCSend::tick()
+{
+    DCCTransfer::tick();
+    fill();
+}
+
+void DCCSend::finish()
+{
+    if (finished)
+        return;
+
+    end(tr("Complete"));
+    printResult();
+    socket->disconnectFromHost();
+}
+
+void DCCSend::sockDisconnected()
+{
+    if (finished)
+        return;
+
+    print(tstar, tr("Transfer of %1 interrupted at %2 of %3.")
+                   .arg(fileName)
+                   .arg(formatSize(transferred))
+                   .arg(formatSize(size)),
+          PT_LOCALINFO);
+    end(tr("Interrupted"));
+}
+
+void DCCSend::sockError(QAbstractSocket::SocketError)
+{
+    if (finished)
+        return;
 
+    print(tstar, tr("DCC error: %1").arg(socket->errorString()), PT_LOCALINFO);
+    if (socket->state() != QAbstractSocket::ConnectedState)
+        end(tr("Failed")); // Never connected, there won't be a disconnect.
 }
@@ -20,21 +20,59 @@
 
 /*! \class DCCSend
  *  \brief DCC file sending
+ *
+ * Offers a file (details type SENDHOST) and sends it to whoever connects.\n
+ * The file is memory mapped and written in DCC_CHUNK_SIZE pieces, up to DCC_SEND_WINDOW
+ * bytes ahead of the receiver's acknowledgements.\n
+ * In turbo mode (config option DCCTurbo) acknowledgements are ignored and the socket is kept full.\n
+ * A DCC RESUME before the receiver connects makes the transfer start at the given position.\n
+ * With the DCCPassive option, the receiver listens and we connect.
  */
 
 #ifndef DCCSEND_H
 #define DCCSEND_H
 
 #include <QObject>
-#include "dcc.h"
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QFile>
+#include "dcctransfer.h"
 
-class DCCSend : public DCC
+class DCCSend : public DCCTransfer
 {
   Q_OBJECT
 public:
     explicit DCCSend(DCCType t, IWin *parentWin, QString dcc_details);
+    ~DCCSend();
 
     void initialize();
+    void start();
+    void resume(qint64 position);
+    void connectTo(const QString &ipv4, quint16 port);
+
+private:
+    QTcpServer server;
+    QTcpSocket *socket;
+    QFile file;
+    uchar *map; //!< The file memory mapped, NULL if mapping failed and we read instead.
+    qint64 sent; //!< Bytes of the file written to the socket, including where we resumed from.
+    qint64 acked; //!< Bytes the receiver has confirmed.
+    bool turbo; //!< Don't wait for acknowledgements.
+
+    QString quotedName();
+    void attach();
+    void finish();
+
+protected slots:
+    void tick();
+
+private slots:
+    void newConnection();
+    void sockConnected();
+    void fill();
+    void readAck();
+    void sockDisconnected();
+    void sockError(QAbstractSocket::SocketError);
 };
 
 #endif // DCCSEND_H
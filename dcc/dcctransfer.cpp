@@ -0,0 +1,122 @@
+#include "dcctransfer.h"
+#include "dccmanager.h"
+
+#include "iwin.h"
+#include "iconnection.h"
+
+DCCTransfer::DCCTransfer(IWin *parentWin, QString dcc_details) :
+    DCC(parentWin, dcc_details),
+    status(tr("Waiting")),
+    port(0),
+    size(0),
+    transferred(0),
+    rate(0),
+    budget(-1),
+    finished(false),
+    lastProgress(0),
+    startOffset(0)
+{
+    if (manager != NULL) {
+        manager->add(this);
+        connect(manager, SIGNAL(tick()),
+                this, SLOT(tick()));
+    }
+
+    progressTimer.setInterval(DCC_PROGRESS_INTERVAL);
+    connect(&progressTimer, SIGNAL(timeout()),
+            this, SLOT(updateProgress()));
+}
+
+DCCTransfer::~DCCTransfer()
+{
+    if (manager != NULL)
+        manager->remove(this);
+}
+
+/*!
+ * Data is about to flow, starts the clock.
+ */
+void DCCTransfer::begin()
+{
+    lastProgress = transferred;
+    startOffset = transferred;
+    elapsed.start();
+    progressTimer.start();
+}
+
+/*!
+ * \param newStatus Final status
+ *
+ * The transfer is over, lets the next queued transfer begin.
+ */
+void DCCTransfer::end(const QString &newStatus)
+{
+    if (finished)
+        return;
+
+    finished = true;
+    status = newStatus;
+    rate = 0;
+    progressTimer.stop();
+    emit progress(transferred, size, 0);
+
+    if (manager != NULL)
+        manager->release(this);
+}
+
+/*!
+ * \param wanted Bytes we'd like to move
+ *
+ * Takes from this transfer's and the global bandwidth limits.
+ * \return Bytes we may move now. 0 means wait for next tick.
+ */
+qint64 DCCTransfer::allowance(qint64 wanted)
+{
+    if (budget >= 0)
+        wanted = qMin(wanted, budget);
+
+    if (manager != NULL)
+        wanted = manager->take(wanted);
+
+    if (budget >= 0)
+        budget -= wanted;
+
+    return wanted;
+}
+
+/*!
+ * Refills the per transfer limit, runs every DCC_TICK_INTERVAL.
+ */
+void DCCTransfer::tick()
+{
+    int limit = subwin->getConfig()->dccTransferLimit;
+    if (limit > 0)
+        budget = (qint64)limit * 1024 * DCC_TICK_INTERVAL / 1000;
+    else
+        budget = -1;
+}
+
+/*!
+ * Prints how much was moved and how fast.
+ */
+void DCCTransfer::printResult()
+{
+    qint64 ms = qMax(elapsed.elapsed(), (qint64)1);
+    qint64 moved = transferred - startOffset;
+
+    print(tstar, tr("%1 %2 (%3) in %4 seconds, %5/s.")
+                   .arg(type == DCC_SEND ? tr("Sent") : tr("Received"))
+                   .arg(fileName)
+                   .arg(formatSize(transferred))
+                   .arg(ms / 1000.0, 0, 'f', 1)
+                   .arg(formatSize(moved * 1000 / ms)),
+          PT_LOCALINFO);
+}
+
+void DCCTransfer::updateProgress()
+{
+    rate = (transferred - lastProgress) * 1000 / DCC_PROGRESS_INTERVAL;
+    lastProgress = transferred;
+
+    emit progress(transferred, size, rate);
+}
@@ -0,0 +1,85 @@
+/*
+ *   IdealIRC - Internet Relay Chat client
+ *   Copyright (C) 2015  Tom-Andre Barstad
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/*! \class DCCTransfer
+ *  \brief Common parts of file sending and receiving.
+ *
+ * Keeps what DCCManager needs to know about a transfer: target, file, progress and status.\n
+ * Transfers ask DCCManager before they begin, so they can be queued, and ask allowance()
+ * before moving data, so they can be throttled.
+ */
+
+#ifndef DCCTRANSFER_H
+#define DCCTRANSFER_H
+
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+#include "dcc.h"
+
+class DCCManager;
+
+class DCCTransfer : public DCC
+{
+  Q_OBJECT
+public:
+    explicit DCCTransfer(IWin *parentWin, QString dcc_details);
+    ~DCCTransfer();
+
+    QString getFileName() { return fileName; } //!< \return File name, without path.
+    QString getStatus() { return status; } //!< \return Human readable status.
+    quint16 getPort() { return port; } //!< \return Port of the offer, identifies the transfer in RESUME and ACCEPT.
+    qint64 getSize() { return size; } //!< \return File size.
+    qint64 getTransferred() { return transferred; } //!< \return Bytes of the file the receiver has.
+    qint64 getRate() { return rate; } //!< \return Bytes per second, as of last progress update.
+    bool isFinished() { return finished; } //!< \return true when the transfer is over, complete or not.
+
+    virtual void start() = 0; //!< Begins the transfer. Called by initialize() or DCCManager when the queue moves.
+    virtual void resume(qint64 position) = 0; //!< DCC RESUME (sending) or DCC ACCEPT (receiving) for this transfer.
+
+protected:
+    QString fileName; //!< File name, without path.
+    QString status;
+    quint16 port;
+    qint64 size;
+    qint64 transferred; //!< Bytes of the file the receiver has, including what was there before resuming.
+    qint64 rate;
+    qint64 budget; //!< Bytes we may move until next DCCManager tick, -1 for no limit.
+    bool finished;
+    QElapsedTimer elapsed;
+
+    void begin();
+    void end(const QString &newStatus);
+    qint64 allowance(qint64 wanted);
+    void printResult();
+
+protected slots:
+    virtual void tick(); // Derived classes continue a throttled transfer here.
+
+private:
+    QTimer progressTimer;
+    qint64 lastProgress; //!< Bytes transferred at last progress update.
+    qint64 startOffset; //!< Bytes transferred when begin() ran.
+
+private slots:
+    void updateProgress();
+};
+
+#endif // DCCTRANSFER_H
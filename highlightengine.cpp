@@ -0,0 +1,165 @@
+/*
+ *   IdealIRC - Internet Relay Chat client
+ *   Copyright (C) 2014  Tom-Andre Barstad
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+
+#include <QQueue>
+#include <QHashIterator>
+#include <QListIterator>
+
+#include "highlightengine.h"
+
+HighlightEngine::HighlightEngine()
+{
+    newNode(); // Root
+}
+
+/*!
+ * Appends an empty node to the automaton.
+ * \return Index of new node
+ */
+int HighlightEngine::newNode()
+{
+    hlnode_t n;
+    n.fail = 0;
+    n.word = -1;
+    nodes << n;
+
+    return nodes.count()-1;
+}
+
+/*!
+ * \param list Words to look for
+ *
+ * Compiles the words into the automaton, replacing any previous words. Empty words are ignored.
+ */
+void HighlightEngine::setWords(const QStringList &list)
+{
+    words.clear();
+    nodes.clear();
+    newNode();
+
+    // Build the trie
+    QListIterator<QString> i(list);
+    while (i.hasNext()) {
+        QString word = i.next().trimmed().toCaseFolded();
+        if (word.isEmpty() || words.contains(word))
+            continue;
+
+        int n = 0;
+        for (int c = 0; c < word.length(); ++c) {
+            int next = nodes[n].next.value(word[c], -1);
+            if (next == -1) {
+                next = newNode();
+                nodes[n].next.insert(word[c], next);
+            }
+            n = next;
+        }
+
+        words << word;
+        nodes[n].word = words.count()-1;
+    }
+
+    // Set up fail links, breadth first so the fail node of a node is always done before it.
+    QQueue<int> queue;
+    QHashIterator<QChar,int> r(nodes[0].next);
+    while (r.hasNext())
+        queue.enqueue(r.next().value()); // fail is 0 for these
+
+    while (! queue.isEmpty()) {
+        int n = queue.dequeue();
+
+        QHashIterator<QChar,int> t(nodes[n].next);
+        while (t.hasNext()) {
+            t.next();
+            QChar c = t.key();
+            int child = t.value();
+
+            int f = nodes[n].fail;
+            while ((f > 0) && (! nodes[f].next.contains(c)))
+                f = nodes[f].fail;
+
+            int fail = nodes[f].next.value(c, 0);
+            nodes[child].fail = fail;
+            if (nodes[child].word == -1)
+                nodes[child].word = nodes[fail].word;
+
+            queue.enqueue(child);
+        }
+    }
+}
+
+/*!
+ * \param list Regular expressions to look for
+ *
+ * Replaces the regular expressions. Invalid ones are ignored.
+ */
+void HighlightEngine::setPatterns(const QStringList &list)
+{
+    patterns.clear();
+
+    QListIterator<QString> i(list);
+    while (i.hasNext()) {
+        QString pattern = i.next();
+        if (pattern.isEmpty())
+            continue;
+
+        QRegExp re(pattern, Qt::CaseInsensitive);
+        if (re.isValid())
+            patterns << re;
+    }
+}
+
+/*!
+ * \param text Text to search
+ * \param trigger If not null, set to the word or pattern that matched
+ *
+ * \return true if the text contains any of the words or matches any of the patterns.
+ */
+bool HighlightEngine::match(const QString &text, QString *trigger) const
+{
+    int n = 0;
+    for (int i = 0; i < text.length(); ++i) {
+        QChar c = text[i].toCaseFolded();
+
+        QHash<QChar,int>::const_iterator it = nodes[n].next.constFind(c);
+        while ((n > 0) && (it == nodes[n].next.constEnd())) {
+            n = nodes[n].fail;
+            it = nodes[n].next.constFind(c);
+        }
+
+        n = (it == nodes[n].next.constEnd()) ? 0 : it.value();
+
+        if (nodes[n].word > -1) {
+            if (trigger != 0)
+                *trigger = words[nodes[n].word];
+            return true;
+        }
+    }
+
+    for (int i = 0; i < patterns.count(); ++i) {
+        if (patterns[i].indexIn(text) > -1) {
+            if (trigger != 0)
+                *trigger = patterns[i].pattern();
+            return true;
+        }
+    }
+
+    return false;
+}
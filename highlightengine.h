@@ -0,0 +1,64 @@
+/*
+ *   IdealIRC - Internet Relay Chat client
+ *   Copyright (C) 2014  Tom-Andre Barstad
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/*! \class HighlightEngine
+ *  \brief Finds highlight words and patterns in a message.
+ *
+ * All words are compiled into one Aho-Corasick automaton, so a message is scanned once
+ * no matter how many words there are. Matching is case insensitive and on substrings, like
+ * the old check of our nickname. Regular expressions are tried after the words, if any.
+ */
+
+#ifndef HIGHLIGHTENGINE_H
+#define HIGHLIGHTENGINE_H
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QVector>
+#include <QList>
+#include <QRegExp>
+
+/*!
+ * Node of the automaton.
+ */
+typedef struct T_HLNODE {
+    QHash<QChar,int> next; //!< Transitions.\n Key: Case folded character\n Value: Node index.
+    int fail; //!< Node to continue from when there's no transition.
+    int word; //!< Index of the word ending here, or reached through fail links. -1 if none.
+} hlnode_t;
+
+class HighlightEngine
+{
+public:
+    HighlightEngine();
+    void setWords(const QStringList &list);
+    void setPatterns(const QStringList &list);
+    bool match(const QString &text, QString *trigger = 0) const;
+    bool isEmpty() const { return words.isEmpty() && patterns.isEmpty(); } //!< \return true if there's nothing to look for.
+
+private:
+    QStringList words; //!< Words in the automaton, case folded.
+    QVector<hlnode_t> nodes; //!< The automaton. Index 0 is the root.
+    mutable QList<QRegExp> patterns; //!< Regular expressions, case insensitive. Mutable since QRegExp keeps its match state.
+    int newNode();
+};
+
+#endif // HIGHLIGHTENGINE_H
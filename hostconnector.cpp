@@ -0,0 +1,341 @@
+/*
+ *   IdealIRC - Internet Relay Chat client
+ *   Copyright (C) 2014  Tom-Andre Barstad
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+
+#include <QDateTime>
+#include <QListIterator>
+#include <QMutableHashIterator>
+
+#include "hostconnector.h"
+
+QHash<QString,hcdnsentry_t> HostConnector::dnsCache;
+
+HostConnector::HostConnector(QObject *parent) :
+    QObject(parent),
+    running(false),
+    serverIndex(0),
+    port(0),
+    tls(false),
+    lookupId(-1),
+    dnsTime(0)
+{
+    staggerTimer.setInterval(HC_STAGGER);
+    serverTimer.setSingleShot(true);
+
+    connect(&staggerTimer, SIGNAL(timeout()),
+            this, SLOT(staggerTimeout()));
+
+    connect(&serverTimer, SIGNAL(timeout()),
+            this, SLOT(serverTimeout()));
+}
+
+/*!
+ * \param serverList Servers to try, in order. Each is "host:port" or "host:port|password", port prefixed with + for TLS.
+ * \param timeout Milliseconds to try each server before moving on.
+ *
+ * Starts connecting. Any attempt already running is aborted.\n
+ * Emits connected() on success, or exhausted() when no server could be reached.
+ */
+void HostConnector::connectTo(QStringList serverList, int timeout)
+{
+    abort();
+
+    servers = serverList;
+    serverIndex = -1;
+    running = true;
+    serverTimer.setInterval(timeout > 0 ? timeout : 30000);
+    nextServer();
+}
+
+/*!
+ * Stops trying to connect.
+ */
+void HostConnector::abort()
+{
+    if (lookupId != -1) {
+        QHostInfo::abortHostLookup(lookupId);
+        lookupId = -1;
+    }
+
+    staggerTimer.stop();
+    serverTimer.stop();
+    clearAttempts();
+    pending.clear();
+    running = false;
+}
+
+/*!
+ * \param hostname Hostname
+ *
+ * Removes a hostname from the DNS cache, so it's resolved again next time.
+ */
+void HostConnector::forget(QString hostname)
+{
+    dnsCache.remove(hostname.toLower());
+}
+
+/*!
+ * Moves on to the next server in the list, emits exhausted() if there's none left.
+ */
+void HostConnector::nextServer()
+{
+    clearAttempts();
+    pending.clear();
+    staggerTimer.stop();
+    serverIndex++;
+
+    if (serverIndex >= servers.count()) {
+        running = false;
+        serverTimer.stop();
+        emit exhausted();
+        return;
+    }
+
+    QString hostport = servers[serverIndex].split('|').at(0);
+    int colon = hostport.lastIndexOf(':');
+    host = hostport.left(colon);
+    QString p = hostport.mid(colon+1);
+    tls = p.startsWith('+');
+    if (tls)
+        p = p.mid(1);
+    port = p.toUShort();
+
+    if ((colon == -1) || (host.isEmpty()) || (port == 0)) {
+        serverFailed(tr("Invalid server address"));
+        return;
+    }
+
+    emit trying(host, port);
+    serverTimer.start();
+    clock.start();
+
+    // No need to look up an IP address.
+    QHostAddress literal;
+    if (literal.setAddress(host)) {
+        dnsTime = 0;
+        race(QList<QHostAddress>() << literal);
+        return;
+    }
+
+    QString key = host.toLower();
+    if (dnsCache.contains(key)) {
+        hcdnsentry_t entry = dnsCache.value(key);
+        if (entry.expires > QDateTime::currentMSecsSinceEpoch() / 1000) {
+            dnsTime = 0;
+            emit resolved(host, 0, true);
+            race(entry.addresses);
+            return;
+        }
+        dnsCache.remove(key);
+    }
+
+    lookupId = QHostInfo::lookupHost(host, this, SLOT(lookedUp(QHostInfo)));
+}
+
+/*!
+ * \param info Result of our lookup
+ *
+ * Caches the result and starts connecting to the addresses.
+ */
+void HostConnector::lookedUp(QHostInfo info)
+{
+    if (info.lookupId() != lookupId)
+        return; // An aborted lookup.
+    lookupId = -1;
+
+    if ((info.error() != QHostInfo::NoError) || (info.addresses().isEmpty())) {
+        serverFailed(info.errorString());
+        return;
+    }
+
+    dnsTime = clock.restart();
+    emit resolved(host, dnsTime, false);
+
+    if (dnsCache.count() >= HC_DNS_MAX) {
+        // Throw out the expired ones, or everything if that didn't help.
+        qint64 now = QDateTime::currentMSecsSinceEpoch() / 1000;
+        QMutableHashIterator<QString,hcdnsentry_t> i(dnsCache);
+        while (i.hasNext()) {
+            i.next();
+            if (i.value().expires <= now)
+                i.remove();
+        }
+        if (dnsCache.count() >= HC_DNS_MAX)
+            dnsCache.clear();
+    }
+
+    hcdnsentry_t entry;
+    entry.addresses = info.addresses();
+    entry.expires = QDateTime::currentMSecsSinceEpoch() / 1000 + HC_DNS_TTL;
+    dnsCache.insert(host.toLower(), entry);
+
+    race(entry.addresses);
+}
+
+/*!
+ * \param addresses All addresses of the current server.
+ *
+ * Orders the addresses so IPv6 and IPv4 alternates (starting with the family the resolver
+ * preferred) and starts the first attempt.
+ */
+void HostConnector::race(QList<QHostAddress> addresses)
+{
+    QList<QHostAddress> first;
+    QList<QHostAddress> second;
+    QAbstractSocket::NetworkLayerProtocol preferred = addresses.first().protocol();
+
+    QListIterator<QHostAddress> i(addresses);
+    while (i.hasNext()) {
+        QHostAddress addr = i.next();
+        if (addr.protocol() == preferred)
+            first << addr;
+        else
+            second << addr;
+    }
+
+    pending.clear();
+    while ((! first.isEmpty()) || (! second.isEmpty())) {
+        if (! first.isEmpty())
+            pending << first.takeFirst();
+        if (! second.isEmpty())
+            pending << second.takeFirst();
+    }
+
+    clock.restart();
+    startAttempt();
+    staggerTimer.start();
+}
+
+/*!
+ * Starts connecting to the next address that's not tried yet.
+ */
+void HostConnector::startAttempt()
+{
+    if (pending.isEmpty()) {
+        staggerTimer.stop();
+        return;
+    }
+
+    // Encryption is started by the receiver of connected(), only the winning attempt does a handshake.
+    QTcpSocket *socket = tls ? new QSslSocket(this) : new QTcpSocket(this);
+    attempts << socket;
+
+    connect(socket, SIGNAL(connected()),
+            this, SLOT(attemptConnected()));
+
+    connect(socket, SIGNAL(error(QAbstractSocket::SocketError)),
+            this, SLOT(attemptFailed()));
+
+    socket->connectToHost(pending.takeFirst(), port, QIODevice::ReadWrite);
+}
+
+/*!
+ * One of our attempts connected. Hands it over and aborts the others.
+ */
+void HostConnector::attemptConnected()
+{
+    QTcpSocket *socket = qobject_cast<QTcpSocket*>(sender());
+    if ((socket == NULL) || (! attempts.contains(socket)))
+        return;
+
+    qint64 connectTime = clock.elapsed();
+
+    attempts.removeAll(socket);
+    disconnect(socket, 0, this, 0);
+    socket->setParent(0);
+
+    QString server = servers.value(serverIndex);
+    abort();
+    emit connected(socket, server, dnsTime, connectTime);
+}
+
+/*!
+ * One of our attempts failed. Starts the next one at once instead of waiting for the stagger timer.
+ */
+void HostConnector::attemptFailed()
+{
+    QTcpSocket *socket = qobject_cast<QTcpSocket*>(sender());
+    if ((socket == NULL) || (! attempts.contains(socket)))
+        return;
+
+    QString reason = socket->errorString();
+    attempts.removeAll(socket);
+    disconnect(socket, 0, this, 0);
+    socket->deleteLater();
+
+    if (! pending.isEmpty()) {
+        startAttempt();
+        staggerTimer.start(); // Restart the interval from this attempt.
+        return;
+    }
+
+    if (attempts.isEmpty()) {
+        // Every address failed. The round-robin might have changed, so look it up again next time.
+        forget(host);
+        serverFailed(reason);
+    }
+}
+
+/*!
+ * The current attempt is taking long, start another one in parallel.
+ */
+void HostConnector::staggerTimeout()
+{
+    startAttempt();
+}
+
+/*!
+ * The current server didn't connect in time.
+ */
+void HostConnector::serverTimeout()
+{
+    if (lookupId != -1) {
+        QHostInfo::abortHostLookup(lookupId);
+        lookupId = -1;
+    }
+    serverFailed(tr("Connection attempt timed out"));
+}
+
+/*!
+ * \param reason Why we failed
+ *
+ * Reports the current server failed and moves on to the next one.
+ */
+void HostConnector::serverFailed(QString reason)
+{
+    serverTimer.stop();
+    emit failed(host, port, reason);
+    nextServer();
+}
+
+/*!
+ * Aborts and deletes all connection attempts in progress.
+ */
+void HostConnector::clearAttempts()
+{
+    QListIterator<QTcpSocket*> i(attempts);
+    while (i.hasNext()) {
+        QTcpSocket *socket = i.next();
+        disconnect(socket, 0, this, 0);
+        socket->abort();
+        socket->deleteLater();
+    }
+    attempts.clear();
+}
@@ -0,0 +1,111 @@
+/*
+ *   IdealIRC - Internet Relay Chat client
+ *   Copyright (C) 2014  Tom-Andre Barstad
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+
+/*! \class HostConnector
+ *  \brief Resolves and connects to an IRC server, racing its addresses and failing over to the next server.
+ *
+ * Give connectTo() a list of servers, the first one being the preferred. For each server the
+ * hostname is resolved (or taken from the DNS cache shared by all connections), and its
+ * addresses are tried Happy Eyeballs style: a new attempt starts every HC_STAGGER ms, or
+ * at once when an attempt fails, alternating between IPv6 and IPv4. The first socket to connect
+ * wins and the rest are aborted.\n
+ * If all addresses fail, or the server didn't connect within the timeout, the next server in the
+ * list is tried.\n
+ * A port starting with + (such as irc.example.org:+6697) means TLS. The socket handed over is then
+ * a QSslSocket, connected but not yet encrypted.
+ */
+
+#ifndef HOSTCONNECTOR_H
+#define HOSTCONNECTOR_H
+
+#include <QObject>
+#include <QStringList>
+#include <QHash>
+#include <QList>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QHostInfo>
+#include <QHostAddress>
+#include <QTcpSocket>
+#include <QSslSocket>
+
+#define HC_STAGGER 250 //!< Milliseconds between starting connection attempts to the addresses of one server.
+#define HC_DNS_TTL 300 //!< Seconds a DNS lookup is cached. QHostInfo doesn't tell us the real TTL.
+#define HC_DNS_MAX 64 //!< Max amount of hostnames in the DNS cache.
+
+/*!
+ * A cached DNS lookup.
+ */
+typedef struct T_HCDNSENTRY {
+    QList<QHostAddress> addresses; //!< A and AAAA results.
+    qint64 expires; //!< Seconds since epoch this entry is no longer valid.
+} hcdnsentry_t;
+
+class HostConnector : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit HostConnector(QObject *parent = 0);
+    void connectTo(QStringList serverList, int timeout);
+    void abort();
+    bool isRunning() { return running; } //!< \return true while we're trying to connect.
+    static void forget(QString hostname);
+
+private:
+    static QHash<QString,hcdnsentry_t> dnsCache; //!< Shared by all connections.\n Key: Hostname in lower case
+
+    bool running; //!< true while we're trying to connect.
+    QStringList servers; //!< Servers to try, "host:port" or "host:port|password".
+    int serverIndex; //!< Server we're trying now.
+    QString host; //!< Hostname of the server we're trying now.
+    quint16 port; //!< Port of the server we're trying now.
+    bool tls; //!< The server we're trying now uses TLS.
+    int lookupId; //!< ID of our running QHostInfo lookup, -1 if none.
+    QList<QHostAddress> pending; //!< Addresses not tried yet.
+    QList<QTcpSocket*> attempts; //!< Connection attempts in progress.
+    QTimer staggerTimer; //!< Starts the next attempt.
+    QTimer serverTimer; //!< Gives up on the current server.
+    QElapsedTimer clock; //!< Measures each phase.
+    qint64 dnsTime; //!< Milliseconds the DNS lookup took for the current server.
+
+    void nextServer();
+    void race(QList<QHostAddress> addresses);
+    void startAttempt();
+    void serverFailed(QString reason);
+    void clearAttempts();
+
+private slots:
+    void lookedUp(QHostInfo info);
+    void attemptConnected();
+    void attemptFailed();
+    void staggerTimeout();
+    void serverTimeout();
+
+signals:
+    void trying(QString host, int port);
+    void resolved(QString host, qint64 ms, bool cached);
+    void connected(QTcpSocket *socket, QString server, qint64 dnsMs, qint64 connectMs); //!< The socket is now owned by the receiver.
+    void failed(QString host, int port, QString reason);
+    void exhausted();
+};
+
+#endif // HOSTCONNECTOR_H
@@ -22,17 +22,21 @@
 #include <QDebug>
 #include <QDateTime>
 #include <QHashIterator>
+#include <QFile>
+#include <QTextStream>
+#include <QVector>
+#include <algorithm>
 
 #include "ial.h"
-#include "iconnection.h"
-#include "script/tscriptparent.h"
 
-IAL::IAL(IConnection *parent, QString *activeNickname, QList<char> *sortingRule, TScriptParent *sp) :
+IAL::IAL(QObject *parent, ICoreEvents *ev, QString *activeNickname, QList<char> *sortingRule) :
     QObject(parent),
     activeNick(activeNickname),
     sortrule(sortingRule),
-    scriptParent(sp),
-    connection(parent)
+    events(ev),
+    revision(0),
+    matchRevision(-1),
+    bansRevision(-1)
 {
     connect(&garbageTimer, SIGNAL(timeout()),
             this, SLOT(cleanGarbage()));
@@ -45,7 +49,16 @@ IAL::IAL(IConnection *parent, QString *activeNickname, QList<char> *sortingRule,
  */
 void IAL::reset()
 {
+    revision++;
+    // Keep the hosts for when we reconnect.
+    QHashIterator<QString,IALEntry_t*> i(entries);
+    while (i.hasNext()) {
+        i.next();
+        remember(i.key(), i.value());
+    }
+
     entries.clear();
+    bans.clear();
 }
 
 /*!
@@ -53,8 +66,20 @@ void IAL::reset()
  */
 void IAL::addNickname(QString nickname)
 {
-    if (! entries.contains(nickname))
-        entries.insert(nickname, new IALEntry_t);
+    revision++;
+    if (! entries.contains(nickname)) {
+        IALEntry_t *entry = new IALEntry_t();
+
+        // Seed with what we remember, until JOIN, WHO or USERHOST tells us the real one.
+        if (warm.contains(nickname)) {
+            const IALUser_t &w = warm[nickname];
+            entry->ident = w.ident;
+            entry->hostname = w.hostname;
+            entry->seeded = true;
+        }
+
+        entries.insert(nickname, entry);
+    }
 
     garbage.removeAll(nickname);
 }
@@ -64,6 +89,7 @@ void IAL::addNickname(QString nickname)
  */
 void IAL::delNickname(QString nickname)
 {
+    revision++;
     IALEntry_t *entry = getEntry(nickname);
     if (entry == NULL)
         return;
@@ -96,23 +122,26 @@ bool IAL::hasNickname(QString nickname)
  */
 bool IAL::setHostname(QString nickname, QString hostname)
 {
+    revision++;
     IALEntry_t *entry = getEntry(nickname);
     if (entry == NULL)
         return false;
 
     QString entryhost = entry->hostname;
+    bool confirmed = entry->seeded; // The remembered hostname is now confirmed, postponed bans can go.
 
     entry->hostname = hostname;
+    entry->seeded = false;
 
-    if (entryhost != hostname) { // Handle events on host change or setting new
-        scriptParent->runevent(te_ialhostget, QStringList()<<nickname<<hostname);
+    if ((entryhost != hostname) || confirmed) { // Handle events on host change or setting new
+        events->coreEvent(te_ialhostget, QStringList()<<nickname<<hostname);
 
         for (int i = 0; i <= banSet.count()-1; i++) {
             QStringList param = banSet[i].split(' ');
             if (param[1].toUpper() == nickname.toUpper()) {
-                connection->sockwrite(QString("MODE %1 +b %2")
-                                      .arg(param[0])
-                                      .arg(hostname));
+                events->sendLine(QString("MODE %1 +b %2")
+                                   .arg(param[0])
+                                   .arg(hostname));
             }
         }
     }
@@ -125,6 +154,7 @@ bool IAL::setHostname(QString nickname, QString hostname)
  */
 bool IAL::setIdent(QString nickname, QString ident)
 {
+    revision++;
     IALEntry_t *entry = getEntry(nickname);
     if (entry == NULL)
         return false;
@@ -139,6 +169,7 @@ bool IAL::setIdent(QString nickname, QString ident)
  */
 bool IAL::setNickname(QString nickname, QString newNickname)
 {
+    revision++;
     IALEntry_t *entry = getEntry(nickname);
     if (entry == NULL)
         return false;
@@ -154,6 +185,7 @@ bool IAL::setNickname(QString nickname, QString newNickname)
  */
 bool IAL::addChannel(QString nickname, QString channel)
 {
+    revision++;
     IALEntry_t *entry = getEntry(nickname);
     if (entry == NULL)
         return false;
@@ -175,6 +207,7 @@ bool IAL::addChannel(QString nickname, QString channel)
  */
 bool IAL::delChannel(QString nickname, QString channel)
 {
+    revision++;
     IALEntry_t *entry = getEntry(nickname);
     if (entry == NULL)
         return false;
@@ -186,6 +219,10 @@ bool IAL::delChannel(QString nickname, QString channel)
     entry->channels.removeAll(c);
     delete c;
 
+    // We left, the ban list we know of is no longer maintained.
+    if (nickname == *activeNick)
+        bans.remove(channel.toUpper());
+
     // No channels left, mark for deletion.
     if (entry->channels.isEmpty())
         delNickname(nickname); // If it is us, delNickname() ignores it.
@@ -193,6 +230,38 @@ bool IAL::delChannel(QString nickname, QString channel)
     return true;
 }
 
+/*!
+ * \param channel Channel name
+ *
+ * Removes the channel from all nicknames, as if everyone parted it.\n
+ * After a reconnect we keep the old members as stale until fresh NAMES arrives, which starts with this.
+ */
+void IAL::dropChannel(QString channel)
+{
+    revision++;
+    QString chanUp = channel.toUpper();
+    QHash<QString,QString> found; // Key: nickname, value: channel name as stored.
+
+    QHashIterator<QString,IALEntry_t*> i(entries);
+    while (i.hasNext()) {
+        i.next();
+        QListIterator<IALChannel_t*> c(i.value()->channels);
+        while (c.hasNext()) {
+            IALChannel_t *chan = c.next();
+            if (chan->name.toUpper() == chanUp) {
+                found.insert(i.key(), chan->name);
+                break;
+            }
+        }
+    }
+
+    QHashIterator<QString,QString> f(found);
+    while (f.hasNext()) {
+        f.next();
+        delChannel(f.key(), f.value());
+    }
+}
+
 /*!
  * Adds a mode (@, +, etc) on the nickname in a given channel.
  * \return false if nickname doesn't exist or isn't on that channel.
@@ -325,6 +394,66 @@ QString IAL::getHost(QString nickname)
     return entry->hostname;
 }
 
+/*!
+ * \param nickname The nickname.
+ * \param away true if away
+ *
+ * Sets the away state, from away-notify.
+ * \return false if nickname doesn't exist.
+ */
+bool IAL::setAway(QString nickname, bool away)
+{
+    IALEntry_t *entry = getEntry(nickname);
+    if (entry == NULL)
+        return false;
+
+    entry->away = away;
+    return true;
+}
+
+/*!
+ * \return true if the nickname is known to be away.
+ */
+bool IAL::isAway(QString nickname)
+{
+    IALEntry_t *entry = getEntry(nickname);
+    if (entry == NULL)
+        return false;
+
+    return entry->away;
+}
+
+/*!
+ * \param nickname The nickname.
+ * \param account Services account, "*" or empty if not logged in.
+ *
+ * Sets the services account, from extended-join.
+ * \return false if nickname doesn't exist.
+ */
+bool IAL::setAccount(QString nickname, QString account)
+{
+    IALEntry_t *entry = getEntry(nickname);
+    if (entry == NULL)
+        return false;
+
+    if (account == "*")
+        account.clear();
+    entry->account = account;
+    return true;
+}
+
+/*!
+ * \return Services account of the nickname, empty if unknown or not logged in.
+ */
+QString IAL::getAccount(QString nickname)
+{
+    IALEntry_t *entry = getEntry(nickname);
+    if (entry == NULL)
+        return "";
+
+    return entry->account;
+}
+
 /*!
  * \param nickname The nickname.
  * \param channel The channel.
@@ -420,13 +549,17 @@ int IAL::userCount(QString channel)
  */
 void IAL::setChannelBan(QString channel, QString nickname)
 {
-    QString hostname = getHost(nickname);
+    // Never ban a remembered hostname, the nickname might belong to someone else now.
+    IALEntry_t *entry = getEntry(nickname);
+    QString hostname;
+    if ((entry != NULL) && (! entry->seeded))
+        hostname = entry->hostname;
 
     if (! hostname.isEmpty()) {
-        connection->sockwrite( QString("MODE %1 +b %2")
-                                 .arg(channel)
-                                 .arg(hostname)
-                              );
+        events->sendLine( QString("MODE %1 +b %2")
+                              .arg(channel)
+                              .arg(hostname)
+                           );
 
         return;
     }
@@ -435,7 +568,378 @@ void IAL::setChannelBan(QString channel, QString nickname)
               .arg(channel)
               .arg(nickname);
 
-    connection->sockwrite(QString("USERHOST %1").arg(nickname));
+    events->sendLine(QString("USERHOST %1").arg(nickname));
+}
+
+/*!
+ * \param mask Hostmask, nick!ident@host
+ *
+ * Splits the mask in its three parts and compiles each of them.\n
+ * Missing parts are treated as *, so "nick" becomes nick!*@* and "*@host" becomes *!*@host.
+ * \return Compiled mask
+ */
+IALMask_t IAL::compileMask(QString mask)
+{
+    QString n = "*";
+    QString u = "*";
+    QString h = "*";
+
+    int at = mask.lastIndexOf('@');
+    QString nu = mask;
+    if (at > -1) {
+        h = mask.mid(at+1);
+        nu = mask.left(at);
+    }
+
+    int ex = nu.indexOf('!');
+    if (ex > -1) {
+        n = nu.left(ex);
+        u = nu.mid(ex+1);
+    }
+    else if (at > -1)
+        u = nu;
+    else
+        n = nu;
+
+    IALMask_t m;
+    m.mask = mask;
+    m.nick = WildcardMatcher::cached(n);
+    m.ident = WildcardMatcher::cached(u);
+    m.host = WildcardMatcher::cached(h);
+    return m;
+}
+
+/*!
+ * \param mask Compiled mask
+ * \param nickname The nickname
+ * \param entry IAL entry of nickname, may be NULL if it's unknown.
+ * \return true if nickname, with the ident and hostname we know of, matches the mask.
+ */
+bool IAL::maskMatches(const IALMask_t &mask, const QString &nickname, IALEntry_t *entry)
+{
+    if (! mask.nick.match(nickname))
+        return false;
+
+    QString ident;
+    QString host;
+    if (entry != NULL) {
+        ident = entry->ident;
+        host = entry->hostname;
+    }
+
+    return mask.ident.match(ident) && mask.host.match(host);
+}
+
+/*!
+ * \param mask Compiled mask
+ * \param nickname The nickname
+ * \return true if nickname matches the mask.
+ */
+bool IAL::maskMatches(const IALMask_t &mask, QString nickname)
+{
+    return maskMatches(mask, nickname, getEntry(nickname));
+}
+
+/*!
+ * \param channel The channel
+ * \param mask Hostmask, nick!ident@host
+ *
+ * Finds every nickname in the channel that matches the mask, using the ident and hostname IAL knows.\n
+ * Users with unknown hostname only match if the host part of the mask is *.
+ * \return List of nicknames, empty if none.
+ */
+QStringList IAL::matchMask(QString channel, QString mask)
+{
+    // Scripts walk the result with $ialmatch(#chan, mask, N), so keep it until the IAL changes.
+    QString key = channel.toUpper() + ' ' + mask;
+    if ((matchRevision == revision) && (matchKey == key))
+        return matchResult;
+
+    IALMask_t m = compileMask(mask);
+    QStringList result;
+
+    QHashIterator<QString,IALEntry_t*> i(entries);
+    while (i.hasNext()) {
+        i.next();
+        IALEntry_t *entry = i.value();
+
+        bool onChannel = false;
+        QListIterator<IALChannel_t*> ic(entry->channels);
+        while (ic.hasNext()) {
+            if (ic.next()->name.compare(channel, Qt::CaseInsensitive) == 0) {
+                onChannel = true;
+                break;
+            }
+        }
+
+        if (onChannel && maskMatches(m, i.key(), entry))
+            result << i.key();
+    }
+
+    matchRevision = revision;
+    matchKey = key;
+    matchResult = result;
+    return result;
+}
+
+/*!
+ * \param nickname The nickname
+ * \param channel The channel
+ *
+ * Uses the ban list received from the IRC server (RPL_BANLIST) and ban changes seen since.
+ * \return List of ban masks in the channel that matches nickname, empty if none.
+ */
+QStringList IAL::bansAffecting(QString nickname, QString channel)
+{
+    QString key = channel.toUpper() + ' ' + nickname;
+    if ((bansRevision == revision) && (bansKey == key))
+        return bansResult;
+
+    QStringList result;
+    IALEntry_t *entry = getEntry(nickname);
+
+    QListIterator<IALMask_t> i(bans.value(channel.toUpper()));
+    while (i.hasNext()) {
+        const IALMask_t &m = i.next();
+        if (maskMatches(m, nickname, entry))
+            result << m.mask;
+    }
+
+    bansRevision = revision;
+    bansKey = key;
+    bansResult = result;
+    return result;
+}
+
+/*!
+ * \param channel The channel
+ * \param masks All ban masks of the channel
+ *
+ * Replaces the known ban list of the channel.
+ */
+void IAL::setBanList(QString channel, QStringList masks)
+{
+    revision++;
+    QList<IALMask_t> list;
+    QStringListIterator i(masks);
+    while (i.hasNext())
+        list << compileMask(i.next());
+
+    bans.insert(channel.toUpper(), list);
+}
+
+/*!
+ * \param channel The channel
+ * \param mask Ban mask
+ *
+ * Adds a ban to the known ban list of the channel.
+ */
+void IAL::addBan(QString channel, QString mask)
+{
+    revision++;
+    QList<IALMask_t> &list = bans[channel.toUpper()];
+    for (int i = 0; i < list.count(); ++i)
+        if (list[i].mask == mask)
+            return;
+
+    list << compileMask(mask);
+}
+
+/*!
+ * \param channel The channel
+ * \param mask Ban mask
+ *
+ * Removes a ban from the known ban list of the channel.
+ */
+void IAL::delBan(QString channel, QString mask)
+{
+    revision++;
+    QHash<QString,QList<IALMask_t> >::iterator it = bans.find(channel.toUpper());
+    if (it == bans.end())
+        return;
+
+    QList<IALMask_t> &list = it.value();
+    for (int i = 0; i < list.count(); ++i) {
+        if (list[i].mask == mask) {
+            list.removeAt(i);
+            return;
+        }
+    }
+}
+
+/*!
+ * \param users List of nicknames with ident and hostname
+ *
+ * Updates many nicknames in one go, used when the WHO replies for a channel are received.\n
+ * Nicknames not in the IAL are ignored.
+ */
+void IAL::setUsers(const QList<IALUser_t> &users)
+{
+    revision++;
+    QListIterator<IALUser_t> i(users);
+    while (i.hasNext()) {
+        const IALUser_t &u = i.next();
+        IALEntry_t *entry = getEntry(u.nickname);
+        if (entry == NULL)
+            continue;
+
+        entry->ident = u.ident;
+        entry->away = u.away;
+        if (! u.account.isEmpty())
+            entry->account = u.account;
+        if ((entry->hostname != u.hostname) || entry->seeded)
+            setHostname(u.nickname, u.hostname); // Runs events and postponed bans.
+    }
+}
+
+/*!
+ * \param nickname The nickname
+ * \param entry IAL entry of nickname
+ *
+ * Keeps ident and hostname of an entry that's about to be removed from the IAL.
+ */
+void IAL::remember(QString nickname, IALEntry_t *entry)
+{
+    if ((entry == NULL) || (entry->hostname.isEmpty()))
+        return;
+
+    if (entry->seeded)
+        return; // Never confirmed, warm still has it with the time we really saw it.
+
+    if ((warm.count() >= IAL_WARM_MAX) && (! warm.contains(nickname)))
+        trimWarm();
+
+    IALUser_t u;
+    u.nickname = nickname;
+    u.ident = entry->ident;
+    u.hostname = entry->hostname;
+    u.away = false;
+    u.seen = QDateTime::currentMSecsSinceEpoch() / 1000;
+    warm.insert(nickname, u);
+}
+
+/*!
+ * Makes room in IAL::warm. Hosts older than IAL_SNAPSHOT_MAXAGE are dropped, and if that's not
+ * enough, the oldest tenth of them.
+ */
+void IAL::trimWarm()
+{
+    qint64 now = QDateTime::currentMSecsSinceEpoch() / 1000;
+
+    QMutableHashIterator<QString,IALUser_t> i(warm);
+    while (i.hasNext()) {
+        if ((now - i.next().value().seen) > IAL_SNAPSHOT_MAXAGE)
+            i.remove();
+    }
+
+    if (warm.count() < IAL_WARM_MAX)
+        return;
+
+    // Find the cut-off that leaves 90% of the cap, newest first.
+    QVector<qint64> seen;
+    seen.reserve(warm.count());
+    QHashIterator<QString,IALUser_t> si(warm);
+    while (si.hasNext())
+        seen << si.next().value().seen;
+
+    int drop = warm.count() - (IAL_WARM_MAX - IAL_WARM_MAX / 10);
+    std::nth_element(seen.begin(), seen.begin() + drop, seen.end());
+    qint64 cutoff = seen[drop];
+
+    i.toFront();
+    while (i.hasNext() && (drop > 0)) {
+        if (i.next().value().seen <= cutoff) {
+            i.remove();
+            --drop;
+        }
+    }
+}
+
+/*!
+ * \param filename File to write
+ *
+ * Writes every known hostname to file, one "nickname ident hostname seen" per line.\n
+ * Loaded with loadSnapshot() when we connect again, so we don't need to ask the server for them.
+ * \return false if file couldn't be written.
+ */
+bool IAL::saveSnapshot(QString filename)
+{
+    QHash<QString,IALUser_t> all = warm;
+    qint64 now = QDateTime::currentMSecsSinceEpoch() / 1000;
+
+    QHashIterator<QString,IALEntry_t*> i(entries);
+    while (i.hasNext()) {
+        i.next();
+        IALEntry_t *entry = i.value();
+        if (entry->hostname.isEmpty() || entry->seeded)
+            continue; // Seeded ones are in warm already, with the time we really saw them.
+
+        IALUser_t u;
+        u.nickname = i.key();
+        u.ident = entry->ident;
+        u.hostname = entry->hostname;
+        u.seen = now;
+        all.insert(u.nickname, u);
+    }
+
+    QFile f(filename);
+    if (! f.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+        return false;
+
+    QTextStream out(&f);
+    QHashIterator<QString,IALUser_t> wi(all);
+    while (wi.hasNext()) {
+        const IALUser_t &u = wi.next().value();
+        QString ident = u.ident.isEmpty() ? "*" : u.ident;
+        out << u.nickname << ' ' << ident << ' ' << u.hostname << ' ' << u.seen << '\n';
+    }
+
+    f.close();
+    return true;
+}
+
+/*!
+ * \param filename File to read
+ *
+ * Reads hostnames written by saveSnapshot(). Hosts older than IAL_SNAPSHOT_MAXAGE are skipped,
+ * and hosts we already know of are kept.
+ * \return false if file couldn't be read.
+ */
+bool IAL::loadSnapshot(QString filename)
+{
+    QFile f(filename);
+    if (! f.open(QIODevice::ReadOnly | QIODevice::Text))
+        return false;
+
+    qint64 now = QDateTime::currentMSecsSinceEpoch() / 1000;
+    QTextStream in(&f);
+    while (! in.atEnd()) {
+        QStringList item = in.readLine().split(' ');
+        if (item.count() < 4)
+            continue;
+
+        IALUser_t u;
+        u.nickname = item[0];
+        u.ident = (item[1] == "*") ? QString() : item[1];
+        u.hostname = item[2];
+        u.seen = item[3].toLongLong();
+
+        if ((now - u.seen) > IAL_SNAPSHOT_MAXAGE)
+            continue;
+
+        if (warm.contains(u.nickname))
+            continue;
+
+        u.away = false;
+        warm.insert(u.nickname, u);
+    }
+
+    f.close();
+
+    if (warm.count() >= IAL_WARM_MAX)
+        trimWarm(); // Keeps the newest.
+
+    return true;
 }
 
 /*!
@@ -532,6 +1036,7 @@ bool IAL::sortLargerThan(const QString s1, const QString s2)
  */
 void IAL::cleanGarbage()
 {
+    revision++;
     qint64 current = QDateTime::currentMSecsSinceEpoch() / 1000;
 
     for (int i = 0; i <= garbage.size()-1; i++) {
@@ -543,6 +1048,8 @@ void IAL::cleanGarbage()
         if  ((current-entry->age) < 300)
             continue; // Too "young"
 
+        remember(name, entry);
         entries.remove(name);
+        delete entry;
     }
 }
@@ -37,9 +37,11 @@
 #include <QHash>
 #include <QStringList>
 #include <QTimer>
+#include "wildcardmatcher.h"
+#include "icoreevents.h"
 
-class IConnection;
-class TScriptParent;
+#define IAL_SNAPSHOT_MAXAGE 604800 //!< Seconds. Hosts older than this in a snapshot are not loaded (one week).
+#define IAL_WARM_MAX 20000 //!< Max amount of hosts remembered for nicknames no longer in the IAL.
 
 typedef struct T_IALCHANNEL {
     QString name;
@@ -52,14 +54,35 @@ typedef struct T_IALENTRY {
     QString hostname;
     QList<IALChannel_t*> channels;
     qint64 age;
+    bool away; // From away-notify, or WHO replies.
+    QString account; // Services account, from extended-join or WHOX. Empty if unknown or not logged in.
+    bool seeded; // Ident and hostname are remembered from before (see IAL::warm), not yet confirmed by the server.
 } IALEntry_t;
 
+typedef struct T_IALUSER {
+    // Used for bulk updates (WHO replies) and for remembering hosts of nicknames no longer in the IAL.
+    QString nickname;
+    QString ident;
+    QString hostname;
+    QString account; // From WHOX, empty if not logged in or not asked for.
+    bool away; // From the WHO flags.
+    qint64 seen; // When we last knew this, seconds since epoch.
+} IALUser_t;
+
+typedef struct T_IALMASK {
+    // A nick!ident@host mask, each part compiled on its own so matching needs no string building.
+    QString mask;
+    WildcardMatcher nick;
+    WildcardMatcher ident;
+    WildcardMatcher host;
+} IALMask_t;
+
 class IAL : public QObject
 {
     Q_OBJECT
 
 public:
-    explicit IAL(IConnection *parent, QString *activeNickname, QList<char> *sortingRule, TScriptParent *sp);
+    explicit IAL(QObject *parent, ICoreEvents *ev, QString *activeNickname, QList<char> *sortingRule);
     void reset(); // When socket disconnects, run this.
     void addNickname(QString nickname);
     void delNickname(QString nickname);
@@ -69,6 +92,7 @@ public:
     bool setNickname(QString nickname, QString newNickname);
     bool addChannel(QString nickname, QString channel);
     bool delChannel(QString nickname, QString channel); // If it got all channels removed, nickname will also be removed from entries.
+    void dropChannel(QString channel); // Removes the channel from everyone, used before refilling a stale channel.
     bool addMode(QString nickname, QString channel, char mode); // Set modes like @ + ... not o v ...
     bool delMode(QString nickname, QString channel, char mode); // Unset modes like @ + ... not o v ...
     bool resetModes(QString nickname, QString channel);
@@ -78,6 +102,10 @@ public:
     QStringList* getChannels(QString nickname);
     QString getIdent(QString nickname);
     QString getHost(QString nickname);
+    bool setAway(QString nickname, bool away);
+    bool isAway(QString nickname);
+    bool setAccount(QString nickname, QString account);
+    QString getAccount(QString nickname);
     QList<char> getModeChars(QString nickname, QString channel, bool cs = true);
 
     bool sharesChannel(QString nickname, QString channel); // checks if nickname shares the channel with us (they're also on there)
@@ -89,6 +117,17 @@ public:
     int userCount(QString channel);
 
     void setChannelBan(QString channel, QString nickname);
+    void setUsers(const QList<IALUser_t> &users); // Bulk update of ident and hostname, from WHO replies.
+    bool saveSnapshot(QString filename);
+    bool loadSnapshot(QString filename);
+
+    static IALMask_t compileMask(QString mask);
+    bool maskMatches(const IALMask_t &mask, QString nickname);
+    QStringList matchMask(QString channel, QString mask); // Nicknames in channel matching the mask.
+    QStringList bansAffecting(QString nickname, QString channel); // Known bans in channel matching the nickname.
+    void setBanList(QString channel, QStringList masks);
+    void addBan(QString channel, QString mask);
+    void delBan(QString channel, QString mask);
 
 private:
     QString *activeNick; //!< Our current nickname of this connection.
@@ -96,13 +135,24 @@ private:
     QStringList garbage; //!< List of nicknames considered garbage.
     QTimer garbageTimer; //!< Runs every 1 minute to clean the garbage.
     QStringList banSet; //!< List of bans that's postponed. See setChannelBan().
+    QHash<QString,IALUser_t> warm; //!< Hosts of nicknames we've seen before, from snapshots and garbage collected entries. Only used to seed new entries.\n Key: nickname
+    void remember(QString nickname, IALEntry_t *entry);
+    void trimWarm();
+    QHash<QString,QList<IALMask_t> > bans; //!< Known bans per channel, compiled.\n Key: channel in upper case\n Value: ban masks
     QList<char> *sortrule; //!< Large list of characters allowed in nicknames, including channel modes such as @ + etc on top. Used for sorting.
-    TScriptParent *scriptParent; //!< Pointer to the script parent.
-    IConnection *connection; //!< The IRC connection this IAL is bound to.
+    ICoreEvents *events; //!< Where we write to the server and fire script events, usually the IConnection we belong to.
+    qint64 revision; //!< Bumped on every change to nicknames, hosts, channels or bans.
+    qint64 matchRevision; //!< IAL::revision the matchMask() result was made at.
+    QString matchKey; //!< Channel and mask of the cached matchMask() result.
+    QStringList matchResult; //!< Last matchMask() result.
+    qint64 bansRevision; //!< IAL::revision the bansAffecting() result was made at.
+    QString bansKey; //!< Channel and nickname of the cached bansAffecting() result.
+    QStringList bansResult; //!< Last bansAffecting() result.
     IALEntry_t* getEntry(QString nickname, bool cs = true);
     IALChannel_t* getChannel(QString nickname, QString channel, bool cs = true);
     void sortList(QList<char> *lst);
     bool sortLargerThan(const QString s1, const QString s2);
+    bool maskMatches(const IALMask_t &mask, const QString &nickname, IALEntry_t *entry);
 
 private slots:
     void cleanGarbage();
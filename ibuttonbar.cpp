@@ -19,9 +19,25 @@
  */
 
 #include <QListIterator>
+#include <QSetIterator>
 #include "ibuttonbar.h"
 #include "constants.h"
 
+/*!
+ * \param name Base name of the icon files, e.g. "channel"
+ *
+ * Loads the icon set for one window type from the resources.
+ * \return button_icons_t
+ */
+static button_icons_t loadIcons(QString name)
+{
+    button_icons_t ico;
+    ico.noact = QIcon(QString(":/window/gfx/%1_noact.png").arg(name));
+    ico.act = QIcon(QString(":/window/gfx/%1.png").arg(name));
+    ico.msg = QIcon(QString(":/window/gfx/%1_act.png").arg(name));
+    return ico;
+}
+
 IButtonBar::IButtonBar(QObject *parent) :
     QObject(parent),
     flashtoggle(false),
@@ -34,6 +50,15 @@ IButtonBar::IButtonBar(QObject *parent) :
     toolbar.setIconSize( QSize(16, 16) );
     toolbar.setContextMenuPolicy(Qt::CustomContextMenu);
 
+    QIcon custom(":/window/gfx/custom.png");
+    defaultIcons.noact = custom;
+    defaultIcons.act = custom;
+    defaultIcons.msg = custom;
+    icons.insert(WT_CHANNEL, loadIcons("channel"));
+    icons.insert(WT_PRIVMSG, loadIcons("query"));
+    icons.insert(WT_STATUS, loadIcons("status"));
+
+    // Started by highlight() when a window is set to HL_HIGHLIGHT.
     flasher.setInterval(500);
     connect(&flasher, SIGNAL(timeout()),
             this, SLOT(onFlasher()));
@@ -54,7 +79,6 @@ IButtonBar::IButtonBar(QObject *parent) :
     connect(&actionClose, SIGNAL(triggered()),
             this, SLOT(actionCloseTrigger()));
 
-    flasher.start();
     ConnectSignals;
 }
 
@@ -74,31 +98,20 @@ void IButtonBar::addButton(int group, int wid, int wtype, QString name)
     b.group = group;
     b.wid = wid;
     b.wtype = wtype;
+    b.highlight = HL_NONE;
 
     b.button->setObjectName(name);
-
-    action_data_t ad = {wid, HL_NONE};
-
-    setActionData(b.button, ad);
-
-    // Add icon
-    QString ico = ":/window/gfx/custom.png"; // Default to this.
-    if (wtype == WT_PRIVMSG)
-      ico = ":/window/gfx/query_noact.png";
-    if (wtype == WT_CHANNEL)
-      ico = ":/window/gfx/channel_noact.png";
-    if (wtype == WT_STATUS)
-      ico = ":/window/gfx/status_noact.png";
-    b.button->setIcon(QIcon(ico));
+    b.button->setData(wid);
+    b.button->setIcon(getIcon(wtype, HL_NONE));
     b.button->setCheckable(true);
 
-    buttons << b;
+    buttons.insert(wid, b);
 
     sigmap.setMapping(b.button, wid);
     connect(b.button, SIGNAL(toggled(bool)),
             &sigmap, SLOT(map()));
 
-    rebuild();
+    insertButton(b);
 }
 
 /*!
@@ -109,21 +122,18 @@ void IButtonBar::addButton(int group, int wid, int wtype, QString name)
 void IButtonBar::delButton(int wid)
 {
     // Deletes a button
-    int idx = -1;
-    QListIterator<button_t> i(buttons);
-    while (i.hasNext()) {
-        button_t b = i.next();
-        ++idx;
+    if (! buttons.contains(wid))
+        return;
 
-        if (wid != b.wid)
-            continue;
+    button_t b = buttons.take(wid);
+    flashing.remove(wid);
+    if (flashing.isEmpty())
+        flasher.stop();
 
-        toolbar.removeAction(b.button);
-        delete b.button;
-        buttons.removeAt(idx);
+    toolbar.removeAction(b.button);
+    delete b.button;
 
-        return;
-    }
+    dropGroupIfEmpty(groupOf(b));
 }
 
 /*!
@@ -135,36 +145,30 @@ void IButtonBar::delButton(int wid)
 void IButtonBar::delGroup(int group)
 {
     // Delete all buttons from group
-    int idx = -1;
-    QList<int> idxList;
-    {
-        QListIterator<button_t> i(buttons);
-        while (i.hasNext()) {
-            button_t b = i.next();
-            ++idx;
-
-            if ((b.wtype == WT_STATUS) && (b.wid == group)) {
-                toolbar.removeAction(b.button);
-                delete b.button;
-                idxList << idx; // mark for deletion
-                continue;
-            }
-
-            if (group != b.group)
-                continue;
-
-            toolbar.removeAction(b.button);
-            delete b.button;
-            idxList << idx; // mark for deletion
-        }
-    }
-
-    // delete marked items
-    QListIterator<int> i(idxList);
+    QList<int> groupList; // groups that may have become empty
+    QMutableHashIterator<int,button_t> i(buttons);
     while (i.hasNext()) {
-        int index = i.next();
-        buttons.removeAt(index);
+        i.next();
+        button_t b = i.value();
+
+        if ((b.group != group) && ((b.wtype != WT_STATUS) || (b.wid != group)))
+            continue;
+
+        if (! groupList.contains(groupOf(b)))
+            groupList << groupOf(b);
+
+        flashing.remove(b.wid);
+        toolbar.removeAction(b.button);
+        delete b.button;
+        i.remove();
     }
+
+    if (flashing.isEmpty())
+        flasher.stop();
+
+    QListIterator<int> gi(groupList);
+    while (gi.hasNext())
+        dropGroupIfEmpty(gi.next());
 }
 
 /*!
@@ -216,7 +220,8 @@ void IButtonBar::setActive(int wid)
  * \param type Highlight Type. See constants.h for HL_*
  *
  * Sets a highlight on specified button.\n
- * This can be for small activity, messages or someone saying our nickname.
+ * This can be for small activity, messages or someone saying our nickname.\n
+ * Windows set to HL_HIGHLIGHT are kept in the flashing set, the flasher timer runs only while that set isn't empty.
  */
 void IButtonBar::highlight(int wid, int type)
 {
@@ -227,93 +232,25 @@ void IButtonBar::highlight(int wid, int type)
         HL_HIGHLIGHT    Highlighted text (MSG icon for window, flashing)
     */
 
-    QAction *a = getAction(wid);
-    if (a == nullptr)
+    QHash<int,button_t>::iterator i = buttons.find(wid);
+    if (i == buttons.end())
         return;
 
-    action_data_t ad = getActionData(a);
-
-    // clang is being good:
-    if (activewid == wid) {
-        ad.wid = wid;
-        ad.highlight = HL_NONE;
-    }
-    else {
-        ad.wid = wid;
-        ad.highlight = type;
-    }
-
-    /* clang is being bad:
     if (activewid == wid)
-        ad = {wid, HL_NONE};
-    else
-        ad = {wid, type};
-        */
-    setActionData(a, ad);
-
-    int wtype = getWtype(wid);
-    if (wtype == WT_CHANNEL) {
-        switch (type) {
-
-            case HL_ACTIVITY:
-                a->setIcon( QIcon(":/window/gfx/channel.png") );
-                break;
-
-            case HL_MSG:
-                a->setIcon( QIcon(":/window/gfx/channel_act.png") );
-                break;
-
-            case HL_HIGHLIGHT:
-                a->setIcon( QIcon(":/window/gfx/channel_act.png") );
-                break;
-
-            default: // covers HL_NONE
-                a->setIcon( QIcon(":/window/gfx/channel_noact.png") );
-                break;
-        }
-    }
-
-    if (wtype == WT_PRIVMSG) {
-        switch (type) {
-
-            case HL_ACTIVITY:
-                a->setIcon( QIcon(":/window/gfx/query.png") );
-                break;
+        type = HL_NONE;
 
-            case HL_MSG:
-                a->setIcon( QIcon(":/window/gfx/query_act.png") );
-                break;
+    button_t &b = i.value();
+    b.highlight = type;
 
-            case HL_HIGHLIGHT:
-                a->setIcon( QIcon(":/window/gfx/query_act.png") );
-                break;
-
-            default: // covers HL_NONE
-                a->setIcon( QIcon(":/window/gfx/query_noact.png") );
-                break;
-        }
+    if (type == HL_HIGHLIGHT) {
+        flashing.insert(wid);
+        if (! flasher.isActive())
+            flasher.start();
     }
+    else if (flashing.remove(wid) && flashing.isEmpty())
+        flasher.stop();
 
-    if (wtype == WT_STATUS) {
-        switch (type) {
-
-            case HL_ACTIVITY:
-                a->setIcon( QIcon(":/window/gfx/status.png") );
-                break;
-
-            case HL_MSG:
-                a->setIcon( QIcon(":/window/gfx/status_act.png") );
-                break;
-
-            case HL_HIGHLIGHT:
-                a->setIcon( QIcon(":/window/gfx/status_act.png") );
-                break;
-
-            default: // covers HL_NONE
-                a->setIcon( QIcon(":/window/gfx/status_noact.png") );
-                break;
-        }
-    }
+    b.button->setIcon( getIcon(b.wtype, type) );
 }
 
 /*!
@@ -325,102 +262,105 @@ void IButtonBar::highlight(int wid, int type)
  */
 int IButtonBar::getWtype(int wid)
 {
-    QListIterator<button_t> i(buttons);
-    while (i.hasNext()) {
-        button_t b = i.next();
-        if (b.wid != wid)
-            continue;
+    QHash<int,button_t>::const_iterator i = buttons.constFind(wid);
+    if (i == buttons.constEnd())
+        return WT_NOTHING;
 
-        return b.wtype;
-    }
-
-    return WT_NOTHING;
+    return i.value().wtype;
 }
 
 /*!
- * \param a Button pointer
+ * \param b Button
  *
- * Returns the custom data set for specified button.\n
- * \return action_data_t
+ * Status windows are stored in group 0, but are shown as the first button of their own group.
+ * \return Group ID the button is shown in on the toolbar.
  */
-action_data_t IButtonBar::getActionData(QAction *a)
+int IButtonBar::groupOf(const button_t &b)
 {
-    QByteArray data = a->data().toByteArray();
-    action_data_t ad;
-    memcpy((char*)&ad, data.data(), sizeof(action_data_t));
-    return ad;
+    if (b.wtype == WT_STATUS)
+        return b.wid;
+    else
+        return b.group;
 }
 
 /*!
- * \param a Button pointer
- * \param ad Data
+ * \param b Button
  *
- * Sets custom data for specified button.
+ * Places the button on the toolbar at the end of its group.\n
+ * If the group is new, it's appended to the toolbar behind a separator.
  */
-void IButtonBar::setActionData(QAction *a, action_data_t ad)
+void IButtonBar::insertButton(const button_t &b)
 {
-    char data[sizeof(action_data_t)];
-    memcpy(data, (char*)&ad, sizeof(action_data_t));
-
-    QByteArray ba;
-    ba.insert(0, data, sizeof(action_data_t));
+    int group = groupOf(b);
+    int idx = groups.indexOf(group);
+
+    if (idx == -1) {
+        groups << group;
+        separators.insert(group, toolbar.addSeparator());
+        toolbar.addAction(b.button);
+        updateSeparators();
+        return;
+    }
 
-    a->setData(ba);
+    if (idx+1 < groups.count())
+        toolbar.insertAction(separators.value(groups.at(idx+1)), b.button);
+    else
+        toolbar.addAction(b.button);
 }
 
 /*!
- * Resets and rebuilds the entire button bar.\n
- * Loops through the groups, gathers the buttons and sorts them.
+ * \param group Group ID
+ *
+ * Removes the group and its separator if there's no buttons left in it.
  */
-void IButtonBar::rebuild()
-{ // todo: This function should be rewritten
-
-    // Rebuild buttons on toolbar
-
-    // Remove all actions
-    {
-        QListIterator<QAction*> i(toolbar.actions());
-        while (i.hasNext()) {
-            QAction *a = i.next();
-            toolbar.removeAction(a);
-        }
+void IButtonBar::dropGroupIfEmpty(int group)
+{
+    QHashIterator<int,button_t> i(buttons);
+    while (i.hasNext()) {
+        i.next();
+        if (groupOf(i.value()) == group)
+            return;
     }
 
-    // Find all group numbers
-    QList<int> group;
-    {
-        QListIterator<button_t> i(buttons);
-        while (i.hasNext()) {
-            button_t b = i.next();
+    groups.removeAll(group);
+    delete separators.take(group);
+    updateSeparators();
+}
 
-            if (! group.contains(b.group))
-                group << b.group;
-        }
+/*!
+ * Hides the separator in front of the first group, shows the others.
+ */
+void IButtonBar::updateSeparators()
+{
+    for (int i = 0; i < groups.count(); ++i) {
+        QAction *sep = separators.value(groups.at(i));
+        if (sep != nullptr)
+            sep->setVisible(i > 0);
     }
+}
 
-    // Get all buttons sorted by groups
-    QListIterator<int> gi(group);
-    while (gi.hasNext()) {
-        int g = gi.next();
-
-        QListIterator<button_t> i(buttons);
-        while (i.hasNext()) {
-            button_t b = i.next();
-
-            if ((b.wtype == WT_STATUS) && (b.wid == g)) {
-                toolbar.addAction(b.button);
-                continue;
-            }
-
-            if (b.group != g)
-                continue;
+/*!
+ * \param wtype Window type. See constants.h for WT_*
+ * \param type Highlight Type. See constants.h for HL_*
+ *
+ * Returns the preloaded icon for a window type in the given highlight state.
+ * \return Reference to icon
+ */
+const QIcon& IButtonBar::getIcon(int wtype, int type)
+{
+    QHash<int,button_icons_t>::const_iterator i = icons.constFind(wtype);
+    const button_icons_t &ico = (i == icons.constEnd()) ? defaultIcons : i.value();
 
-            toolbar.addAction(b.button);
-        }
+    switch (type) {
+        case HL_ACTIVITY:
+            return ico.act;
 
-        if (gi.hasNext())
-            toolbar.addSeparator();
+        case HL_MSG:
+        case HL_HIGHLIGHT:
+            return ico.msg;
 
+        default: // covers HL_NONE
+            return ico.noact;
     }
 }
 
@@ -432,16 +372,11 @@ void IButtonBar::rebuild()
  */
 QAction* IButtonBar::getAction(int wid)
 {
-    QListIterator<button_t> i(buttons);
-    while (i.hasNext()) {
-        button_t b = i.next();
-        if (b.wid != wid)
-            continue;
+    QHash<int,button_t>::const_iterator i = buttons.constFind(wid);
+    if (i == buttons.constEnd())
+        return nullptr;
 
-        return b.button;
-    }
-
-    return nullptr;
+    return i.value().button;
 }
 
 /*!
@@ -463,46 +398,22 @@ void IButtonBar::buttonSelected(int wid)
 }
 
 /*!
- * Timer slot that flashes all window icons set to highlight as such.
+ * Timer slot that flashes all window icons set to highlight as such.\n
+ * Only the windows in the flashing set are visited.
  */
 void IButtonBar::onFlasher()
 {
     flashtoggle = !flashtoggle;
+    int type = flashtoggle ? HL_MSG : HL_ACTIVITY;
 
-    QListIterator<button_t> i(buttons);
+    QSetIterator<int> i(flashing);
     while (i.hasNext()) {
-        button_t b = i.next();
-
-        action_data_t ad = getActionData(b.button);
-        if (ad.highlight != HL_HIGHLIGHT)
-            continue; // HL type isn't highlight, ignore.
-
-        QIcon icon = QIcon(":/window/gfx/generic.png");
-
-        if (flashtoggle) {
-            if (b.wtype == WT_CHANNEL)
-                icon = QIcon(":/window/gfx/channel_act.png");
-
-            if (b.wtype == WT_PRIVMSG)
-                icon = QIcon(":/window/gfx/query_act.png");
-
-            if (b.wtype == WT_STATUS)
-                icon = QIcon(":/window/gfx/status_act.png");
-
-        }
-        else {
-            if (b.wtype == WT_CHANNEL)
-                icon = QIcon(":/window/gfx/channel.png");
-
-            if (b.wtype == WT_PRIVMSG)
-                icon = QIcon(":/window/gfx/query.png");
-
-            if (b.wtype == WT_STATUS)
-                icon = QIcon(":/window/gfx/status.png");
-
-        }
+        QHash<int,button_t>::const_iterator bi = buttons.constFind(i.next());
+        if (bi == buttons.constEnd())
+            continue;
 
-        b.button->setIcon(icon);
+        const button_t &b = bi.value();
+        b.button->setIcon( getIcon(b.wtype, type) );
     }
 }
 
@@ -515,13 +426,11 @@ void IButtonBar::onFlasher()
 void IButtonBar::contextMenu(QPoint pos)
 {
     QAction *action = toolbar.actionAt(pos);
-    if (action == nullptr)
+    if ((action == nullptr) || (action->isSeparator()))
         return;
 
-    action_data_t ad = getActionData(action);
-
     actionTitle.setText(action->text());
-    actionTitle.setData((int)ad.wid);
+    actionTitle.setData(action->data().toInt());
 
     QPoint gpos = toolbar.mapToGlobal(pos);
     menu.popup(gpos);
@@ -31,6 +31,9 @@
 #include <QToolBar>
 #include <QAction>
 #include <QList>
+#include <QHash>
+#include <QSet>
+#include <QIcon>
 #include <QSignalMapper>
 #include <QTimer>
 #include <QContextMenuEvent>
@@ -47,20 +50,23 @@
  */
 typedef struct T_BUTTON
 {
-    QAction *button; //!< Pointer to button. The data() of this contains highlight info, in type of action_data_t
+    QAction *button; //!< Pointer to button. The data() of this contains the window ID.
     int group; //!< Group the button is in, a connection ID.
     int wid; //!< Window ID
     int wtype; //!< Window type
+    int highlight; //!< Highlight type. See constants.h for HL_*
 } button_t;
 
 /*!
- * Used in QAction for their data.\n
+ * Used in IButtonBar.\n
+ * Preloaded icons for one window type, one per highlight state.
  */
-typedef struct T_ACTION_DATA
+typedef struct T_BUTTON_ICONS
 {
-    int wid; //!< Window ID
-    int highlight; //!< Highlight type. See constants.h for HL_*
-} action_data_t;
+    QIcon noact; //!< HL_NONE
+    QIcon act; //!< HL_ACTIVITY, also the "off" frame while flashing
+    QIcon msg; //!< HL_MSG and HL_HIGHLIGHT, also the "on" frame while flashing
+} button_icons_t;
 
 class IButtonBar : public QObject
 {
@@ -77,13 +83,20 @@ public:
     int getWtype(int wid); // returns WT_NOTHING on error
 
 private:
-    void rebuild();
+    void insertButton(const button_t &b);
+    void dropGroupIfEmpty(int group);
+    void updateSeparators();
+    int groupOf(const button_t &b);
     QAction* getAction(int wid);
-    action_data_t getActionData(QAction *a);
-    void setActionData(QAction *a, action_data_t ad);
+    const QIcon& getIcon(int wtype, int type);
 
     QToolBar toolbar; //!< The visible widget in the GUI.
-    QList<button_t> buttons; //!< List of all the buttons.
+    QHash<int,button_t> buttons; //!< All the buttons, key is window ID.
+    QList<int> groups; //!< Group IDs in the order they appear on the toolbar.
+    QHash<int,QAction*> separators; //!< Separator placed in front of each group, key is group ID.
+    QSet<int> flashing; //!< Window IDs set to HL_HIGHLIGHT. The flasher only runs while this isn't empty.
+    QHash<int,button_icons_t> icons; //!< Preloaded icons, key is window type.
+    button_icons_t defaultIcons; //!< Icons for window types not in icons (custom windows).
     QSignalMapper sigmap; //<! Signal map for QAction Toggle event (when a button is clicked)
     QTimer flasher; //!< Timer for highlighted messages, 500ms cycle.
     bool flashtoggle; //!< On/off for flashing icon (highlight message)
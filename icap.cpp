@@ -0,0 +1,142 @@
+/*
+ *   IdealIRC - Internet Relay Chat client
+ *   Copyright (C) 2014  Tom-Andre Barstad
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+
+#include "icap.h"
+
+ICap::ICap()
+{
+    reset();
+}
+
+/*!
+ * Forgets everything, used when we're disconnected.
+ */
+void ICap::reset()
+{
+    negotiating = false;
+    available.clear();
+    enabled.clear();
+    requested.clear();
+}
+
+/*!
+ * \return Capabilities IdealIRC knows how to use.
+ */
+QStringList ICap::supported()
+{
+    return QStringList() << "multi-prefix"
+                         << "userhost-in-names"
+                         << "away-notify"
+                         << "extended-join"
+                         << "batch"
+                         << "server-time"
+                         << "draft/chathistory"
+                         << "znc.in/playback";
+}
+
+/*!
+ * \param list Space separated capabilities from CAP LS or CAP NEW, such as "sasl=PLAIN batch"
+ *
+ * Adds capabilities the server offers.
+ */
+void ICap::offered(const QString &list)
+{
+    QStringList caps = list.split(' ', QString::SkipEmptyParts);
+    for (int i = 0; i <= caps.count()-1; i++) {
+        QString name = caps[i].section('=', 0, 0);
+        QString value = caps[i].section('=', 1);
+        available.insert(name, value);
+    }
+}
+
+/*!
+ * \param list Space separated capabilities from CAP DEL
+ *
+ * Removes capabilities the server no longer offers.
+ */
+void ICap::removed(const QString &list)
+{
+    QStringList caps = list.split(' ', QString::SkipEmptyParts);
+    for (int i = 0; i <= caps.count()-1; i++) {
+        available.remove(caps[i]);
+        enabled.remove(caps[i]);
+        requested.remove(caps[i]);
+    }
+}
+
+/*!
+ * \param list Space separated capabilities from CAP ACK. A leading '-' means it was disabled.
+ *
+ * Marks capabilities as enabled.
+ * \return The capabilities that got enabled.
+ */
+QStringList ICap::acknowledged(const QString &list)
+{
+    QStringList r;
+    QStringList caps = list.split(' ', QString::SkipEmptyParts);
+    for (int i = 0; i <= caps.count()-1; i++) {
+        QString cap = caps[i];
+        if (cap.startsWith('-')) {
+            enabled.remove(cap.mid(1));
+            requested.remove(cap.mid(1));
+            continue;
+        }
+
+        enabled.insert(cap);
+        requested.remove(cap);
+        r << cap;
+    }
+    return r;
+}
+
+/*!
+ * \param list Space separated capabilities from CAP NAK
+ *
+ * The server didn't enable the capabilities we requested. They won't be requested again.
+ */
+void ICap::refused(const QString &list)
+{
+    QStringList caps = list.split(' ', QString::SkipEmptyParts);
+    for (int i = 0; i <= caps.count()-1; i++) {
+        requested.remove(caps[i]);
+        available.remove(caps[i]);
+    }
+}
+
+/*!
+ * Picks the offered capabilities we support, but haven't enabled or requested yet.\n
+ * They are marked as requested, so the next call won't return them again.
+ * \return Capabilities to send in CAP REQ, empty if there's nothing to request.
+ */
+QStringList ICap::request()
+{
+    QStringList r;
+    QStringList sup = supported();
+    for (int i = 0; i <= sup.count()-1; i++) {
+        QString cap = sup[i];
+        if ((! available.contains(cap)) || (enabled.contains(cap)) || (requested.contains(cap)))
+            continue;
+
+        requested.insert(cap);
+        r << cap;
+    }
+    return r;
+}
@@ -0,0 +1,63 @@
+/*
+ *   IdealIRC - Internet Relay Chat client
+ *   Copyright (C) 2014  Tom-Andre Barstad
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+
+/*! \class ICap
+ *  \brief IRCv3 capabilities of a connection, negotiated with CAP.
+ *
+ * Keeps what the server offers (CAP LS / NEW / DEL) and what it acknowledged (CAP ACK).\n
+ * Only capabilities in the supported list are requested, since each changes what the
+ * server sends us and the parser must know how to handle it.
+ */
+
+#ifndef ICAP_H
+#define ICAP_H
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QSet>
+
+class ICap
+{
+public:
+    ICap();
+    void reset();
+    void offered(const QString &list);
+    void removed(const QString &list);
+    QStringList acknowledged(const QString &list);
+    void refused(const QString &list);
+    bool isWaiting() { return ! requested.isEmpty(); } //!< \return true if we're waiting for ACK/NAK on some request.
+    QStringList request();
+    bool has(const QString &cap) { return enabled.contains(cap); } //!< \return true if cap is enabled on this connection.
+    QString value(const QString &cap) { return available.value(cap); } //!< \return Value the server gave with cap in CAP LS (such as "draft/chathistory=100"), empty if none.
+    QStringList getEnabled() { return enabled.toList(); } //!< \return All enabled capabilities.
+    QStringList getAvailable() { return available.keys(); } //!< \return All capabilities the server offers.
+    static QStringList supported();
+
+    bool negotiating; //!< true from CAP LS until we've sent CAP END.
+
+private:
+    QHash<QString,QString> available; //!< Capabilities the server offers.\n Key: Name\n Value: Value, if any
+    QSet<QString> enabled; //!< Capabilities the server acknowledged.
+    QSet<QString> requested; //!< Capabilities we've requested and are waiting for ACK/NAK on.
+};
+
+#endif // ICAP_H
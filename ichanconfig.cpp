@@ -74,7 +74,7 @@ IChanConfig::IChanConfig(IConnection *c, QString chan, QWidget *parent) :
     loading = new UnsupportedModel("Loading the list...");
     ui->banView->setModel(loading);
 
-    if (connection->haveExceptionList) {
+    if (connection->getISupport()->haveExceptionList) {
         ui->exceptionView->setModel(loading);
     }
     else {
@@ -84,7 +84,7 @@ IChanConfig::IChanConfig(IConnection *c, QString chan, QWidget *parent) :
     }
 
 
-    if (connection->haveInviteList) {
+    if (connection->getISupport()->haveInviteList) {
         ui->inviteView->setModel(loading);
     }
     else {
@@ -171,6 +171,18 @@ void IChanConfig::setDefaultMode(QString mode)
     }
 }
 
+/*!
+ * Used when rejoining after a reconnect.
+ * \return Channel key (+k) as last received from the IRC server, empty if none.
+ */
+QString IChanConfig::getKey()
+{
+    t_csdefault def = defaultMode.value('k');
+    if (! def.enabled)
+        return "";
+    return def.data;
+}
+
 void IChanConfig::setMode(char mode, bool enabled, QString data)
 {
     t_csdefault def;
@@ -237,6 +249,7 @@ void IChanConfig::finishModel(MaskType type)
     if (type == MT_BAN) {
         banTable.setBanList(maskL, dateL, authorL);
         ui->banView->setModel(&banTable);
+        connection->ial.setBanList(channel, maskL);
     }
     if (type == MT_EXCEPT) {
         exceptionTable.setBanList(maskL, dateL, authorL);
@@ -277,7 +290,7 @@ void IChanConfig::delMask(QString mask, MaskType mt)
 void IChanConfig::deleteMasks(MaskType type)
 {
     QItemSelectionModel *sel = NULL;
-    int maxmode = connection->maxModes;
+    int maxmode = connection->getISupport()->maxModes;
     char modeset; // This one WILL be set properly right below
 
     if (type == MT_BAN) {
@@ -549,6 +562,9 @@ void IChanConfig::btnAddMask(MaskType type)
     if (text.length() == 0)
         return;
 
+    if ((type == MT_BAN) && (! confirmBan(text)))
+        return;
+
     QString data = QString("MODE %1 +%2 %3")
                      .arg(channel)
                      .arg(modeset)
@@ -557,6 +573,34 @@ void IChanConfig::btnAddMask(MaskType type)
     connection->sockwrite(data);
 }
 
+/*!
+ * \param mask Ban mask
+ *
+ * Previews how many users in the channel the ban would hit, and asks if it should be set.\n
+ * If nobody is hit, no question is asked.
+ * \return true if the ban should be set.
+ */
+bool IChanConfig::confirmBan(QString mask)
+{
+    QStringList hits = connection->ial.matchMask(channel, mask);
+    if (hits.isEmpty())
+        return true;
+
+    hits.sort();
+    QString names = QStringList(hits.mid(0, 10)).join(", ");
+    if (hits.count() > 10)
+        names += ", ...";
+
+    QMessageBox::StandardButton b;
+    b = QMessageBox::question(this, tr("Set ban"),
+                              tr("The ban %1 matches %n user(s) in %2:\n%3\n\nSet it anyway?", "", hits.count())
+                                .arg(mask)
+                                .arg(channel)
+                                .arg(names));
+
+    return b == QMessageBox::Yes;
+}
+
 /*!
  * Button slot for Add ban.\n See btnAddMask()
  */
@@ -625,6 +669,9 @@ void IChanConfig::btnEditMask(MaskType type)
     if (mask == text)
         return;
 
+    if ((type == MT_BAN) && (! confirmBan(text)))
+        return;
+
     QString data = QString("MODE %1 %2 %3 %4")
                      .arg(channel)
                      .arg(mode)
@@ -33,6 +33,7 @@
 #include <QHash>
 #include "bantablemodel.h" /// @todo Rename to MaskTableModel
 #include "unsupportedmodel.h"
+#include "icoreevents.h"
 
 typedef struct T_CS_DEFAULT
 {
@@ -44,15 +45,9 @@ namespace Ui {
 class IChanConfig;
 }
 
-enum MaskType {
-    MT_BAN = 0,
-    MT_EXCEPT,
-    MT_INVITE
-};
-
 class IConnection;
 
-class IChanConfig : public QDialog
+class IChanConfig : public QDialog, public ICoreChanSettings
 {
     Q_OBJECT
 
@@ -65,6 +60,7 @@ public:
     void addMask(QString mask, QString author, QString created);
     void finishModel(MaskType type);
     void delMask(QString mask, MaskType type);
+    QString getKey();
 
 private:
     Ui::IChanConfig *ui; //!< Qt Creator generated GUI class.
@@ -90,6 +86,7 @@ private:
     void deleteMasks(MaskType type); // Unset the selected masks
     void btnAddMask(MaskType type);
     void btnEditMask(MaskType type);
+    bool confirmBan(QString mask);
     void setMode(char mode, bool enabled, QString data = ""); // Does NOT send the mode to server, used for internal storage.
 
 protected:
@@ -21,9 +21,12 @@
 #include <QStringList>
 #include <QTextCodec>
 #include <QDateTime>
+#include <QListIterator>
+#include <QFileInfo>
 #include "icommand.h"
-#include "iwin.h"
 #include "iconnection.h"
+#include "script/tscriptparent.h"
+#include "iperf.h"
 
 /*!
  * \param con IRC connection which we send data to.
@@ -138,7 +141,7 @@ bool ICommand::parse(QString command)
             localMsg(tr("You're not in a chat window!"));
             return true;
         }
-        QString target = wt.widget->getTarget();
+        QString target = wt.window->getTarget();
         me(target, command.mid(3));
         return true;
     }
@@ -265,7 +268,7 @@ bool ICommand::parse(QString command)
         subwindow_t sw = getCurrentSubwin();
         if (sw.type == WT_NOTHING)
             return true;
-        sw.widget->clear();
+        sw.window->clear();
         return true;
     }
 
@@ -293,6 +296,120 @@ bool ICommand::parse(QString command)
         return true;
     }
 
+    if (t1 == "CTCPSTATS") {
+        CtcpResponder *ctcp = connection->getCtcpResponder();
+        localMsg(tr("CTCP requests: %1 received, %2 replied, %3 dropped by rate limit, %4 summarized.")
+                   .arg(ctcp->getReceived())
+                   .arg(ctcp->getReplied())
+                   .arg(ctcp->getDropped())
+                   .arg(ctcp->getCoalesced())
+                 );
+        return true;
+    }
+
+    if (t1 == "PERF") {
+        // /perf [on|off|reset]
+        if (token.count() > 1) {
+            QString opt = token[1].toLower();
+            if (opt == "on")
+                IPerf::setEnabled(true);
+            else if (opt == "off")
+                IPerf::setEnabled(false);
+            else if (opt == "reset")
+                IPerf::reset();
+            else {
+                localMsg(tr("/Perf: Unknown option %1, use on, off or reset").arg(token[1]));
+                return true;
+            }
+
+            localMsg(tr("Performance counters are %1.").arg(IPerf::isEnabled() ? tr("on") : tr("off")));
+            return true;
+        }
+
+        QListIterator<QString> i(IPerf::report());
+        while (i.hasNext())
+            localMsg(i.next());
+
+        t_perfconn traffic = connection->getTraffic();
+        localMsg(tr("  This connection: %1 lines / %2 bytes in, %3 lines / %4 bytes out")
+                   .arg(traffic.linesIn)
+                   .arg(traffic.bytesIn)
+                   .arg(traffic.linesOut)
+                   .arg(traffic.bytesOut)
+                 );
+        return true;
+    }
+
+    if (t1 == "IGNORE") {
+        // /ignore [-pnci] mask [seconds]
+        if (token.count() == 1) {
+            ignore();
+            return true;
+        }
+
+        int i = 1;
+        QString flags;
+        if (token[1].startsWith('-')) {
+            flags = token[1].mid(1);
+            ++i;
+        }
+
+        if (token.count() <= i) {
+            localMsg(InsufficientParameters("/Ignore"));
+            return true;
+        }
+
+        int seconds = 0;
+        if (token.count() > i+1)
+            seconds = token[i+1].toInt();
+
+        ignore(token[i], flags, seconds);
+        return true;
+    }
+
+    if (t1 == "UNIGNORE") {
+        if (token.count() < 2) {
+            localMsg(InsufficientParameters("/Unignore"));
+            return true;
+        }
+
+        unignore(token[1]);
+        return true;
+    }
+
+    if (t1 == "DCC") {
+        // /dcc send nickname [file]
+        // /dcc get nickname
+        // /dcc chat nickname
+        // /dcc transfers
+        if ((token.count() == 2) && (token[1].toUpper() == "TRANSFERS")) {
+            connection->getFrontEnd()->showDccTransfers();
+            return true;
+        }
+
+        if (token.count() < 3) {
+            localMsg(InsufficientParameters("/Dcc"));
+            return true;
+        }
+
+        QString type = token[1].toUpper();
+        if (type == "SEND") {
+            if (! connection->isOnline()) {
+                localMsg(NotConnectedToServer("/Dcc"));
+                return true;
+            }
+            dccSend(token[2], QStringList(token.mid(3)).join(" "));
+        }
+        else if (type == "GET")
+            dccGet(token[2]);
+        else if (type == "CHAT")
+            dccChat(token[2]);
+        else
+            localMsg(tr("/Dcc: Unknown type %1, use send, get, chat or transfers.").arg(token[1]));
+
+        return true;
+    }
+
     return false; // Command wasn't found.
 }
 
@@ -333,13 +450,13 @@ void ICommand::part(QString channel, QString reason)
 /*!
  * \param reason Quit reason (optional)
  *
- * Sends QUIT message to the IRC server.\n Will eventually result in IConnection loses connection.
+ * Sends QUIT message to the IRC server.\n Will eventually result in IConnection loses connection.\n
+ * Goes through IConnection::closeConnection() so it won't reconnect by itself, and so it cancels
+ * a pending reconnect if we're not connected.
  */
 void ICommand::quit(QString reason)
 {
-    sockwrite( QString("QUIT :%1")
-                 .arg(reason)
-              );
+    connection->closeConnection(false, reason);
 }
 
 /*!
@@ -423,7 +540,7 @@ void ICommand::kick(QString channel, QString nickname, QString reason)
             echo(tstar, NotInAChannel("/Kick"));
             return;
         }
-        channel = wt.widget->getTarget();
+        channel = wt.window->getTarget();
     }
 
     sockwrite( QString("KICK %1 %2 :%3")
@@ -463,7 +580,7 @@ void ICommand::ban(QString channel, QString nickname)
             localMsg(NotInAChannel("/Ban"));
             return;
         }
-        channel = wt.widget->getTarget();
+        channel = wt.window->getTarget();
     }
 
     connection->ial.setChannelBan(channel, nickname);
@@ -574,7 +691,147 @@ void ICommand::query(QString nickname)
 void ICommand::chansettings()
 {
     subwindow_t sw = winlist->value(activewin());
-    sw.widget->execChanSettings();
+    if (sw.window != NULL)
+        sw.window->execChanSettings();
+}
+
+/*!
+ * \param mask Mask to ignore, missing parts are treated as *. Empty mask lists all ignores.
+ * \param flags Message types, p=privmsg, n=notice, c=ctcp, i=invite. Empty means all.
+ * \param seconds Remove the ignore after this many seconds. 0 for a permanent ignore.
+ *
+ * Adds an ignore. Permanent ignores are saved to iirc.ini.
+ */
+void ICommand::ignore(QString mask, QString flags, int seconds)
+{
+    IgnoreList *ignores = connection->getIgnoreList();
+    if (ignores == NULL)
+        return;
+
+    if (mask.isEmpty()) {
+        QStringList masks = ignores->masks();
+        if (masks.isEmpty()) {
+            localMsg(tr("Ignore list is empty."));
+            return;
+        }
+
+        localMsg(tr("Ignore list:"));
+        QListIterator<QString> i(masks);
+        while (i.hasNext()) {
+            QString m = i.next();
+            QString line = QString("%1 [%2] hits: %3")
+                             .arg(m)
+                             .arg(IgnoreList::typesToString(ignores->types(m)))
+                             .arg(ignores->hits(m));
+
+            int expires = ignores->expires(m);
+            if (expires > 0)
+                line += tr(" expires in %1s").arg(expires);
+
+            localMsg(line);
+        }
+        return;
+    }
+
+    int types = IgnoreList::typesFromString(flags);
+    if (types == 0) {
+        localMsg(tr("/Ignore: Invalid flags, use one or more of p, n, c, i."));
+        return;
+    }
+
+    mask = ignores->add(mask, types, seconds);
+    if (seconds == 0)
+        ignores->save();
+
+    if (seconds > 0)
+        localMsg(tr("Ignoring %1 [%2] for %3 seconds.")
+                   .arg(mask)
+                   .arg(IgnoreList::typesToString(types))
+                   .arg(seconds)
+                 );
+    else
+        localMsg(tr("Ignoring %1 [%2].")
+                   .arg(mask)
+                   .arg(IgnoreList::typesToString(types))
+                 );
+}
+
+/*!
+ * \param mask Ignore mask to remove
+ */
+void ICommand::unignore(QString mask)
+{
+    IgnoreList *ignores = connection->getIgnoreList();
+    if (ignores == NULL)
+        return;
+
+    if (! ignores->del(mask)) {
+        localMsg(tr("%1 is not ignored.").arg(IgnoreList::normalize(mask)));
+        return;
+    }
+
+    ignores->save();
+    localMsg(tr("No longer ignoring %1.").arg(IgnoreList::normalize(mask)));
+}
+
+/*!
+ * \param nickname Nickname to send to
+ * \param file Path of file to send. Empty shows a file dialog.
+ *
+ * Offers a file to nickname over DCC.
+ */
+void ICommand::dccSend(QString nickname, QString file)
+{
+    if (file.isEmpty())
+        file = connection->getFrontEnd()->getOpenFileName(tr("Send file to %1").arg(nickname));
+    if (file.isEmpty())
+        return;
+
+    if (! QFileInfo(file).isFile()) {
+        localMsg(tr("/Dcc: No such file %1").arg(file));
+        return;
+    }
+
+    QString name = QString("%1 (%2)").arg(QFileInfo(file).fileName()).arg(nickname);
+    connection->dccinfo = QString("%1 %2 SENDHOST \"%3\"")
+                            .arg(connection->getActiveNickname())
+                            .arg(nickname)
+                            .arg(file);
+
+    emit requestWindow(name, WT_DCCSEND, *cid, true);
+}
+
+/*!
+ * \param nickname Nickname who offered a file
+ *
+ * Accepts a file offered with DCC SEND.
+ */
+void ICommand::dccGet(QString nickname)
+{
+    if (! connection->acceptDcc(nickname, "SEND"))
+        localMsg(tr("/Dcc: No file offered by %1.").arg(nickname));
+}
+
+/*!
+ * \param nickname Nickname to chat with
+ *
+ * Accepts a chat offered with DCC CHAT, or offers one if there's none.
+ */
+void ICommand::dccChat(QString nickname)
+{
+    if (connection->acceptDcc(nickname, "CHAT"))
+        return;
+
+    if (! connection->isOnline()) {
+        localMsg(NotConnectedToServer("/Dcc"));
+        return;
+    }
+
+    connection->dccinfo = QString("%1 %2 CHATHOST")
+                            .arg(connection->getActiveNickname())
+                            .arg(nickname);
+
+    emit requestWindow(nickname, WT_DCCCHAT, *cid, true);
 }
 
 /// -------------------------------------------------------------
@@ -587,7 +844,7 @@ void ICommand::chansettings()
 void ICommand::localMsg(QString message)
 {
     subwindow_t wt = getCurrentSubwin();
-    wt.widget->print(message, tstar, PT_LOCALINFO);
+    wt.window->print(message, tstar, PT_LOCALINFO);
 }
 
 /*!
@@ -601,7 +858,7 @@ void ICommand::localMsg(QString message)
 void ICommand::echo(QString sender, QString message, int ptype)
 {
     subwindow_t wt = getCurrentSubwin();
-    wt.widget->print(sender, message, ptype);
+    wt.window->print(sender, message, ptype);
 }
 
 /*!
@@ -621,7 +878,7 @@ void ICommand::sockwrite(QString data)
 QString ICommand::getCurrentTarget()
 {
      subwindow_t wt = getCurrentSubwin();
-     return wt.widget->getTarget();
+     return wt.window->getTarget();
 }
 
 /*!
@@ -629,8 +886,7 @@ QString ICommand::getCurrentTarget()
  */
 QString ICommand::getCurrentNickname()
 {
-    subwindow_t wt = getCurrentSubwin();
-    return wt.widget->getConnection()->getActiveNickname();
+    return connection->getActiveNickname();
 }
 
 /*!
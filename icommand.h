@@ -36,7 +36,6 @@
 #include "config.h"
 #include "constants.h"
 
-class IWin;
 class IConnection;
 
 class ICommand : public QObject
@@ -65,6 +64,11 @@ public:
     void ping(); // Issue a PING to the server (see if we or them is still alive)
     void query(QString nickname); // Open a query window for "nickname"
     void chansettings();
+    void ignore(QString mask = "", QString flags = "", int seconds = 0); // No mask lists all ignores.
+    void unignore(QString mask);
+    void dccSend(QString nickname, QString file = ""); // No file shows a file dialog.
+    void dccGet(QString nickname);
+    void dccChat(QString nickname);
 
 public slots:
     // Primarily we should use parse. You can tie it to a signal aswell.
@@ -22,55 +22,55 @@
 #include <QStringList>
 #include <QDateTime>
 #include <QDebug>
+#include <QDir>
 
 #include "constants.h"
 #include "iconnection.h"
 #include "icommand.h"
 #include "numerics.h"
+#include "servermgr.h"
 #include "script/tscriptparent.h"
+#include "dcc/dccdetails.h"
 
 /*!
  * \param parent Parent of this connection. Usually its respective status window.
- * \param clptr Pointer to channel list dialog
+ * \param fe Front end, for dialogs and the window switcher.
  * \param connId ID of this connection, shares ID with its corresponding status window.
  * \param cfg Pointer to config class (iirc.ini)
  * \param sp Pointer to the script parent.
- * \param ws Pointer to the window switcher.
  */
-IConnection::IConnection(QObject *parent, IChannelList **clptr, int connId,
-                         config *cfg, TScriptParent *sp, IWindowSwitcher *ws) :
+IConnection::IConnection(QObject *parent, ICoreFrontEnd *fe, int connId,
+                         config *cfg, TScriptParent *sp) :
     QObject(parent),
-    maxBanList(-1), /** -1 means undefined. **/
-    maxExceptList(-1),
-    maxInviteList(-1),
-    maxModes(3),
-    haveExceptionList(false),
-    haveInviteList(false),
     FillSettings(false),
-    ial(this, &activeNick, &sortrule, sp),
+    ial(this, this, &activeNick, support.getSortRuleMapPtr()),
     // addresslist((QWidget*)parent, this),
     cmdhndl(this, cfg),
     conf(cfg),
     cid(connId),
     active(false),
     registered(false),
-    isupport(false),
+    tls(false),
+    socket(NULL),
+    phaseLast(0),
+    reconnectAttempts(0),
     ShuttingDown(false),
     tryingConnect(false),
-    chanlistPtr(clptr),
+    frontEnd(fe),
     listInDialog(false),
     connectionClosing(false),
-    motd(cfg, (QWidget*)parent),
     scriptParent(sp),
     receivingNames(false),
-    cmA("b"),
-    cmB("k"),
-    cmC("l"),
-    cmD("imnpstr"),
+    hlRevision(-1),
+    ignores(NULL),
+    lastCR(false),
+    lineOverflow(false),
+    flushQueued(false),
+    traffic(),
+    msgTime(0),
     tstar("***"),
     sstar("*"),
-    checkState(0),
-    wsw(ws)
+    checkState(0)
 {
     cmdhndl.setWinList(&winlist);
     cmdhndl.setCid(&cid);
@@ -79,21 +79,39 @@ IConnection::IConnection(QObject *parent, IChannelList **clptr, int connId,
             this, SIGNAL(RequestWindow(QString,int,int,bool)));
 
     std::cout << "Connection class ID: " << cid << std::endl;
-    resetSortRules();
 
-    connect(&socket, SIGNAL(connected()),
-            this, SLOT(onSocketConnected()));
+    setSocket(new QTcpSocket(this)); // Unconnected until HostConnector gives us a real one.
 
-    connect(&socket, SIGNAL(disconnected()),
-            this, SLOT(onSocketDisconnected()));
+    connect(&connector, SIGNAL(trying(QString,int)),
+            this, SLOT(connectorTrying(QString,int)));
 
-    connect(&socket, SIGNAL(readyRead()),
-            this, SLOT(onSocketReadyRead()));
+    connect(&connector, SIGNAL(resolved(QString,qint64,bool)),
+            this, SLOT(connectorResolved(QString,qint64,bool)));
+
+    connect(&connector, SIGNAL(connected(QTcpSocket*,QString,qint64,qint64)),
+            this, SLOT(connectorConnected(QTcpSocket*,QString,qint64,qint64)));
+
+    connect(&connector, SIGNAL(failed(QString,int,QString)),
+            this, SLOT(connectorFailed(QString,int,QString)));
+
+    connect(&connector, SIGNAL(exhausted()),
+            this, SLOT(connectorExhausted()));
 
     connect(&checkConnection, SIGNAL(timeout()),
             this, SLOT(checkConnectionTimeout()));
 
+    connect(&ctcpResponder, SIGNAL(summary(QString)),
+            this, SLOT(ctcpSummary(QString)));
+
     checkConnection.setInterval(180000); // 3 min.
+
+    reconnectTimer.setSingleShot(true);
+    connect(&reconnectTimer, SIGNAL(timeout()),
+            this, SLOT(reconnectTimeout()));
+
+    handshakeTimer.setSingleShot(true);
+    connect(&handshakeTimer, SIGNAL(timeout()),
+            this, SLOT(handshakeTimeout()));
 }
 
 /*!
@@ -109,27 +127,436 @@ void IConnection::setServer(QString server, QString passwd)
 
     QStringList details = server.split(':');
     host = details.at(0);
-    port = details.at(1).toInt();
+    QString p = details.value(1);
+    tls = p.startsWith('+'); // irc.example.org:+6697
+    if (tls)
+        p = p.mid(1);
+    port = p.toInt();
     password = passwd;
 }
 
 /*!
- * Attempts to connect to the IRC server.
+ * Attempts to connect to the IRC server.\n
+ * If the server is part of a network in servers.ini, the other servers of that network are tried
+ * in turn if it can't be reached. See HostConnector.
  */
 void IConnection::tryConnect()
 {
     setServer();
-    IWin *s = winlist.value("STATUS").widget;
 
-    s->print( tstar, tr("Connecting to %1:%2...")
-                      .arg(host)
-                      .arg(port),
-              PT_LOCALINFO
-             );
+    QStringList servers;
+    servers << QString("%1:%2%3").arg(host).arg(tls ? "+" : "").arg(port);
+    ServerMgr sm;
+    servers << sm.alternateServers(servers.first());
 
+    reconnectTimer.stop();
+    connectionClosing = false;
     tryingConnect = true;
-    conTimeout.singleShot(conf->timeout, this, SLOT(connectionAttemptTimeout()));
-    socket.connectToHost(host, port, QIODevice::ReadWrite | QIODevice::Text);
+    phaseClock.start();
+    phaseLast = 0;
+    connector.connectTo(servers, conf->timeout);
+}
+
+/*!
+ * \param s New socket
+ *
+ * Replaces our socket with a new one and connects its signals.
+ */
+void IConnection::setSocket(QTcpSocket *s)
+{
+    if (socket != NULL) {
+        disconnect(socket, 0, this, 0);
+        socket->abort();
+        socket->deleteLater();
+    }
+
+    socket = s;
+    socket->setParent(this);
+
+    connect(socket, SIGNAL(disconnected()),
+            this, SLOT(onSocketDisconnected()));
+
+    connect(socket, SIGNAL(readyRead()),
+            this, SLOT(onSocketReadyRead()));
+}
+
+/*!
+ * \param phase Name of the phase that just ended
+ *
+ * Prints the time spent in a phase of connecting, and since we started connecting, to the status window.
+ */
+void IConnection::logPhase(QString phase)
+{
+    qint64 now = phaseClock.elapsed();
+    print("STATUS", tstar, tr("Timing: %1 took %2 ms (%3 ms total)")
+                             .arg(phase)
+                             .arg(now - phaseLast)
+                             .arg(now),
+          PT_LOCALINFO);
+    phaseLast = now;
+}
+
+/*!
+ * \param server Hostname
+ * \param serverPort Port
+ *
+ * HostConnector starts on a server.
+ */
+void IConnection::connectorTrying(QString server, int serverPort)
+{
+    print("STATUS", tstar, tr("Connecting to %1:%2...")
+                             .arg(server)
+                             .arg(serverPort),
+          PT_LOCALINFO);
+}
+
+/*!
+ * \param server Hostname
+ * \param ms Milliseconds the lookup took
+ * \param cached true if the addresses came from the DNS cache
+ *
+ * HostConnector resolved the server hostname.
+ */
+void IConnection::connectorResolved(QString server, qint64 ms, bool cached)
+{
+    Q_UNUSED(server)
+    Q_UNUSED(ms)
+    logPhase(cached ? "DNS (cached)" : "DNS");
+}
+
+/*!
+ * \param s The connected socket, we take ownership
+ * \param server The server that connected, as in servers.ini ("host:port|password")
+ * \param dnsMs Milliseconds the DNS lookup took
+ * \param connectMs Milliseconds the TCP connect took
+ *
+ * HostConnector got us connected. Start registering.
+ */
+void IConnection::connectorConnected(QTcpSocket *s, QString server, qint64 dnsMs, qint64 connectMs)
+{
+    Q_UNUSED(dnsMs)
+    Q_UNUSED(connectMs)
+
+    if (server.contains('|'))
+        setServer(server.section('|', 0, 0), server.section('|', 1));
+    else
+        setServer(server);
+
+    setSocket(s);
+    logPhase("TCP connect");
+
+    print("STATUS", tstar, tr("Connected to %1 (%2)")
+                             .arg(getConnectionInfo())
+                             .arg(s->peerAddress().toString()),
+          PT_LOCALINFO);
+
+    QSslSocket *ssl = qobject_cast<QSslSocket*>(s);
+    if (ssl == NULL) {
+        onSocketConnected();
+        return;
+    }
+
+    if (! ITls::available()) {
+        print("STATUS", tstar, tr("Cannot use TLS, the SSL library isn't installed."), PT_LOCALINFO);
+        connectionClosing = true;
+        socket->abort(); // Emits disconnected()
+        return;
+    }
+
+    // Registration starts when the handshake is done, see onSocketEncrypted().
+    ITls::prepare(ssl, host, port);
+
+    connect(ssl, SIGNAL(encrypted()),
+            this, SLOT(onSocketEncrypted()));
+
+    connect(ssl, SIGNAL(sslErrors(QList<QSslError>)),
+            this, SLOT(onSslErrors(QList<QSslError>)));
+
+    // HostConnector's timeout ended at TCP connect, and checkConnection starts at the first line.
+    handshakeTimer.start(conf->timeout > 0 ? conf->timeout : 30000);
+    ssl->startClientEncryption();
+}
+
+/*!
+ * The TLS handshake is done. Checks the certificate pin and continues with registration.
+ */
+void IConnection::onSocketEncrypted()
+{
+    handshakeTimer.stop();
+
+    QSslSocket *ssl = qobject_cast<QSslSocket*>(socket);
+    if (ssl == NULL)
+        return;
+
+    logPhase(ITls::offeredSession(host, port) ? "TLS handshake (resuming)" : "TLS handshake");
+
+    if (! ITls::checkPin(ssl, host)) {
+        print("STATUS", tstar, tr("The key of %1 doesn't match the pin in pins.ini (it's now %2). Disconnecting.")
+                                 .arg(host)
+                                 .arg(ITls::fingerprint(ssl)),
+              PT_LOCALINFO);
+        connectionClosing = true; // Don't reconnect, it won't get any better.
+        socket->abort(); // Emits disconnected()
+        return;
+    }
+
+    ITls::saveSession(ssl, host, port);
+
+    print("STATUS", tstar, tr("Encrypted with %1 (%2)")
+                             .arg(ssl->sessionCipher().name())
+                             .arg(ssl->sessionCipher().protocolString()),
+          PT_LOCALINFO);
+
+    onSocketConnected();
+}
+
+/*!
+ * \param errors Certificate errors
+ *
+ * The server certificate didn't verify. Unless it's pinned, we tell why and the handshake fails.
+ */
+void IConnection::onSslErrors(const QList<QSslError> &errors)
+{
+    QSslSocket *ssl = qobject_cast<QSslSocket*>(socket);
+    if (ssl == NULL)
+        return;
+
+    if (ITls::handleErrors(ssl, host, errors))
+        return;
+
+    QListIterator<QSslError> i(errors);
+    while (i.hasNext())
+        print("STATUS", tstar, tr("TLS: %1").arg(i.next().errorString()), PT_LOCALINFO);
+
+    print("STATUS", tstar, tr("To trust this server anyway, pin its key in pins.ini: [%1] SHA256=%2")
+                             .arg(host.toLower())
+                             .arg(ITls::fingerprint(ssl)),
+          PT_LOCALINFO);
+
+    connectionClosing = true; // Don't reconnect, the certificate won't verify next time either.
+}
+
+/*!
+ * The server accepted TCP but didn't finish the TLS handshake in time.\n
+ * Aborting goes through onSocketDisconnected(), which reconnects as for any lost connection.
+ */
+void IConnection::handshakeTimeout()
+{
+    if ((socket == NULL) || (! socket->isOpen()))
+        return;
+
+    print("STATUS", tstar, tr("TLS handshake with %1 timed out.").arg(getConnectionInfo()), PT_LOCALINFO);
+    socket->abort(); // Emits disconnected()
+}
+
+/*!
+ * \param server Hostname
+ * \param serverPort Port
+ * \param reason Error message
+ *
+ * HostConnector couldn't connect to a server, and will try the next one if there's any.
+ */
+void IConnection::connectorFailed(QString server, int serverPort, QString reason)
+{
+    print("STATUS", tstar, tr("Unable to connect to %1:%2: %3")
+                             .arg(server)
+                             .arg(serverPort)
+                             .arg(reason),
+          PT_LOCALINFO);
+}
+
+/*!
+ * HostConnector tried every server without luck.
+ */
+void IConnection::connectorExhausted()
+{
+    print("STATUS", tstar, tr("Connection attempt failed."), PT_LOCALINFO);
+    tryingConnect = false;
+    emit updateConnectionButton();
+
+    if ((reconnectAttempts > 0) && (conf->autoReconnect) && (! connectionClosing))
+        scheduleReconnect();
+}
+
+/*!
+ * Waits a while before reconnecting. The wait doubles for each attempt, up to RECONNECT_MAX, and
+ * is randomized between half and all of that so many clients dropped at once don't come back at once.\n
+ * qrand() is seeded once per process, at startup.
+ */
+void IConnection::scheduleReconnect()
+{
+    int delay = RECONNECT_MAX;
+    if (reconnectAttempts < 16)
+        delay = qMin(RECONNECT_BASE << reconnectAttempts, RECONNECT_MAX);
+    delay = delay / 2 + qrand() % (delay / 2 + 1);
+    reconnectAttempts++;
+
+    print("STATUS", tstar, tr("Reconnecting in %1 seconds (attempt %2)...")
+                             .arg((delay + 500) / 1000)
+                             .arg(reconnectAttempts),
+          PT_LOCALINFO);
+
+    reconnectTimer.start(delay);
+}
+
+/*!
+ * Timer slot for IConnection::reconnectTimer
+ */
+void IConnection::reconnectTimeout()
+{
+    tryConnect();
+}
+
+/*!
+ * \param channel Channel name
+ *
+ * We won't get a fresh member list for this channel, so throw out what's left from before the reconnect.
+ */
+void IConnection::dropStaleChannel(QString channel)
+{
+    if (! staleChannels.contains(channel.toUpper()))
+        return;
+
+    staleChannels.removeAll(channel.toUpper());
+    ial.dropChannel(channel);
+
+    ICoreWindow *w = getWinObj(channel);
+    if (w != NULL)
+        w->resetMemberlist();
+}
+
+/*!
+ * We're not reconnecting after all. Throws out the member lists and IAL data we kept.
+ */
+void IConnection::dropStaleState()
+{
+    if (staleChannels.isEmpty())
+        return;
+
+    QStringList channels = staleChannels;
+    QListIterator<QString> i(channels);
+    while (i.hasNext())
+        dropStaleChannel(i.next());
+
+    ial.reset();
+}
+
+/*!
+ * Joins favourites marked for auto join, and the channels we got open if config::autoReJoin is set.\n
+ * Keys are taken from what we've seen on the server, the channel settings dialog and favourites, in that order.\n
+ * The channels are sent in as few JOIN lines as the server allows (TARGMAX, 512 byte lines), all in one go,
+ * and we won't try to join more channels than CHANLIMIT says we can be on.
+ */
+void IConnection::rejoinChannels()
+{
+    QStringList channels;
+    QStringList channelsUp;
+    QHash<QString,QString> keys; // Key: channel name in upper case
+
+    // Auotjoin favourites
+    IniFile ini(QString("%1/favourites.ini").arg(CONF_PATH));
+    int count = ini.CountSections();
+    for (int i = 1; i <= count; i++) {
+        QString channel = ini.ReadIni(i);
+        bool autojoin = (bool)ini.ReadIni(channel, "AutoJoin").toInt();
+        if ((! autojoin) || (channelsUp.contains(channel.toUpper())))
+            continue;
+
+        channels << channel;
+        channelsUp << channel.toUpper();
+
+        QString key = ini.ReadIni(channel, "Key");
+        if (key.length() > 0)
+            keys.insert(channel.toUpper(), key);
+    }
+
+    if (conf->autoReJoin) {
+        // Rejoin channels which is open
+        QHashIterator<QString,subwindow_t> i(winlist);
+        while (i.hasNext()) {
+            i.next();
+            subwindow_t sw = i.value();
+
+            if (sw.type != WT_CHANNEL)
+                continue;
+
+            QString target = sw.window->getTarget();
+            QString up = target.toUpper();
+            if (! channelsUp.contains(up)) {
+                channels << target;
+                channelsUp << up;
+            }
+
+            QString key = channelKeys.value(up);
+            if ((key.isEmpty()) && (sw.window->chanSettings() != NULL))
+                key = sw.window->chanSettings()->getKey();
+            if (key.length() > 0)
+                keys.insert(up, key);
+        }
+    }
+
+    // Channels with keys must come first in a JOIN.
+    QStringList ordered;
+    QStringList open;
+    QHash<char,int> joining; // Key: channel type
+    for (int i = 0; i <= channels.count()-1; i++) {
+        QString channel = channels[i];
+        char type = channel[0].toLatin1();
+        int limit = support.getChanLimit(type);
+        if ((limit >= 0) && (joining.value(type) >= limit)) {
+            print("STATUS", tstar, tr("Not joining %1, the server allows only %2 channels.")
+                                     .arg(channel)
+                                     .arg(limit),
+                  PT_LOCALINFO);
+            dropStaleChannel(channel);
+            continue;
+        }
+        joining.insert(type, joining.value(type) + 1);
+
+        if (keys.contains(channel.toUpper()))
+            ordered << channel;
+        else
+            open << channel;
+    }
+    ordered << open;
+
+    int batch = (support.maxJoinTargets > 0) ? support.maxJoinTargets : REJOIN_BATCH;
+    QString chanlist;
+    QString keylist;
+    int n = 0;
+
+    for (int i = 0; i <= ordered.count()-1; i++) {
+        QString channel = ordered[i];
+        QString key = keys.value(channel.toUpper());
+
+        QString nextChans = chanlist.isEmpty() ? channel : chanlist + ',' + channel;
+        QString nextKeys = keylist;
+        if (key.length() > 0)
+            nextKeys = keylist.isEmpty() ? key : keylist + ',' + key;
+
+        int len = nextChans.toUtf8().length() + nextKeys.toUtf8().length() + 6; // "JOIN " and a space.
+        if ((n > 0) && ((n >= batch) || (len > IRC_SENDLINE_MAX))) {
+            sockwrite(QString("JOIN %1 %2").arg(chanlist).arg(keylist).trimmed());
+            chanlist = channel;
+            keylist = key;
+            n = 1;
+            continue;
+        }
+
+        chanlist = nextChans;
+        keylist = nextKeys;
+        n++;
+    }
+
+    if (n > 0)
+        sockwrite(QString("JOIN %1 %2").arg(chanlist).arg(keylist).trimmed());
+
+    // Channels we had before the reconnect but won't join again.
+    QStringList stale = staleChannels;
+    for (int i = 0; i <= stale.count()-1; i++) {
+        if (! channelsUp.contains(stale[i]))
+            dropStaleChannel(stale[i]);
+    }
 }
 
 /*!
@@ -157,17 +584,21 @@ void IConnection::freeWindow(QString name)
 {
     winlist.remove(name.toUpper());
     acList.removeAll(name);
+    staleChannels.removeAll(name.toUpper());
+    channelKeys.remove(name.toUpper());
 }
 
 /*!
  * \param data Data to send
  *
- * Sends data to the IRC server. The CR+LF is appended inside this function, so do not add that in the data yourself.
+ * Sends data to the IRC server. The CR+LF is appended inside this function, so do not add that in the data yourself.\n
+ * The line is added to IConnection::outbuf, which is written to the socket by flushOutput() when we're back
+ * in the event loop. Lines sent in one go (such as a perform list) thereby end up in one write.
  * \return false if socket is disconnected or no data to send. true on (apparent) success.
  */
 bool IConnection::sockwrite(QString data)
 {
-    if (! socket.isOpen()) {
+    if (! socket->isOpen()) {
         print("STATUS", tstar, tr("Not connected to server"), PT_LOCALINFO);
         return false;
     }
@@ -176,22 +607,56 @@ bool IConnection::sockwrite(QString data)
       return false;
 
     QTextCodec *tc = QTextCodec::codecForName(conf->charset.toStdString().c_str());
-    if (tc != 0) {
-        QByteArray encodedData = tc->fromUnicode(data);
-        encodedData.append("\r\n");
-        socket.write(encodedData);
-        //qDebug() << "[out]" << encodedData;
+    if (tc != 0)
+        outbuf.append(tc->fromUnicode(data));
+    else
+        outbuf.append(data.toUtf8());
+    outbuf.append("\r\n");
+
+    if (IPerf::isEnabled()) {
+        traffic.linesOut++;
+        IPerf::add(pc_LinesOut);
     }
-    else {
-        QByteArray outData;
-        outData.append(data);
-        outData.append("\r\n");
-        socket.write(outData);
-        //qDebug() << "[out]" << outData;
+
+    if (! flushQueued) {
+        flushQueued = true;
+        QTimer::singleShot(0, this, SLOT(flushOutput()));
     }
     return true;
 }
 
+/*!
+ * Writes everything in IConnection::outbuf to the socket.
+ */
+void IConnection::flushOutput()
+{
+    flushQueued = false;
+    if (outbuf.isEmpty())
+        return;
+
+    if (socket->isOpen()) {
+        socket->write(outbuf);
+
+        if (IPerf::isEnabled()) {
+            traffic.bytesOut += outbuf.size();
+            IPerf::add(pc_BytesOut, outbuf.size());
+            IPerf::set(pc_SendQueue, socket->bytesToWrite());
+        }
+    }
+    outbuf.clear();
+}
+
+/*!
+ * \param event Script event to fire.
+ * \param param Parameters for the event.
+ *
+ * Core classes (such as IAL) report events here, which are passed on to the scripts.
+ */
+void IConnection::coreEvent(e_iircevent event, const QStringList &param)
+{
+    scriptParent->runevent(event, param);
+}
+
 /*!
  * Runs when we're successfully connected to the IRC server, however not yet registered with it.\n
  * In here we send registration details (PASS, USER and NICK).
@@ -200,8 +665,14 @@ void IConnection::onSocketConnected()
 {
     emit updateConnectionButton();
 
-    if (conf->password.length() > 0)
-        sockwrite("PASS :" + conf->password);
+    // Registration is held back until we send CAP END. Servers without CAP ignore this.
+    caps.reset();
+    caps.negotiating = true;
+    sockwrite("CAP LS 302");
+
+    QString pass = password.isEmpty() ? conf->password : password; // A failover server may have its own.
+    if (pass.length() > 0)
+        sockwrite("PASS :" + pass);
 
     QString username;                            // Store our username to pass to IRC server here.
     if (conf->username[0] == '@')                // If our @ token is first, we'll just use the nickname.
@@ -218,7 +689,25 @@ void IConnection::onSocketConnected()
                  .arg(conf->realname)
               );
 
-    conTimeout.stop();
+    logPhase("registration sent");
+
+    if (conf->ialSnapshot)
+        ial.loadSnapshot(ialSnapshotFile());
+}
+
+/*!
+ * \return /path/to/the IAL snapshot file of the server we're connecting to.
+ */
+QString IConnection::ialSnapshotFile()
+{
+    QString path = QString("%1/ial").arg(CONF_PATH);
+    if (! QDir(path).exists())
+        QDir().mkpath(path);
+
+    QString name = host.toLower();
+    name.replace(QRegExp("[^a-z0-9._-]"), "_");
+
+    return QString("%1/%2.ial").arg(path).arg(name);
 }
 
 /*!
@@ -228,45 +717,65 @@ void IConnection::onSocketConnected()
 void IConnection::onSocketDisconnected()
 {
     if (ShuttingDown) { // Close all windows related to this connection
-        socket.close();
+        socket->close();
         emit connectionClosed();
         return; // All windows are closed, status window will close itself when ready to close.
     }
 
-    ial.reset();
+    // A TLS 1.3 session ticket arrives after the handshake, keep the latest one for the reconnect.
+    QSslSocket *ssl = qobject_cast<QSslSocket*>(socket);
+    if ((ssl != NULL) && (ssl->mode() == QSslSocket::SslClientMode))
+        ITls::saveSession(ssl, host, port);
+
+    // Unless we closed it ourselves, keep member lists and the IAL as stale until we're back.
+    bool reconnecting = (conf->autoReconnect) && (! connectionClosing);
+
+    if (conf->ialSnapshot)
+        ial.saveSnapshot(ialSnapshotFile());
+    if (! reconnecting) {
+        ial.reset();
+        staleChannels.clear();
+        backfillFrom.clear();
+    }
 
     active = false;
-    maxBanList = -1;
-    maxExceptList = -1;
-    maxInviteList = -1;
-    maxModes = 3;
-    haveExceptionList = false;
-    haveInviteList = false;
+    support.reset();
+    caps.reset();
+    batches.clear();
+    linedata.clear();
+    lastCR = false;
+    lineOverflow = false;
+    outbuf.clear();
+    whoPending.clear();
+    whoBatch.clear();
     FillSettings = false;
     registered = false;
-    isupport = false;
-    chantype.clear();
-    cumode.clear();
-    culetter.clear();
-    resetSortRules();
-    cmA = "b";
-    cmB = "k";
-    cmC = "l";
-    cmD = "imnpstr";
     checkConnection.setInterval(180000);
     checkConnection.stop();
+    handshakeTimer.stop();
 
     QHashIterator<QString, subwindow_t> i(winlist);
     while (i.hasNext()) {
         i.next();
         subwindow_t win = i.value();
 
-        win.widget->print(tstar, tr("Disconnected."), PT_LOCALINFO);
+        // Where the gap starts, for the chat history request after we're back.
+        if (reconnecting && (win.type == WT_CHANNEL)) {
+            QString up = win.window->getTarget().toUpper();
+            if (! backfillFrom.contains(up))
+                backfillFrom.insert(up, win.window->getLastTimestamp());
+        }
+
+        win.window->print(tstar, tr("Disconnected."), PT_LOCALINFO);
         if (win.type == WT_CHANNEL) {
-            win.widget->resetMemberlist();
+            QString up = win.window->getTarget().toUpper();
+            if (! reconnecting)
+                win.window->resetMemberlist();
+            else if (! staleChannels.contains(up))
+                staleChannels << up;
         }
     }
-    socket.close();
+    socket->close();
     emit updateConnectionButton();
     emit connectionClosed();
 
@@ -275,6 +784,9 @@ void IConnection::onSocketDisconnected()
                         .arg(port);
 
     scriptParent->runevent(te_disconnect, QStringList()<<hostinfo);
+
+    if (reconnecting)
+        scheduleReconnect();
 }
 
 /*!
@@ -286,59 +798,133 @@ void IConnection::onSocketDisconnected()
  *
  * \bug If our network connection is lost and attempting to quit a registered connection, we'll seem to not being able to disconnect.
  */
-void IConnection::closeConnection(bool shutdown)
+void IConnection::closeConnection(bool shutdown, QString reason)
 {
+    if (reconnectTimer.isActive()) {
+        reconnectTimer.stop();
+        reconnectAttempts = 0;
+        dropStaleState();
+        print("STATUS", tstar, tr("Reconnect cancelled."), PT_LOCALINFO);
+        emit updateConnectionButton();
+        return;
+    }
+
     if (tryingConnect == true) {
         print("STATUS", tstar, tr("Disconnected."), PT_LOCALINFO);
-        socket.close();
+        connectionClosing = true;
+        connector.abort();
+        socket->close();
         tryingConnect = false;
+        reconnectAttempts = 0;
+        dropStaleState();
         emit updateConnectionButton();
         return;
     }
 
-    if (registered) {
+    if (socket->isOpen()) {
         connectionClosing = true;
         ShuttingDown = shutdown;
         QString data = QString("QUIT :%1")
-                         .arg( conf->quit );
+                         .arg( reason.isEmpty() ? conf->quit : reason );
 
         sockwrite(data);
+        flushOutput(); // Don't wait for the event loop, we might be shutting down.
     }
 }
 
+/*!
+ * \param text Line from the server, decoded
+ *
+ * Logs a line from the server to stdout and parses it.\n
+ * The benchmark tools in bench/ override this to time parse() on its own.
+ */
+void IConnection::lineReceived(QString &text)
+{
+    std::cout << "[in] " << text.toStdString().c_str() << std::endl;
+    IPerfTimer parseTimer(pc_Parse);
+    parse( text );
+}
+
 /*!
  * Runs when we're got stuff in the socket buffer ready to read.\n\n
  *
- * This function reads data to variable IConnection::linedata until we reach a LF.\n
- * Qt converts CR+LF to LF since socket is opened in Text mode.\n
- * When we reach the LF, we'll parse the "linedata" with parse() function, and reset it
- * and continue reading in until our buffer is empty.
+ * The socket is read in binary mode, in chunks of IConnection::readbuf.\n
+ * A line ends at CR, LF or CR+LF. Each complete line is decoded and passed to lineReceived(), and any
+ * incomplete line at the end of a chunk is kept in IConnection::linedata for the next read.
  */
 void IConnection::onSocketReadyRead()
 {
-    QByteArray in = socket.readAll();
     tryingConnect = false;
 
+    if (readbuf.isEmpty()) {
+        int size = socket->socketOption(QAbstractSocket::ReceiveBufferSizeSocketOption).toInt();
+        if (size <= 0)
+            size = IRC_READ_BUFFER;
+        readbuf.resize(size);
+    }
+
     QTextCodec *tc = QTextCodec::codecForName(conf->charset.toStdString().c_str());
+    bool gotLine = false;
+
+    qint64 len;
+    while ((len = socket->read(readbuf.data(), readbuf.size())) > 0) {
+        const char *in = readbuf.constData();
+
+        if (IPerf::isEnabled()) {
+            traffic.bytesIn += len;
+            IPerf::add(pc_BytesIn, len);
+        }
+
+        int start = 0; // Where the part of the current line in this chunk starts.
+
+        for (int i = 0; i < len; i++) {
+            char c = in[i];
+            if (c != '\r' && c != '\n')
+                continue;
+
+            // A LF right after CR is the end of the same line.
+            bool crlf = (c == '\n' && lastCR && i == start);
+            lastCR = (c == '\r');
+            if (crlf) {
+                start = i + 1;
+                continue;
+            }
+
+            if (! lineOverflow)
+                linedata.append(in + start, qMin(i - start, IRC_MAXLINE - linedata.length()));
+            start = i + 1;
+            lineOverflow = false;
 
-    for (int i = 0; i <= in.length()-1; i++) {
+            if (linedata.isEmpty())
+                continue;
 
-      if (in[i] == '\n') {
-          // Newline, parse this.
-          QString text = tc->toUnicode(linedata);
-          std::cout << "[in] " << text.toStdString().c_str() << std::endl;
-          parse( text );
-          linedata.clear();
+            QString text = (tc != 0) ? tc->toUnicode(linedata) : QString::fromUtf8(linedata);
+            linedata.clear();
+            gotLine = true;
 
-          if (checkState == 0)
-              checkConnection.start(); // (re-)start the timer that checks if our TCP connection's still alive.
+            if (IPerf::isEnabled()) {
+                traffic.linesIn++;
+                IPerf::add(pc_LinesIn);
+            }
 
-          continue;
-      }
+            lineReceived( text );
+            msgTime = 0; // Anything printed from now on is not from this message.
+        }
 
-      // By default, add data to linedata.
-      linedata += in.at(i);
+        int rest = (int)len - start;
+        if (rest > 0) {
+            lastCR = false;
+            if (! lineOverflow) {
+                int room = IRC_MAXLINE - linedata.length();
+                linedata.append(in + start, qMin(rest, room));
+                if (rest > room)
+                    lineOverflow = true;
+            }
+        }
     }
+
+    if (gotLine && checkState == 0)
+        checkConnection.start(); // (re-)start the timer that checks if our TCP connection's still alive.
 }
 
 /*!
@@ -360,31 +946,18 @@ void IConnection::checkConnectionTimeout()
         checkState = 0;
         checkConnection.setInterval(180000); // set back to default 3 min.
         print("STATUS", tstar, tr("Ping timeout."), PT_LOCALINFO);
-        socket.close(); // close socket, connection's dead.
+        socket->close(); // close socket, connection's dead.
         return;
     }
 }
 
-/*!
- * Timer slot for IConnection::conTimeout\n
- */
-void IConnection::connectionAttemptTimeout()
-{
-    if (socket.isOpen())
-        return;
-
-    print("STATUS", tstar, tr("Connection attempt timed out."), PT_LOCALINFO);
-    socket.abort();
-    closeConnection();
-}
-
 /*!
  * \param name Window name
  *
  * Tries to find a subwindow by a given name.
- * \return Pointer to IWin or NULL on failure
+ * \return Pointer to the window or NULL on failure
  */
-IWin* IConnection::getWinObj(QString name)
+ICoreWindow* IConnection::getWinObj(QString name)
 {
     subwindow_t empty;
     empty.wid = -1; // Indicate error
@@ -394,78 +967,116 @@ IWin* IConnection::getWinObj(QString name)
     if (w.wid == -1)
         return NULL;
     else
-        return w.widget;
+        return w.window;
 }
 
 /*!
- * \param name Window name
+ * \param text Summary of CTCP requests
  *
- * Tries to find a subwindow by a given name.
- * \return true if window exist, false otherwise.
+ * Shows the summary from the CTCP rate limiter in status.
  */
-bool IConnection::windowExist(QString name)
+void IConnection::ctcpSummary(QString text)
 {
-    subwindow_t empty;
-    empty.wid = -1; // Indicate error
-
-    subwindow_t w = winlist.value(name.toUpper(), empty);
-
-    if (w.wid == -1)
-        return false;
-    else
-        return true;
+    print("STATUS", tstar, text, PT_CTCP);
 }
 
 /*!
- * \param channel A channel name
+ * \param token Tokens of the line from server
+ * \param token1up Upper case command
  *
- * Tests if a given name is a valid channel name.\n
- * The test is checked against the channel types we receive from the server via isupport.
- * \return true if it's a valid channel name, false otherwise.
+ * Checks PRIVMSG, NOTICE and INVITE against the ignore list, before any other work is done on them.\n
+ * Also counts messages for flood protection, and ignores the host for a while if it floods.
+ * \return true if the message should be dropped.
  */
-bool IConnection::isValidChannel(QString channel)
+bool IConnection::isIgnored(QStringList &token, QString &token1up)
 {
-    if (channel.isEmpty())
+    if ((ignores == NULL) || (ignores->isEmpty() && (conf->autoIgnoreLines <= 0)))
+        return false;
+
+    int type;
+    if (token1up == "PRIVMSG") {
+        type = IGN_PRIVMSG;
+        // :nick!ident@host PRIVMSG target :<0x01>VERSION<0x01>
+        if ((token.count() > 3) && (token[3].length() > 1) && (token[3][1] == QChar(0x01))
+                && (! token[3].mid(2).toUpper().startsWith("ACTION")))
+            type = IGN_CTCP;
+    }
+    else if (token1up == "NOTICE")
+        type = IGN_NOTICE;
+    else if (token1up == "INVITE")
+        type = IGN_INVITE;
+    else
         return false;
 
-    char prefix = channel[0].toLatin1();
-    return chantype.contains(prefix);
+    if (! token[0].contains('!'))
+        return false; // From server
+
+    user_t u = parseUserinfo(token[0]);
+    if (ignores->isIgnored(u.nick, u.user, u.host, type))
+        return true;
+
+    if ((conf->autoIgnoreLines > 0) && (type != IGN_INVITE)
+            && ignores->flooding(u.host, conf->autoIgnoreLines, conf->autoIgnoreSecs)) {
+        QString mask = ignores->add(QString("*!*@%1").arg(u.host), IGN_ALL, conf->autoIgnoreTime);
+        print( "STATUS", tstar, tr("Flood from %1, ignoring %2 for %3 seconds.")
+                                  .arg(u.nick)
+                                  .arg(mask)
+                                  .arg(conf->autoIgnoreTime),
+               PT_LOCALINFO
+              );
+        return true;
+    }
+
+    return false;
 }
 
 /*!
- * \param mode Channel user-mode (such as o, v, h, etc)
+ * \param text Message text
+ * \param trigger If not NULL, set to the word or pattern that caused the highlight
  *
- * Checks if the usermode is a letter and returns the letter.
- * \return Channel user-mode letter (such as @, +, %, etc) or 0x00 on failure.
+ * Runs a message through the highlight engine. The engine is rebuilt first if our nickname,
+ * the network or the highlight options changed since last time.
+ * \return true if the message is a highlight.
  */
-char IConnection::getCuLetter(char mode)
+bool IConnection::isHighlight(const QString &text, QString *trigger)
 {
-    if (cumode.contains(mode))
-        return culetter.at( cumode.indexOf(mode) );
-    else
-        return 0x00;
+    if ((hlRevision != conf->hlRevision) || (hlNick != activeNick)) {
+        QStringList words = conf->hlWords;
+        words << activeNick;
+        words << conf->hlNicks.value(support.network.toUpper());
+
+        highlighter.setWords(words);
+        highlighter.setPatterns(conf->hlPatterns);
+        hlRevision = conf->hlRevision;
+        hlNick = activeNick;
+    }
+
+    return highlighter.match(text, trigger);
 }
 
 /*!
- * \param mode Channel user-mode (such as o, v, h, etc)
+ * \param name Window name
+ * \param type Window type (see constants.h for WT_*)
+ * \param activate Activate window on creation
  *
- * Checks if the usermode is valid.
- * \return true if valid, false otherwise.
+ * Emits RequestWindow only if the window doesn't exist already, so incoming messages
+ * to open windows doesn't go through IdealIRC::CreateSubWindow each time.
  */
-bool IConnection::isValidCuMode(char mode)
+void IConnection::requestWindow(QString name, int type, bool activate)
 {
-    return cumode.contains(mode);
+    if (! windowExist(name))
+        emit RequestWindow(name, type, cid, activate);
 }
 
 /*!
- * \param l Channel user-mode letter (such as @, +, %, etc)
+ * \param name Window name
  *
- * Checks if the usermode letter is valid.
- * \return true if valid, false otherwise.
+ * Tries to find a subwindow by a given name.
+ * \return true if window exist, false otherwise.
  */
-bool IConnection::isValidCuLetter(char l)
+bool IConnection::windowExist(QString name)
 {
-    return culetter.contains(l);
+    return winlist.contains(name.toUpper());
 }
 
 /*!
@@ -523,14 +1134,39 @@ QString IConnection::trimCtrlCodes(QString &text)
  */
 void IConnection::print(const QString &window, const QString &sender, const QString &line, const int ptype)
 {
-    IWin *w = NULL; // Default value of *w is NULL to make sure we can error-check.
+    ICoreWindow *w = NULL; // Default value of *w is NULL to make sure we can error-check.
     w = getWinObj(window.toUpper()); // Attempt to get window object...
     if (w == NULL) // No such window, go back to default...
         w = getWinObj("STATUS"); // Default to Status window, this one always exsist.
     if ((w == NULL) && (window == "STATUS"))
         return; // Nowhere to send this text, ignore silently...
 
-    w->print(sender, line, ptype); // Do printing
+    w->print(sender, line, ptype, msgTime); // Do printing
+}
+
+/*!
+ * \param nickname Nickname who made the offer
+ * \param type DCC type, CHAT or SEND
+ *
+ * Accepts a DCC offer and opens its window.
+ * \return false if there's no such offer.
+ */
+bool IConnection::acceptDcc(QString nickname, QString type)
+{
+    QString key = QString("%1 %2").arg(nickname.toUpper()).arg(type.toUpper());
+    if (! dccOffers.contains(key))
+        return false;
+
+    dccinfo = dccOffers.take(key);
+
+    if (type.toUpper() == "CHAT")
+        emit RequestWindow(nickname, WT_DCCCHAT, cid, true);
+    else {
+        QString file = DCCDetails::split(dccinfo).value(3);
+        emit RequestWindow(QString("%1 (%2)").arg(file).arg(nickname), WT_DCCRECV, cid, true);
+    }
+
+    return true;
 }
 
 /*!
@@ -585,33 +1221,6 @@ QString IConnection::intipv4toStr(unsigned int addr)
             .arg(byte[3]);
 }
 
-/*!
- * Clears the sort rules and rebuild it.
- */
-void IConnection::resetSortRules()
-{
-    // sortrule is a QList of char that is inserted in what order we like it to be.
-    // Clear it so we can reset it.
-    sortrule.clear();
-
-    // On the topp, add any culetters (@,%,+ etc) which goes on top in nicklist box.
-    if (culetter.length() > 0)
-        sortrule.append( culetter ); // These goes first, so operators come on top, etc. The IRC server decides this order via ISupport!
-
-    // Add numbers, letters and signs that are typically allowed in a nickname.
-    for (char i = 0x30; i <= 0x39; i++)
-        sortrule.append(i); // Numbers
-    for (char i = 0x41; i <= 0x5A; i++) {
-        // Add letters such as A a B b C c D d
-        sortrule.append(i); // Uppercase
-        sortrule.append(i+0x20); // Lowercase
-    }
-    for (char i = 0x5B; i <= 0x60; i++)
-        sortrule.append(i); // [\]^_`
-    for (char i = 0x7B; i <= 0x7D; i++)
-        sortrule.append(i); // {|}
-}
-
 /*!
  * \return QString of active window name, in uppercase.
  */
@@ -675,10 +1284,13 @@ user_t IConnection::parseUserinfo(QString uinfo)
  *
  * \return Pointer to the given channel's channel config dialog. On failure, returns NULL.
  */
-IChanConfig* IConnection::getChanConfigPtr(QString channel)
+ICoreChanSettings* IConnection::getChanConfigPtr(QString channel)
 {
-    subwindow_t sw = winlist.value(channel.toUpper());
-    return sw.widget->settings;
+    ICoreWindow *w = getWinObj(channel);
+    if (w == NULL)
+        return NULL;
+
+    return w->chanSettings();
 }
 
 /*!
@@ -709,6 +1321,190 @@ QString IConnection::getMsg(QString &data)
     return data.mid(l);
 }
 
+/*!
+ * \param tags IRCv3 message tags, without the leading '@'. Example: time=2019-01-01T12:00:00.000Z;batch=yXNAbvnRHTRBv
+ *
+ * Fills msgTags, msgTime and msgBatch for the message being parsed.
+ */
+void IConnection::parseTags(const QString &tags)
+{
+    QStringList list = tags.split(';', QString::SkipEmptyParts);
+    for (int i = 0; i <= list.count()-1; i++) {
+        QString key = list[i].section('=', 0, 0);
+        QString raw = list[i].section('=', 1);
+
+        // Unescape the value
+        QString value;
+        for (int c = 0; c <= raw.length()-1; c++) {
+            if ((raw[c] != '\\') || (c == raw.length()-1)) {
+                if (raw[c] != '\\')
+                    value += raw[c];
+                continue;
+            }
+
+            QChar n = raw[++c];
+            if (n == ':')
+                value += ';';
+            else if (n == 's')
+                value += ' ';
+            else if (n == 'r')
+                value += '\r';
+            else if (n == 'n')
+                value += '\n';
+            else
+                value += n;
+        }
+
+        msgTags.insert(key, value);
+    }
+
+    if (msgTags.contains("time")) {
+        QDateTime dt = QDateTime::fromString(msgTags.value("time"), Qt::ISODate);
+        if (dt.isValid())
+            msgTime = dt.toMSecsSinceEpoch();
+    }
+
+    msgBatch = msgTags.value("batch");
+}
+
+/*!
+ * Requests the capabilities the server offers that we support.\n
+ * When there's nothing more to request or wait for, negotiation ends and registration continues.
+ */
+void IConnection::capRequest()
+{
+    QStringList req = caps.request();
+    if (req.count() > 0) {
+        sockwrite( QString("CAP REQ :%1").arg(req.join(' ')) );
+        return;
+    }
+
+    if (caps.negotiating && (! caps.isWaiting())) {
+        sockwrite("CAP END");
+        caps.negotiating = false;
+    }
+}
+
+/*!
+ * \param channel Channel we just joined
+ *
+ * If we got disconnected from the channel, asks the server or bouncer for what we missed since
+ * the last line we had (draft/chathistory or znc.in/playback).\n
+ * The replies come in a batch, see historyLine() and endBatch().
+ */
+void IConnection::requestHistory(QString channel)
+{
+    if (! backfillFrom.contains(channel.toUpper()))
+        return;
+
+    qint64 from = backfillFrom.take(channel.toUpper());
+    if (from <= 0)
+        return; // Window was empty, nothing to fill in.
+    from -= HISTORY_OVERLAP; // Clocks may differ, duplicates are thrown out.
+
+    if (caps.has("draft/chathistory")) {
+        int limit = (support.maxChatHistory > 0) ? support.maxChatHistory : HISTORY_LIMIT;
+        QString ts = QDateTime::fromMSecsSinceEpoch(from).toUTC().toString("yyyy-MM-dd'T'HH:mm:ss.zzz'Z'");
+        sockwrite( QString("CHATHISTORY LATEST %1 timestamp=%2 %3")
+                     .arg(channel)
+                     .arg(ts)
+                     .arg(limit)
+                  );
+    }
+    else if (caps.has("znc.in/playback"))
+        sockwrite( QString("PRIVMSG *playback :PLAY %1 %2")
+                     .arg(channel)
+                     .arg(from / 1000.0, 0, 'f', 3)
+                  );
+}
+
+/*!
+ * \param token Message split by space
+ * \param data The message
+ *
+ * Formats a replayed PRIVMSG or NOTICE the way it would be printed live, and adds it to its batch.\n
+ * Nothing else happens, no CTCP replies, highlights or script events.
+ */
+void IConnection::historyLine(const QStringList &token, QString &data)
+{
+    if (token.count() < 3)
+        return;
+
+    QString cmd = token[1].toUpper();
+    if ((cmd != "PRIVMSG") && (cmd != "NOTICE"))
+        return;
+
+    user_t u = parseUserinfo(token[0]);
+    QString text = getMsg(data);
+
+    t_text t;
+    t.ts = (msgTime > 0) ? msgTime : QDateTime::currentMSecsSinceEpoch();
+    t.reset = true;
+    t.type = (u.nick == activeNick) ? PT_OWNTEXT : PT_NORMAL;
+    t.sender = u.nick;
+
+    QString action = QString("%1ACTION ").arg(QChar(0x01));
+    if (cmd == "NOTICE") {
+        t.type = PT_NOTICE;
+        t.sender = QString("-%1-").arg(u.nick);
+    }
+    else if (text.startsWith(action, Qt::CaseInsensitive)) {
+        text.remove(0x01);
+        text = QString("* %1 %2").arg(u.nick).arg(text.mid(7));
+        t.type = PT_ACTION;
+        t.sender.clear();
+    }
+    else if (text.startsWith(QChar(0x01)))
+        return; // Other CTCPs aren't shown.
+    else if (conf->showUsermodeMsg) {
+        ICoreWindow *w = getWinObj(token[2]);
+        if (w != NULL) {
+            member_t m = w->ReadMember(u.nick);
+            if (m.mode.length() > 0)
+                t.sender.prepend(m.mode[0]);
+        }
+    }
+
+    t.text = text;
+    batches[msgBatch].lines << t;
+}
+
+/*!
+ * \param ref Batch reference
+ *
+ * The batch is complete. Netsplits and netjoins are printed as one line per window.
+ */
+void IConnection::endBatch(QString ref)
+{
+    if (! batches.contains(ref))
+        return;
+
+    ircbatch_t b = batches.take(ref);
+
+    if ((b.type == "chathistory") || (b.type == "znc.in/playback")) {
+        ICoreWindow *w = getWinObj(b.params.value(0));
+        if (w != NULL)
+            w->printHistory(b.lines);
+        return;
+    }
+
+    QString text;
+    if (b.type == "netsplit")
+        text = tr("Netsplit (%1): %2");
+    else if (b.type == "netjoin")
+        text = tr("Netjoin (%1): %2");
+    else
+        return;
+
+    QString servers = b.params.join(' ');
+
+    QHashIterator<QString,QStringList> i(b.members);
+    while (i.hasNext()) {
+        i.next();
+        print(i.key(), tstar, text.arg(servers).arg(i.value().join(", ")), PT_SERVINFO);
+    }
+}
+
 /*!
  * \param data Reference to data
  *
@@ -719,18 +1515,42 @@ void IConnection::parse(QString &data)
 {
 /*
   format
-  :nick!user@host num/cmd [target] :msg
+  [@tag=value;tag2 ]:nick!user@host num/cmd [target] :msg
 */
 
+    msgTags.clear();
+    msgTime = 0;
+    msgBatch.clear();
+
+    if (data.startsWith('@')) {
+        // IRCv3 message tags.
+        int sp = data.indexOf(' ');
+        if (sp == -1)
+            return;
+        parseTags(data.mid(1, sp-1));
+        data = data.mid(sp+1);
+    }
+
     QStringList token = data.split(" ");
+    if (token.size() < 2) // Rubbish, there should be at least two tokens separated by a space.
+        return;
+
     QString token0up = token[0].toUpper();
     QString token1up = token[1].toUpper();
 
+    int num = token[1].toInt();
 
-    if (token.size() < 2) // Rubbish, there should be at least two tokens separated by a space.
+    if ((num == 0) && isIgnored(token, token1up))
         return;
 
-    int num = token[1].toInt();
+    if ((num == 0) && (! msgBatch.isEmpty())) {
+        QString type = batchType();
+        if ((type == "chathistory") || (type == "znc.in/playback")) {
+            // Replayed, collect it for IWin::printHistory() and don't act on it.
+            historyLine(token, data);
+            return;
+        }
+    }
 
     if (num > 0) { // valid NUMERIC
         QString params;
@@ -767,6 +1587,69 @@ void IConnection::parse(QString &data)
         return;
     }
 
+    else if (token1up == "CAP") {
+        // :irc.server CAP * LS * :multi-prefix sasl       (more LS lines follows)
+        // :irc.server CAP * LS :batch server-time
+        // :irc.server CAP nickname ACK :multi-prefix batch
+        if (token.count() < 4)
+            return;
+
+        QString sub = token[3].toUpper();
+        QString list = getMsg(data);
+        bool more = (token.count() > 5) && (token[4] == "*");
+
+        if ((sub == "LS") || (sub == "NEW")) {
+            caps.offered(list);
+            if (! more)
+                capRequest();
+        }
+
+        else if (sub == "DEL")
+            caps.removed(list);
+
+        else if (sub == "ACK") {
+            QStringList on = caps.acknowledged(list);
+            if (on.count() > 0)
+                print("STATUS", tstar, tr("Capabilities enabled: %1").arg(on.join(' ')), PT_LOCALINFO);
+            capRequest();
+        }
+
+        else if (sub == "NAK") {
+            caps.refused(list);
+            capRequest();
+        }
+
+        return;
+    }
+
+    else if (token1up == "BATCH") {
+        // :irc.server BATCH +yXNAbvnRHTRBv netsplit irc.hub other.host
+        // :irc.server BATCH -yXNAbvnRHTRBv
+        if (token.count() < 3)
+            return;
+
+        QString ref = token[2].mid(1);
+        if (token[2].startsWith('+')) {
+            ircbatch_t b;
+            b.type = token.value(3).toLower();
+            b.params = token.mid(4);
+            batches.insert(ref, b);
+        }
+        else
+            endBatch(ref);
+
+        return;
+    }
+
+    else if (token1up == "AWAY") {
+        // away-notify
+        // :nick!user@host AWAY :Gone fishing
+        // :nick!user@host AWAY              (back again)
+        user_t u = parseUserinfo(token[0]);
+        ial.setAway(u.nick, token.count() > 2);
+        return;
+    }
+
     else if (token0up == "PING") {
         sockwrite( QString("PONG %1")
                      .arg(token[1])
@@ -810,6 +1693,7 @@ void IConnection::parse(QString &data)
         // CTCP check, ACTION check
         if (text[0] != ' ') {
             bool ctcpReceived = false;
+            bool ctcpReply = true;
 
             QString request;
             QStringList tx = text.split(" ");
@@ -824,7 +1708,7 @@ void IConnection::parse(QString &data)
                 if (! isValidChannel(target))
                     target = u.nick; // Target was not a channel, but a private message. Write action to own window for u.nick
 
-                emit RequestWindow(target, WT_PRIVMSG, cid, false);
+                requestWindow(target, WT_PRIVMSG);
                 print( target.toUpper(), "", QString("* %1 %2")
                                         .arg(u.nick)
                                         .arg(text),
@@ -838,10 +1722,16 @@ void IConnection::parse(QString &data)
                 // CTCP indicator
                 QString ctcp = tx.at(0);
                 ctcp.remove(QChar(0x01));
-                print( "STATUS", u.nick, tr("[CTCP %1]")
-                                   .arg(ctcp),
-                       PT_CTCP
-                      );
+
+                // DCC negotiation is never replied to here, so it must not use up reply tokens.
+                bool show = true;
+                if (ctcp.toUpper() != "DCC")
+                    ctcpReply = ctcpResponder.request(u.host, ctcp.toUpper(), &show);
+                if (show)
+                    print( "STATUS", u.nick, tr("[CTCP %1]")
+                                       .arg(ctcp),
+                           PT_CTCP
+                          );
                 ctcpReceived = true;
             }
             request.clear();
@@ -856,10 +1746,11 @@ void IConnection::parse(QString &data)
                                   .arg(VERSION_STRING)
                                   .arg(SYSTEM_NAME);
 
-                sockwrite( QString("NOTICE %1 :%2")
-                             .arg(u.nick)
-                             .arg(reply)
-                          );
+                if (ctcpReply)
+                    sockwrite( QString("NOTICE %1 :%2")
+                                 .arg(u.nick)
+                                 .arg(reply)
+                              );
                 return;
             }
             request.clear();
@@ -877,10 +1768,11 @@ void IConnection::parse(QString &data)
                                   .arg(time)
                                   .arg(date);
 
-                sockwrite( QString("NOTICE %1 :%2")
-                             .arg(u.nick)
-                             .arg(reply)
-                          );
+                if (ctcpReply)
+                    sockwrite( QString("NOTICE %1 :%2")
+                                 .arg(u.nick)
+                                 .arg(reply)
+                              );
                 return;
             }
             request.clear();
@@ -893,10 +1785,11 @@ void IConnection::parse(QString &data)
                                   .arg(QChar(0x01))
                                   .arg(tx[1]);
 
-                sockwrite( QString("NOTICE %1 :%2")
-                             .arg(u.nick)
-                             .arg(reply)
-                          );
+                if (ctcpReply)
+                    sockwrite( QString("NOTICE %1 :%2")
+                                 .arg(u.nick)
+                                 .arg(reply)
+                              );
 
                 return;
             }
@@ -905,9 +1798,6 @@ void IConnection::parse(QString &data)
             request.append(0x01);
             request.append("DCC");
             if (tx.at(0).toUpper() == request) { // DCC
-                return; // FIXME dcc is disabled for now.
-
-                // DCC
                 /*
 
 mirc
@@ -918,17 +1808,46 @@ xchat
 [in] :Tomatix_!tomatix@148.46.164.82.customer.cdi.no PRIVMSG Tomatix :DCC SEND "01 - Logo.png" 199 0 18980 1
 */
 
-                if (token[4] == "CHAT") {
-                    unsigned int ip = token[6].toUInt();
-                    QString sip = intipv4toStr(ip);
-                    print( activewin(), "", "CHAT ip: " + sip);
-                    print( activewin(), "", "CHAT intip: " + QString::number(ipv4toint(sip)));
-
-                    dccinfo = text.replace(char(0x01), ""); // delete 0x01 (ctcp indicators)
-                    dccinfo = dccinfo.mid(4, dccinfo.length());
-                    dccinfo.prepend(activeNick + " " + u.nick + " ");
-
-                    emit RequestWindow(u.nick, WT_DCCCHAT, cid);
+                QString dcctype = tx.value(1).toUpper();
+                if ((dcctype == "RESUME") || (dcctype == "ACCEPT")) {
+                    // RESUME file port position: they want to resume a file we offered.
+                    // ACCEPT file port position: they agreed to resume a file we're getting.
+                    QStringList d = DCCDetails::split(text.remove(QChar(0x01)));
+                    frontEnd->dccResume(dcctype, u.nick, d.value(3).toUShort(), d.value(4).toLongLong());
+                }
+                else if ((dcctype == "CHAT") || (dcctype == "SEND")) {
+                    QString info = text.remove(QChar(0x01)); // delete 0x01 (ctcp indicators)
+                    info = info.mid(4, info.length());
+                    info.prepend(activeNick + " " + u.nick + " ");
+
+                    // An answer to our passive offer has their port and our token:
+                    // me nick SEND file ip port size token
+                    // me nick CHAT chat ip port token
+                    QStringList d = DCCDetails::split(info);
+                    QString token = d.value(dcctype == "SEND" ? 7 : 6);
+                    quint16 port = d.value(5).toUShort();
+                    if ((! token.isEmpty()) && (port > 0)
+                            && (frontEnd->dccPassiveAnswer(token, u.nick, intipv4toStr(d.value(4).toUInt()), port)))
+                        return;
+
+                    dccOffers.insert(QString("%1 %2").arg(u.nick.toUpper()).arg(dcctype), info);
+
+                    if (conf->dccAutoAccept)
+                        acceptDcc(u.nick, dcctype);
+                    else if (dcctype == "CHAT")
+                        print( "STATUS", tstar, tr("%1 offers a DCC chat. Type /dcc chat %1 to accept.")
+                                                  .arg(u.nick),
+                               PT_LOCALINFO
+                              );
+                    else {
+                        qint64 size = d.count() > 6 ? d[6].toLongLong() : 0;
+                        print( "STATUS", tstar, tr("%1 offers the file %2 (%3). Type /dcc get %1 to accept.")
+                                                  .arg(u.nick)
+                                                  .arg(d.value(3))
+                                                  .arg(DCCDetails::formatSize(size)),
+                               PT_LOCALINFO
+                              );
+                    }
                 }
 
                 return;
@@ -940,10 +1859,11 @@ xchat
 
         QString name = u.nick;
         if (isValidChannel(token[2].toUpper()) == false) { // Privmsg
-            emit RequestWindow(name, WT_PRIVMSG, cid, false);
+            requestWindow(name, WT_PRIVMSG);
             print( name.toUpper(), name, text);
             subwindow_t w = winlist.value(name.toUpper());
-            emit HighlightWindow(w.wid, HL_MSG);
+            if (w.window != NULL)
+                w.window->markHighlight(HL_MSG);
             emit RequestTrayMsg(tr("Private MSG from %1").arg(name), text);
         }
         else { // Channel
@@ -953,8 +1873,9 @@ xchat
                            .arg(name)
                            .arg(text);
 
+            requestWindow(chan, WT_CHANNEL);
             subwindow_t w = winlist.value(chan.toUpper());
-            member_t m = w.widget->ReadMember(name);
+            member_t m = w.window->ReadMember(name);
 
             if ((conf->showUsermodeMsg == true) && (m.mode.length() > 0)) {
                 sender.prepend(m.mode[0]);
@@ -965,21 +1886,22 @@ xchat
                        .arg(text);
             }
 
-            emit RequestWindow(chan, WT_CHANNEL, cid, false);
+            QString trigger;
+            bool highlight = isHighlight(text, &trigger);
 
-            if (text.contains(activeNick, Qt::CaseInsensitive)) {
+            if (highlight) {
                 print(chan.toUpper(), sender, text, PT_HIGHLIGHT);
-                emit HighlightWindow(w.wid, HL_HIGHLIGHT);
+                if (w.window != NULL)
+                    w.window->markHighlight(HL_HIGHLIGHT);
+
+                emit RequestTrayMsg(chan, traymsg);
+                scriptParent->runevent(te_highlight, QStringList()<<name<<chan<<text<<trigger);
             }
             else {
                 print(chan.toUpper(), sender, text);
-                emit HighlightWindow(w.wid, HL_MSG);
+                if (w.window != NULL)
+                    w.window->markHighlight(HL_MSG);
             }
-
-            // Check if our nickname is in the text, if so, put up a tray notify
-            if (text.indexOf(activeNick, Qt::CaseInsensitive) > -1)
-                emit RequestTrayMsg(chan, traymsg);
-
         }
         // privmsg script event
         scriptParent->runevent(te_msg, QStringList()<<name<<token[2]<<text);
@@ -1063,6 +1985,8 @@ xchat
         ial.addChannel(u.nick, chan);
         ial.setHostname(u.nick, u.host);
         ial.setIdent(u.nick, u.user);
+        if (caps.has("extended-join") && (token.count() > 3))
+            ial.setAccount(u.nick, token[3]); // :nick!user@host JOIN #channel account :Real name
 
         if (u.nick == activeNick) { // I am joining a channel
             emit RequestWindow(chan, WT_CHANNEL, cid, true);
@@ -1070,19 +1994,33 @@ xchat
                                      .arg(chan),
                    PT_SERVINFO
                   );
+            requestHistory(chan);
+
+            // With userhost-in-names, NAMES already gave us ident and hostname.
+            if (conf->ialWhoOnJoin && (! caps.has("userhost-in-names"))) {
+                // Fill the IAL with ident and hostname of everyone in one go.
+                whoPending << chan.toUpper();
+                if (support.haveWhox)
+                    sockwrite( QString("WHO %1 %tcuhnfa,%2").arg(chan, IAL_WHOX_TOKEN) );
+                else
+                    sockwrite( QString("WHO %1").arg(chan) );
+            }
         }
         else { // Someone joined a channel I am on
-            print( chan, tstar, tr("Joins: %1 (%2@%3)")
-                                     .arg(u.nick)
-                                     .arg(u.user)
-                                     .arg(u.host),
-                   PT_SERVINFO
-                  );
-
             member_t mt = {u.nick, u.user, u.host};
-            IWin *w = getWinObj(chan);
-            if (w != NULL)
+            ICoreWindow *w = getWinObj(chan);
+            if (w != NULL) {
+              if (batchType() == "netjoin")
+                  batches[msgBatch].members[chan.toUpper()] << u.nick; // Printed as one line at the end of the batch.
+              else
+                  w->printMemberEvent(ME_JOIN, u.nick, tr("Joins: %1 (%2@%3)")
+                                                         .arg(u.nick)
+                                                         .arg(u.user)
+                                                         .arg(u.host),
+                                      PT_SERVINFO, msgTime
+                                     );
               w->insertMember(u.nick, mt);
+            }
         }
 
         // join script event.
@@ -1105,25 +2043,24 @@ xchat
         if (windowExist(chan) == false)
             return;
 
+        QString partText;
         if (msg.length() > 0)
-            print( chan.toUpper(), tstar, tr("Parts: %1 (%2@%3) (%4)")
-                                            .arg(u.nick)
-                                            .arg(u.user)
-                                            .arg(u.host)
-                                            .arg(msg),
-                   PT_SERVINFO
-                  );
+            partText = tr("Parts: %1 (%2@%3) (%4)")
+                         .arg(u.nick)
+                         .arg(u.user)
+                         .arg(u.host)
+                         .arg(msg);
         else
-            print( chan.toUpper(), tstar, tr("Parts: %1 (%2@%3)")
-                                            .arg(u.nick)
-                                            .arg(u.user)
-                                            .arg(u.host),
-                   PT_SERVINFO
-                  );
-
-        IWin *w = getWinObj(chan);
-        if (w != NULL)
+            partText = tr("Parts: %1 (%2@%3)")
+                         .arg(u.nick)
+                         .arg(u.user)
+                         .arg(u.host);
+
+        ICoreWindow *w = getWinObj(chan);
+        if (w != NULL) {
+            w->printMemberEvent(ME_PART, u.nick, partText, PT_SERVINFO, msgTime);
             w->removeMember(u.nick);
+        }
 
         bool e = windowExist(chan);
         if ((u.nick == activeNick) && (e == true)) {
@@ -1151,7 +2088,7 @@ xchat
                PT_SERVINFO
               );
 
-        IWin *w = getWinObj(chan);
+        ICoreWindow *w = getWinObj(chan);
         if (w != NULL)
             w->removeMember(target);
 
@@ -1172,20 +2109,24 @@ xchat
 
         ial.delNickname(u.nick);
 
+        bool netsplit = (batchType() == "netsplit");
+
         QHashIterator<QString,subwindow_t> w(winlist); // Set up iterator for all open windows, to find this user
         while (w.hasNext()) {
             w.next();
-            if (w.value().widget->memberExist(u.nick) == true) { // Member is in here.
-                QString wName = w.value().widget->objectName();
-                print( wName, tstar, tr("Quit: %1 (%2@%3) (%4)")
-                                       .arg(u.nick)
-                                       .arg(u.user)
-                                       .arg(u.host)
-                                       .arg(msg),
-                       PT_LOCALINFO
-                      );
-
-                w.value().widget->removeMember(u.nick);
+            if (w.value().window->memberExist(u.nick) == true) { // Member is in here.
+                if (netsplit)
+                    batches[msgBatch].members[w.key()] << u.nick; // Printed as one line at the end of the batch.
+                else
+                    w.value().window->printMemberEvent(ME_QUIT, u.nick, tr("Quit: %1 (%2@%3) (%4)")
+                                                                          .arg(u.nick)
+                                                                          .arg(u.user)
+                                                                          .arg(u.host)
+                                                                          .arg(msg),
+                                                       PT_LOCALINFO, msgTime
+                                                      );
+
+                w.value().window->removeMember(u.nick);
             }
         }
         // quit script event.
@@ -1212,9 +2153,9 @@ xchat
             QString mode;
             for (int i = 3; i <= token.size()-1; i++) { mode += token[i] + ' '; } // Modes to parse (e.g. +ov user user)
 
-            IWin *tg = getWinObj(target);
-            if (tg->settings)
-                tg->settings->setDefaultMode(mode); // it is safe; this will ignore user-based channel modes like op, voice, ban etc
+            ICoreWindow *tg = getWinObj(target);
+            if ((tg != NULL) && (tg->chanSettings() != NULL))
+                tg->chanSettings()->setDefaultMode(mode); // it is safe; this will ignore user-based channel modes like op, voice, ban etc
 
             print( target.toUpper(), tstar, tr("%1 sets mode %2")
                                               .arg(u.nick)
@@ -1233,8 +2174,22 @@ xchat
                     continue;
                 }
 
+                // Remember the key for rejoining.
+                if ((m == 'k') && (p == '+') && (parapos < token.count()))
+                    channelKeys.insert(target.toUpper(), token[parapos]);
+                if ((m == 'k') && (p == '-'))
+                    channelKeys.remove(target.toUpper());
+
+                // Keep the IAL ban list up to date, used for matching bans against users.
+                if ((m == 'b') && (parapos < token.count())) {
+                    if (p == '+')
+                        ial.addBan(target, token[parapos]);
+                    else
+                        ial.delBan(target, token[parapos]);
+                }
+
                 // Handle stuff if IChanConfig is running
-                IChanConfig *cc = getChanConfigPtr(target);
+                ICoreChanSettings *cc = getChanConfigPtr(target);
                 if (cc != NULL) {
                     MaskType mt;
 
@@ -1255,14 +2210,14 @@ xchat
                 }
 
                 // Check if we must increment parapos...
-                if ((cmA.contains(m) || cmB.contains(m)) || ((p == '+') && (cmC.contains(m))))
+                if ((support.cmA.contains(m) || support.cmB.contains(m)) || ((p == '+') && (support.cmC.contains(m))))
                     parapos++;
 
                 if (isValidCuMode(m)) {
                     // Mode is a valid "channel usermode", store it
                     QString param = token[parapos];
                     parapos++; // user modes to channel isn't in the cm* lists. increment.
-                    IWin *w = getWinObj(target);
+                    ICoreWindow *w = getWinObj(target);
                     if (p == '+') {
                         ial.addMode(param, target, getCuLetter(m));
                         w->MemberSetMode(param, getCuLetter(m));
@@ -1303,14 +2258,14 @@ xchat
         QHashIterator<QString,subwindow_t> w(winlist); // Set up iterator for all open windows, to find this user
         while (w.hasNext()) {
             w.next();
-            QString wName = w.value().widget->objectName();
-            if (w.value().widget->memberExist(u.nick) == true) { // Member is in here.
+            QString wName = w.key();
+            if (w.value().window->memberExist(u.nick) == true) { // Member is in here.
                 print(wName, tstar, tr("%1 is now known as %2")
                                       .arg(u.nick)
                                       .arg(newnick),
                        PT_SERVINFO
                       );
-                w.value().widget->memberSetNick(u.nick, newnick);
+                w.value().window->memberSetNick(u.nick, newnick);
             }
         }
         return;
@@ -1329,7 +2284,7 @@ xchat
         ial.setHostname(u.nick, u.host);
         ial.setIdent(u.nick, u.user);
 
-        IWin *w = getWinObj(chan);
+        ICoreWindow *w = getWinObj(chan);
         w->setTopic(newTopic);
 
         emit refreshTitlebar();
@@ -1395,6 +2350,12 @@ void IConnection::parseNumeric(int numeric, QString &data)
 */
     QStringList token = data.split(' ');
 
+    if ((token.count() > 3) &&
+        ((numeric == ERR_NOSUCHCHANNEL) || (numeric == ERR_TOOMANYCHANNELS) ||
+         (numeric == ERR_CHANNELISFULL) || (numeric == ERR_INVITEONLYCHAN) ||
+         (numeric == ERR_BANNEDFROMCHAN) || (numeric == ERR_BADCHANNELKEY)))
+        dropStaleChannel(token[3]); // Couldn't rejoin after a reconnect.
+
     /** ***********************
     **        ERRORS        **
     ** *******************  **/
@@ -1507,7 +2468,7 @@ void IConnection::parseNumeric(int numeric, QString &data)
                 emit refreshTitlebar();
             }
             else {
-                IWin *w = getWinObj("Status");
+                ICoreWindow *w = getWinObj("Status");
                 w->setInputText("/Nick ");
                 activeNick = "?";
                 emit refreshTitlebar();
@@ -1691,6 +2652,7 @@ void IConnection::parseNumeric(int numeric, QString &data)
         // Not doing this will cause the client to act retarded.
         activeNick = token[2];
         active = true; // Connection is registered.
+        logPhase("001");
 
         ial.addNickname(activeNick);
 
@@ -1717,62 +2679,12 @@ void IConnection::parseNumeric(int numeric, QString &data)
                 line += c;
             }
             f.close();
-
-            // Auotjoin favourites
-            fname = QString("%1/favourites.ini").arg(CONF_PATH);
-            IniFile ini(fname);
-            QString channel;
-            QString password;
-            int count = ini.CountSections();
-            for (int i = 1; i <= count; i++) {
-                QString channelItem = ini.ReadIni(i);
-                QString passwordItem = ini.ReadIni(channelItem, "Key");
-                bool autojoin = (bool)ini.ReadIni(channelItem, "AutoJoin").toInt();
-
-                if (autojoin == true) {
-                    if (channel.length() > 0)
-                        channel.append(',');
-                    channel.append(channelItem);
-
-                    if (passwordItem.length() > 0) {
-                        if (password.length() > 0)
-                            password.append(',');
-                        else
-                            password.prepend(' ');
-                        password.append(passwordItem);
-                    }
-                }
-            }
-            if (channel.length() > 0) {
-                QString data = QString("JOIN %1%2")
-                                 .arg(channel)
-                                 .arg(password);
-                sockwrite(data);
-            }
         }
         QString hostinfo = QString("%1:%2")
                              .arg(host)
                              .arg(port);
 
-        if (conf->autoReJoin) {
-            // Rejoin channels which is open
-            QHashIterator<QString,subwindow_t> i(winlist);
-            QString channels;
-            while (i.hasNext()) {
-                i.next();
-                subwindow_t sw = i.value();
-
-                if (sw.type != WT_CHANNEL)
-                    continue;
-
-                QString target = sw.widget->getTarget();
-                if (! channels.isEmpty())
-                    channels.append(',');
-                channels.append(target);
-            }
-
-            sockwrite(QString("JOIN %1").arg(channels));
-        }
+        reconnectAttempts = 0;
 
         scriptParent->runevent(te_connect, QStringList()<<hostinfo);
     }
@@ -1787,141 +2699,19 @@ void IConnection::parseNumeric(int numeric, QString &data)
     }
 
     else if (numeric == RPL_ISUPPORT) {
-
-        /*****
-         *[IN] :irc.3phasegaming.net 005 Tomatix_ CMDS=KNOCK,MAP,DCCALLOW,USERIP,STARTTLS UHNAMES NAMESX SAFELIST HCN MAXCHANNELS=25 CHANLIMIT=#:25 MAXLIST=b:60,e:60,I:60 NICKLEN=30 CHANNELLEN=32 TOPICLEN=307 KICKLEN=307 AWAYLEN=307 :are supported by this server
-         *[IN] :irc.3phasegaming.net 005 Tomatix_ MAXTARGETS=20 WALLCHOPS WATCH=128 WATCHOPTS=A SILENCE=15 MODES=12 CHANTYPES=# PREFIX=(ohv)@%+ CHANMODES=beIqa,kfL,lj,psmntirRcOAQKVCuzNSMTGZ NETWORK=3PhaseGaming CASEMAPPING=ascii EXTBAN=~,qjncrRa ELIST=MNUCT :are supported by this server
-         ********/
-
-        isupport = true;
-
         int c = 0;
         for (int i = 0; i <= 2; i++)
             c += token[i].length() + 1;
         print("STATUS", "", data.mid(c));
 
-        for (int i = 3; i <= token.count()-1; i++) {
-            QStringList lst = token[i].split('=');
-
-            if (lst[0] == "CHANMODES") {
-                /*
-                * Unreal: CHANMODES=beIqa,kfL,lj,psmntirRcOAQKVCuzNSMTGZ
-                *   IRCu: CHANMODES=b,AkU,l,imnpstrDdR
-                *
-                * A = Mode that adds or removes a nick or address to a list. Always has a parameter.
-                * B = Mode that changes a setting and always has a parameter.
-                * C = Mode that changes a setting and only has a parameter when set.
-                * D = Mode that changes a setting and never has a parameter.
-                *
-                */
-
-                // Currently we only need to check list A.
-                QStringList ml = lst[1].split(',');
-                cmA = ml[0];
-                cmB = ml[1];
-                cmC = ml[2];
-                cmD = ml[3];
-
-                for (int j = 0; j <= cmA.length()-1; ++j) {
-                char c = cmA[j].toLatin1();
-
-                switch (c) {
-                    case 'e':
-                        haveExceptionList = true;
-                        continue;
-                    case 'I':
-                        haveInviteList = true;
-                        continue;
-                    }
-                }
-            }
-
-            if (lst[0] == "MAXLIST") {
-                // Unreal: MAXLIST=b:60,e:60,I:60
-                // IRCu: See MAXBANS
-                // IRCnet: MAXLIST=beI:30
-
-                QStringList maxlist = lst[1].split(',');
-
-                for (int l = 0; l <= maxlist.count()-1; ++l) {
-                    QString item = maxlist[l];
-                    QString len = maxlist[l].split(':')[1]; // ooh so ugly, ohh I don't care
-                    // item can be b:60 or beI:30 (examples)
-                    // len is always a number e.g. 60
-                    for (int j = 0; j <= item.length()-1; j++) {
-                        char c = item[j].toLatin1();
-                        switch (c) {
-                            case 'b':
-                                maxBanList = len.toInt();
-                                continue;
-                            case 'e':
-                                maxExceptList = len.toInt();
-                                continue;
-                            case 'I':
-                                maxInviteList = len.toInt();
-                                continue;
-                            case ':':
-                                break;
-                        }
-                    }
-                }
-            }
-
-            if (lst[0] == "MAXBANS") {
-                // Quite simple, really.
-                maxBanList = lst[1].toInt();
-                maxExceptList = lst[1].toInt();
-                maxInviteList = lst[1].toInt();
-            }
-
-            if (lst.at(0) == "MODES")
-                maxModes = lst[1].toInt();
-
-
-            if (lst.at(0) == "NETWORK") {
-                subwindow_t sw = winlist.value("STATUS");
-                QString title = QString("Status (%1)").arg(lst[1]);
-
-                sw.treeitem->setText(0, title);
-                wsw->setTitle(sw.wid, title);
-            }
-
-            if (lst.at(0) == "PREFIX") {
-                //  PREFIX=(ohv)@%+
-                // ohv is cumode, @%+ is culetter
-                cumode.clear();
-                culetter.clear();
-
-                QString parse = lst[1];
-
-                enum pState { P_MODE, P_LETTER };
-                pState state = P_MODE;
-                for (int i = 0; i <= parse.length()-1; i++) {
-                    char c = parse[i].toLatin1();
-                    if (c == '(') {
-                        state = P_MODE;
-                        continue;
-                    }
-
-                    if (c == ')') {
-                        state = P_LETTER;
-                        continue;
-                    }
+        QString oldNetwork = support.network;
+        support.parse(token);
 
-                    if (state == P_MODE)
-                        cumode << c;
-
-                    if (state == P_LETTER)
-                        culetter << c;
-                }
-                resetSortRules();
-            }
+        if (support.network != oldNetwork) {
+            hlRevision = -1; // Pick up nickname aliases for this network.
 
-            if (lst[0] == "CHANTYPES") {
-                QString types = lst[1];
-                for (int j = 0; j <= types.count()-1; j++)
-                chantype << types[j].toLatin1();
-            }
+            subwindow_t sw = winlist.value("STATUS");
+            frontEnd->renameWindow(sw.wid, QString("Status (%1)").arg(support.network));
         }
         return;
     }
@@ -2114,15 +2904,7 @@ void IConnection::parseNumeric(int numeric, QString &data)
     }
 
     else if (numeric == RPL_LISTSTART) {
-        IChannelList *cl = *chanlistPtr;
-        if (cl == NULL)
-            listInDialog = false;
-        else {
-            if (cl->isVisible())
-                listInDialog = true;
-            else
-                listInDialog = false;
-        }
+        listInDialog = frontEnd->channelListVisible();
         print("STATUS", tstar, tr("Downloading /LIST..."), PT_LOCALINFO);
 
         return;
@@ -2133,10 +2915,8 @@ void IConnection::parseNumeric(int numeric, QString &data)
         QString users = token[4];
         QString topic = getMsg(data);
 
-        if (listInDialog) {
-            IChannelList *cl = *chanlistPtr;
-            cl->addItem(channel, users, trimCtrlCodes(topic));
-        }
+        if (listInDialog)
+            frontEnd->channelListItem(channel, users, trimCtrlCodes(topic));
         else {
             QString text = QString("%1 (%2 users): %3")
                              .arg(channel)
@@ -2162,7 +2942,20 @@ void IConnection::parseNumeric(int numeric, QString &data)
         QString mode;
         for (int i = 4; i <= token.size()-1; i++) { mode += token[i] + ' '; }
 
-        IWin *w = getWinObj(chan);
+        // Remember the key for rejoining.
+        if (token.count() > 4) {
+            QString modes = token[4];
+            int parapos = 5;
+            for (int i = 0; i <= modes.length()-1; i++) {
+                char m = modes[i].toLatin1();
+                if ((m == 'k') && (parapos < token.count()))
+                    channelKeys.insert(chan.toUpper(), token[parapos]);
+                if (support.cmA.contains(m) || support.cmB.contains(m) || support.cmC.contains(m))
+                    parapos++;
+            }
+        }
+
+        ICoreWindow *w = getWinObj(chan);
         if (w == NULL) {
             print("STATUS", tstar, tr("Modes for %1: %2")
                                   .arg(chan)
@@ -2174,8 +2967,8 @@ void IConnection::parseNumeric(int numeric, QString &data)
         if (FillSettings == false)
             print(chan.toUpper(), tstar, tr("Modes: %1").arg(mode), PT_SERVINFO);
         else {
-            if (w->settings != NULL) {
-                w->settings->setDefaultMode(mode);
+            if (w->chanSettings() != NULL) {
+                w->chanSettings()->setDefaultMode(mode);
                 sockwrite(QString("MODE %1 +b").arg(chan));
             }
             else
@@ -2198,8 +2991,8 @@ void IConnection::parseNumeric(int numeric, QString &data)
         if (FillSettings == false)
             print(chan.toUpper(), tstar, tr("No topic is set."), PT_SERVINFO);
         else {
-            IWin *w = getWinObj(chan);
-            if (w->settings != NULL)
+            ICoreWindow *w = getWinObj(chan);
+            if (w->chanSettings() != NULL)
                 sockwrite(QString("MODE %1").arg(chan));
             else
                 FillSettings = false;
@@ -2211,7 +3004,7 @@ void IConnection::parseNumeric(int numeric, QString &data)
         QString chan = token[3];
         QString topic = getMsg(data);
 
-        IWin *w = getWinObj(chan);
+        ICoreWindow *w = getWinObj(chan);
         if (w == NULL) {
             print( "STATUS", "", tr("Topic for %1: %2")
                                .arg(chan)
@@ -2223,8 +3016,8 @@ void IConnection::parseNumeric(int numeric, QString &data)
         if (FillSettings == false)
             print(chan.toUpper(), tstar, tr("Topic is: %1").arg(topic), PT_SERVINFO);
         else {
-            if (w->settings != NULL) {
-                w->settings->setDefaultTopic(topic);
+            if (w->chanSettings() != NULL) {
+                w->chanSettings()->setDefaultTopic(topic);
                 sockwrite(QString("MODE %1").arg(chan));
             }
             else
@@ -2241,7 +3034,7 @@ void IConnection::parseNumeric(int numeric, QString &data)
         int utime = token[5].toInt();
         QString date = QDateTime::fromTime_t(utime).toString("ddd d MMM yyyy, hh:mm");
 
-        IWin *w = getWinObj(chan);
+        ICoreWindow *w = getWinObj(chan);
         if (w == NULL) {
             print( "STATUS", "", tr("%1 Topic set by %2, %3")
                                .arg(chan)
@@ -2251,7 +3044,7 @@ void IConnection::parseNumeric(int numeric, QString &data)
             return;
         }
 
-        if (w->settings == 0)
+        if (w->chanSettings() == NULL)
             print(chan, tstar, tr("Topic set by %2, %3")
                           .arg(nick)
                           .arg(date),
@@ -2297,6 +3090,20 @@ void IConnection::parseNumeric(int numeric, QString &data)
     }
 
     else if (numeric == RPL_WHOREPLY) {
+        // :server 352 me #channel ident host server nickname flags :hops realname
+        if (token.count() > 7) {
+            IALUser_t u;
+            u.nickname = token[7];
+            u.ident = token[4];
+            u.hostname = token[5];
+            u.away = (token.count() > 8) && token[8].startsWith('G'); // H is here, G is gone.
+            u.seen = 0;
+            whoBatch << u;
+
+            if (whoPending.contains(token[3].toUpper()))
+                return; // We asked for this to fill the IAL, don't print.
+        }
+
         int l = 0;
         for (int i = 0; i <= 2; i++)
             l += token[i].length() + 1;
@@ -2306,7 +3113,27 @@ void IConnection::parseNumeric(int numeric, QString &data)
         return;
     }
 
+    else if ((numeric == RPL_WHOSPCRPL) && (token.count() > 7) && (token[3] == IAL_WHOX_TOKEN)) {
+        // Our WHOX reply, :server 354 me 152 #channel ident host nickname flags account
+        IALUser_t u;
+        u.nickname = token[7];
+        u.ident = token[5];
+        u.hostname = token[6];
+        u.away = (token.count() > 8) && token[8].startsWith('G');
+        if ((token.count() > 9) && (token[9] != "0")) // 0 is not logged in.
+            u.account = token[9];
+        u.seen = 0;
+        whoBatch << u;
+        return;
+    }
+
     else if (numeric == RPL_ENDOFWHO) {
+        ial.setUsers(whoBatch);
+        whoBatch.clear();
+
+        if (whoPending.removeAll(token.at(3).toUpper()) > 0)
+            return; // We asked for this to fill the IAL, don't print.
+
         QString text = token.at(3);
         text += ": "+ getMsg(data);
         print("STATUS", "", text);
@@ -2323,8 +3150,14 @@ void IConnection::parseNumeric(int numeric, QString &data)
 
         subwindow_t win = winlist.value(chan.toUpper());
 
+        if (staleChannels.contains(chan.toUpper())) {
+            // Fresh member list after a reconnect, forget the old one.
+            staleChannels.removeAll(chan.toUpper());
+            ial.dropChannel(chan);
+        }
+
         if (! receivingNames) {
-            win.widget->resetMemberlist();
+            win.window->resetMemberlist();
             receivingNames = true;
         }
 
@@ -2335,25 +3168,45 @@ void IConnection::parseNumeric(int numeric, QString &data)
             if (nicks[i].count() == 0)
                 continue; // Empty nickname...
 
-            char l = item[0].toLatin1();
-            if (isValidCuLetter(l)) { // This user got a mode
-                mode = l; // Set mode
+            // With multi-prefix every mode is listed, highest first (@+nickname).
+            QList<char> modes;
+            while ((item.length() > 0) && isValidCuLetter(item[0].toLatin1())) {
+                char l = item[0].toLatin1();
+                if (mode == 0x00)
+                    mode = l;
+                modes << l;
                 item = item.mid(1); // Set nickname without mode
             }
 
             member_t m;
+
+            // With userhost-in-names, the entry is nickname!ident@host.
+            int ex = item.indexOf('!');
+            if (ex > 0) {
+                user_t u = parseUserinfo(item);
+                item = u.nick;
+                m.ident = u.user;
+                m.host = u.host;
+            }
+
             m.nickname = item;
             ial.addNickname(m.nickname);
             ial.addChannel(m.nickname, chan);
 
+            if (ex > 0) {
+                ial.setIdent(m.nickname, m.ident);
+                ial.setHostname(m.nickname, m.host);
+            }
+
             if (mode != 0x00) {
-                m.mode << mode;
+                m.mode << modes;
                 ial.resetModes(m.nickname, chan);
-                ial.addMode(m.nickname, chan, mode);
+                for (int j = 0; j <= modes.count()-1; j++)
+                    ial.addMode(m.nickname, chan, modes[j]);
             }
 
-            // Ident and host is unknown, for now. It's safe not to have it.            
-            win.widget->insertMember(item, m, false);
+            // Without userhost-in-names ident and host is unknown, for now. It's safe not to have it.
+            win.window->insertMember(item, m, false);
         }
     }
 
@@ -2361,7 +3214,7 @@ void IConnection::parseNumeric(int numeric, QString &data)
         QString chan = token[3];
         receivingNames = false;
         if (chan != "*")
-            winlist.value(chan.toUpper()).widget->sortMemberList();
+            winlist.value(chan.toUpper()).window->sortMemberList();
     }
 
     else if (numeric == RPL_LINKS) {
@@ -2386,13 +3239,12 @@ void IConnection::parseNumeric(int numeric, QString &data)
 
     else if ((numeric == RPL_MOTDSTART) && (conf->showMotd)) {
         print("STATUS", tstar, tr("Loading MOTD..."), PT_LOCALINFO);
-        motd.reset();
+        motdLines.clear();
         return;
     }
 
     else if ((numeric == RPL_MOTD) && (conf->showMotd)) {
-        QString text = getMsg(data);
-        motd.print("", text);
+        motdLines << getMsg(data);
         return;
     }
 
@@ -2400,7 +3252,8 @@ void IConnection::parseNumeric(int numeric, QString &data)
         print("STATUS", "", getMsg(data));
 
         if (conf->showMotd)
-            motd.show();
+            frontEnd->showMotd(cid, motdLines);
+        motdLines.clear();
 
         if (registered == true)
             return; // Stop here
@@ -2412,13 +3265,13 @@ void IConnection::parseNumeric(int numeric, QString &data)
             emit RequestFavourites();
 
         registered = true;
+        logPhase("end of MOTD");
 
-        if (cumode.count() == 0) {
-            // We're just connected, but no ISUPPORT were received. Use the default ones.
-            cumode << 'o' << 'v';
-            culetter << '@' << '+';
-            resetSortRules();
-        }
+        // We're just connected, but if no ISUPPORT were received, use the default ones.
+        support.useDefaultPrefix();
+
+        // ISUPPORT is known by now, so we can follow its limits when joining.
+        rejoinChannels();
 
 
         if (conf->connectInvisible == true)
@@ -2437,6 +3290,9 @@ void IConnection::parseNumeric(int numeric, QString &data)
         int created = token[6].toInt();
         QString date = QDateTime::fromTime_t(created).toString("ddd d MMM yyyy, hh:mm");
 
+        if (numeric == RPL_BANLIST)
+            ial.addBan(chan, token[4]);
+
         if (windowExist(chan) == false)
            // print("STATUS", token.at(4) + " set by " + token.at(5) + ", " + date);
             print("STATUS", "", tr("%1 set by %2, %3")
@@ -2445,10 +3301,10 @@ void IConnection::parseNumeric(int numeric, QString &data)
                                   .arg(date)
                   );
         else {
-            IWin *w = getWinObj(chan);
+            ICoreWindow *w = getWinObj(chan);
 
-            if ((FillSettings == true) && (w->settings != NULL))
-                w->settings->addMask(token[4], token[5], date);
+            if ((FillSettings == true) && (w->chanSettings() != NULL))
+                w->chanSettings()->addMask(token[4], token[5], date);
 
             if (FillSettings == false)
                 print(chan, "", tr("%1 set by %2, %3")
@@ -2471,15 +3327,15 @@ void IConnection::parseNumeric(int numeric, QString &data)
             return;
         }
 
-        IWin *w = getWinObj(chan);
+        ICoreWindow *w = getWinObj(chan);
 
         if (FillSettings == true) {
-            if (w->settings != NULL) {
-                w->settings->finishModel(MT_BAN);
+            if (w->chanSettings() != NULL) {
+                w->chanSettings()->finishModel(MT_BAN);
 
-                if (haveExceptionList)
+                if (support.haveExceptionList)
                     sockwrite(QString("MODE %1 +e").arg(chan));
-                else if (haveInviteList)
+                else if (support.haveInviteList)
                     sockwrite(QString("MODE %1 +I").arg(chan));
                 else
                     FillSettings = false;
@@ -2500,13 +3356,13 @@ void IConnection::parseNumeric(int numeric, QString &data)
             return;
         }
 
-        IWin *w = getWinObj(chan);
+        ICoreWindow *w = getWinObj(chan);
 
         if (FillSettings == true) {
-            if (w->settings != NULL) {
-                w->settings->finishModel(MT_EXCEPT);
+            if (w->chanSettings() != NULL) {
+                w->chanSettings()->finishModel(MT_EXCEPT);
 
-                if (haveInviteList)
+                if (support.haveInviteList)
                     sockwrite(QString("MODE %1 +I").arg(chan));
                 else
                     FillSettings = false;
@@ -2526,11 +3382,11 @@ void IConnection::parseNumeric(int numeric, QString &data)
                   );
             return;
         }
-        IWin *w = getWinObj(chan);
+        ICoreWindow *w = getWinObj(chan);
 
         if (FillSettings == true) {
-            if (w->settings != NULL) {
-                w->settings->finishModel(MT_INVITE);
+            if (w->chanSettings() != NULL) {
+                w->chanSettings()->finishModel(MT_INVITE);
                 FillSettings = false;
             }
         }
@@ -37,19 +37,37 @@
 #include <QObject>
 #include <QTcpSocket>
 #include <QList>
+#include <QHash>
+#include <QVector>
+#include <QTimer>
 #include <QTextCodec>
+#include <QElapsedTimer>
 
-#include "iwin.h"
 #include "config.h"
-#include "ichannellist.h"
-#include "imotdview.h"
 #include "ial.h"
-#include "iwindowswitcher.h"
+#include "isupport.h"
+#include "icap.h"
+#include "icommand.h"
+#include "icoreevents.h"
+#include "highlightengine.h"
+#include "ignorelist.h"
+#include "ctcpresponder.h"
+#include "hostconnector.h"
+#include "itls.h"
+#include "iperf.h"
+
+#define IAL_WHOX_TOKEN "152" //!< Query type token on our WHOX requests, tells our replies apart from the user's own /who.
+#define IRC_READ_BUFFER 65536 //!< Bytes. Read buffer size when the socket can't tell us its receive buffer size.
+#define IRC_MAXLINE 16384 //!< Bytes. Longer lines from the server are cut here, the rest is thrown away.
+#define IRC_SENDLINE_MAX 510 //!< Bytes in a line we send, not counting CR+LF.
+#define RECONNECT_BASE 2000 //!< Milliseconds to wait before the first reconnect attempt, doubled for each failed attempt.
+#define RECONNECT_MAX 300000 //!< Milliseconds we'll ever wait between reconnect attempts.
+#define REJOIN_BATCH 10 //!< Channels in one JOIN when rejoining, unless the server tells us (TARGMAX).
+#define HISTORY_LIMIT 100 //!< Messages to ask for per channel when backfilling, unless the server tells us (CHATHISTORY).
 
 // For accessing the IAL with a GUI
 //#include "iaddresslist.h"
 
-class ICommand;
 class TScriptParent;
 
 /*!
@@ -63,28 +81,46 @@ typedef struct T_USER {
 } user_t;
 
 
-class IConnection : public QObject
+/*!
+ * An IRCv3 batch we're receiving (BATCH +reference type params).
+ */
+typedef struct T_IRCBATCH {
+    QString type; //!< Batch type in lower case, such as netsplit, netjoin
+    QStringList params; //!< Parameters after the type.
+    QHash<QString,QStringList> members; //!< For netsplit and netjoin, nicknames per window.\n Key: Window name in upper case
+    QVector<t_text> lines; //!< For chathistory and znc.in/playback, the replayed lines.
+} ircbatch_t;
+
+class IConnection : public QObject, public ICoreEvents
 {
   Q_OBJECT
 
 public:
-      explicit IConnection(QObject *parent, IChannelList **clptr, int connId, config *cfg, TScriptParent *sp, IWindowSwitcher *ws);
+      explicit IConnection(QObject *parent, ICoreFrontEnd *fe, int connId, config *cfg, TScriptParent *sp);
       bool isOnline() { return active; } //!< \return true when we're registered to server.
-      bool isSocketOpen() { return socket.isOpen(); } //!< \return true when socket is connected.
+      bool isSocketOpen() { return socket->isOpen(); } //!< \return true when socket is connected.
       QString getActiveNickname() { return activeNick; } //!< \return QString of our actual nickname on this connection. May differ from config.
       void setServer(QString server = "", QString passwd = "");
       void tryConnect();
       void addWindow(QString name, subwindow_t win);
       void freeWindow(QString name);
       ICommand* getCmdHndlPtr() { return &cmdhndl; } //!< \return ICommand that belongs to here.
-      QList<char>* getSortRuleMapPtr() { return &sortrule; } //!< \return Pointer to the QList<char> of sort rule this connection generates.
+      QList<char>* getSortRuleMapPtr() { return support.getSortRuleMapPtr(); } //!< \return Pointer to the QList<char> of sort rule this connection generates.
+      ISupport* getISupport() { return &support; } //!< \return Pointer to what the server told us in RPL_ISUPPORT.
+      ICap* getCaps() { return &caps; } //!< \return Pointer to the IRCv3 capabilities of this connection.
       int getCid() { return cid; } //!< \return The ID of this IConnection
-      void closeConnection(bool shutdown = false); // shutdown is set to true if IIRC is shutting down.
+      void closeConnection(bool shutdown = false, QString reason = ""); // shutdown is set to true if IIRC is shutting down.
+      TScriptParent* getScriptParent() { return scriptParent; } //!< \return Pointer to the script parent.
       void setActiveInfo(QString *wn, int *ac);
-      char getCuLetter(char mode);
-      bool isValidCuMode(char mode);
-      bool isValidCuLetter(char l);
-      bool isValidChannel(QString channel);
+      void setIgnoreList(IgnoreList *il) { ignores = il; } //!< Sets the ignore list to check incoming messages against.
+      IgnoreList* getIgnoreList() { return ignores; } //!< \return Pointer to the ignore list.
+      ICoreFrontEnd* getFrontEnd() { return frontEnd; } //!< \return Pointer to the front end driving this connection.
+      CtcpResponder* getCtcpResponder() { return &ctcpResponder; } //!< \return Pointer to the CTCP rate limiter.
+      t_perfconn getTraffic() { return traffic; } //!< \return Traffic counted on this connection while IPerf is enabled.
+      char getCuLetter(char mode) { return support.getCuLetter(mode); } //!< See ISupport::getCuLetter()
+      bool isValidCuMode(char mode) { return support.isValidCuMode(mode); } //!< See ISupport::isValidCuMode()
+      bool isValidCuLetter(char l) { return support.isValidCuLetter(l); } //!< See ISupport::isValidCuLetter()
+      bool isValidChannel(QString channel) { return support.isValidChannel(channel); } //!< See ISupport::isValidChannel()
       subwindow_t getSubWindowStruct(QString wname) { return winlist.value(wname); } //!< \return subwindow_t structure of given window name.
       QString getConnectionInfo() { return host + ":" + QString::number(port); } //!< \return QString of the connections server:port
       QString trimCtrlCodes(QString &text);
@@ -93,22 +129,23 @@ public:
       void print(const QString &window, const QString &sender, const QString &line, const int ptype = PT_NORMAL);
       unsigned int ipv4toint(QString addr);
       QString intipv4toStr(unsigned int addr);
-      int maxBanList; //!< Maximum channel bans (+b) we can send to IRC server, defined in isupport (numeric 005). Default is 3.
-      int maxExceptList; //!< Maximum channel ban exceptions (+e) we can send to IRC server, defined in isupport (numeric 005). Default is 3.
-      int maxInviteList; //!< Maximum channel invites (+I) we can send to IRC server, defined in isupport (numeric 005). Default is 3.
-      int maxModes;
-      bool haveExceptionList; //!< True if IRC server supports ban exceptions. Default false.
-      bool haveInviteList; //!< True if IRC server supports invite lists. Default false.
+      quint32 getLocalIPv4() { return socket->localAddress().toIPv4Address(); } //!< \return Our IPv4 address as the IRC server sees it, 0 if not connected over IPv4.
+      bool acceptDcc(QString nickname, QString type);
       bool FillSettings; //!< Sets to true when we're about to show the channel settings dialog, to fill its data. When we're done filling the data, it sets back to false.\n This is for to not print text (topic, ban lists, etc) in the window.
 
-      QString getcmA() { return cmA; } //!< See cmA
-      QString getcmB() { return cmB; } //!< See cmB
-      QString getcmC() { return cmC; } //!< See cmC
-      QString getcmD() { return cmD; } //!< See cmD
+      QString getcmA() { return support.cmA; } //!< See ISupport::cmA
+      QString getcmB() { return support.cmB; } //!< See ISupport::cmB
+      QString getcmC() { return support.cmC; } //!< See ISupport::cmC
+      QString getcmD() { return support.cmD; } //!< See ISupport::cmD
 
       IAL ial; //!< Our IAL for this connection.
 
+      // ICoreEvents
+      bool sendLine(const QString &data) { return sockwrite(data); } //!< Sends a line to the server for the core classes.
+      void coreEvent(e_iircevent event, const QStringList &param);
+
       QString dccinfo; //!< Passes instructions to dcc derived classes.
+      QHash<QString,QString> dccOffers; //!< DCC offers waiting for /dcc get or /dcc chat.\n Key: "NICKNAME TYPE" in upper case\n Value: dccinfo to pass on.
 
 private:
       // for accessing the IAL with a GUI.
@@ -119,69 +156,116 @@ private:
       int cid; //!< Connection ID. Will never change. Equal to the ID of status window this belongs to.
       bool active; //!< Sets to true when RPL_WELCOME is received.
       bool registered; //!< Sets to true when RPL_ENDOFMOTD is received.
-      bool isupport; //!< true if the IRC server sent us an isupport (005)
       QString host; //!< IRC server hostname.
       QString password; //!< IRC server password.
       int port; //!< IRC server port.
+      bool tls; //!< Connect with TLS, the port was given as +port.
       QString serverName; //!< The server's reported hostname.
       QString activeNick; //!< Nickname we use for this connection.
-      QTcpSocket socket; //!< The actual TCP socket to the IRC server.
+      QTcpSocket *socket; //!< The actual TCP socket to the IRC server. Replaced by the one HostConnector hands us on connect.
+      HostConnector connector; //!< Resolves, races addresses and fails over to other servers of the network.
+      QElapsedTimer phaseClock; //!< Started when we start connecting, for logging how long each phase took.
+      qint64 phaseLast; //!< phaseClock value when the previous phase ended.
+      void logPhase(QString phase);
+      QTimer reconnectTimer; //!< Runs while we're waiting to reconnect.
+      QTimer handshakeTimer; //!< Runs during the TLS handshake, aborts it if the server stalls.
+      int reconnectAttempts; //!< Reconnect attempts since we were last registered. Used for the backoff.
+      QStringList staleChannels; //!< Channels (upper case) whose member list and IAL data is from before a reconnect, until fresh NAMES arrives.
+      QHash<QString,QString> channelKeys; //!< Channel keys (+k) we've seen.\n Key: Channel name in upper case\n Value: Key
+      void scheduleReconnect();
+      QHash<QString,qint64> backfillFrom; //!< Timestamp of the last line we had in each channel when we got disconnected.\n Key: Channel name in upper case
+      void requestHistory(QString channel);
+      void historyLine(const QStringList &token, QString &data);
+      void dropStaleChannel(QString channel);
+      void dropStaleState();
+      void rejoinChannels();
+      void setSocket(QTcpSocket *s);
       QHash<QString,subwindow_t> winlist; //!< Subwindows assosciated with this connection.
       QString *activeWname; //!< Pointer to active window name.
       int *activeConn; //!< Pointer to the active IRC connection ID. Might differ to this one!
       bool ShuttingDown; //!< True if we're about to shut down IdealIRC.
       bool tryingConnect; //!< True when we're attempting to connect to an IRC server.
-      IChannelList **chanlistPtr; //!< Used when we're filling the channel list.
-      bool listInDialog; //!< true if we're listing in a dialog. chanlistPtr must be set on beforehand!
+      ICoreFrontEnd *frontEnd; //!< Dialogs and window switcher, see ICoreFrontEnd.
+      bool listInDialog; //!< true if we're listing in the front end's channel list dialog.
       bool connectionClosing; //!< About to disconnect from the IRC server.
-      IMotdView motd; //!< MOTD dialog.
+      QStringList motdLines; //!< MOTD being received, handed to the front end at the end of it.
       QStringList acList; //<! Contains channel names we'd like to autocomplete. The nicknames is composed from IWin.
       TScriptParent *scriptParent; //!< Pointer to the script parent.
       bool receivingNames; //!< True when we're receiving NAMES command, for filling a nickname listbox.
+      QStringList whoPending; //!< Channels (upper case) we've sent WHO for to fill the IAL. Replies for these are not printed.
+      QList<IALUser_t> whoBatch; //!< WHO replies collected for the IAL, applied at end of WHO.
+      QString ialSnapshotFile();
+      int hlRevision; //!< config::hlRevision the highlighter was built from. -1 forces a rebuild.
+      QString hlNick; //!< Our nickname when the highlighter was built.
+      HighlightEngine highlighter; //!< Highlight words, our nickname and aliases for this network.
+      bool isHighlight(const QString &text, QString *trigger = NULL);
+      IgnoreList *ignores; //!< Pointer to the ignore list in IdealIRC class.
+      bool isIgnored(QStringList &token, QString &token1up);
+      CtcpResponder ctcpResponder; //!< Rate limits CTCP replies and status lines.
 
       /* For retreiving data, onSocketReadyRead() */
-      QByteArray linedata; //!< Socket reading buffer. When we receive CR+LF, this buffer will be parsed and reset for next line.
+      QByteArray readbuf; //!< Reused for every read, sized to the socket receive buffer when we connect.
+      QByteArray linedata; //!< Incomplete line carried over from the previous read.
+      bool lastCR; //!< Previous byte was a CR, so a LF following it ends the same line.
+      bool lineOverflow; //!< Current line passed IRC_MAXLINE, skip bytes until the line ends.
 
-      QList<char> chantype; //<! Channel types this server allows, such as #, &
-      QList<char> cumode; //<! Channel User-modes this server allows, such as +o +h +v, etc.
-      QList<char> culetter; //<! Same as cumode, Channel User-mode letters, such as @ % +, etc.
-      QList<char> sortrule; //<! All letters (culetter) in order which should be sorted by.
+      /* For sending data, sockwrite() */
+      QByteArray outbuf; //!< Encoded lines waiting to be written, see flushOutput().
+      bool flushQueued; //!< true when flushOutput() is scheduled for this event-loop turn.
+      t_perfconn traffic; //!< Bytes and lines in and out, counted while IPerf is enabled.
 
-      QString cmA; //!< Modes from isupport CHANMODES, A types.\n Mode that adds or removes a nick or address to a list. Always has a parameter.\n Default: b\n See http://www.irc.org/tech_docs/005.html
-      QString cmB; //!< Modes from isupport CHANMODES, B types.\n Mode that changes a setting and always has a parameter.\n Default: k\n See http://www.irc.org/tech_docs/005.html
-      QString cmC; //!< Modes from isupport CHANMODES, C types.\n Mode that changes a setting and only has a parameter when set.\n Default: l\n See http://www.irc.org/tech_docs/005.html
-      QString cmD; //!< Modes from isupport CHANMODES, D types.\n Mode that changes a setting and never has a parameter.\n default imnpstr\n See http://www.irc.org/tech_docs/005.html
+      ISupport support; //!< What the server told us in RPL_ISUPPORT (numeric 005).
+      ICap caps; //!< IRCv3 capabilities negotiated with CAP.
+
+      /* Message being parsed, from its IRCv3 tags */
+      QHash<QString,QString> msgTags; //!< Tags of the message.\n Key: Tag name\n Value: Unescaped value
+      qint64 msgTime; //!< From the server-time tag, milliseconds since epoch. 0 means now.
+      QString msgBatch; //!< Reference of the batch the message belongs to, empty if none.
+      QHash<QString,ircbatch_t> batches; //!< Batches we're receiving.\n Key: Reference
+      void parseTags(const QString &tags);
+      void capRequest();
+      QString batchType() { return batches.value(msgBatch).type; } //!< \return Type of the batch the message belongs to, empty if none.
+      void endBatch(QString ref);
 
       const QString tstar; //!< \return A QString with triple stars (***).
       const QString sstar; //!< \return A QString with a single star (*).
 
-      IChanConfig* getChanConfigPtr(QString channel);
+      ICoreChanSettings* getChanConfigPtr(QString channel);
 
       QTimer checkConnection; //!< Timer that run every 3 minutes, to check connection life. Whenever we receive data from the socket, the timer is restarted. If the timer time-outs, it sends "PING :ALIVE" to the server to test.
       int checkState; //!< Used with IConnection::checkConnection, different states of it.\n Valid values:\n 0: on timeout, send "PING :ALIVE" to server. Sets checkState to 1 and starts timer on 30 seconds.\n 1: on timeout, close socket (took too long to receive pong), server connection is dead.
 
-      QTimer conTimeout; //!< Timer that runs for config::timeout ms, and aborts connection attempt on timeout.
-
       QString getMsg(QString &data);
-      IWin* getWinObj(QString name); // Returns NULL if no matches.
+      ICoreWindow* getWinObj(QString name); // Returns NULL if no matches.
+      void requestWindow(QString name, int type, bool activate = false);
 
       user_t parseUserinfo(QString uinfo);
-      void parse(QString &data);
       void parseNumeric(int numeric, QString &data);
-      void resetSortRules();
       QString activewin();
 
-      IWindowSwitcher *wsw; //!< Pointer to the window switcher, which holds the button bar.
+protected:
+      virtual void lineReceived(QString &text);
+      void parse(QString &data);
 
 public slots:
       bool sockwrite(QString data);
 
 private slots:
       void onSocketConnected();
+      void onSocketEncrypted();
+      void onSslErrors(const QList<QSslError> &errors);
+      void handshakeTimeout();
       void onSocketDisconnected();
       void onSocketReadyRead();
+      void flushOutput();
       void checkConnectionTimeout();
-      void connectionAttemptTimeout();
+      void connectorTrying(QString server, int serverPort);
+      void connectorResolved(QString server, qint64 ms, bool cached);
+      void connectorConnected(QTcpSocket *s, QString server, qint64 dnsMs, qint64 connectMs);
+      void connectorFailed(QString server, int serverPort, QString reason);
+      void connectorExhausted();
+      void reconnectTimeout();
+      void ctcpSummary(QString text);
 
 signals:
       void RequestTrayMsg(QString title, QString message);
@@ -191,7 +275,6 @@ signals:
       void chanListItem(QString channel, QString users, QString topic);
       void RequestFavourites();
       void connectedToIRC();
-      void HighlightWindow(int wid, int type); // Name must be a window in this connection's windows!
       void connectionClosed(); // This one is only used when IIRC is about to exit.
       void updateConnectionButton();
 };
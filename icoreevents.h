@@ -0,0 +1,312 @@
+/*
+ *   IdealIRC - Internet Relay Chat client
+ *   Copyright (C) 2014  Tom-Andre Barstad
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+
+/*! \file icoreevents.h
+ *  \brief The narrow interfaces between the IRC core and whoever drives it.
+ *
+ * ICoreEvents: what core classes (IAL, ISupport and friends) need from the connection that owns them.\n
+ * ICoreWindow: what the core needs from a window. IWin implements it in the GUI.\n
+ * ICoreChanSettings: what the core needs from an open channel settings dialog.\n
+ * ICorePicture: what the script engine needs from a paintable window. TPictureWindow implements it.\n
+ * ICoreScriptDialog: what the script engine needs from a scriptable dialog. TCustomScriptDialog implements it.\n
+ * ICoreFrontEnd: everything else the core asks of its front end, dialogs and the window switcher.\n\n
+ *
+ * A headless front end (a bot, a bouncer, a test driver replaying a log) implements ICoreFrontEnd and
+ * ICoreWindow, and may return NULL from ICoreWindow::chanSettings(), ICoreWindow::picture() and
+ * ICoreFrontEnd::createScriptDialog().
+ */
+
+/*! \class ICoreEvents
+ *  \brief The narrow interface core classes use to reach the connection that owns them.
+ *
+ * Classes in the core library (IAL, ISupport and friends) must not know about IConnection,
+ * the script engine or any widget. When they need to write to the server or fire a script
+ * event, they go through this interface instead.\n
+ * IConnection implements it. A test driver for a single core class only needs to implement these two functions.
+ */
+
+#ifndef ICOREEVENTS_H
+#define ICOREEVENTS_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QList>
+#include <QBrush>
+#include <QPen>
+#include <QFont>
+#include <QPainterPath>
+#include "constants.h"
+
+class TScript;
+
+#define ME_JOIN 0 //!< Member event, see ICoreWindow::printMemberEvent()
+#define ME_PART 1
+#define ME_QUIT 2
+
+typedef struct T_TEXT {
+    int type; // what type? (what main color)
+    quint64 ts; // timestamp of when the text was written
+    QString sender; // who or what sent the text
+    QString text; // actual text
+    bool reset; // Used when printing texts, reset ctrl codes, links, etc.
+} t_text;
+
+typedef struct T_MEMBER {
+  QString nickname;
+  QString ident;
+  QString host;
+  QList<char> mode; // Store mode letters like +, @, etc (not the modes v, o, etc)
+} member_t;
+
+enum MaskType {
+    MT_BAN = 0,
+    MT_EXCEPT,
+    MT_INVITE
+};
+
+class ICoreEvents
+{
+public:
+    virtual ~ICoreEvents() {}
+
+    /*!
+     * \param data Line to send, without CR+LF.
+     *
+     * Sends a line to the IRC server.
+     * \return true if the line was sent, false otherwise.
+     */
+    virtual bool sendLine(const QString &data) = 0;
+
+    /*!
+     * \param event Script event to fire.
+     * \param param Parameters for the event.
+     *
+     * Notifies the front end (usually its script engine) about something that happened in the core.
+     */
+    virtual void coreEvent(e_iircevent event, const QStringList &param) = 0;
+};
+
+/*! \class ICoreChanSettings
+ *  \brief An open channel settings dialog, as the core sees it.
+ *
+ * While it's open, IConnection fills it from the topic, mode and list replies. See IConnection::FillSettings
+ */
+class ICoreChanSettings
+{
+public:
+    virtual ~ICoreChanSettings() {}
+    virtual void setDefaultMode(QString mode) = 0;
+    virtual void setDefaultTopic(QString topic) = 0;
+    virtual void addMask(QString mask, QString author, QString created, MaskType mt) = 0;
+    virtual void addMask(QString mask, QString author, QString created) = 0;
+    virtual void finishModel(MaskType type) = 0;
+    virtual void delMask(QString mask, MaskType type) = 0;
+    virtual QString getKey() = 0;
+};
+
+/*! \class ICorePicture
+ *  \brief The paintable part of a graphic window (WT_GRAPHIC and WT_GWINPUT), as the script engine sees it.
+ */
+class ICorePicture
+{
+public:
+    virtual ~ICorePicture() {}
+    virtual void clear() = 0; //!< Clears the current layer.
+    virtual void clearAll() = 0; //!< Clears all layers.
+    virtual void setBrushPen(QBrush b, QPen p) = 0;
+    virtual void paintDot(int x, int y) = 0;
+    virtual void paintLine(int x1, int y1, int x2, int y2) = 0;
+    virtual void paintText(int x, int y, QFont font, QString text) = 0;
+    virtual void paintRect(int x, int y, int w, int h) = 0;
+    virtual void paintCircle(int x, int y, int r) = 0;
+    virtual void paintEllipse(int x, int y, int rx, int ry) = 0;
+    virtual void paintImage(QString filename, int x, int y, bool dontBuffer) = 0;
+    virtual void paintFill(int x, int y, int w = -1, int h = -1) = 0;
+    virtual void paintFillPath(QPainterPath path) = 0;
+    virtual void clearImageBuffer() = 0;
+    virtual void setViewBuffer(bool b) = 0;
+    virtual void setLayer(QString name) = 0;
+    virtual void delLayer(QString name) = 0;
+    virtual void orderLayers(QStringList list) = 0;
+    virtual QString colorAt(QString layer, int x, int y) = 0;
+};
+
+/*! \class ICoreScriptDialog
+ *  \brief A dialog declared with dialog{} in a script, as the script engine sees it.
+ *
+ * The front end creates it, see ICoreFrontEnd::createScriptDialog(). The script owns and deletes it.
+ */
+class ICoreScriptDialog
+{
+public:
+    virtual ~ICoreScriptDialog() {}
+    virtual QString getName() = 0;
+    virtual void showDlg() = 0;
+    virtual void hideDlg() = 0;
+    virtual void closeDlg() = 0;
+    virtual void setTitle(QString title) = 0;
+    virtual void setGeometry(int X, int Y, int W, int H) = 0;
+    virtual bool addLabel(QString oname, int X, int Y, int W, int H, QString text) = 0;
+    virtual bool addButton(QString oname, int X, int Y, int W, int H, QString text) = 0;
+    virtual bool addEditbox(QString oname, int X, int Y, int W, int H) = 0;
+    virtual bool addTextbox(QString oname, int X, int Y, int W, int H) = 0;
+    virtual bool addListbox(QString oname, int X, int Y, int W, int H) = 0;
+    virtual QString getLabel(QString oname) = 0;
+    virtual QString getItem(QString oname, int pos) = 0;
+    virtual bool setLabel(QString oname, QString text) = 0;
+    virtual bool addItem(QString oname, QString text) = 0;
+    virtual bool reItem(QString oname, int idx, QString text) = 0;
+    virtual bool delItem(QString oname, int idx) = 0;
+    virtual bool clear(QString oname) = 0;
+};
+
+/*! \class ICoreWindow
+ *  \brief A status, channel, query or custom window, as the core sees it.
+ *
+ * subwindow_t::window points to one of these. The core never touches subwindow_t::widget.
+ */
+class ICoreWindow
+{
+public:
+    virtual ~ICoreWindow() {}
+    virtual QString getName() = 0; //!< \return Window name, as it was created with.
+    virtual QString getTarget() = 0; //!< \return Channel or nickname the window writes to.
+    virtual void print(const QString &sender, const QString &text, const int ptype = 0, qint64 ts = 0) = 0;
+    virtual void printMemberEvent(int event, const QString &nickname, const QString &text, const int ptype, qint64 ts = 0) = 0;
+    virtual void printHistory(QVector<t_text> batch) = 0;
+    virtual qint64 getLastTimestamp() = 0;
+    virtual void markHighlight(int type) = 0;
+    virtual void clear() = 0;
+    virtual void insertMember(QString nickname, member_t mt, bool sort = true) = 0;
+    virtual void removeMember(QString nickname, bool sort = true) = 0;
+    virtual bool memberExist(QString nickname) = 0;
+    virtual void memberSetNick(QString nickname, QString newnick) = 0;
+    virtual void sortMemberList(QString memberRemoved = "") = 0;
+    virtual void resetMemberlist() = 0;
+    virtual void MemberSetMode(QString nickname, char mode) = 0;
+    virtual void MemberUnsetMode(QString nickname, char mode) = 0;
+    virtual member_t ReadMember(QString nickname) = 0;
+    virtual void setInputText(QString text) = 0;
+    virtual void setTopic(QString newTopic) = 0;
+    virtual void execChanSettings() = 0; //!< Opens the channel settings dialog, if this is a channel.
+    virtual ICoreChanSettings* chanSettings() = 0; //!< \return The open channel settings dialog, NULL if none.
+    virtual QStringList getSelectedMembers() = 0; //!< \return Nicknames selected in the member list.
+    virtual int getWidth() = 0; //!< \return Width of the text or picture area, in pixels.
+    virtual int getHeight() = 0; //!< \return Height of the text or picture area, in pixels.
+    virtual int listboxWidth() = 0; //!< \return Width of the member list, in pixels.
+    virtual int listboxHeight() = 0; //!< \return Height of the member list, in pixels.
+    virtual ICorePicture* picture() = 0; //!< \return The paintable area, NULL unless this is a graphic window.
+};
+
+/*! \class ICoreFrontEnd
+ *  \brief What the core asks of the front end driving it.
+ *
+ * Window creation, tray messages and title bar updates are signals on IConnection and need no
+ * front end call. Everything here is a dialog or GUI state the core used to reach into directly.\n
+ * IdealIRC implements it.
+ */
+class ICoreFrontEnd
+{
+public:
+    virtual ~ICoreFrontEnd() {}
+
+    /*!
+     * \param wid Window ID
+     * \param title New title
+     *
+     * Renames a window in the window tree and switcher, such as "Status (network)".
+     */
+    virtual void renameWindow(int wid, const QString &title) = 0;
+
+    /*!
+     * \param cid Connection ID
+     * \param lines Message of the day
+     *
+     * Shows the MOTD, if the user wants it shown.
+     */
+    virtual void showMotd(int cid, const QStringList &lines) = 0;
+
+    virtual bool channelListVisible() = 0; //!< \return true if a /LIST should go into the channel list dialog.
+    virtual void channelListItem(const QString &channel, const QString &users, const QString &topic) = 0; //!< Adds a /LIST reply to the channel list dialog.
+
+    /*!
+     * \param request RESUME, they want to resume a file we offered. ACCEPT, they agreed to resume a file we're getting.
+     * \param nickname Who sent it
+     * \param port Port of the transfer
+     * \param position Byte to resume from
+     *
+     * Hands a DCC RESUME or ACCEPT to the matching file transfer.
+     */
+    virtual void dccResume(const QString &request, const QString &nickname, quint16 port, qint64 position) = 0;
+
+    /*!
+     * \param token Token from our passive offer
+     * \param nickname Who answered
+     * \param ipv4 Their address
+     * \param port Their port
+     *
+     * \return true if this answered a passive DCC offer of ours, which now connects to them.
+     */
+    virtual bool dccPassiveAnswer(const QString &token, const QString &nickname, const QString &ipv4, quint16 port) = 0;
+
+    virtual void showDccTransfers() = 0; //!< Shows the DCC transfers dialog.
+
+    /*!
+     * \param caption Dialog caption
+     *
+     * Asks the user for a file to open.
+     * \return Path, empty if cancelled or there's nobody to ask.
+     */
+    virtual QString getOpenFileName(const QString &caption) = 0;
+
+    /*!
+     * \param type CRITICAL, INFO, QUESTION or WARNING
+     * \param caption Dialog caption
+     * \param text Dialog text
+     * \param buttons Any of o (ok), c (cancel) and q (yes and no). Empty for ok and cancel.
+     *
+     * Shows a message box for a script.
+     * \return OK, CANCEL, YES or NO. Empty if nothing was pushed or there's nobody to ask.
+     */
+    virtual QString messageBox(const QString &type, const QString &caption, const QString &text, const QString &buttons) = 0;
+
+    /*!
+     * \param caption Dialog caption
+     * \param label Text above the input box
+     * \param ok Set to true if the user pushed OK
+     *
+     * Asks the user for a line of text, for a script.
+     * \return The text, empty if cancelled or there's nobody to ask.
+     */
+    virtual QString getText(const QString &caption, const QString &label, bool *ok) = 0;
+
+    /*!
+     * \param script Script the dialog belongs to
+     * \param name Dialog name
+     *
+     * Creates an empty, hidden scriptable dialog. The script fills it while loading.
+     * \return The dialog, or NULL if this front end can't show dialogs.
+     */
+    virtual ICoreScriptDialog* createScriptDialog(TScript *script, const QString &name) = 0;
+};
+
+#endif // ICOREEVENTS_H
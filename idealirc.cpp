@@ -26,17 +26,22 @@
 #include <QDebug>
 #include <QPalette>
 #include <QMessageBox>
+#include <QFileDialog>
+#include <QInputDialog>
 
 #include "idealirc.h"
 #include "ui_idealirc.h"
 
 #include "iabout.h"
+#include "dcc/dcctransfer.h"
+#include "script/tcustomscriptdialog.h"
 
 IdealIRC::IdealIRC(QWidget *parent) :
     QMainWindow(parent),
     ui(new Ui::IdealIRC),
     firstShow(true),
     windowIsActive(true),
+    winreg(&winlist),
     confDlg(NULL),
     favourites(NULL),
     chanlist(NULL),
@@ -44,7 +49,9 @@ IdealIRC::IdealIRC(QWidget *parent) :
     connectionsRemaining(-1),
     preventSocketAction(false),
     reconnect(NULL),
-    scriptParent(this, this, &conf, &conlist, &winlist, &activeWid, &activeConn)
+    ignores(&conf),
+    dccmanager(&conf),
+    scriptParent(this, this, &conf, &conlist, &winlist, &winreg, &activeWid, &activeConn)
 {
     ui->setupUi(this);
 
@@ -64,6 +71,7 @@ IdealIRC::IdealIRC(QWidget *parent) :
     trayicon.setVisible(true);
 
     conf.rehash();
+    ignores.load();
 
     setGeometry(conf.mainWinGeo);
     if (conf.maximized)
@@ -326,22 +334,7 @@ void IdealIRC::keyReleaseEvent(QKeyEvent *e)
  */
 bool IdealIRC::WindowExists(QString name, int parent)
 {
-    QHashIterator<int, subwindow_t> i(winlist);
-    while (i.hasNext()) {
-        i.next();
-
-        subwindow_t sw = i.value();
-
-        if ((sw.widget->objectName().toUpper() == name.toUpper()) && (i.value().parent == parent)) {
-            if (sw.type == WT_STATUS)
-                return false;
-            else
-                return true;
-        }
-    }
-
-
-    return false;
+    return winreg.exists(parent, name); // Status windows are not indexed, so they never "exist" here.
 }
 
 /*!
@@ -372,7 +365,6 @@ void IdealIRC::subWinClosed(int wid)
     }
 
     std::cout << "Closing " << sw.widget->objectName().toStdString().c_str() << " (" << wid << ")" << std::endl;
-    scriptParent.resetMenuPtrList();
 
     if (sw.type == WT_STATUS) {
         // Closing a status window.
@@ -412,7 +404,6 @@ void IdealIRC::subWinClosed(int wid)
         IConnection *con = conlist.value(sw.parent, NULL);
         if (con != NULL)
             con->freeWindow( sw.widget->objectName() );
-        winlist.remove(sw.wid);
     }
 
     if (sw.type == WT_CHANNEL) {
@@ -420,15 +411,19 @@ void IdealIRC::subWinClosed(int wid)
         con->sockwrite("PART :" + sw.widget->objectName() );
     }
 
-    if (sw.type == WT_STATUS)
+    if (sw.type == WT_STATUS) {
         wsw.delGroup(sw.wid);
+        delete motdViews.take(sw.wid);
+    }
     else
         wsw.delWindow(sw.wid);
 
+    // Forget the window before deleting it, anything it signals while dying must not find it.
+    winreg.remove(wid);
+    winlist.remove(wid);
     ui->treeWidget->removeItemWidget(sw.treeitem, 0);
     delete sw.treeitem;
     delete sw.widget;
-    winlist.remove(wid);
 
     /**
        @note Do we need to delete the other pointers from subwindow_t ?
@@ -442,7 +437,7 @@ void IdealIRC::subWinClosed(int wid)
  * \param activate Activate window on creation
  *
  * Creates a new subwindow.\n
- * Specify Parent 0 if it's a custom (scriptable window).\n
+ * Specify Parent WP_CUSTOM if it's a custom (scriptable window).\n
  * DCC windows sets their parent to the IConnection that created it. It won't be a child of this IConnection though.
  * \return -1 if failed, otherwise Window ID
  */
@@ -458,7 +453,7 @@ int IdealIRC::CreateSubWindow(QString name, int type, int parent, bool activate)
 
     if ((type >= WT_DCCSEND) && (type <= WT_DCCCHAT)) {
         IConnection *c = conlist.value(parent, NULL);
-        s = new IWin(ui->mdiArea, name, type, &conf, &scriptParent, c);
+        s = new IWin(ui->mdiArea, name, type, &conf, &scriptParent, c, &dccmanager);
 
         parent = 0;
     }
@@ -468,8 +463,9 @@ int IdealIRC::CreateSubWindow(QString name, int type, int parent, bool activate)
     IConnection *connection = conlist.value(parent, NULL);
     if (type == WT_STATUS) {
         qDebug() << "Window is status, new connection added with id " << s->getId();
-        connection = new IConnection(this, &chanlist, s->getId(), &conf, &scriptParent, &wsw);
+        connection = new IConnection(this, this, s->getId(), &conf, &scriptParent);
         connection->setActiveInfo(&activeWname, &activeConn);
+        connection->setIgnoreList(&ignores);
         connect(connection, SIGNAL(connectionClosed()),
                 this, SLOT(connectionClosed()));
         connect(connection, SIGNAL(connectedToIRC()),
@@ -527,11 +523,13 @@ int IdealIRC::CreateSubWindow(QString name, int type, int parent, bool activate)
     wt.type = type;
     wt.wid = s->getId();
     wt.widget = s;
+    wt.window = s;
     wt.highlight = HL_NONE;
 
     qDebug() << "Adding subwindow_t to winlist...";
 
     winlist.insert(s->getId(), wt);
+    winreg.add(wt);
 
     wsw.addWindow(type, name, wt.wid, parent);
 
@@ -545,8 +543,6 @@ int IdealIRC::CreateSubWindow(QString name, int type, int parent, bool activate)
         connection->addWindow("STATUS", wt);
         connect(connection, SIGNAL(RequestWindow(QString,int,int,bool)),
                 this, SLOT(CreateSubWindow(QString,int,int,bool)));
-        connect(connection, SIGNAL(HighlightWindow(int,int)),
-                this, SLOT(Highlight(int,int)));
     }
 
     if (connection != NULL) {
@@ -637,7 +633,7 @@ void IdealIRC::on_mdiArea_subWindowActivated(QMdiSubWindow *arg1)
 
         // found it here.
         activeWid = sw.wid;
-        sw.treeitem->setForeground(0, QBrush(QColor(conf.colWindowlist)));
+        sw.treeitem->setForeground(0, conf.theme.windowlistBrush);
         sw.highlight = HL_NONE;
         ui->treeWidget->setCurrentItem(sw.treeitem);
         updateConnectionButton();
@@ -954,19 +950,19 @@ void IdealIRC::updateTreeViewColor()
 {
     QPalette treePal = ui->treeWidget->palette();
 
-    treePal.setColor(QPalette::Active,    QPalette::Base,            conf.colWindowlistBackground);
-    treePal.setColor(QPalette::Active,    QPalette::AlternateBase,   conf.colWindowlistBackground);
-    treePal.setColor(QPalette::Inactive,  QPalette::Base,            conf.colWindowlistBackground);
-    treePal.setColor(QPalette::Inactive,  QPalette::AlternateBase,   conf.colWindowlistBackground);
-    treePal.setColor(QPalette::Disabled,  QPalette::Base,            conf.colWindowlistBackground);
-    treePal.setColor(QPalette::Disabled,  QPalette::AlternateBase,   conf.colWindowlistBackground);
+    treePal.setColor(QPalette::Active,    QPalette::Base,            conf.theme.windowlistBackground);
+    treePal.setColor(QPalette::Active,    QPalette::AlternateBase,   conf.theme.windowlistBackground);
+    treePal.setColor(QPalette::Inactive,  QPalette::Base,            conf.theme.windowlistBackground);
+    treePal.setColor(QPalette::Inactive,  QPalette::AlternateBase,   conf.theme.windowlistBackground);
+    treePal.setColor(QPalette::Disabled,  QPalette::Base,            conf.theme.windowlistBackground);
+    treePal.setColor(QPalette::Disabled,  QPalette::AlternateBase,   conf.theme.windowlistBackground);
 
-    treePal.setColor(QPalette::Active,    QPalette::Text,            conf.colWindowlist);
-    treePal.setColor(QPalette::Active,    QPalette::WindowText,      conf.colWindowlist);
-    treePal.setColor(QPalette::Inactive,  QPalette::Text,            conf.colWindowlist);
-    treePal.setColor(QPalette::Inactive,  QPalette::WindowText,      conf.colWindowlist);
-    treePal.setColor(QPalette::Disabled,  QPalette::Text,            conf.colWindowlist);
-    treePal.setColor(QPalette::Disabled,  QPalette::WindowText,      conf.colWindowlist);
+    treePal.setColor(QPalette::Active,    QPalette::Text,            conf.theme.windowlist);
+    treePal.setColor(QPalette::Active,    QPalette::WindowText,      conf.theme.windowlist);
+    treePal.setColor(QPalette::Inactive,  QPalette::Text,            conf.theme.windowlist);
+    treePal.setColor(QPalette::Inactive,  QPalette::WindowText,      conf.theme.windowlist);
+    treePal.setColor(QPalette::Disabled,  QPalette::Text,            conf.theme.windowlist);
+    treePal.setColor(QPalette::Disabled,  QPalette::WindowText,      conf.theme.windowlist);
 
     ui->treeWidget->setPalette(treePal);
 
@@ -976,7 +972,7 @@ void IdealIRC::updateTreeViewColor()
         subwindow_t sw = i.next().value();
         if (sw.highlight != HL_NONE)
             continue;
-        sw.treeitem->setForeground(0, QBrush(QColor(conf.colWindowlist)));
+        sw.treeitem->setForeground(0, conf.theme.windowlistBrush);
     }
 }
 
@@ -1152,3 +1148,156 @@ void IdealIRC::rebuildCustomToolbar()
     ui->toolBar->addActions( customToolButtons );
     ui->menuTools->addActions( customToolButtons );
 }
+
+/*!
+ * \param wid Window ID
+ * \param title New title
+ *
+ * Renames a window in the tree view and window switcher.
+ */
+void IdealIRC::renameWindow(int wid, const QString &title)
+{
+    subwindow_t sw = winlist.value(wid);
+    if (sw.treeitem == NULL)
+        return;
+
+    sw.treeitem->setText(0, title);
+    wsw.setTitle(wid, title);
+}
+
+/*!
+ * \param cid Connection ID
+ * \param lines Message of the day
+ *
+ * Shows the MOTD of a connection in its own dialog.
+ */
+void IdealIRC::showMotd(int cid, const QStringList &lines)
+{
+    IMotdView *mv = motdViews.value(cid, NULL);
+    if (mv == NULL) {
+        mv = new IMotdView(&conf, this);
+        motdViews.insert(cid, mv);
+    }
+
+    mv->reset();
+    QStringListIterator i(lines);
+    while (i.hasNext()) {
+        QString line = i.next();
+        mv->print("", line);
+    }
+    mv->show();
+}
+
+/*!
+ * \param channel Channel name
+ * \param users User count
+ * \param topic Topic, without control codes
+ *
+ * Adds a /LIST reply to the channel list dialog.
+ */
+void IdealIRC::channelListItem(const QString &channel, const QString &users, const QString &topic)
+{
+    if (chanlist != NULL)
+        chanlist->addItem(channel, users, topic);
+}
+
+/*!
+ * See ICoreFrontEnd::dccResume()
+ */
+void IdealIRC::dccResume(const QString &request, const QString &nickname, quint16 port, qint64 position)
+{
+    DCCTransfer *t = dccmanager.find(request == "RESUME" ? DCC_SEND : DCC_RECV, nickname, port);
+    if (t != NULL)
+        t->resume(position);
+}
+
+/*!
+ * See ICoreFrontEnd::dccPassiveAnswer()
+ */
+bool IdealIRC::dccPassiveAnswer(const QString &token, const QString &nickname, const QString &ipv4, quint16 port)
+{
+    DCC *dcc = dccmanager.findPassive(token);
+    if ((dcc == NULL) || (dcc->getTarget().toUpper() != nickname.toUpper()))
+        return false;
+
+    dcc->connectTo(ipv4, port);
+    return true;
+}
+
+/*!
+ * \param caption Dialog caption
+ *
+ * \return Path of the file picked, empty if cancelled.
+ */
+QString IdealIRC::getOpenFileName(const QString &caption)
+{
+    return QFileDialog::getOpenFileName(this, caption);
+}
+
+/*!
+ * See ICoreFrontEnd::messageBox()
+ */
+QString IdealIRC::messageBox(const QString &type, const QString &caption, const QString &text, const QString &buttons)
+{
+    QMessageBox::StandardButtons btn = QMessageBox::NoButton;
+    if (buttons.isEmpty())
+        btn = QMessageBox::Ok | QMessageBox::Cancel;
+
+    for (int i = 0; i <= buttons.length()-1; ++i) {
+        char c = buttons[i].toLatin1();
+        switch (c) {
+            case 'o':
+                btn |= QMessageBox::Ok;
+                break;
+            case 'c':
+                btn |= QMessageBox::Cancel;
+                break;
+            case 'q':
+                btn |= (QMessageBox::Yes | QMessageBox::No);
+                break;
+        }
+    }
+
+    int b = QMessageBox::NoButton;
+    if (type == "CRITICAL")
+        b = QMessageBox::critical(this, caption, text, btn);
+
+    else if (type == "INFO")
+        b = QMessageBox::information(this, caption, text, btn);
+
+    else if (type == "QUESTION")
+        b = QMessageBox::question(this, caption, text, btn);
+
+    else if (type == "WARNING")
+        b = QMessageBox::warning(this, caption, text, btn);
+
+    if (b == QMessageBox::Ok)
+        return "OK";
+    if (b == QMessageBox::Cancel)
+        return "CANCEL";
+    if (b == QMessageBox::Yes)
+        return "YES";
+    if (b == QMessageBox::No)
+        return "NO";
+
+    return "";
+}
+
+/*!
+ * See ICoreFrontEnd::getText()
+ */
+QString IdealIRC::getText(const QString &caption, const QString &label, bool *ok)
+{
+    return QInputDialog::getText(this, caption, label, QLineEdit::Normal, "", ok);
+}
+
+/*!
+ * \param script Script the dialog belongs to
+ * \param name Dialog name
+ *
+ * \return A new, hidden scriptable dialog with IdealIRC as its parent.
+ */
+ICoreScriptDialog* IdealIRC::createScriptDialog(TScript *script, const QString &name)
+{
+    return new TCustomScriptDialog(script, name, this);
+}
@@ -48,7 +48,12 @@
 #include "versionchecker.h"
 #include "ifavourites.h"
 #include "ichannellist.h"
+#include "imotdview.h"
+#include "icoreevents.h"
 #include "iwindowswitcher.h"
+#include "iwindowregistry.h"
+#include "ignorelist.h"
+#include "dcc/dccmanager.h"
 
 #include "script/tscriptparent.h"
 #include "script/iscriptmanager.h"
@@ -57,7 +62,7 @@ namespace Ui {
     class IdealIRC;
 }
 
-class IdealIRC : public QMainWindow
+class IdealIRC : public QMainWindow, public ICoreFrontEnd
 {
   Q_OBJECT
     
@@ -68,6 +73,19 @@ public:
       //IWin* GetWindowObject();
       bool WindowExists(QString name, int parent);
       int currentStatus();
+
+      // ICoreFrontEnd
+      void renameWindow(int wid, const QString &title);
+      void showMotd(int cid, const QStringList &lines);
+      bool channelListVisible() { return (chanlist != NULL) && chanlist->isVisible(); } //!< \return true if the channel list dialog is open.
+      void channelListItem(const QString &channel, const QString &users, const QString &topic);
+      void dccResume(const QString &request, const QString &nickname, quint16 port, qint64 position);
+      bool dccPassiveAnswer(const QString &token, const QString &nickname, const QString &ipv4, quint16 port);
+      void showDccTransfers() { dccmanager.showDialog(); } //!< Shows the DCC transfers dialog.
+      QString getOpenFileName(const QString &caption);
+      QString messageBox(const QString &type, const QString &caption, const QString &text, const QString &buttons);
+      QString getText(const QString &caption, const QString &label, bool *ok);
+      ICoreScriptDialog* createScriptDialog(TScript *script, const QString &name);
     
 private:
       Ui::IdealIRC *ui; //!< Qt Creator generated GUI class.
@@ -75,6 +93,7 @@ private:
       bool windowIsActive; //!< IdealIRC is the active window (got the focus).
       bool readyToClose; //!< By default, this variable "floats", got no apparent value until we are about to close IdealIRC.\n When we're about to close, this one sets to false until all IRC connections are closed, then it's set to true and IdealIRC will close down.
       QHash<int,subwindow_t> winlist; //!< Windows list. All subwindows is stored here.\n Key: Window ID\n Value: Subwindow.
+      IWindowRegistry winreg; //!< Name lookup of the windows list.
       QHash<int,IConnection*> conlist; //!< Connections list.\n Key: Connection ID. This ID is bound to its Status subwindow ID.\n Value: Connection.
       int activeWid; //!< Current active window ID.
       QString activeWname; //!< Current active window name.\n Use activeWid for lookup methods.
@@ -83,10 +102,13 @@ private:
       IConfig *confDlg; //!< Configuration dialog pointer.
       IFavourites *favourites; //!< Favourites dialog pointer.
       IChannelList *chanlist; //!< Channel list dialog pointer.
+      QHash<int,IMotdView*> motdViews; //!< MOTD dialogs.\n Key: Connection ID\n Value: Dialog, created the first time that connection shows its MOTD.
       IScriptManager *scriptManager; //!< Script manager diaog pointer.
       int connectionsRemaining; //!< When closing IdealIRC, we must wait for all connections to close before exiting IdealIRC. This one counts backwards for each disconneciton.
       bool preventSocketAction; //!< Used when updating connection toolbutton, when using setChecked it also performs its signal.
       IConnection *reconnect; //!< When re-using a current active connection, to connect somewhere else, set this to the pointer of that connection.
+      IgnoreList ignores; //!< Ignored users, shared by all connections.
+      DCCManager dccmanager; //!< DCC transfer queue and bandwidth limits, shared by all connections.
       VersionChecker vc; //!< As the class name suggest, a version checker. Disabled by default.
       TScriptParent scriptParent; //!< Main instance of the script parent, where all scripts are loaded and events are pushed into.
       QSystemTrayIcon trayicon; //!< System tray icon.
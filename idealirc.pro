@@ -24,23 +24,20 @@ TEMPLATE = app
 
 RC_FILE = idealirc.rc
 
+include(core.pri)
+
 SOURCES += main.cpp\
         idealirc.cpp \
     iwin.cpp \
-    config.cpp \
-    inifile.cpp \
     tpicturewindow.cpp \
     qmylineedit.cpp \
     qmylistwidget.cpp \
-    iconnection.cpp \
     iconfig.cpp \
     iconfig/iconfiggeneral.cpp \
     iconfig/iservereditor.cpp \
     iconfig/servermodel.cpp \
     iconfig/iconfigperform.cpp \
     iconfig/iconfiglogging.cpp \
-    servermgr.cpp \
-    icommand.cpp \
     ichanconfig.cpp \
     bantablemodel.cpp \
     unsupportedmodel.cpp \
@@ -51,38 +48,22 @@ SOURCES += main.cpp\
     ifavourites.cpp \
     ichannellist.cpp \
     imotdview.cpp \
-    ial.cpp \
-    script/tsockfactory.cpp \
-    script/tsock.cpp \
     script/tsdialog.cpp \
-    script/tscriptparent.cpp \
-    script/tscriptinternalfunctions.cpp \
-    script/tscript.cpp \
-    script/ttimer.cpp \
-    script/tscriptcommand.cpp \
     script/tcustomscriptdialog.cpp \
     script/iscriptmanager.cpp \
     script/editor/iscripteditor.cpp \
     script/editor/tscripteditorhighlighter.cpp \
     script/editor/editorwidget.cpp \
-    script/tscript/commands.cpp \
-    script/tscript/containers.cpp \
-    script/tscript/dialogs.cpp \
-    script/tscript/events.cpp \
-    script/tscript/extracters.cpp \
-    script/tscript/loadscript.cpp \
-    script/tscript/menu.cpp \
-    script/tscript/runf.cpp \
-    script/tscript/solvers.cpp \
-    script/tscript/utils.cpp \
     dcc/dccsend.cpp \
     dcc/dccchat.cpp \
     dcc/dcc.cpp \
     dcc/dccrecv.cpp \
+    dcc/dcctransfer.cpp \
+    dcc/dccmanager.cpp \
+    dcc/dccmanagerdialog.cpp \
     iircview.cpp \
     ibuttonbar.cpp \
     iwindowswitcher.cpp \
-    script/tscriptinternalfunctions/n.cpp \
     script/editor/iscripteditorsettings.cpp \
     script/editor/iscripteditoree.cpp
 
@@ -90,22 +71,15 @@ SOURCES += main.cpp\
 
 HEADERS  += idealirc.h \
     iwin.h \
-    constants.h \
-    config.h \
-    inifile.h \
     tpicturewindow.h \
     qmylistwidget.h \
     qmylineedit.h \
-    iconnection.h \
     iconfig.h \
     iconfig/iconfiggeneral.h \
     iconfig/iservereditor.h \
     iconfig/servermodel.h \
     iconfig/iconfigperform.h \
     iconfig/iconfiglogging.h \
-    servermgr.h \
-    numerics.h \
-    icommand.h \
     ichanconfig.h \
     bantablemodel.h \
     unsupportedmodel.h \
@@ -116,16 +90,7 @@ HEADERS  += idealirc.h \
     ifavourites.h \
     ichannellist.h \
     imotdview.h \
-    ial.h \
-    script/tsock.h \
     script/tsdialog.h \
-    script/tscriptparent.h \
-    script/tscriptinternalfunctions.h \
-    script/tscript.h \
-    script/tsockfactory.h \
-    script/ttimer.h \
-    script/exprtk/exprtk.hpp \
-    script/tscriptcommand.h \
     script/tcustomscriptdialog.h \
     script/iscriptmanager.h \
     script/editor/iscripteditor.h \
@@ -136,6 +101,9 @@ HEADERS  += idealirc.h \
     dcc/dcc.h \
     dcc/dccrecv.h \
     dcc/dcc_protocols.h \
+    dcc/dcctransfer.h \
+    dcc/dccmanager.h \
+    dcc/dccmanagerdialog.h \
     iircview.h \
     ibuttonbar.h \
     iwindowswitcher.h \
@@ -0,0 +1,396 @@
+/*
+ *   IdealIRC - Internet Relay Chat client
+ *   Copyright (C) 2014  Tom-Andre Barstad
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+
+#include <QDateTime>
+#include <QHashIterator>
+#include <QMutableHashIterator>
+#include <QListIterator>
+
+#include "ignorelist.h"
+
+/*!
+ * \param cfg Pointer to config class (iirc.ini)
+ */
+IgnoreList::IgnoreList(config *cfg) :
+    conf(cfg)
+{
+}
+
+/*!
+ * Reads the permanent ignores from iirc.ini
+ */
+void IgnoreList::load()
+{
+    int count = conf->ini->CountItems("Ignore");
+    for (int i = 1; i <= count; ++i)
+        add( conf->ini->ReadIniItem("Ignore", i),
+             typesFromString(conf->ini->ReadIni("Ignore", i)) );
+}
+
+/*!
+ * Writes the permanent ignores to iirc.ini
+ */
+void IgnoreList::save()
+{
+    conf->ini->DelSection("Ignore");
+
+    QHashIterator<QString,ignore_t> i(list);
+    while (i.hasNext()) {
+        ignore_t ig = i.next().value();
+        if (ig.expires == 0)
+            conf->ini->WriteIni("Ignore", ig.mask.mask, typesToString(ig.types));
+    }
+}
+
+/*!
+ * \param mask Mask, missing parts are treated as *. See IAL::compileMask()
+ * \return Mask on the form nick!ident@host
+ */
+QString IgnoreList::normalize(QString mask)
+{
+    IALMask_t m = IAL::compileMask(mask);
+    return QString("%1!%2@%3")
+             .arg(m.nick.getPattern())
+             .arg(m.ident.getPattern())
+             .arg(m.host.getPattern());
+}
+
+/*!
+ * \param flags Letters, p=privmsg, n=notice, c=ctcp, i=invite. Empty means all.
+ * \return IGN_* flags
+ */
+int IgnoreList::typesFromString(QString flags)
+{
+    if (flags.isEmpty())
+        return IGN_ALL;
+
+    int types = 0;
+    flags = flags.toLower();
+    if (flags.contains('p'))
+        types |= IGN_PRIVMSG;
+    if (flags.contains('n'))
+        types |= IGN_NOTICE;
+    if (flags.contains('c'))
+        types |= IGN_CTCP;
+    if (flags.contains('i'))
+        types |= IGN_INVITE;
+
+    return types;
+}
+
+/*!
+ * \param types IGN_* flags
+ * \return Letters, see typesFromString()
+ */
+QString IgnoreList::typesToString(int types)
+{
+    QString flags;
+    if (types & IGN_PRIVMSG)
+        flags += 'p';
+    if (types & IGN_NOTICE)
+        flags += 'n';
+    if (types & IGN_CTCP)
+        flags += 'c';
+    if (types & IGN_INVITE)
+        flags += 'i';
+
+    return flags;
+}
+
+/*!
+ * \param mask Mask to ignore
+ * \param types IGN_* flags
+ * \param seconds Remove the ignore after this many seconds. 0 for a permanent ignore.
+ *
+ * Adds an ignore, or replaces an ignore on the same mask.\n
+ * This function doesn't save to iirc.ini, run save() for that.
+ * \return The normalized mask
+ */
+QString IgnoreList::add(QString mask, int types, int seconds)
+{
+    QString n = normalize(mask);
+    QString key = n.toLower();
+
+    if (list.contains(key))
+        unindex(key);
+
+    ignore_t ig;
+    ig.mask = IAL::compileMask(n);
+    ig.types = types;
+    ig.expires = 0;
+    ig.hits = 0;
+
+    if (seconds > 0)
+        ig.expires = QDateTime::currentMSecsSinceEpoch()/1000 + seconds;
+
+    list.insert(key, ig);
+    index(key);
+
+    return n;
+}
+
+/*!
+ * \param mask Mask to remove
+ *
+ * This function doesn't save to iirc.ini, run save() for that.
+ * \return true if mask was ignored.
+ */
+bool IgnoreList::del(QString mask)
+{
+    QString key = normalize(mask).toLower();
+    if (! list.contains(key))
+        return false;
+
+    unindex(key);
+    list.remove(key);
+    return true;
+}
+
+/*!
+ * \param key Key into list
+ *
+ * Puts the ignore into byNick, byHost or other.
+ */
+void IgnoreList::index(const QString &key)
+{
+    const ignore_t &ig = list[key];
+
+    if (ig.mask.nick.isLiteral())
+        byNick[ig.mask.nick.getPattern().toUpper()] << key;
+    else if (ig.mask.host.isLiteral())
+        byHost[ig.mask.host.getPattern().toLower()] << key;
+    else
+        other << key;
+}
+
+/*!
+ * \param key Key into list
+ *
+ * Removes the ignore from byNick, byHost or other.
+ */
+void IgnoreList::unindex(const QString &key)
+{
+    const ignore_t &ig = list[key];
+
+    if (ig.mask.nick.isLiteral()) {
+        QString nick = ig.mask.nick.getPattern().toUpper();
+        byNick[nick].removeAll(key);
+        if (byNick[nick].isEmpty())
+            byNick.remove(nick);
+    }
+    else if (ig.mask.host.isLiteral()) {
+        QString host = ig.mask.host.getPattern().toLower();
+        byHost[host].removeAll(key);
+        if (byHost[host].isEmpty())
+            byHost.remove(host);
+    }
+    else
+        other.removeAll(key);
+}
+
+/*!
+ * Checks the given ignores against a user. Expired ignores are added to 'expired' instead.
+ * \return true if one of them matched.
+ */
+bool IgnoreList::scan(const QStringList &keys, const QString &nickname, const QString &ident,
+                      const QString &hostname, int type, qint64 now, QStringList &expired)
+{
+    QListIterator<QString> i(keys);
+    while (i.hasNext()) {
+        QString key = i.next();
+        ignore_t &ig = list[key];
+
+        if ((ig.expires > 0) && (ig.expires <= now)) {
+            expired << key;
+            continue;
+        }
+
+        if ((ig.types & type) == 0)
+            continue;
+
+        if (ig.mask.nick.match(nickname) && ig.mask.ident.match(ident) && ig.mask.host.match(hostname)) {
+            ++ig.hits;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*!
+ * \param nickname Nickname of sender
+ * \param ident Ident of sender
+ * \param hostname Hostname of sender
+ * \param type Message type, one of IGN_*
+ *
+ * Checks if a message should be dropped. Counts a hit on the ignore that matched.
+ * \return true if sender is ignored for this type of message.
+ */
+bool IgnoreList::isIgnored(const QString &nickname, const QString &ident, const QString &hostname, int type)
+{
+    if (list.isEmpty())
+        return false;
+
+    qint64 now = QDateTime::currentMSecsSinceEpoch()/1000;
+    QStringList expired;
+
+    bool ignored = false;
+
+    QHash<QString,QStringList>::const_iterator n = byNick.constFind(nickname.toUpper());
+    if (n != byNick.constEnd())
+        ignored = scan(n.value(), nickname, ident, hostname, type, now, expired);
+
+    if (! ignored) {
+        QHash<QString,QStringList>::const_iterator h = byHost.constFind(hostname.toLower());
+        if (h != byHost.constEnd())
+            ignored = scan(h.value(), nickname, ident, hostname, type, now, expired);
+    }
+
+    if ((! ignored) && (! other.isEmpty()))
+        ignored = scan(other, nickname, ident, hostname, type, now, expired);
+
+    QListIterator<QString> e(expired);
+    while (e.hasNext()) {
+        QString key = e.next();
+        unindex(key);
+        list.remove(key);
+    }
+
+    return ignored;
+}
+
+/*!
+ * \param hostname Hostname of sender
+ * \param lines Max messages within 'seconds'
+ * \param seconds Time span
+ *
+ * Counts a message from hostname.
+ * \return true if hostname sent more than 'lines' messages within 'seconds'.
+ */
+bool IgnoreList::flooding(const QString &hostname, int lines, int seconds)
+{
+    qint64 now = QDateTime::currentMSecsSinceEpoch()/1000;
+
+    ignflood_t f = floods.value(hostname, ignflood_t());
+    if ((f.count == 0) || (now - f.start >= seconds)) {
+        f.start = now;
+        f.count = 0;
+    }
+
+    ++f.count;
+    floods.insert(hostname, f);
+
+    if (floods.count() > IGN_FLOOD_MAXHOSTS) {
+        QMutableHashIterator<QString,ignflood_t> i(floods);
+        while (i.hasNext())
+            if (now - i.next().value().start >= seconds)
+                i.remove();
+    }
+
+    return f.count > lines;
+}
+
+/*!
+ * Removes temporary ignores that have expired.\n
+ * isIgnored() only drops those it comes across, so anything listing the ignores runs this first.
+ */
+void IgnoreList::purgeExpired()
+{
+    qint64 now = QDateTime::currentMSecsSinceEpoch()/1000;
+    QStringList expired;
+
+    QHashIterator<QString,ignore_t> i(list);
+    while (i.hasNext()) {
+        i.next();
+        qint64 expires = i.value().expires;
+        if ((expires > 0) && (expires <= now))
+            expired << i.key();
+    }
+
+    QListIterator<QString> e(expired);
+    while (e.hasNext())
+        del(e.next());
+}
+
+/*!
+ * \return All masks, normalized.
+ */
+QStringList IgnoreList::masks()
+{
+    purgeExpired();
+
+    QStringList r;
+
+    QHashIterator<QString,ignore_t> i(list);
+    while (i.hasNext())
+        r << i.next().value().mask.mask;
+
+    return r;
+}
+
+/*!
+ * \param mask Ignore mask
+ * \return Amount of messages dropped by the ignore. -1 if mask isn't ignored.
+ */
+int IgnoreList::hits(QString mask)
+{
+    purgeExpired();
+
+    QString key = normalize(mask).toLower();
+    if (! list.contains(key))
+        return -1;
+
+    return list.value(key).hits;
+}
+
+/*!
+ * \param mask Ignore mask
+ * \return Seconds until the ignore expires. 0 if it's permanent, -1 if mask isn't ignored.
+ */
+int IgnoreList::expires(QString mask)
+{
+    purgeExpired();
+
+    QString key = normalize(mask).toLower();
+    if (! list.contains(key))
+        return -1;
+
+    qint64 expires = list.value(key).expires;
+    if (expires == 0)
+        return 0;
+
+    return expires - QDateTime::currentMSecsSinceEpoch()/1000;
+}
+
+/*!
+ * \param mask Ignore mask
+ * \return IGN_* flags of the ignore. 0 if mask isn't ignored.
+ */
+int IgnoreList::types(QString mask)
+{
+    purgeExpired();
+
+    QString key = normalize(mask).toLower();
+    if (! list.contains(key))
+        return 0;
+
+    return list.value(key).types;
+}
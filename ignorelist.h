@@ -0,0 +1,99 @@
+/*
+ *   IdealIRC - Internet Relay Chat client
+ *   Copyright (C) 2014  Tom-Andre Barstad
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/*! \class IgnoreList
+ *  \brief Ignored users, by nick!ident@host mask and message type.
+ *
+ * Ignores with a plain (wildcard free) nickname or hostname are indexed on that part,
+ * so checking a message normally costs a hash lookup or two. The rest is scanned.\n
+ * Permanent ignores are stored in iirc.ini under [Ignore]. Temporary ignores (for example
+ * from flood detection) expires by themselves, and are never saved.
+ */
+
+#ifndef IGNORELIST_H
+#define IGNORELIST_H
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include "ial.h"
+#include "config.h"
+
+#define IGN_PRIVMSG  0x01 //!< Private and channel messages, including actions.
+#define IGN_NOTICE   0x02 //!< Notices, including CTCP replies.
+#define IGN_CTCP     0x04 //!< CTCP requests.
+#define IGN_INVITE   0x08 //!< Channel invites.
+#define IGN_ALL      0x0F
+
+#define IGN_FLOOD_MAXHOSTS 512 //!< Prune the flood counters when they exceed this amount of hosts.
+
+/*!
+ * An ignore entry.
+ */
+typedef struct T_IGNORE {
+    IALMask_t mask;
+    int types; //!< IGN_* flags.
+    qint64 expires; //!< Seconds since epoch when this ignore is removed. 0 for never.
+    int hits; //!< Amount of messages dropped by this ignore.
+} ignore_t;
+
+/*!
+ * Message counter for one host, for flood detection.
+ */
+typedef struct T_IGNFLOOD {
+    qint64 start; //!< Seconds since epoch when counting started.
+    int count; //!< Messages since start.
+} ignflood_t;
+
+class IgnoreList
+{
+public:
+    explicit IgnoreList(config *cfg);
+    void load();
+    void save();
+    QString add(QString mask, int types = IGN_ALL, int seconds = 0);
+    bool del(QString mask);
+    bool isIgnored(const QString &nickname, const QString &ident, const QString &hostname, int type);
+    bool flooding(const QString &hostname, int lines, int seconds);
+    bool isEmpty() const { return list.isEmpty(); } //!< \return true if nobody is ignored.
+    QStringList masks();
+    int hits(QString mask);
+    int expires(QString mask);
+    int types(QString mask);
+
+    static QString normalize(QString mask);
+    static int typesFromString(QString flags);
+    static QString typesToString(int types);
+
+private:
+    config *conf; //!< Pointer to config class (iirc.ini)
+    QHash<QString,ignore_t> list; //!< All ignores.\n Key: Normalized mask, lower case\n Value: Ignore entry.
+    QHash<QString,QStringList> byNick; //!< Ignores with a plain nickname.\n Key: Upper case nickname\n Value: Keys into list.
+    QHash<QString,QStringList> byHost; //!< Ignores with a plain hostname (and wildcard nickname).\n Key: Lower case hostname\n Value: Keys into list.
+    QStringList other; //!< Ignores with wildcards in both nickname and hostname. Keys into list.
+    QHash<QString,ignflood_t> floods; //!< Flood counters.\n Key: Hostname.
+    void index(const QString &key);
+    void unindex(const QString &key);
+    void purgeExpired();
+    bool scan(const QStringList &keys, const QString &nickname, const QString &ident,
+              const QString &hostname, int type, qint64 now, QStringList &expired);
+};
+
+#endif // IGNORELIST_H
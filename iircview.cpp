@@ -8,9 +8,12 @@
 #include <QVectorIterator>
 #include <QDesktopServices>
 #include <QApplication>
+#include <QMultiHash>
+#include <algorithm>
 
 #include "iircview.h"
 #include "constants.h"
+#include "iperf.h"
 #include "math.h"
 
 /*!
@@ -178,143 +181,155 @@ void IIRCView::redraw()
     update();
 }
 
-QColor IIRCView::getColorFromCode(int num)
+/*!
+ * \param sender Sender of message (text in left margin)
+ * \param text Text to add
+ * \param type Type of text (see constants.h for PT_*)
+ *
+ * Adds text to the widget.
+ */
+void IIRCView::addLine(QString sender, QString text, int type)
 {
-      switch(num) {
-        case 0:
-            return C_WHITE;
-
-        case 1:
-              return C_BLACK;
-
-        case 2:
-            return C_BLUE;
-
-        case 3:
-            return C_GREEN;
-
-        case 4:
-            return C_BRIGHTRED;
-
-        case 5:
-            return C_RED;
+    t_text t;
+    t.type = type;
+    t.ts = QDateTime::currentMSecsSinceEpoch();
+    t.sender = sender;
+    t.text = text;
+    t.reset = true; // set to false when re-making the textwriter.
 
-        case 6:
-            return C_MAGENTA;
+    lines.append(t);
 
-        case 7:
-            return C_BROWN;
+    if (lines.count() > 1000) // should be configurable
+        lines.pop_front();
 
-        case 8:
-            return C_YELLOW;
+    scrollbar.setMaximum(lines.count());
 
-        case 9:
-            return C_BRIGHTGREEN;
+    if (draggingText) { // Preserve selection
+        QPoint p = textCpyVect.p1();
+        p.setY( p.y() - fontSize );
+        textCpyVect.setP1(p);
+    }
 
-        case 10:
-            return C_CYAN;
+    update();
+}
 
-        case 11:
-            return C_BRIGHTCYAN;
+/*!
+ * \param batch Lines to add
+ *
+ * Adds several lines to the widget, with one update.
+ */
+void IIRCView::addLines(const QVector<t_text> &batch)
+{
+    if (batch.isEmpty())
+        return;
 
-        case 12:
-            return C_BRIGHTBLUE;
+    lines += batch;
 
-        case 13:
-            return C_BRIGHTMAGENTA;
+    int excess = lines.count() - 1000; // should be configurable
+    if (excess > 0)
+        lines.remove(0, excess);
 
-        case 14:
-            return C_DARKGRAY;
+    scrollbar.setMaximum(lines.count());
 
-        case 15:
-            return C_LIGHTGRAY;
+    if (draggingText) { // Preserve selection
+        QPoint p = textCpyVect.p1();
+        p.setY( p.y() - fontSize*batch.count() );
+        textCpyVect.setP1(p);
+    }
 
-        default:
-            return C_BLACK;
-      }
+    update();
 }
 
 /*!
- * \param c Color to invert
- *
- * Inverts a color using XOR.
- * \return Inverted color
+ * Sort helper for mergeLines().
+ * \return true if a was written before b.
  */
-QColor IIRCView::invertColor(QColor c)
+static bool tsLessThan(const t_text &a, const t_text &b)
 {
-    // Bitwise XOR to invert colors.
-    int R = c.red() ^ 255;
-    int G = c.green() ^ 255;
-    int B = c.blue() ^ 255;
-
-    QColor rs;
-    rs.setRed(R);
-    rs.setGreen(G);
-    rs.setBlue(B);
-    return rs;
+    return a.ts < b.ts;
 }
 
-QColor IIRCView::getColorFromType(int type)
+/*!
+ * \param batch Lines to merge, in any order. Lines already in the widget are removed from it.
+ *
+ * Merges replayed lines (such as chat history) in among the lines we have, by timestamp, with one update.\n
+ * A line with the same sender and text as one we have within HISTORY_OVERLAP is a duplicate.
+ */
+void IIRCView::mergeLines(QVector<t_text> &batch)
 {
-    switch (type) {
-        case PT_NORMAL:
-            return conf->colDefault;
-
-        case PT_LOCALINFO:
-            return conf->colLocalInfo;
+    if (batch.isEmpty())
+        return;
 
-        case PT_SERVINFO:
-            return conf->colServerInfo;
+    std::stable_sort(batch.begin(), batch.end(), tsLessThan);
+
+    // Only the lines from where the batch starts can be duplicates or come after it.
+    quint64 from = batch.first().ts;
+    from = (from > HISTORY_OVERLAP) ? from - HISTORY_OVERLAP : 0;
+    int start = lines.count();
+    while ((start > 0) && (lines[start-1].ts >= from))
+        start--;
+
+    QMultiHash<QString,quint64> have; // Key: sender and text
+    for (int i = start; i <= lines.count()-1; i++)
+        have.insert(lines[i].sender + '\n' + lines[i].text, lines[i].ts);
+
+    QVector<t_text> fresh;
+    for (int i = 0; i <= batch.count()-1; i++) {
+        const t_text &t = batch[i];
+        QString key = t.sender + '\n' + t.text;
+        bool dup = false;
+
+        QList<quint64> ts = have.values(key);
+        for (int j = 0; j <= ts.count()-1; j++) {
+            quint64 diff = (ts[j] > t.ts) ? ts[j] - t.ts : t.ts - ts[j];
+            if (diff <= HISTORY_OVERLAP) {
+                dup = true;
+                break;
+            }
+        }
 
-        case PT_NOTICE:
-            return conf->colNotice;
+        if (dup)
+            continue;
 
-        case PT_ACTION:
-            return conf->colAction;
+        have.insert(key, t.ts);
+        fresh << t;
+    }
+    batch = fresh;
 
-        case PT_CTCP:
-            return conf->colCTCP;
+    if (fresh.isEmpty())
+        return;
 
-        case PT_OWNTEXT:
-            return conf->colOwntext;
+    // Merge the new lines with the tail, both sorted by time.
+    QVector<t_text> tail = lines.mid(start);
+    lines.resize(start);
+    int a = 0;
+    int b = 0;
+    while ((a < tail.count()) || (b < fresh.count())) {
+        if ((b == fresh.count()) || ((a < tail.count()) && (tail[a].ts <= fresh[b].ts)))
+            lines << tail[a++];
+        else
+            lines << fresh[b++];
+    }
 
-        case PT_HIGHLIGHT:
-            return conf->colHighlight;
+    int excess = lines.count() - 1000; // should be configurable
+    if (excess > 0)
+        lines.remove(0, excess);
 
-        default:
-            return conf->colDefault;
-    }
+    scrollbar.setMaximum(lines.count());
+    update();
 }
 
 /*!
- * \param sender Sender of message (text in left margin)
- * \param text Text to add
- * \param type Type of text (see constants.h for PT_*)
+ * \param text New text
  *
- * Adds text to the widget.
+ * Replaces the text of the last line, keeping its sender and timestamp.
  */
-void IIRCView::addLine(QString sender, QString text, int type)
+void IIRCView::replaceLastLine(const QString &text)
 {
-    t_text t;
-    t.type = type;
-    t.ts = QDateTime::currentMSecsSinceEpoch();
-    t.sender = sender;
-    t.text = text;
-    t.reset = true; // set to false when re-making the textwriter.
-
-    lines.append(t);
-
-    if (lines.count() > 1000) // should be configurable
-        lines.pop_front();
-
-    scrollbar.setMaximum(lines.count());
-
-    if (draggingText) { // Preserve selection
-        QPoint p = textCpyVect.p1();
-        p.setY( p.y() - fontSize );
-        textCpyVect.setP1(p);
-    }
+    if (lines.isEmpty())
+        return;
 
+    lines.last().text = text;
     update();
 }
 
@@ -384,6 +399,8 @@ void IIRCView::paintEvent(QPaintEvent *)
     if (cooldown.isActive())
         return; // we're cooling down...
 
+    IPerfTimer paintTimer(pc_Paint);
+
     quint64 current = QDateTime::currentMSecsSinceEpoch();
     if (current-lastUpdate < 33)
         cooldown.singleShot(33, this, SLOT(update()));
@@ -394,7 +411,7 @@ void IIRCView::paintEvent(QPaintEvent *)
     QPainter painter(this);
 
     // Background
-    painter.fillRect(0, 0, width(), height(), conf->colBackground);
+    painter.fillRect(0, 0, width(), height(), conf->theme.backgroundBrush);
 
     if (backgroundImage != nullptr) {
         resizeBackground(size()); // construct a new 'pBackgroundImage'
@@ -407,7 +424,7 @@ void IIRCView::paintEvent(QPaintEvent *)
     //painter.drawLine(textCpyVect);
 
     // Splitter
-    painter.setPen( invertColor(conf->colBackground) );
+    painter.setPen( conf->theme.splitterPen );
     painter.drawLine(splitterPos, -20, splitterPos, height());
 
     int maxWidth = width()-splitterPos-scrollbar.width()-45;
@@ -518,9 +535,9 @@ void IIRCView::paintEvent(QPaintEvent *)
         QFont font = painter.font();
         font.setBold(false);
         font.setUnderline(false);
-        painter.setPen( getColorFromType(pl.type) );
+        painter.setPen( conf->textPen(pl.type) );
         painter.setFont(font);
-        QColor textcolor = getColorFromType(pl.type);
+        QColor textcolor = conf->textColor(pl.type);
 
         // Draw timestamp
         QString ts;
@@ -591,7 +608,7 @@ void IIRCView::paintEvent(QPaintEvent *)
                     readURL = true;
                     paintLink = true;
                     anchor.P1 = QPoint(X, Y-fm->height()+4);
-                    painter.setPen(conf->colLinks);
+                    painter.setPen(conf->theme.linksPen);
                 }
 
                 if (c == CTRL_BOLD) {
@@ -613,7 +630,7 @@ void IIRCView::paintEvent(QPaintEvent *)
                     c = line[ic+1];
                     if ((! c.isDigit()) && (c != ',')) { // reset
                         color = false;
-                        painter.setPen( getColorFromType(pl.type) );
+                        painter.setPen( conf->textPen(pl.type) );
                         continue;
                     }
 
@@ -631,9 +648,9 @@ void IIRCView::paintEvent(QPaintEvent *)
                             // Get background
                             bg = true;
                             if (s.isEmpty()) // no fg was defined, reset.
-                                painter.setPen( getColorFromType(pl.type) );
+                                painter.setPen( conf->textPen(pl.type) );
                             else
-                                painter.setPen( getColorFromCode(s.toInt()) );
+                                painter.setPen( conf->mircPen(s.toInt()) );
                             s.clear();
 
                             continue;
@@ -647,12 +664,12 @@ void IIRCView::paintEvent(QPaintEvent *)
                                     --ic;
                                     break;
                                 }
-                                bgColor = getColorFromCode(s.toInt());
+                                bgColor = conf->mircColor(s.toInt());
                                 color = true;
                                 s.clear();
                             }
                             else {
-                                painter.setPen( getColorFromCode(s.toInt()) );
+                                painter.setPen( conf->mircPen(s.toInt()) );
                                 s.clear();
                             }
 
@@ -672,7 +689,7 @@ void IIRCView::paintEvent(QPaintEvent *)
                     QFont font = painter.font();
                     font.setBold(false);
                     font.setUnderline(false);
-                    painter.setPen(getColorFromType(pl.type));
+                    painter.setPen( conf->textPen(pl.type) );
                     painter.setFont(font);
                     continue;
                 }            
@@ -691,11 +708,11 @@ void IIRCView::paintEvent(QPaintEvent *)
                     if ((p2.x() >= tl.x()) && (p2.x() < br.x()) &&
                         (p2.y() >= tl.y()) && (p2.y() < br.y())) {
                         textCopyBg = false;
-                        painter.fillRect(X+1, Y-fontSize+2, fw+1, fontSize+1, invertColor(conf->colBackground));
+                        painter.fillRect(X+1, Y-fontSize+2, fw+1, fontSize+1, conf->theme.backgroundInvertedBrush);
                     }
                 }
                 if (textCopyBg)
-                    painter.fillRect(X+1, Y-fontSize+2, fw+1, fontSize+1, invertColor(conf->colBackground));
+                    painter.fillRect(X+1, Y-fontSize+2, fw+1, fontSize+1, conf->theme.backgroundInvertedBrush);
                 else if (color)
                     painter.fillRect(X+1, Y-fontSize+2, fw+1, fontSize+1, bgColor);
 
@@ -716,7 +733,7 @@ void IIRCView::paintEvent(QPaintEvent *)
                         // Create url
                         readURL = false;
                         paintLink = false;
-                        painter.setPen( getColorFromType(pl.type) );
+                        painter.setPen( conf->textPen(pl.type) );
 
                         anchor.P2 = QPoint(X, Y);
                         addUrl << anchor;
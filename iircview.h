@@ -42,14 +42,9 @@
 
 #include "config.h"
 #include "constants.h"
+#include "icoreevents.h"
 
-typedef struct T_TEXT {
-    int type; // what type? (what main color)
-    quint64 ts; // timestamp of when the text was written
-    QString sender; // who or what sent the text
-    QString text; // actual text
-    bool reset; // Used when printing texts, reset ctrl codes, links, etc.
-} t_text;
+#define HISTORY_OVERLAP 5000 //!< Milliseconds. Replayed history starts this much before our last line, identical lines this close are duplicates.
 
 typedef struct PRINTLINE_T {
     int type; // what type? (what main color)
@@ -71,15 +66,16 @@ public:
     explicit IIRCView(config *cfg, QWidget *parent = 0);
     ~IIRCView();
     void addLine(QString sender, QString text, int type = PT_NORMAL);
+    void addLines(const QVector<t_text> &batch);
+    void mergeLines(QVector<t_text> &batch);
+    quint64 getLastTimestamp() { return lines.isEmpty() ? 0 : lines.last().ts; } //!< \return Timestamp of the last line, 0 if there's none.
+    void replaceLastLine(const QString &text);
     int getSplitterPos() { return splitterPos; } //!< returns the position on X axis where the spliter is.
     void changeFont(QString fontName, int pxSize);
     void clear();
     void redraw();
 
 private:
-    QColor getColorFromCode(int num);
-    QColor invertColor(QColor c);
-    QColor getColorFromType(int type); // see constants.h for PT_*
     config *conf; //!< Pointer to the config class (iirc.ini)
     QVector<t_text> lines; //!< Contains all lines (up to 1000 lines)
     quint64 lastUpdate; //!< Used to not re-run GUI update too frequently. Limits to ca 30 updates per second.
@@ -0,0 +1,360 @@
+/*
+ *   IdealIRC - Internet Relay Chat client
+ *   Copyright (C) 2014  Tom-Andre Barstad
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+
+#include <QObject>
+#include "iperf.h"
+
+bool IPerf::enabled = false;
+QElapsedTimer IPerf::since;
+qint64 IPerf::countedMs = 0;
+quint64 (*IPerf::allocCounter)() = NULL;
+QAtomicInteger<qint64> IPerf::values[pc_Count];
+QAtomicInteger<qint64> IPerf::sums[pc_Count];
+QAtomicInteger<qint64> IPerf::maxes[pc_Count];
+QAtomicInteger<qint64> IPerf::buckets[pc_Count][PERF_BUCKETS];
+
+/*!
+ * \param enable true to start counting, false to stop.
+ *
+ * Values are kept when stopping, use reset() to clear them. The time counted so far is kept
+ * too, so rates only count the time counting was on.
+ */
+void IPerf::setEnabled(bool enable)
+{
+    if (enable == enabled)
+        return;
+
+    if (enable)
+        since.start();
+    else {
+        countedMs += since.elapsed();
+        since.invalidate();
+    }
+
+    enabled = enable;
+}
+
+/*!
+ * \return Seconds counting has been on since the last reset, for rates.
+ */
+double IPerf::countedSecs()
+{
+    qint64 ms = countedMs;
+    if (since.isValid())
+        ms += since.elapsed();
+
+    return ms / 1000.0;
+}
+
+/*!
+ * Sets all counters to zero.
+ */
+void IPerf::reset()
+{
+    for (int c = 0; c < pc_Count; ++c) {
+        values[c].store(0);
+        sums[c].store(0);
+        maxes[c].store(0);
+        for (int b = 0; b < PERF_BUCKETS; ++b)
+            buckets[c][b].store(0);
+    }
+
+    countedMs = 0;
+    if (enabled)
+        since.start();
+}
+
+/*!
+ * \param c Gauge
+ * \param v Current value
+ *
+ * Sets the value of a gauge, and raises its max if needed.
+ */
+void IPerf::set(e_perfcounter c, qint64 v)
+{
+    if (! enabled)
+        return;
+
+    values[c].store(v);
+    raise(maxes[c], v);
+}
+
+/*!
+ * \param c Timing
+ * \param ns Nanoseconds it took
+ *
+ * Adds a sample to a timing.
+ */
+void IPerf::time(e_perfcounter c, qint64 ns)
+{
+    if (! enabled)
+        return;
+
+    int b = 0;
+    for (qint64 us = ns / 1000; (us > 0) && (b < PERF_BUCKETS-1); us >>= 1)
+        ++b;
+
+    values[c].fetchAndAddRelaxed(1);
+    sums[c].fetchAndAddRelaxed(ns);
+    buckets[c][b].fetchAndAddRelaxed(1);
+    raise(maxes[c], ns);
+}
+
+/*!
+ * \param max Value to raise
+ * \param v New value
+ *
+ * Sets max to v if v is higher, without locking.
+ */
+void IPerf::raise(QAtomicInteger<qint64> &max, qint64 v)
+{
+    qint64 current = max.load();
+    while ((v > current) && (! max.testAndSetRelaxed(current, v, current)))
+        ;
+}
+
+/*!
+ * \param c Counter
+ * \return Name of the counter, as used by /perf and $perf().
+ */
+QString IPerf::name(e_perfcounter c)
+{
+    switch (c) {
+    case pc_BytesIn:
+        return "bytes_in";
+
+    case pc_BytesOut:
+        return "bytes_out";
+
+    case pc_LinesIn:
+        return "lines_in";
+
+    case pc_LinesOut:
+        return "lines_out";
+
+    case pc_Parse:
+        return "parse";
+
+    case pc_Paint:
+        return "paint";
+
+    case pc_Script:
+        return "script";
+
+    case pc_LogWrite:
+        return "log_write";
+
+    case pc_SendQueue:
+        return "send_queue";
+
+    case pc_PrintQueue:
+        return "print_queue";
+
+    default:
+        return "";
+    }
+}
+
+/*!
+ * \param c Counter
+ * \return What the counter measures.
+ */
+e_perfkind IPerf::kind(e_perfcounter c)
+{
+    switch (c) {
+    case pc_Parse:
+    case pc_Paint:
+    case pc_Script:
+    case pc_LogWrite:
+        return pk_Timing;
+
+    case pc_SendQueue:
+    case pc_PrintQueue:
+        return pk_Gauge;
+
+    default:
+        return pk_Counter;
+    }
+}
+
+/*!
+ * \param name Counter name, not case sensitive.
+ * \return The counter, pc_Count if there's no such counter.
+ */
+e_perfcounter IPerf::find(QString name)
+{
+    name = name.toLower();
+    for (int c = 0; c < pc_Count; ++c)
+        if (IPerf::name((e_perfcounter)c) == name)
+            return (e_perfcounter)c;
+
+    return pc_Count;
+}
+
+/*!
+ * \param c Timing
+ * \param pct Percentile, 1 to 100
+ * \return Upper bound in microseconds of the bucket the percentile falls in, 0 if no samples.
+ */
+qint64 IPerf::percentile(e_perfcounter c, int pct)
+{
+    qint64 count = values[c].load();
+    if (count == 0)
+        return 0;
+
+    qint64 target = (count * pct + 99) / 100;
+    qint64 seen = 0;
+    for (int b = 0; b < PERF_BUCKETS-1; ++b) {
+        seen += buckets[c][b].load();
+        if (seen >= target)
+            return (qint64)1 << b;
+    }
+
+    return maxes[c].load() / 1000;
+}
+
+/*!
+ * \param bucket Histogram bucket
+ * \return Label for the bucket in the report.
+ */
+QString IPerf::bucketLabel(int bucket)
+{
+    if (bucket == PERF_BUCKETS-1)
+        return QString(">=%1us").arg((qint64)1 << (bucket-1));
+
+    return QString("<%1us").arg((qint64)1 << bucket);
+}
+
+/*!
+ * \param name Counter name
+ * \param field What to get, empty for the default.\n
+ *   Counters: total (default) or rate, per second.\n
+ *   Timings: avg (default), count, total, max, p50 or p99. Times are in microseconds.\n
+ *   Gauges: value (default) or max.
+ * \param result Set to the value
+ * \return false if there's no such counter or field.
+ */
+bool IPerf::value(QString name, QString field, QString &result)
+{
+    e_perfcounter c = find(name);
+    if (c == pc_Count)
+        return false;
+
+    field = field.toLower();
+    qint64 v = values[c].load();
+
+    switch (kind(c)) {
+    case pk_Counter:
+        if (field.isEmpty() || (field == "total"))
+            result = QString::number(v);
+        else if (field == "rate") {
+            double secs = countedSecs();
+            result = QString::number((secs > 0) ? v / secs : 0, 'f', 1);
+        }
+        else
+            return false;
+        return true;
+
+    case pk_Timing:
+        if (field.isEmpty() || (field == "avg"))
+            result = QString::number((v > 0) ? sums[c].load() / 1000.0 / v : 0, 'f', 1);
+        else if (field == "count")
+            result = QString::number(v);
+        else if (field == "total")
+            result = QString::number(sums[c].load() / 1000);
+        else if (field == "max")
+            result = QString::number(maxes[c].load() / 1000);
+        else if (field == "p50")
+            result = QString::number(percentile(c, 50));
+        else if (field == "p99")
+            result = QString::number(percentile(c, 99));
+        else
+            return false;
+        return true;
+
+    case pk_Gauge:
+        if (field.isEmpty() || (field == "value"))
+            result = QString::number(v);
+        else if (field == "max")
+            result = QString::number(maxes[c].load());
+        else
+            return false;
+        return true;
+    }
+
+    return false;
+}
+
+/*!
+ * \return Report of all counters, one line per entry.
+ */
+QStringList IPerf::report()
+{
+    QStringList lines;
+    double secs = countedSecs();
+
+    lines << QObject::tr("Performance counters, %1 s counted%2:")
+               .arg(secs, 0, 'f', 1)
+               .arg(enabled ? QString() : QObject::tr(", counting is off"));
+
+    for (int i = 0; i < pc_Count; ++i) {
+        e_perfcounter c = (e_perfcounter)i;
+        qint64 v = values[c].load();
+
+        switch (kind(c)) {
+        case pk_Counter:
+            lines << QObject::tr("  %1: %2 (%3/s)")
+                       .arg(name(c))
+                       .arg(v)
+                       .arg((secs > 0) ? v / secs : 0, 0, 'f', 1);
+            break;
+
+        case pk_Timing: {
+            lines << QObject::tr("  %1: %2 samples, avg %3 us, p50 <%4 us, p99 <%5 us, max %6 us")
+                       .arg(name(c))
+                       .arg(v)
+                       .arg((v > 0) ? sums[c].load() / 1000.0 / v : 0, 0, 'f', 1)
+                       .arg(percentile(c, 50))
+                       .arg(percentile(c, 99))
+                       .arg(maxes[c].load() / 1000);
+
+            QStringList histogram;
+            for (int b = 0; b < PERF_BUCKETS; ++b) {
+                qint64 n = buckets[c][b].load();
+                if (n > 0)
+                    histogram << QString("%1 %2").arg(bucketLabel(b)).arg(n);
+            }
+            if (histogram.count() > 0)
+                lines << "    " + histogram.join(", ");
+            break;
+        }
+
+        case pk_Gauge:
+            lines << QObject::tr("  %1: %2, max %3")
+                       .arg(name(c))
+                       .arg(v)
+                       .arg(maxes[c].load());
+            break;
+        }
+    }
+
+    return lines;
+}
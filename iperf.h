@@ -0,0 +1,121 @@
+/*
+ *   IdealIRC - Internet Relay Chat client
+ *   Copyright (C) 2014  Tom-Andre Barstad
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+
+/*! \class IPerf
+ *  \brief Runtime performance counters.
+ *
+ * The socket, parser, text view, script engine and logger report to these counters on their hot paths.
+ * There are three kinds:\n
+ * Counters count things (bytes, lines), timings keep a histogram of how long something took, and
+ * gauges hold the last seen depth of a queue along with its max.\n
+ * The values are atomics, so no locking is needed. Counting is off until /perf on, and while off
+ * each call site costs one check of isEnabled().
+ */
+
+/*! \class IPerfTimer
+ *  \brief Adds the time from construction to destruction to a timing counter.
+ */
+
+#ifndef IPERF_H
+#define IPERF_H
+
+#include <QString>
+#include <QStringList>
+#include <QAtomicInteger>
+#include <QElapsedTimer>
+
+#define PERF_BUCKETS 16 //!< Histogram buckets per timing. Bucket n holds samples below 2^n microseconds, the last one holds the rest.
+
+/*! \enum e_perfcounter Performance counters. Names used by /perf and $perf() are in IPerf::name(). */
+enum e_perfcounter {
+    pc_BytesIn = 0,
+    pc_BytesOut,
+    pc_LinesIn,
+    pc_LinesOut,
+    pc_Parse,
+    pc_Paint,
+    pc_Script,
+    pc_LogWrite,
+    pc_SendQueue,
+    pc_PrintQueue,
+    pc_Count // Amount of counters, keep last.
+};
+
+/*! \enum e_perfkind What a counter measures. */
+enum e_perfkind {
+    pk_Counter = 0,
+    pk_Timing,
+    pk_Gauge
+};
+
+/*! Traffic of a single connection, only counted while IPerf is enabled. */
+typedef struct T_PERFCONN {
+    quint64 bytesIn;
+    quint64 bytesOut;
+    quint64 linesIn;
+    quint64 linesOut;
+} t_perfconn;
+
+class IPerf
+{
+public:
+    static bool isEnabled() { return enabled; } //!< \return true if counting is on.
+    static void setEnabled(bool enable);
+    static void reset();
+    static void add(e_perfcounter c, qint64 n = 1) { if (enabled) values[c].fetchAndAddRelaxed(n); } //!< Adds n to a counter.
+    static void set(e_perfcounter c, qint64 v);
+    static void time(e_perfcounter c, qint64 ns);
+    static QString name(e_perfcounter c);
+    static e_perfkind kind(e_perfcounter c);
+    static e_perfcounter find(QString name);
+    static bool value(QString name, QString field, QString &result);
+    static QStringList report();
+    static void setAllocCounter(quint64 (*counter)()) { allocCounter = counter; } //!< Sets where allocations() reads from. Only the benchmark tools in bench/ count allocations.
+    static quint64 allocations() { return (allocCounter != NULL) ? allocCounter() : 0; } //!< \return Allocations done so far, 0 if nobody counts them.
+
+private:
+    static bool enabled; //!< Counting is on.
+    static QElapsedTimer since; //!< Time since counting was last turned on or reset. Invalid while off.
+    static qint64 countedMs; //!< Milliseconds counted before since was last started, see countedSecs().
+    static quint64 (*allocCounter)(); //!< Returns the allocations done so far. NULL if nobody counts them.
+    static QAtomicInteger<qint64> values[pc_Count]; //!< Counter total, gauge value or amount of timing samples.
+    static QAtomicInteger<qint64> sums[pc_Count]; //!< Timings: Nanoseconds in total.
+    static QAtomicInteger<qint64> maxes[pc_Count]; //!< Timings and gauges: Highest value seen.
+    static QAtomicInteger<qint64> buckets[pc_Count][PERF_BUCKETS]; //!< Timings: Histogram, see PERF_BUCKETS.
+    static void raise(QAtomicInteger<qint64> &max, qint64 v);
+    static double countedSecs();
+    static qint64 percentile(e_perfcounter c, int pct);
+    static QString bucketLabel(int bucket);
+};
+
+class IPerfTimer
+{
+public:
+    explicit IPerfTimer(e_perfcounter c) : counter(c), running(IPerf::isEnabled()) { if (running) timer.start(); }
+    ~IPerfTimer() { if (running) IPerf::time(counter, timer.nsecsElapsed()); }
+
+private:
+    e_perfcounter counter; //!< Timing to add to.
+    bool running; //!< false if counting was off when we started.
+    QElapsedTimer timer; //!< Started at construction.
+};
+
+#endif // IPERF_H
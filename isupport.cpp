@@ -0,0 +1,295 @@
+/*
+ *   IdealIRC - Internet Relay Chat client
+ *   Copyright (C) 2014  Tom-Andre Barstad
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+
+#include "isupport.h"
+
+ISupport::ISupport()
+{
+    reset();
+}
+
+/*!
+ * Sets everything back to the defaults, used when we're disconnected.
+ */
+void ISupport::reset()
+{
+    received = false;
+    maxBanList = -1; /** -1 means undefined. **/
+    maxExceptList = -1;
+    maxInviteList = -1;
+    maxModes = 3;
+    haveExceptionList = false;
+    haveInviteList = false;
+    haveWhox = false;
+    network.clear();
+    chanLimit.clear();
+    maxJoinTargets = -1;
+    maxChatHistory = 0;
+    chantype.clear();
+    cumode.clear();
+    culetter.clear();
+    cmA = "b";
+    cmB = "k";
+    cmC = "l";
+    cmD = "imnpstr";
+    resetSortRules();
+}
+
+/*!
+ * \param token A RPL_ISUPPORT line split by space.
+ * \param first Index of the first parameter in token.
+ *
+ * Reads all NAME=VALUE parameters of one RPL_ISUPPORT line.\n
+ * The trailing ":are supported by this server" text is ignored since it doesn't match any name.
+ */
+void ISupport::parse(const QStringList &token, int first)
+{
+    /*****
+     *[IN] :irc.3phasegaming.net 005 Tomatix_ CMDS=KNOCK,MAP,DCCALLOW,USERIP,STARTTLS UHNAMES NAMESX SAFELIST HCN MAXCHANNELS=25 CHANLIMIT=#:25 MAXLIST=b:60,e:60,I:60 NICKLEN=30 CHANNELLEN=32 TOPICLEN=307 KICKLEN=307 AWAYLEN=307 :are supported by this server
+     *[IN] :irc.3phasegaming.net 005 Tomatix_ MAXTARGETS=20 WALLCHOPS WATCH=128 WATCHOPTS=A SILENCE=15 MODES=12 CHANTYPES=# PREFIX=(ohv)@%+ CHANMODES=beIqa,kfL,lj,psmntirRcOAQKVCuzNSMTGZ NETWORK=3PhaseGaming CASEMAPPING=ascii EXTBAN=~,qjncrRa ELIST=MNUCT :are supported by this server
+     ********/
+
+    received = true;
+
+    for (int i = first; i <= token.count()-1; i++) {
+        QStringList lst = token[i].split('=');
+        QString value = lst.count() > 1 ? lst[1] : QString();
+
+        if (lst[0] == "CHANMODES") {
+            /*
+            * Unreal: CHANMODES=beIqa,kfL,lj,psmntirRcOAQKVCuzNSMTGZ
+            *   IRCu: CHANMODES=b,AkU,l,imnpstrDdR
+            *
+            * A = Mode that adds or removes a nick or address to a list. Always has a parameter.
+            * B = Mode that changes a setting and always has a parameter.
+            * C = Mode that changes a setting and only has a parameter when set.
+            * D = Mode that changes a setting and never has a parameter.
+            *
+            */
+
+            QStringList ml = value.split(',');
+            if (ml.count() < 4)
+                continue;
+
+            cmA = ml[0];
+            cmB = ml[1];
+            cmC = ml[2];
+            cmD = ml[3];
+
+            // Currently we only need to check list A.
+            for (int j = 0; j <= cmA.length()-1; ++j) {
+                char c = cmA[j].toLatin1();
+
+                switch (c) {
+                    case 'e':
+                        haveExceptionList = true;
+                        continue;
+                    case 'I':
+                        haveInviteList = true;
+                        continue;
+                }
+            }
+        }
+
+        if (lst[0] == "WHOX")
+            haveWhox = true;
+
+        if (lst[0] == "MAXLIST") {
+            // Unreal: MAXLIST=b:60,e:60,I:60
+            // IRCu: See MAXBANS
+            // IRCnet: MAXLIST=beI:30
+
+            QStringList maxlist = value.split(',');
+
+            for (int l = 0; l <= maxlist.count()-1; ++l) {
+                QString item = maxlist[l];
+                int len = item.section(':', 1).toInt();
+                // item can be b:60 or beI:30 (examples)
+                for (int j = 0; j <= item.length()-1; j++) {
+                    char c = item[j].toLatin1();
+                    if (c == ':')
+                        break;
+
+                    switch (c) {
+                        case 'b':
+                            maxBanList = len;
+                            continue;
+                        case 'e':
+                            maxExceptList = len;
+                            continue;
+                        case 'I':
+                            maxInviteList = len;
+                            continue;
+                    }
+                }
+            }
+        }
+
+        if (lst[0] == "MAXBANS") {
+            // Quite simple, really.
+            maxBanList = value.toInt();
+            maxExceptList = value.toInt();
+            maxInviteList = value.toInt();
+        }
+
+        if (lst[0] == "MODES")
+            maxModes = value.toInt();
+
+        if (lst[0] == "NETWORK")
+            network = value;
+
+        if (lst[0] == "CHANLIMIT") {
+            // CHANLIMIT=#&:25,+:10 (no number means no limit)
+            QStringList limits = value.split(',');
+            for (int l = 0; l <= limits.count()-1; ++l) {
+                QString types = limits[l].section(':', 0, 0);
+                QString len = limits[l].section(':', 1);
+                for (int j = 0; j <= types.length()-1; j++)
+                    chanLimit.insert(types[j].toLatin1(), len.isEmpty() ? -1 : len.toInt());
+            }
+        }
+
+        if ((lst[0] == "MAXCHANNELS") && (chanLimit.isEmpty())) {
+            // Older form of CHANLIMIT, for all channel types.
+            chanLimit.insert('#', value.toInt());
+            chanLimit.insert('&', value.toInt());
+        }
+
+        if (lst[0] == "TARGMAX") {
+            // TARGMAX=PRIVMSG:3,WHOIS:1,JOIN:,NOTICE:3 (no number means no limit)
+            QStringList targets = value.split(',');
+            for (int t = 0; t <= targets.count()-1; ++t) {
+                if (targets[t].section(':', 0, 0).toUpper() != "JOIN")
+                    continue;
+                QString len = targets[t].section(':', 1);
+                maxJoinTargets = len.isEmpty() ? -1 : len.toInt();
+            }
+        }
+
+        if (lst[0] == "CHATHISTORY")
+            maxChatHistory = value.toInt(); // CHATHISTORY=100 (0 means no limit)
+
+        if (lst[0] == "PREFIX") {
+            //  PREFIX=(ohv)@%+
+            // ohv is cumode, @%+ is culetter
+            cumode.clear();
+            culetter.clear();
+
+            enum pState { P_MODE, P_LETTER };
+            pState state = P_MODE;
+            for (int j = 0; j <= value.length()-1; j++) {
+                char c = value[j].toLatin1();
+                if (c == '(') {
+                    state = P_MODE;
+                    continue;
+                }
+
+                if (c == ')') {
+                    state = P_LETTER;
+                    continue;
+                }
+
+                if (state == P_MODE)
+                    cumode << c;
+
+                if (state == P_LETTER)
+                    culetter << c;
+            }
+            resetSortRules();
+        }
+
+        if (lst[0] == "CHANTYPES") {
+            chantype.clear();
+            for (int j = 0; j <= value.length()-1; j++)
+                chantype << value[j].toLatin1();
+        }
+    }
+}
+
+/*!
+ * Sets PREFIX to (ov)@+ unless the server told us something else.\n
+ * Used when registration completes without any ISUPPORT.
+ */
+void ISupport::useDefaultPrefix()
+{
+    if (cumode.count() > 0)
+        return;
+
+    cumode << 'o' << 'v';
+    culetter << '@' << '+';
+    resetSortRules();
+}
+
+/*!
+ * \param mode Channel user-mode (such as o, v, h, etc)
+ *
+ * Checks if the usermode is a letter and returns the letter.
+ * \return Channel user-mode letter (such as @, +, %, etc) or 0x00 on failure.
+ */
+char ISupport::getCuLetter(char mode)
+{
+    if (cumode.contains(mode))
+        return culetter.at( cumode.indexOf(mode) );
+    else
+        return 0x00;
+}
+
+/*!
+ * \param channel Channel name
+ *
+ * The test is checked against the channel types we receive from the server via isupport.
+ * \return true if it's a valid channel name, false otherwise.
+ */
+bool ISupport::isValidChannel(const QString &channel)
+{
+    if (channel.isEmpty())
+        return false;
+
+    char prefix = channel[0].toLatin1();
+    return chantype.contains(prefix);
+}
+
+/*!
+ * Clears the sort rules and rebuild it.
+ */
+void ISupport::resetSortRules()
+{
+    // sortrule is a QList of char that is inserted in what order we like it to be.
+    // Clear it so we can reset it.
+    sortrule.clear();
+
+    // On the topp, add any culetters (@,%,+ etc) which goes on top in nicklist box.
+    if (culetter.length() > 0)
+        sortrule.append( culetter ); // These goes first, so operators come on top, etc. The IRC server decides this order via ISupport!
+
+    // Add numbers, letters and signs that are typically allowed in a nickname.
+    for (char i = 0x30; i <= 0x39; i++)
+        sortrule.append(i); // Numbers
+    for (char i = 0x41; i <= 0x5A; i++) {
+        // Add letters such as A a B b C c D d
+        sortrule.append(i); // Uppercase
+        sortrule.append(i+0x20); // Lowercase
+    }
+    for (char i = 0x5B; i <= 0x60; i++)
+        sortrule.append(i); // [\]^_`
+    for (char i = 0x7B; i <= 0x7D; i++)
+        sortrule.append(i); // {|}
+}
@@ -0,0 +1,80 @@
+/*
+ *   IdealIRC - Internet Relay Chat client
+ *   Copyright (C) 2014  Tom-Andre Barstad
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+
+/*! \class ISupport
+ *  \brief What the IRC server told us about itself in RPL_ISUPPORT (numeric 005).
+ *
+ * Holds channel types, channel user-modes and their letters, the CHANMODES groups, list
+ * limits and so on. All values are reset to what an RFC 1459 server would use until the
+ * server tells us otherwise.\n
+ * This class is part of the core library and does not depend on any widgets.
+ */
+
+#ifndef ISUPPORT_H
+#define ISUPPORT_H
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QHash>
+
+class ISupport
+{
+public:
+    ISupport();
+    void reset();
+    void parse(const QStringList &token, int first = 3);
+    void useDefaultPrefix();
+    char getCuLetter(char mode);
+    bool isValidCuMode(char mode) { return cumode.contains(mode); } //!< \return true if mode is a valid channel user-mode (such as o, v, h, etc).
+    bool isValidCuLetter(char l) { return culetter.contains(l); } //!< \return true if l is a valid channel user-mode letter (such as @, +, %, etc).
+    bool isValidChannel(const QString &channel);
+    int getChanLimit(char type) { return chanLimit.value(type, -1); } //!< \return Max channels of the given type we can be on, -1 if undefined.
+    QList<char>* getSortRuleMapPtr() { return &sortrule; } //!< \return Pointer to the QList<char> of sort rule generated from PREFIX.
+
+    bool received; //!< true if the IRC server sent us an isupport (005)
+    int maxBanList; //!< Maximum channel bans (+b) we can send to IRC server. -1 means undefined.
+    int maxExceptList; //!< Maximum channel ban exceptions (+e) we can send to IRC server. -1 means undefined.
+    int maxInviteList; //!< Maximum channel invites (+I) we can send to IRC server. -1 means undefined.
+    int maxModes; //!< Maximum modes with parameter in one MODE command. Default is 3.
+    bool haveExceptionList; //!< True if IRC server supports ban exceptions. Default false.
+    bool haveInviteList; //!< True if IRC server supports invite lists. Default false.
+    bool haveWhox; //!< True if IRC server supports WHOX. Default false.
+    QString network; //!< Network name, empty if the server didn't tell.
+    QHash<char,int> chanLimit; //!< Max channels we can join, from CHANLIMIT (or MAXCHANNELS).\n Key: Channel type\n Value: Limit
+    int maxJoinTargets; //!< Max channels in one JOIN, from TARGMAX. -1 means undefined.
+    int maxChatHistory; //!< Max messages in one CHATHISTORY reply, from CHATHISTORY. 0 means undefined.
+
+    QList<char> chantype; //!< Channel types this server allows, such as #, &
+    QList<char> cumode; //!< Channel User-modes this server allows, such as +o +h +v, etc.
+    QList<char> culetter; //!< Same as cumode, Channel User-mode letters, such as @ % +, etc.
+
+    QString cmA; //!< Modes from isupport CHANMODES, A types.\n Mode that adds or removes a nick or address to a list. Always has a parameter.\n Default: b\n See http://www.irc.org/tech_docs/005.html
+    QString cmB; //!< Modes from isupport CHANMODES, B types.\n Mode that changes a setting and always has a parameter.\n Default: k\n See http://www.irc.org/tech_docs/005.html
+    QString cmC; //!< Modes from isupport CHANMODES, C types.\n Mode that changes a setting and only has a parameter when set.\n Default: l\n See http://www.irc.org/tech_docs/005.html
+    QString cmD; //!< Modes from isupport CHANMODES, D types.\n Mode that changes a setting and never has a parameter.\n default imnpstr\n See http://www.irc.org/tech_docs/005.html
+
+private:
+    QList<char> sortrule; //!< All letters (culetter) in order which should be sorted by.
+    void resetSortRules();
+};
+
+#endif // ISUPPORT_H
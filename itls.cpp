@@ -0,0 +1,132 @@
+/*
+ *   IdealIRC - Internet Relay Chat client
+ *   Copyright (C) 2014  Tom-Andre Barstad
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+
+#include <QCryptographicHash>
+#include <QSslConfiguration>
+#include <QSslCertificate>
+#include <QSslKey>
+
+#include "itls.h"
+#include "inifile.h"
+#include "constants.h"
+
+QHash<QString,QByteArray> ITls::sessions;
+
+/*!
+ * \param socket Socket about to start TLS
+ * \param host Hostname we connect to, the certificate must match it
+ * \param port Port we connect to
+ *
+ * Sets up the socket to resume the last session with this server, if we got one.
+ * Must be done before the handshake starts.
+ */
+void ITls::prepare(QSslSocket *socket, QString host, int port)
+{
+    socket->setPeerVerifyName(host); // We might be connecting to an IP address.
+
+    QSslConfiguration conf = socket->sslConfiguration();
+    conf.setProtocol(QSsl::TlsV1_2OrLater);
+    conf.setSslOption(QSsl::SslOptionDisableSessionTickets, false);
+    conf.setSslOption(QSsl::SslOptionDisableSessionPersistence, false); // Lets us read out the ticket.
+
+    QByteArray ticket = sessions.value(sessionKey(host, port));
+    if (! ticket.isEmpty())
+        conf.setSessionTicket(ticket);
+
+    socket->setSslConfiguration(conf);
+}
+
+/*!
+ * \param socket Encrypted socket
+ * \param host Hostname
+ * \param port Port
+ *
+ * Keeps the session ticket of the socket for the next connection to this server.\n
+ * With TLS 1.3 the ticket comes after the handshake, so this is also worth doing before the socket closes.
+ */
+void ITls::saveSession(QSslSocket *socket, QString host, int port)
+{
+    QByteArray ticket = socket->sslConfiguration().sessionTicket();
+    if (ticket.isEmpty())
+        return;
+
+    QString key = sessionKey(host, port);
+    if ((! sessions.contains(key)) && (sessions.count() >= TLS_SESSION_MAX))
+        sessions.clear(); // Tickets are cheap to get again.
+
+    sessions.insert(key, ticket);
+}
+
+/*!
+ * \param socket Socket that did the handshake
+ * \return Base64 of the SHA-256 hash of the peer's public key, as written in pins.ini.
+ */
+QString ITls::fingerprint(QSslSocket *socket)
+{
+    QSslCertificate cert = socket->peerCertificate();
+    if (cert.isNull())
+        return "";
+
+    QByteArray key = cert.publicKey().toDer();
+    return QCryptographicHash::hash(key, QCryptographicHash::Sha256).toBase64();
+}
+
+/*!
+ * \param host Hostname
+ * \return The pin for host from pins.ini, empty if it's not pinned.
+ */
+QString ITls::getPin(QString host)
+{
+    IniFile ini(PIN_FILE);
+    return ini.ReadIni(host.toLower(), "SHA256");
+}
+
+/*!
+ * \param socket Socket that did the handshake
+ * \param host Hostname
+ * \return false if host is pinned and presented a different key.
+ */
+bool ITls::checkPin(QSslSocket *socket, QString host)
+{
+    QString pin = getPin(host);
+    if (pin.isEmpty())
+        return true;
+
+    return (pin == fingerprint(socket));
+}
+
+/*!
+ * \param socket Socket with certificate errors
+ * \param host Hostname
+ * \param errors The errors
+ *
+ * A pinned server presenting the pinned key is trusted even if its certificate didn't verify
+ * (such as when it's self signed), so the errors are ignored.
+ * \return true if the errors were ignored.
+ */
+bool ITls::handleErrors(QSslSocket *socket, QString host, const QList<QSslError> &errors)
+{
+    if (getPin(host).isEmpty() || (! checkPin(socket, host)))
+        return false;
+
+    socket->ignoreSslErrors(errors);
+    return true;
+}
@@ -0,0 +1,60 @@
+/*
+ *   IdealIRC - Internet Relay Chat client
+ *   Copyright (C) 2014  Tom-Andre Barstad
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/*! \class ITls
+ *  \brief TLS helpers shared by IRC connections and script sockets.
+ *
+ * Keeps the TLS session tickets we got, per host and port, so a reconnect can resume the
+ * session instead of doing a full handshake. Also checks certificate pins from pins.ini:\n
+ * [irc.example.org]\n
+ * SHA256=base64 of the SHA-256 hash of the server's public key\n
+ * A pinned server must present that key. Its certificate doesn't need to be signed by a known CA.
+ */
+
+#ifndef ITLS_H
+#define ITLS_H
+
+#include <QString>
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QSslSocket>
+#include <QSslError>
+
+#define TLS_SESSION_MAX 64 //!< Max amount of session tickets kept.
+
+class ITls
+{
+public:
+    static bool available() { return QSslSocket::supportsSsl(); } //!< \return true if the TLS library could be loaded.
+    static void prepare(QSslSocket *socket, QString host, int port);
+    static void saveSession(QSslSocket *socket, QString host, int port);
+    static bool offeredSession(QString host, int port) { return sessions.contains(sessionKey(host, port)); } //!< \return true if we have a session ticket to resume with.
+    static QString fingerprint(QSslSocket *socket);
+    static QString getPin(QString host);
+    static bool checkPin(QSslSocket *socket, QString host);
+    static bool handleErrors(QSslSocket *socket, QString host, const QList<QSslError> &errors);
+
+private:
+    static QHash<QString,QByteArray> sessions; //!< Session tickets.\n Key: host:port in lower case
+    static QString sessionKey(QString host, int port) { return QString("%1:%2").arg(host.toLower()).arg(port); } //!< \return Key in sessions.
+};
+
+#endif // ITLS_H
@@ -40,6 +40,7 @@
 #include "iwin.h"
 #include "ui_iwin.h"
 #include "iconnection.h"
+#include "iperf.h"
 #include "script/tscriptparent.h"
 #include "script/tscript.h"
 
@@ -57,25 +58,34 @@ int IWin::statusCount = 0; // IdealIRC always starts with no windows, but the in
  * \param cfg Pointer to config class (iirc.ini).
  * \param sp Script parent.
  * \param c IRC connection this window sends data to. Scriptable windows can change this.
+ * \param dm DCC transfer manager, for DCC windows.
  */
-IWin::IWin(QWidget *parent, QString wname, int WinType, config *cfg, TScriptParent *sp, IConnection *c) :
+IWin::IWin(QWidget *parent, QString wname, int WinType, config *cfg, TScriptParent *sp, IConnection *c, DCCManager *dm) :
     QWidget(parent),
     settings(NULL),
     ui(new Ui::IWin),
     WindowType(WinType),
     connection(c),
+    dccManager(dm),
     scriptParent(sp),
     tstar("***"),
     sstar("*"),
     split(NULL),
     textdata(NULL),
     conf(cfg),
+    progress(NULL),
     picwin(NULL),
     listbox(NULL),
     listboxMenu(NULL),
     opMenu(NULL),
     textboxMenu(NULL),
-    input(NULL)
+    input(NULL),
+    pendingHighlight(HL_NONE),
+    pendingTitle(false),
+    stampSecond(-1),
+    collapseOpen(false),
+    collapseIndex(-1),
+    collapseDirty(false)
 {
     ui->setupUi(this);
 
@@ -88,6 +98,11 @@ IWin::IWin(QWidget *parent, QString wname, int WinType, config *cfg, TScriptPare
     ui->gridLayout->setHorizontalSpacing(0);
     ui->gridLayout->setVerticalSpacing(1);
 
+    flushTimer.setSingleShot(true);
+    flushTimer.setInterval(IWIN_FLUSH_INTERVAL);
+    connect(&flushTimer, SIGNAL(timeout()),
+            this, SLOT(flush()));
+
     // This one will be redefined if required.
     // Default is a custom window
     target = wname;
@@ -208,16 +223,24 @@ IWin::IWin(QWidget *parent, QString wname, int WinType, config *cfg, TScriptPare
         ui->gridLayout->addWidget(textdata, 0, 0);
     }
 
-    if (WindowType == WT_DCCSEND) {
-        dcc = new DCCSend(DCC_SEND, this, connection->dccinfo);
-        DCCSend *dsock = (DCCSend*)dcc;
+    if ((WindowType == WT_DCCSEND) || (WindowType == WT_DCCRECV)) {
+        if (WindowType == WT_DCCSEND)
+            dcc = new DCCSend(DCC_SEND, this, connection->dccinfo);
+        else
+            dcc = new DCCRecv(DCC_RECV, this, connection->dccinfo);
 
-    }
+        connect(dcc, SIGNAL(progress(qint64,qint64,qint64)),
+                this, SLOT(dccProgress(qint64,qint64,qint64)));
 
-    if (WindowType == WT_DCCRECV) {
-        dcc = new DCCRecv(DCC_RECV, this, connection->dccinfo);
-        DCCRecv *dsock = (DCCRecv*)dcc;
+        textdata = new IIRCView(conf);
 
+        progress = new QProgressBar(this);
+        progress->setRange(0, 1000);
+        progress->setValue(0);
+        progress->setFormat(tr("Waiting..."));
+
+        ui->gridLayout->addWidget(textdata, 0, 0);
+        ui->gridLayout->addWidget(progress, 1, 0);
     }
 
     if (WindowType == WT_DCCCHAT) {
@@ -303,6 +326,17 @@ IWin::IWin(QWidget *parent, QString wname, int WinType, config *cfg, TScriptPare
 
 IWin::~IWin()
 {
+    // Lines still waiting for the flush timer must reach the text widget and the log.
+    // The window list may already have forgotten us, so don't signal highlights or titles.
+    pendingHighlight = HL_NONE;
+    pendingTitle = false;
+    blockSignals(true);
+    if (textdata != NULL) {
+        if (collapseOpen)
+            closeCollapsed();
+        flush();
+    }
+
     textdata = NULL;
     delete ui;
 
@@ -338,6 +372,13 @@ void IWin::closeEvent(QCloseEvent *e)
         }
     }
 
+    if (textdata != NULL) {
+        if (collapseOpen)
+            closeCollapsed();
+        flushTimer.stop();
+        flush();
+    }
+
     emit activeWin("STATUS");
     emit closed(winid);
 }
@@ -619,11 +660,11 @@ void IWin::splitterMoved(int, int)
 void IWin::textboxMenuRequested(QPoint p)
 {
     if (WindowType == WT_CHANNEL)
-        scriptParent->populateMenu( textboxMenu, 'c' );
+        populateScriptMenu( textboxMenu, 'c' );
     else if (WindowType == WT_STATUS)
-        scriptParent->populateMenu( textboxMenu, 's' );
+        populateScriptMenu( textboxMenu, 's' );
     else if (WindowType == WT_PRIVMSG)
-        scriptParent->populateMenu( textboxMenu, 'q' );
+        populateScriptMenu( textboxMenu, 'q' );
     else
         return;
 
@@ -639,7 +680,7 @@ void IWin::textboxMenuRequested(QPoint p)
 void IWin::listboxMenuRequested(QPoint p)
 {
     if (WindowType == WT_CHANNEL)
-        scriptParent->populateMenu( listboxMenu, 'n' );
+        populateScriptMenu( listboxMenu, 'n' );
     else
         return;
 
@@ -647,7 +688,91 @@ void IWin::listboxMenuRequested(QPoint p)
 }
 
 /*!
- * \param text Text to log
+ * \param menu Menu to fill
+ * \param type Type of menu, see TScript::createMenu()
+ *
+ * Clears the menu and fills it with the menu items of all loaded scripts.
+ */
+void IWin::populateScriptMenu(QMenu *menu, char type)
+{
+    menu->clear();
+
+    QListIterator<QMenu*> si(scriptSubMenus);
+    while (si.hasNext())
+        si.next()->deleteLater();
+    scriptSubMenus.clear();
+
+    QVectorIterator<TScript*> i(scriptParent->getScripts());
+    while (i.hasNext()) {
+        TScript *script = i.next();
+        QList<scriptmenu_t> *items = NULL;
+
+        if (type == 'n')
+            items = script->getCustomNicklistMenu();
+        if (type == 'c')
+            items = script->getCustomChannelMenu();
+        if (type == 'q')
+            items = script->getCustomQueryMenu();
+        if (type == 's')
+            items = script->getCustomStatusMenu();
+
+        if (items != NULL)
+            populateScriptMenuIterate(menu, type, script, items, -1);
+    }
+}
+
+/*!
+ * \param menu Menu or submenu to fill
+ * \param type Type of menu, see TScript::createMenu()
+ * \param script Script the items belong to
+ * \param items All menu items of this type in the script
+ * \param parent Index of the submenu item we're filling, -1 for top level.
+ *
+ * \note This is a helper function for populateScriptMenu() and should not be called elsewhere.
+ */
+void IWin::populateScriptMenuIterate(QMenu *menu, char type, TScript *script, QList<scriptmenu_t> *items, int parent)
+{
+    QListIterator<scriptmenu_t> i(*items);
+    for (int idx = 0; i.hasNext(); ++idx) {
+        scriptmenu_t sm = i.next();
+        if (sm.parent != parent)
+            continue;
+
+        if (sm.haveChildren) {
+            QMenu *subMenu = menu->addMenu(sm.text);
+            scriptSubMenus << subMenu;
+            populateScriptMenuIterate(subMenu, type, script, items, idx);
+        }
+        else if (sm.separator)
+            menu->addSeparator();
+        else {
+            QAction *action = menu->addAction(sm.text);
+            action->setData(QStringList() << QString(type) << script->getName() << sm.function);
+        }
+    }
+}
+
+/*!
+ * \param action The picked script menu item
+ *
+ * Runs the function tied to a script menu item. Submenus pass their triggered actions on to
+ * the top level menu, so only that one is connected here.
+ */
+void IWin::scriptMenuTriggered(QAction *action)
+{
+    QStringList data = action->data().toStringList();
+    if (data.count() != 3)
+        return;
+
+    TScript *script = scriptParent->getScriptPtr(data[1]);
+    if (script == NULL)
+        return; // Unloaded while the menu was open.
+
+    script->runMenuItem(data[0].at(0).toLatin1(), data[2]);
+}
+
+/*!
+ * \param text Text to log, may be several lines
  *
  * If logging is enabled, this function will write to a text log.
  */
@@ -656,6 +781,8 @@ void IWin::writeToLog(QString text)
     if (! conf->logEnabled)
         return;
 
+    IPerfTimer logTimer(pc_LogWrite);
+
     QString LogFile = QString("%1/%2.txt")
                         .arg(conf->logPath)
                         .arg(target);
@@ -675,44 +802,258 @@ void IWin::writeToLog(QString text)
  * \param sender Sender of text (text in left margin)
  * \param text Text to print
  * \param ptype Type of text (see constants.h for PT_*)
+ * \param ts Milliseconds since epoch the text was sent (IRCv3 server-time), 0 for now
  *
  * Prints a text in this window.\n
  * If there's nowhere to print, this function does nothing.
  */
-void IWin::print(const QString &sender, const QString &text, const int ptype)
+void IWin::print(const QString &sender, const QString &text, const int ptype, qint64 ts)
 {
     if (textdata == NULL)
         return;
 
-    QString msg;
-
-    if ((ptype == PT_LOCALINFO) || (ptype == PT_SERVINFO))
-        msg = QString("%1 %2").arg(sender).arg(text);
-    else if (ptype == PT_ACTION)
-        msg = QString("* %1 %2").arg(sender).arg(text);
-    else
-        msg = QString("<%1> %2").arg(sender).arg(text);
+    if (collapseOpen)
+        closeCollapsed();
 
     if ((ptype == PT_ACTION) || (ptype == PT_CTCP))
-        emit Highlight(winid, HL_MSG);
+        markHighlight(HL_MSG);
     else if (ptype == PT_NOTICE)
-        emit Highlight(winid, HL_HIGHLIGHT);
+        markHighlight(HL_HIGHLIGHT);
     else
-        emit Highlight(winid, HL_ACTIVITY);
+        markHighlight(HL_ACTIVITY);
+
+    t_text t;
+    t.type = ptype;
+    t.ts = (ts > 0) ? ts : QDateTime::currentMSecsSinceEpoch();
+    t.sender = sender;
+    t.text = text;
+    t.reset = true;
+
+    pending.append(t);
+
+    if ((WindowType == WT_CHANNEL) || (WindowType == WT_PRIVMSG))
+        pendingLog.append(t);
+
+    if (WindowType == WT_PRIVMSG)
+        pendingTitle = true;
+
+    scheduleFlush();
+}
+
+/*!
+ * \param event Member event (ME_JOIN, ME_PART, ME_QUIT)
+ * \param nickname Nickname the event is about
+ * \param text Full text of the event, used when not collapsing and in the log
+ * \param ptype Type of text (see constants.h for PT_*)
+ * \param ts Milliseconds since epoch the event happened (IRCv3 server-time), 0 for now
+ *
+ * Prints a join, part or quit.\n
+ * If collapsing is enabled, events following each other go onto one line, like\n
+ * "Joins: a, b Parts: c", which is updated as more events arrive.
+ */
+void IWin::printMemberEvent(int event, const QString &nickname, const QString &text, const int ptype, qint64 ts)
+{
+    if (textdata == NULL)
+        return;
+
+    if ((! conf->collapseMemberEvents) || (event < ME_JOIN) || (event > ME_QUIT)) {
+        print(tstar, text, ptype, ts);
+        return;
+    }
+
+    if (collapseOpen && (collapsed[event].count() >= IWIN_COLLAPSE_MAX))
+        closeCollapsed();
+
+    t_text t;
+    t.type = ptype;
+    t.ts = (ts > 0) ? ts : QDateTime::currentMSecsSinceEpoch();
+    t.sender = tstar;
+    t.text = text;
+    t.reset = true;
+
+    if (! collapseOpen) {
+        for (int i = ME_JOIN; i <= ME_QUIT; ++i)
+            collapsed[i].clear();
+        collapseOpen = true;
+        collapseDirty = false;
+        pending.append(t); // Text is filled in by flush()
+        collapseIndex = pending.count() - 1;
+    }
+
+    collapsed[event] << nickname;
+    if (collapseIndex == -1)
+        collapseDirty = true;
+
+    // The log keeps every event on its own line.
+    if ((WindowType == WT_CHANNEL) || (WindowType == WT_PRIVMSG))
+        pendingLog.append(t);
+
+    markHighlight(HL_ACTIVITY);
+    scheduleFlush();
+}
+
+/*!
+ * \param type Highlight type (see constants.h for HL_*)
+ *
+ * Raises the highlight of this window, emitted on next flush.\n
+ * Only the highest highlight since last flush is emitted.
+ */
+void IWin::markHighlight(int type)
+{
+    if (type > pendingHighlight)
+        pendingHighlight = type;
+
+    scheduleFlush();
+}
+
+void IWin::scheduleFlush()
+{
+    if (! flushTimer.isActive())
+        flushTimer.start();
+}
+
+/*!
+ * \return Text of the open collapsed line.
+ */
+QString IWin::collapsedText()
+{
+    QStringList parts;
+    if (collapsed[ME_JOIN].count() > 0)
+        parts << tr("Joins: %1").arg(collapsed[ME_JOIN].join(", "));
+    if (collapsed[ME_PART].count() > 0)
+        parts << tr("Parts: %1").arg(collapsed[ME_PART].join(", "));
+    if (collapsed[ME_QUIT].count() > 0)
+        parts << tr("Quit: %1").arg(collapsed[ME_QUIT].join(", "));
+
+    return parts.join("  ");
+}
+
+/*!
+ * Ends the open collapsed line, next member event starts a new one.
+ */
+void IWin::closeCollapsed()
+{
+    if (collapseIndex > -1)
+        pending[collapseIndex].text = collapsedText();
+    else if (collapseDirty)
+        textdata->replaceLastLine(collapsedText());
+
+    collapseOpen = false;
+    collapseIndex = -1;
+    collapseDirty = false;
+}
+
+/*!
+ * \param batch Replayed lines, such as from CHATHISTORY
+ *
+ * Merges lines we missed in among the lines we have, by their timestamp.\n
+ * Lines we already have are skipped, the rest go to the log. The text widget repaints once.
+ */
+void IWin::printHistory(QVector<t_text> batch)
+{
+    if (textdata == NULL)
+        return;
+
+    if (collapseOpen)
+        closeCollapsed();
+    flush(); // Everything printed so far must be in the text widget before merging.
+
+    textdata->mergeLines(batch);
+    if (batch.isEmpty())
+        return;
+
+    if ((WindowType == WT_CHANNEL) || (WindowType == WT_PRIVMSG))
+        pendingLog += batch;
+
+    markHighlight(HL_MSG); // Also writes the log at next flush.
+}
+
+/*!
+ * \return Timestamp of the last line printed here, 0 if there's none.
+ */
+qint64 IWin::getLastTimestamp()
+{
+    if (pending.count() > 0)
+        return pending.last().ts;
+
+    if (textdata == NULL)
+        return 0;
+
+    return textdata->getLastTimestamp();
+}
+
+/*!
+ * \param t Line to format
+ *
+ * Formats a line the way it's written to the log.\n
+ * The timestamp is cached, lines within the same second share it.
+ * \return Formatted line
+ */
+QString IWin::logLine(const t_text &t)
+{
+    QString msg;
+
+    if ((t.type == PT_LOCALINFO) || (t.type == PT_SERVINFO))
+        msg = QString("%1 %2").arg(t.sender).arg(t.text);
+    else if (t.type == PT_ACTION)
+        msg = QString("* %1 %2").arg(t.sender).arg(t.text);
+    else
+        msg = QString("<%1> %2").arg(t.sender).arg(t.text);
 
     if (conf->showTimestmap) {
-        QString stamp = QDateTime::currentDateTime().toString( conf->timestamp );
-        stamp.append(' ');
+        qint64 second = t.ts / 1000;
+        if (second != stampSecond) {
+            stampSecond = second;
+            stamp = QDateTime::fromMSecsSinceEpoch(t.ts).toString( conf->timestamp );
+            stamp.append(' ');
+        }
         msg.prepend(stamp);
     }
 
-    textdata->addLine(sender, text, ptype);
+    return msg;
+}
 
-    if ((WindowType == WT_CHANNEL) || (WindowType == WT_PRIVMSG))
-        writeToLog(msg);
+/*!
+ * Moves all printed lines since last flush into the text widget with one repaint,\n
+ * writes them to the log in one go and emits the highlight once.\n
+ * Runs at most once per IWIN_FLUSH_INTERVAL, so a flood only repaints about once per frame.
+ */
+void IWin::flush()
+{
+    if (textdata == NULL)
+        return;
 
-    if (WindowType == WT_PRIVMSG)
+    if (collapseOpen) {
+        if (collapseIndex > -1) {
+            pending[collapseIndex].text = collapsedText();
+            collapseIndex = -1; // In the text widget after this flush.
+        }
+        else if (collapseDirty)
+            textdata->replaceLastLine(collapsedText());
+        collapseDirty = false;
+    }
+
+    IPerf::set(pc_PrintQueue, pending.count());
+    textdata->addLines(pending);
+    pending.clear();
+
+    if (pendingLog.count() > 0) {
+        QStringList log;
+        for (int i = 0; i < pendingLog.count(); ++i)
+            log << logLine(pendingLog[i]);
+        pendingLog.clear();
+        writeToLog(log.join("\n"));
+    }
+
+    if (pendingHighlight > HL_NONE) {
+        emit Highlight(winid, pendingHighlight);
+        pendingHighlight = HL_NONE;
+    }
+
+    if (pendingTitle) {
+        pendingTitle = false;
         updateTitleHost();
+    }
 }
 
 /*!
@@ -989,6 +1330,11 @@ void IWin::reloadCSS()
  */
 void IWin::clear()
 {
+    pending.clear();
+    collapseOpen = false;
+    collapseIndex = -1;
+    collapseDirty = false;
+
     if (textdata != NULL)
         textdata->clear();
 
@@ -1132,6 +1478,12 @@ void IWin::regenChannelMenus()
         delete textboxMenu;
     textboxMenu = new QMenu(this);
 
+    connect(listboxMenu, SIGNAL(triggered(QAction*)),
+            this, SLOT(scriptMenuTriggered(QAction*)));
+
+    connect(textboxMenu, SIGNAL(triggered(QAction*)),
+            this, SLOT(scriptMenuTriggered(QAction*)));
+
     connect(listbox, SIGNAL(MenuRequested(QPoint)),
             this, SLOT(listboxMenuRequested(QPoint)));
 
@@ -1149,6 +1501,9 @@ void IWin::regenQueryMenu()
         delete textboxMenu;
     textboxMenu = new QMenu(this);
 
+    connect(textboxMenu, SIGNAL(triggered(QAction*)),
+            this, SLOT(scriptMenuTriggered(QAction*)));
+
     connect(textdata, SIGNAL(menuRequested(QPoint)),
             this, SLOT(textboxMenuRequested(QPoint)));
 }
@@ -1163,6 +1518,9 @@ void IWin::regenStatusMenu()
         delete textboxMenu;
     textboxMenu = new QMenu(this);
 
+    connect(textboxMenu, SIGNAL(triggered(QAction*)),
+            this, SLOT(scriptMenuTriggered(QAction*)));
+
     connect(textdata, SIGNAL(menuRequested(QPoint)),
             this, SLOT(textboxMenuRequested(QPoint)));
 }
@@ -1217,3 +1575,29 @@ void IWin::nickMenuRequest(QPoint point, QString nickname)
         listboxMenuRequested( QWidget::mapToGlobal(point) );
     }
 }
+
+/*!
+ * \param done Bytes transferred
+ * \param size File size
+ * \param bps Bytes per second since last update
+ *
+ * Shows file transfer progress, for WT_DCCSEND and WT_DCCRECV.
+ */
+void IWin::dccProgress(qint64 done, qint64 size, qint64 bps)
+{
+    if (progress == NULL)
+        return;
+
+    if (size > 0)
+        progress->setValue(done * 1000 / size);
+    else
+        progress->setValue(1000);
+
+    if (done >= size)
+        progress->setFormat(tr("%1 - Complete").arg(DCC::formatSize(size)));
+    else
+        progress->setFormat(tr("%1 of %2 - %3/s")
+                              .arg(DCC::formatSize(done))
+                              .arg(DCC::formatSize(size))
+                              .arg(DCC::formatSize(bps)));
+}
@@ -40,6 +40,9 @@
 #include <QFocusEvent>
 #include <QTextCodec>
 #include <QMenu>
+#include <QTimer>
+#include <QVector>
+#include <QProgressBar>
 
 #include "constants.h"
 #include "tpicturewindow.h"
@@ -49,34 +52,39 @@
 #include "config.h"
 #include "ichanconfig.h"
 #include "icommand.h"
+#include "icoreevents.h"
 #include "dcc/dcc.h"
 
 namespace Ui {
     class IWin;
 }
 
+#define IWIN_FLUSH_INTERVAL 16 //!< Milliseconds between moving printed lines into the text widget, about one frame.
+#define IWIN_COLLAPSE_MAX   40 //!< Max nicknames on one collapsed join/part/quit line.
+
 class TScriptParent;
+class TScript;
+struct scriptmenu_t;
 class IConnection;
 class IWin;
+class DCCManager;
 
-typedef struct T_MEMBER {
-  QString nickname;
-  QString ident;
-  QString host;
-  QList<char> mode; // Store mode letters like +, @, etc (not the modes v, o, etc)
-} member_t;
-
-class IWin : public QWidget
+class IWin : public QWidget, public ICoreWindow
 {
     Q_OBJECT
 
 public:
-      explicit IWin(QWidget *parent, QString wname, int WinType, config *cfg, TScriptParent *sp, IConnection *p = NULL);
+      explicit IWin(QWidget *parent, QString wname, int WinType, config *cfg, TScriptParent *sp, IConnection *p = NULL, DCCManager *dm = NULL);
       ~IWin();
       int getId() { return winid; } //!< \return Integer of this subwindows ID.
       int getType() { return WindowType; } //!< \return Integer of what type this window is. (WT_* constants)
+      QString getName() { return objectName(); } //!< \return QString of the window name.
       QString getTarget() { return target; } //!< \return QString of what target this widget writes to (channel or nickname)
-      void print(const QString &sender, const QString &text, const int ptype = 0);
+      void print(const QString &sender, const QString &text, const int ptype = 0, qint64 ts = 0);
+      void printMemberEvent(int event, const QString &nickname, const QString &text, const int ptype, qint64 ts = 0);
+      void printHistory(QVector<t_text> batch);
+      qint64 getLastTimestamp();
+      void markHighlight(int type);
       void insertMember(QString nickname, member_t mt, bool sort = true);
       void removeMember(QString nickname, bool sort = true);
       bool memberExist(QString nickname);
@@ -87,12 +95,15 @@ public:
       void MemberUnsetMode(QString nickname, char mode);
       member_t ReadMember(QString nickname);
       IChanConfig *settings; //!< Channel settings dialog. Must be created before this one is shown. See execChanSettings()
+      ICoreChanSettings* chanSettings() { return settings; } //!< \return The channel settings dialog for the core, NULL if it's not open.
       void setInputText(QString text);
       void setTopic(QString newTopic); // Just for storing, nothing else.
       void setCmdHandler(ICommand *cmd) { cmdhndl = cmd; } //!< Passes the ICommand class from the IConnection this window is bound to.
       void setConnectionPtr(IConnection *con);
       void sockwrite(QString data) { emit sendToSocket(data); } //!< Writes data to the IRC server.
       IConnection* getConnection() { return connection; } //!< Returns the IConnection this window is bound to.
+      DCCManager* getDccManager() { return dccManager; } //!< Returns the DCC transfer manager, for DCC windows.
+      config* getConfig() { return conf; } //!< Returns the config class (iirc.ini).
       void setSortRuleMap(QList<char> *sl) { sortrule = sl; } //!< Copies the sort rule which the bound IConnection uses.
       void setFont(const QFont &font);
       void reloadCSS(); // Runs only if TIRCVIEW is present.
@@ -100,7 +111,10 @@ public:
       QStringList getSelectedMembers(); // Returns a list of selected nicknames.
       void updateTitleHost(); // for WT_PRIVMSG, set hostname in titlebar
       TPictureWindow* picwinPtr() { return picwin; } //!< Returns the drawable picture widget, only if WindowType = WT_GRAPHIC or WT_GWINPUT - otherwise this returns NULL.
+      ICorePicture* picture() { return picwin; } //!< Same as picwinPtr(), for the script engine.
       void execChanSettings();
+      int getWidth() { return width(); } //!< \return Width of this window.
+      int getHeight() { return height(); } //!< \return Height of this window.
       int listboxWidth();
       int listboxHeight();
 
@@ -113,6 +127,7 @@ private:
       int winid; //!< The window id.
       IConnection *connection; //!< The connection this window is bound to.
       DCC *dcc; //!< DCC processing, if this is a DCC window.
+      DCCManager *dccManager; //!< Pointer to the DCC transfer manager in IdealIRC class.
       TScriptParent *scriptParent; //!< Pointer to the script parent.
 
       const QString tstar; //!< Just a string with triple stars.
@@ -122,12 +137,14 @@ private:
       QSplitter *split; //!< Splitter for text widget and listbox.
       IIRCView *textdata; //!< Text widget. (Most window types except custom graphic.)
       config *conf; //!< Pointer to config class (iirc.ini)
+      QProgressBar *progress; //!< Transfer progress, only for WT_DCCSEND and WT_DCCRECV.
       int WinType; //!< Window type. See constants.h for WT_*
       TPictureWindow *picwin; //!< Paintable picture window (WindowType = WT_GRAPHIC or WT_GWINPUT)
       QMyListWidget *listbox; //!< Listbox widget. (Channels only)
       QMenu *listboxMenu; //!< Menu for the listbox widget. Gets its contents via scriptParent. (Channels only)
       QMenu *opMenu;
       QMenu *textboxMenu; //!< Menu for the display widget. Gets its contents via scriptParent. Its contents depends on the window type.
+      QList<QMenu*> scriptSubMenus; //!< Submenus made by populateScriptMenu(). Deleted when the menu is filled again.
 
       // 'Join channel' menu, requested by IIRCView.
       QMenu joinChannelMenu; //!< Menu requested by IIRCView, when you click on channels, this menu popup.
@@ -150,12 +167,33 @@ private:
       QString acPost; //!< All text after the autocompleted word.
 
       void writeToLog(QString text); // Writes to a log file under logdir and filename is target.txt
+
+      // Printed lines waiting for flush()
+      QTimer flushTimer; //!< Single shot, runs flush() when there are lines waiting.
+      QVector<t_text> pending; //!< Lines not yet in the text widget.
+      QVector<t_text> pendingLog; //!< Lines not yet in the log file.
+      int pendingHighlight; //!< Highest highlight (HL_*) since last flush.
+      bool pendingTitle; //!< Update the query title at next flush.
+      qint64 stampSecond; //!< Second of the cached timestamp for log lines.
+      QString stamp; //!< Cached timestamp for log lines.
+      QString logLine(const t_text &t);
+      void scheduleFlush();
+
+      // Collapsed joins/parts/quits
+      QStringList collapsed[3]; //!< Nicknames on the open collapsed line, indexed by ME_*
+      bool collapseOpen; //!< The last line is a collapsed line, member events go onto it.
+      int collapseIndex; //!< Index in pending of the collapsed line, -1 if it's already in the text widget.
+      bool collapseDirty; //!< Collapsed line changed since it went into the text widget.
+      QString collapsedText();
+      void closeCollapsed();
       void sortList(QList<char> *lst);
       bool sortLargerThan(const QString s1, const QString s2);
       QString stripModeChar(QString nickname);
       void regenChannelMenus();
       void regenQueryMenu();
       void regenStatusMenu();
+      void populateScriptMenu(QMenu *menu, char type);
+      void populateScriptMenuIterate(QMenu *menu, char type, TScript *script, QList<scriptmenu_t> *items, int parent);
       void processLineInput(QString &line);
 
 protected:
@@ -176,12 +214,15 @@ private slots:
       void splitterMoved(int, int);
       void textboxMenuRequested(QPoint p);
       void listboxMenuRequested(QPoint p);
+      void scriptMenuTriggered(QAction *action);
       void settingsClosed();
       void listboxDoubleClick(QListWidgetItem *item);
       void mouseDoubleClick();
       void joinChannelMenuRequest(QPoint point, QString channel);
       void joinChannelTriggered();
       void nickMenuRequest(QPoint point, QString nickname);
+      void flush();
+      void dccProgress(qint64 done, qint64 size, qint64 bps);
 
 signals:
       void closed(int wid);
@@ -0,0 +1,99 @@
+/*
+ *   IdealIRC - Internet Relay Chat client
+ *   Copyright (C) 2014  Tom-Andre Barstad
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+
+#include "iwindowregistry.h"
+#include "icoreevents.h"
+
+/*!
+ * \param wl Pointer to the list of all subwindows
+ */
+IWindowRegistry::IWindowRegistry(QHash<int,subwindow_t> *wl) :
+    winlist(wl)
+{
+}
+
+/*!
+ * \param sw Subwindow
+ *
+ * Indexes the subwindow by its parent and name. The subwindow must already be in the window list.
+ */
+void IWindowRegistry::add(const subwindow_t &sw)
+{
+    if (sw.type == WT_STATUS)
+        return;
+
+    QString name = sw.window->getName().toUpper();
+    index[sw.parent].insert(name, sw.wid);
+    keys.insert(sw.wid, qMakePair(sw.parent, name));
+}
+
+/*!
+ * \param wid Window ID
+ *
+ * Removes the subwindow from the index. Does nothing if it isn't indexed.
+ */
+void IWindowRegistry::remove(int wid)
+{
+    if (! keys.contains(wid))
+        return;
+
+    QPair<int,QString> k = keys.take(wid);
+    QHash<int, QHash<QString,int> >::iterator i = index.find(k.first);
+    if (i == index.end())
+        return;
+
+    i.value().remove(k.second);
+    if (i.value().isEmpty())
+        index.erase(i);
+}
+
+/*!
+ * \param parent Parent ID
+ * \param name Window name, case insensitive
+ *
+ * \return Window ID, or -1 if not found.
+ */
+int IWindowRegistry::find(int parent, const QString &name) const
+{
+    QHash<int, QHash<QString,int> >::const_iterator i = index.constFind(parent);
+    if (i == index.constEnd())
+        return -1;
+
+    // toUpper() gives back the same string, without a copy, when it's upper case already.
+    return i.value().value(name.toUpper(), -1);
+}
+
+/*!
+ * \param parent Parent ID
+ * \param name Window name, case insensitive
+ *
+ * \return Subwindow, with type WT_NOTHING if not found.
+ */
+subwindow_t IWindowRegistry::get(int parent, const QString &name) const
+{
+    subwindow_t sw_empty = SW_EMPTY_SET;
+
+    int wid = find(parent, name);
+    if (wid == -1)
+        return sw_empty;
+
+    return winlist->value(wid, sw_empty);
+}
@@ -0,0 +1,54 @@
+/*
+ *   IdealIRC - Internet Relay Chat client
+ *   Copyright (C) 2014  Tom-Andre Barstad
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/*! \class IWindowRegistry
+ *  \brief Name lookup for subwindows.
+ *
+ * Subwindows are stored by window ID in the window list of IdealIRC. This class keeps an index on top
+ * of that list, keyed by parent (connection ID, or WP_CUSTOM for custom windows) and the upper case window
+ * name, so finding a window by name is two hash lookups rather than a walk over every open window.\n
+ * Status windows are not indexed, there may be many of them with the same name.
+ */
+
+#ifndef IWINDOWREGISTRY_H
+#define IWINDOWREGISTRY_H
+
+#include <QHash>
+#include <QString>
+#include <QPair>
+#include "constants.h"
+
+class IWindowRegistry
+{
+public:
+    explicit IWindowRegistry(QHash<int,subwindow_t> *wl);
+    void add(const subwindow_t &sw);
+    void remove(int wid);
+    int find(int parent, const QString &name) const;
+    bool exists(int parent, const QString &name) const { return find(parent, name) != -1; } //!< \return true if the window name exist under given parent.
+    subwindow_t get(int parent, const QString &name) const;
+
+private:
+    QHash<int,subwindow_t> *winlist; //!< All subwindows. Pointer from IdealIRC class.
+    QHash<int, QHash<QString,int> > index; //!< Key: Parent ID\n Value: Key: Upper case window name, Value: Window ID.
+    QHash<int, QPair<int,QString> > keys; //!< Reverse of index, parent and name by window ID. Used when removing a window.
+};
+
+#endif // IWINDOWREGISTRY_H
@@ -19,11 +19,15 @@
  */
 
 #include <QApplication>
+#include <QDateTime>
 #include "idealirc.h"
 
 int main(int argc, char *argv[])
 {
     QApplication a(argc, argv);
+
+    // Reconnect delays and $rand draw from qrand(), they must differ between clients.
+    qsrand( (uint)(QDateTime::currentMSecsSinceEpoch() ^ QCoreApplication::applicationPid()) );
     IdealIRC w;
     w.show();
     
@@ -185,7 +185,8 @@ enum reserved_e {
     RPL_WHOISMODES        = 379,
     RPL_WHOISIDENTIFIED   = 307,
     RPL_WHOISLOGGEDIN     = 330,
-    RPL_WHOISHELP         = 310
+    RPL_WHOISHELP         = 310,
+    RPL_WHOSPCRPL         = 354
 
     // these - or one or more of these numerics, may be removed.
     // some may be added if needed.
@@ -168,8 +168,8 @@ void QMyLineEdit::keyPressEvent(QKeyEvent *e)
  */
 void QMyLineEdit::updateCSS()
 {
-    QString bg = conf->colInputBackground;
-    QString fg = conf->colInput;
+    QString bg = conf->theme.inputBackground.name();
+    QString fg = conf->theme.input.name();
 
     setStyleSheet( QString("background-color: %1; color: %2;")
                      .arg(bg)
@@ -213,56 +213,5 @@ int QMyLineEdit::acBegin()
 
 QColor QMyLineEdit::getColorFromCode(int num)
 {
-    switch(num) {
-        case 0:
-            return C_WHITE;
-
-        case 1:
-            return C_BLACK;
-
-        case 2:
-            return C_BLUE;
-
-        case 3:
-            return C_GREEN;
-
-        case 4:
-            return C_BRIGHTRED;
-
-        case 5:
-            return C_RED;
-
-        case 6:
-            return C_MAGENTA;
-
-        case 7:
-            return C_BROWN;
-
-        case 8:
-            return C_YELLOW;
-
-        case 9:
-            return C_BRIGHTGREEN;
-
-        case 10:
-            return C_CYAN;
-
-        case 11:
-            return C_BRIGHTCYAN;
-
-        case 12:
-            return C_BRIGHTBLUE;
-
-        case 13:
-            return C_BRIGHTMAGENTA;
-
-        case 14:
-            return C_DARKGRAY;
-
-        case 15:
-            return C_LIGHTGRAY;
-
-        default:
-            return C_BLACK;
-    }
+    return conf->mircColor(num);
 }
@@ -44,73 +44,22 @@ void QMyListWidget::contextMenuEvent(QContextMenuEvent *e)
 void QMyListWidget::updateCSS()
 {
     QPalette pal = palette();
-    pal.setColor(QPalette::Active, QPalette::Base, conf->colListboxBackground);
-    pal.setColor(QPalette::Active, QPalette::AlternateBase, conf->colListboxBackground);
-    pal.setColor(QPalette::Inactive, QPalette::Base, conf->colListboxBackground);
-    pal.setColor(QPalette::Inactive, QPalette::AlternateBase, conf->colListboxBackground);
-    pal.setColor(QPalette::Disabled, QPalette::Base, conf->colListboxBackground);
-    pal.setColor(QPalette::Disabled, QPalette::AlternateBase, conf->colListboxBackground);
-    pal.setColor(QPalette::Active, QPalette::Text, conf->colListbox);
-    pal.setColor(QPalette::Active, QPalette::WindowText, conf->colListbox);
-    pal.setColor(QPalette::Inactive, QPalette::Text, conf->colListbox);
-    pal.setColor(QPalette::Inactive, QPalette::WindowText, conf->colListbox);
-    pal.setColor(QPalette::Disabled, QPalette::Text, conf->colListbox);
-    pal.setColor(QPalette::Disabled, QPalette::WindowText, conf->colListbox);
+    pal.setColor(QPalette::Active, QPalette::Base, conf->theme.listboxBackground);
+    pal.setColor(QPalette::Active, QPalette::AlternateBase, conf->theme.listboxBackground);
+    pal.setColor(QPalette::Inactive, QPalette::Base, conf->theme.listboxBackground);
+    pal.setColor(QPalette::Inactive, QPalette::AlternateBase, conf->theme.listboxBackground);
+    pal.setColor(QPalette::Disabled, QPalette::Base, conf->theme.listboxBackground);
+    pal.setColor(QPalette::Disabled, QPalette::AlternateBase, conf->theme.listboxBackground);
+    pal.setColor(QPalette::Active, QPalette::Text, conf->theme.listbox);
+    pal.setColor(QPalette::Active, QPalette::WindowText, conf->theme.listbox);
+    pal.setColor(QPalette::Inactive, QPalette::Text, conf->theme.listbox);
+    pal.setColor(QPalette::Inactive, QPalette::WindowText, conf->theme.listbox);
+    pal.setColor(QPalette::Disabled, QPalette::Text, conf->theme.listbox);
+    pal.setColor(QPalette::Disabled, QPalette::WindowText, conf->theme.listbox);
     setPalette(pal);
 }
 
 QColor QMyListWidget::getColorFromCode(int num)
 {
-    switch(num) {
-        case 0:
-            return C_WHITE;
-
-        case 1:
-            return C_BLACK;
-
-        case 2:
-            return C_BLUE;
-
-        case 3:
-            return C_GREEN;
-
-        case 4:
-            return C_BRIGHTRED;
-
-        case 5:
-            return C_RED;
-
-        case 6:
-            return C_MAGENTA;
-
-        case 7:
-            return C_BROWN;
-
-        case 8:
-            return C_YELLOW;
-
-        case 9:
-            return C_BRIGHTGREEN;
-
-        case 10:
-            return C_CYAN;
-
-        case 11:
-            return C_BRIGHTCYAN;
-
-        case 12:
-            return C_BRIGHTBLUE;
-
-        case 13:
-            return C_BRIGHTMAGENTA;
-
-        case 14:
-            return C_DARKGRAY;
-
-        case 15:
-            return C_LIGHTGRAY;
-
-        default:
-            return C_BLACK;
-    }
+    return conf->mircColor(num);
 }
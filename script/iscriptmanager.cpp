@@ -65,6 +65,8 @@ IScriptManager::IScriptManager(QWidget *parent, TScriptParent *sp, config *cfg)
     header->setSectionResizeMode(1, QHeaderView::Stretch);
 
     selection = ui->tableView->selectionModel();
+
+    ui->chkProfile->setChecked(scriptParent->getProfiler()->isEnabled());
 }
 
 IScriptManager::~IScriptManager()
@@ -217,3 +219,41 @@ void IScriptManager::on_btnNew_clicked()
     ini.WriteIni("Script", name, file);
 
 }
+
+void IScriptManager::on_chkProfile_toggled(bool checked)
+{
+    scriptParent->getProfiler()->setEnabled(checked);
+    on_btnProfileRefresh_clicked();
+}
+
+void IScriptManager::on_btnProfileRefresh_clicked()
+{
+    ui->profileView->setPlainText(scriptParent->getProfiler()->report(scriptParent));
+}
+
+void IScriptManager::on_btnProfileReset_clicked()
+{
+    scriptParent->getProfiler()->reset();
+    on_btnProfileRefresh_clicked();
+}
+
+void IScriptManager::on_btnProfileSave_clicked()
+{
+    QString file = QFileDialog::getSaveFileName(this, tr("Save profile"), CONF_PATH, "Text files (*.txt);;Other files (*)");
+    if (file.isEmpty())
+        return;
+
+    if (! scriptParent->getProfiler()->dump(file, scriptParent))
+        QMessageBox::critical(this, tr("Cannot save profile"), tr("Unable to write to %1").arg(file), QMessageBox::Ok);
+}
+
+/*!
+ * \param index Tab index
+ *
+ * Shows the latest results when switching to the profiler tab.
+ */
+void IScriptManager::on_tabWidget_currentChanged(int index)
+{
+    if (ui->tabWidget->widget(index) == ui->tabProfiler)
+        on_btnProfileRefresh_clicked();
+}
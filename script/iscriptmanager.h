@@ -51,6 +51,11 @@ private slots:
     void on_btnLoad_clicked();
     void on_btnEdit_clicked();
     void on_btnNew_clicked();
+    void on_chkProfile_toggled(bool checked);
+    void on_btnProfileRefresh_clicked();
+    void on_btnProfileReset_clicked();
+    void on_btnProfileSave_clicked();
+    void on_tabWidget_currentChanged(int index);
 
 private:
     Ui::IScriptManager *ui; //!< Qt Creator generated GUI class.
@@ -35,9 +35,9 @@
 #include <QStringList>
 #include <QSignalMapper>
 
-#include "iwin.h"
 #include "tsdialog.h"
 #include "constants.h"
+#include "icoreevents.h"
 
 /*
   Label
@@ -49,7 +49,7 @@
 
 class TScript;
 
-class TCustomScriptDialog : public QObject
+class TCustomScriptDialog : public QObject, public ICoreScriptDialog
 {
   Q_OBJECT
 
@@ -24,7 +24,6 @@
 #include <QListIterator>
 #include <QVector>
 #include <QDebug>
-#include <QMenu>
 
 #include "tscriptparent.h"
 #include "tscript.h"
@@ -41,17 +40,13 @@
 #include "tscript/containers.cpp"
 #include "tscript/dialogs.cpp"
 
-TScript::TScript(QObject *parent, TScriptParent *sp, QWidget *dialogParent, QString fname,
-                 QHash<int,IConnection*> *cl, QHash<int,subwindow_t> *wl, int *aWid, int *aConn) :
+TScript::TScript(QObject *parent, TScriptParent *sp, ICoreFrontEnd *fe, QString fname,
+                 QHash<int,IConnection*> *cl, QHash<int,subwindow_t> *wl, IWindowRegistry *wr, int *aWid, int *aConn) :
     QObject(parent),
-    dlgParent(dialogParent),
+    frontEnd(fe),
     scriptParent(sp),
-    ifn(&sockets, &fnindex, &dialogs, &files, cl, wl, aWid, aConn, this),
+    ifn(&sockets, &fnindex, &dialogs, &files, cl, wl, wr, aWid, aConn, this),
     filename(fname),
-    rootNicklistMenu(NULL),
-    rootChannelMenu(NULL),
-    rootQueryMenu(NULL),
-    rootStatusMenu(NULL),
     activeWid(aWid),
     activeConn(aConn),
     winList(wl),
@@ -62,19 +57,6 @@ TScript::TScript(QObject *parent, TScriptParent *sp, QWidget *dialogParent, QStr
 
     connect(&sockets, SIGNAL(runEvent(e_iircevent,QStringList)),
             this, SLOT(runEvent(e_iircevent,QStringList)));
-
-
-    connect(&nicklistMenuMapper, SIGNAL(mapped(QString)),
-            this, SLOT(nicklistMenuItemTriggered(QString)));
-
-    connect(&channelMenuMapper, SIGNAL(mapped(QString)),
-            this, SLOT(channelMenuItemTriggered(QString)));
-
-    connect(&queryMenuMapper, SIGNAL(mapped(QString)),
-            this, SLOT(queryMenuItemTriggered(QString)));
-
-    connect(&statusMenuMapper, SIGNAL(mapped(QString)),
-            this, SLOT(statusMenuItemTriggered(QString)));
 }
 
 /*!
@@ -93,14 +75,6 @@ TScriptParent* TScript::getScriptParent()
     return scriptParent;
 }
 
-/*!
- * \return Pointer to IdealIRC class
- */
-QWidget* TScript::getDlgParent()
-{
-    return dlgParent;
-}
-
 /*!
  * \param fn Function name
  *
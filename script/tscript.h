@@ -25,19 +25,17 @@
 #ifndef TSCRIPT_H
 #define TSCRIPT_H
 
-#include <QWidget>
+#include <QObject>
 #include <QStringList>
 #include <QHash>
 #include <QList>
 #include <QFile>
-#include <QAction>
-#include <QSignalMapper>
 
 #include "constants.h"
+#include "icoreevents.h"
 #include "tscriptinternalfunctions.h"
 #include "ttimer.h"
 #include "tsockfactory.h"
-#include "tcustomscriptdialog.h"
 
 typedef struct T_SCRIPT
 {
@@ -53,7 +51,9 @@ typedef struct T_SCRIPTLINE
 
 struct scriptmenu_t
 {
-    QAction *action;
+    QString text; // Item or submenu text. Empty for separators.
+    QString function; // Function to run when the item is picked.
+    bool separator;
     int parent; // -1 for no parent ("top level"). Begins at 0.
     bool haveChildren;
 };
@@ -65,12 +65,14 @@ class TScript : public QObject
   Q_OBJECT
 
 public:
-    TScript(QObject *parent, TScriptParent *sp, QWidget *dialogParent, QString fname,
-            QHash<int,IConnection*> *cl, QHash<int,subwindow_t> *wl, int *aWid, int *aConn);
+    TScript(QObject *parent, TScriptParent *sp, ICoreFrontEnd *fe, QString fname,
+            QHash<int,IConnection*> *cl, QHash<int,subwindow_t> *wl, IWindowRegistry *wr, int *aWid, int *aConn);
 
     e_scriptresult loadScript2(QString includeFile = "", QString parent = "");
     e_scriptresult runf(QString function, QStringList param, QString &result, bool ignoreParamCount = false);
 
+    void runMenuItem(char type, QString function);
+
     bool runCommand(QString cmd);
     bool hasCommand(QString cmd);
 
@@ -89,7 +91,7 @@ public:
 
     config* getConfPtr();
     TScriptParent* getScriptParent();
-    QWidget* getDlgParent();
+    ICoreFrontEnd* getFrontEnd() { return frontEnd; } //!< \return Pointer to the front end. Used for scriptable dialogs and message boxes.
 
     QHash<QString,QString>* getCommandListPtr() { return &command; } //!< \return Pointer to list of commands tied to function.
     QHash<e_iircevent,QString>* getEventListPtr() { return &tevent; } //!< \return Pointer to list of events tied to function.
@@ -106,7 +108,7 @@ public:
     e_scriptresult externalExtract(QString &text);
 
 private:
-    QWidget *dlgParent; //!< Pointer to the IdealIRC class. Used as parent to scriptable dialogs.
+    ICoreFrontEnd *frontEnd; //!< Pointer to the front end. Creates the scriptable dialogs.
     TScriptParent *scriptParent; //!< Pointer to the script parent.
     TScriptInternalFunctions ifn; //!< All internal script functions.
     TSockFactory sockets; //!< Scriptable sockets.
@@ -118,27 +120,19 @@ private:
     QHash<QString,int> fnindex; //!< Index over functions, which byte positon to find them in.\n Key: Function\n Value: Position
     QHash<QString,TTimer*> timers; //!< List of timers.\n Key: name\n Value: timer object
     QHash<QString,QString> container; //!< Containers. Deprecated functionality.\n Key: Name\n Value: value
-    QHash<QString,TCustomScriptDialog*> dialogs; //!< Scriptable dialogs.\n Key: Name\n Value: Dialog handler
+    QHash<QString,ICoreScriptDialog*> dialogs; //!< Scriptable dialogs.\n Key: Name\n Value: Dialog handler
     QHash<int,t_sfile> files; //!< Scriptable file I/O.\n Key: File descriptor\n Value: File handler
     QHash<QString,QString> variables; //!< Global text variables.\n Key: Name\n Value: data
     QHash<QString,QByteArray> binVars; //!< Global binary variables.\n Key: Name\n Value: data
     QMap<int,QString> lineMap; //!< Line mapping. Since lines are skewed internally due to removal of whitespace, this is needed.\n Key: internal line\n Value: line number with filename
 
-    QAction *rootNicklistMenu; //!< The root of custom nicklist menu.
-    QAction *rootChannelMenu; //!< The root of custom channel menu.
-    QAction *rootQueryMenu; //!< The root of custom query menu.
-    QAction *rootStatusMenu; //!< The root of custom status menu.
-    QList<scriptmenu_t> customNicklistMenu; //!< Custom nicklist menu. Pointer passed to Script Parent for processing this list.
-    QList<scriptmenu_t> customChannelMenu; //!< Custom channel menu. Pointer passed to Script Parent for processing this list.
-    QList<scriptmenu_t> customQueryMenu; //!< Custom query menu. Pointer passed to Script Parent for processing this list.
-    QList<scriptmenu_t> customStatusMenu; //!< Custom status menu. Pointer passed to Script Parent for processing this list.
+    QList<scriptmenu_t> customNicklistMenu; //!< Custom nicklist menu. IWin builds its popup menu from this list.
+    QList<scriptmenu_t> customChannelMenu; //!< Custom channel menu. IWin builds its popup menu from this list.
+    QList<scriptmenu_t> customQueryMenu; //!< Custom query menu. IWin builds its popup menu from this list.
+    QList<scriptmenu_t> customStatusMenu; //!< Custom status menu. IWin builds its popup menu from this list.
     void createMenu(int &pos, char type);
     void createMenuIterate(int &pos, char type, int parent); // position is where the given menu block starts in script (byte pos). (after {)
     void resetMenu(QList<scriptmenu_t> &menu); // Use for re-parsing the menu structure
-    QSignalMapper nicklistMenuMapper; //!< Map of all menu items in nicklist, tied to their triggered action.
-    QSignalMapper channelMenuMapper; //!< Map of all menu items in channel, tied to their triggered action.
-    QSignalMapper queryMenuMapper; //!< Map of all menu items in query, tied to their triggered action.
-    QSignalMapper statusMenuMapper; //!< Map of all menu items in status, tied to their triggered action.
 
     int *activeWid; //!< Current active window ID.
     int *activeConn; //!< Current active connection ID.
@@ -184,12 +178,6 @@ public slots:
     void timerTimeout(QString fn);
     bool runEvent(e_iircevent evt, QStringList param, QString *result = nullptr);
 
-private slots:
-    void nicklistMenuItemTriggered(QString function);
-    void channelMenuItemTriggered(QString function);
-    void queryMenuItemTriggered(QString function);
-    void statusMenuItemTriggered(QString function);
-
 signals:
     void execCmdSignal(QString cmd); // command param param2 ...
     void error(QString text);
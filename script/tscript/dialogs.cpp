@@ -23,10 +23,10 @@
 
 bool TScript::customDialogShow(QString oname)
 {
-    QHashIterator<QString,TCustomScriptDialog*> i(dialogs);
+    QHashIterator<QString,ICoreScriptDialog*> i(dialogs);
     while (i.hasNext()) {
         i.next();
-        TCustomScriptDialog *dlg = i.value();
+        ICoreScriptDialog *dlg = i.value();
         if (dlg->getName().toUpper() == oname.toUpper()) {
             dlg->showDlg();
             return true;
@@ -38,10 +38,10 @@ bool TScript::customDialogShow(QString oname)
 
 bool TScript::customDialogHide(QString oname)
 {
-    QHashIterator<QString,TCustomScriptDialog*> i(dialogs);
+    QHashIterator<QString,ICoreScriptDialog*> i(dialogs);
     while (i.hasNext()) {
         i.next();
-        TCustomScriptDialog *dlg = i.value();
+        ICoreScriptDialog *dlg = i.value();
         if (dlg->getName().toUpper() == oname.toUpper()) {
             dlg->hideDlg();
             return true;
@@ -53,10 +53,10 @@ bool TScript::customDialogHide(QString oname)
 
 bool TScript::customDialogClose(QString oname)
 {
-    QHashIterator<QString,TCustomScriptDialog*> i(dialogs);
+    QHashIterator<QString,ICoreScriptDialog*> i(dialogs);
     while (i.hasNext()) {
         i.next();
-        TCustomScriptDialog *dlg = i.value();
+        ICoreScriptDialog *dlg = i.value();
         if (dlg->getName().toUpper() == oname.toUpper()) {
             dlg->closeDlg();
             return true;
@@ -68,10 +68,10 @@ bool TScript::customDialogClose(QString oname)
 
 bool TScript::customDialogSetLabel(QString dlg, QString oname, QString text)
 {
-    QHashIterator<QString,TCustomScriptDialog*> i(dialogs);
+    QHashIterator<QString,ICoreScriptDialog*> i(dialogs);
     while (i.hasNext()) {
         i.next();
-        TCustomScriptDialog *d = i.value();
+        ICoreScriptDialog *d = i.value();
         if (d->getName().toUpper() == dlg.toUpper())
             return d->setLabel(oname, text);
     }
@@ -81,10 +81,10 @@ bool TScript::customDialogSetLabel(QString dlg, QString oname, QString text)
 
 bool TScript::customDialogAddItem(QString dlg, QString oname, QString text)
 {
-    QHashIterator<QString,TCustomScriptDialog*> i(dialogs);
+    QHashIterator<QString,ICoreScriptDialog*> i(dialogs);
     while (i.hasNext()) {
         i.next();
-        TCustomScriptDialog *d = i.value();
+        ICoreScriptDialog *d = i.value();
         if (d->getName().toUpper() == dlg.toUpper())
             return d->addItem(oname, text);
     }
@@ -94,10 +94,10 @@ bool TScript::customDialogAddItem(QString dlg, QString oname, QString text)
 
 bool TScript::customDialogReItem(QString dlg, QString oname, QString index, QString text)
 {
-    QHashIterator<QString,TCustomScriptDialog*> i(dialogs);
+    QHashIterator<QString,ICoreScriptDialog*> i(dialogs);
     while (i.hasNext()) {
         i.next();
-        TCustomScriptDialog *d = i.value();
+        ICoreScriptDialog *d = i.value();
         if (d->getName().toUpper() == dlg.toUpper())
             return d->reItem(oname, index.toInt(), text);
     }
@@ -107,10 +107,10 @@ bool TScript::customDialogReItem(QString dlg, QString oname, QString index, QStr
 
 bool TScript::customDialogDelItem(QString dlg, QString oname, QString index)
 {
-    QHashIterator<QString,TCustomScriptDialog*> i(dialogs);
+    QHashIterator<QString,ICoreScriptDialog*> i(dialogs);
     while (i.hasNext()) {
         i.next();
-        TCustomScriptDialog *d = i.value();
+        ICoreScriptDialog *d = i.value();
         if (d->getName().toUpper() == dlg.toUpper()) {
             bool ok = false;
             int idx = index.toInt(&ok);
@@ -126,10 +126,10 @@ bool TScript::customDialogDelItem(QString dlg, QString oname, QString index)
 
 bool TScript::customDialogClear(QString dlg, QString oname)
 {
-    QHashIterator<QString,TCustomScriptDialog*> i(dialogs);
+    QHashIterator<QString,ICoreScriptDialog*> i(dialogs);
     while (i.hasNext()) {
         i.next();
-        TCustomScriptDialog *d = i.value();
+        ICoreScriptDialog *d = i.value();
         if (d->getName().toUpper() == dlg.toUpper())
             return d->clear(oname);
     }
@@ -19,6 +19,7 @@
  */
 
 #include "../tscript.h"
+#include "../tscriptparent.h"
 #include "constants.h"
 
 /*!
@@ -46,7 +47,14 @@ bool TScript::runEvent(e_iircevent evt, QStringList param, QString *result)
 
             QString r;
 
+            TScriptProfiler *profiler = scriptParent->getProfiler();
+            qint64 started = profiler->isEnabled() ? profiler->elapsed() : -1;
+
             e_scriptresult ok = runf(fnct, param, r);
+
+            if (started >= 0)
+                profiler->eventDone(name, evt, started);
+
             if (ok != se_RunfDone)
                 emit error( tr("Unable to run function %1 via an event (Script %2) - Parameter count?")
                             .arg(fnct)
@@ -163,6 +171,12 @@ e_iircevent TScript::getEvent(QString event)
     else if (evt == "DEACTIVATE")
         return te_deactivate;
 
+    else if (evt == "SOCKWRITABLE")
+        return te_sockwritable;
+
+    else if (evt == "HIGHLIGHT")
+        return te_highlight;
+
     else
         return te_noevent;
 }
@@ -269,6 +283,12 @@ QString TScript::getEventStr(e_iircevent evt)
     case te_deactivate:
         return "Deactivate";
 
+    case te_sockwritable:
+        return "SockWritable";
+
+    case te_highlight:
+        return "Highlight";
+
     default:
         return "";
     }
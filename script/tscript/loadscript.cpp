@@ -35,7 +35,7 @@ e_scriptresult TScript::loadScript2(QString includeFile, QString parent)
         tevent.clear();
         lineMap.clear();
 
-        QHashIterator<QString,TCustomScriptDialog*> i(dialogs);
+        QHashIterator<QString,ICoreScriptDialog*> i(dialogs);
         while (i.hasNext()) {
             i.next();
             delete i.value();
@@ -161,7 +161,7 @@ e_scriptresult TScript::loadScript2(QString includeFile, QString parent)
     int n = 0; // Nesting level. 0 is where script blocks are at (script, function, menu, etc.)
 
     QString temp[3];
-    TCustomScriptDialog *dialog = NULL;
+    ICoreScriptDialog *dialog = NULL; // Stays NULL if the front end can't show dialogs, the dialog{} block is then only parsed.
 
     // Reset the custom menues, they'll be set up later on in here...
     resetMenu(customNicklistMenu);
@@ -216,9 +216,8 @@ e_scriptresult TScript::loadScript2(QString includeFile, QString parent)
             n--;
 
             if (state == st_Dialog) {
-                dialogs.insert( dialog->getName(), dialog );
-                connect(dialog, SIGNAL(runEvent(e_iircevent,QStringList)),
-                this, SLOT(runEvent(e_iircevent,QStringList)));
+                if (dialog != NULL)
+                    dialogs.insert( dialog->getName(), dialog );
                 state = st_None;
             }
 
@@ -322,7 +321,7 @@ e_scriptresult TScript::loadScript2(QString includeFile, QString parent)
                 }
 
                 if (ex == ex_DialogName) {
-                    dialog =  new TCustomScriptDialog(this, keyword, dlgParent);
+                    dialog = frontEnd->createScriptDialog(this, keyword);
                     ex = ex_Brace;
                     keyword.clear();
                     continue;
@@ -487,7 +486,8 @@ e_scriptresult TScript::loadScript2(QString includeFile, QString parent)
                                 break;
                             keyword += c;
                         }
-                        dialog->setTitle(keyword);
+                        if (dialog != NULL)
+                            dialog->setTitle(keyword);
                         keyword.clear();
                         ex = ex_Statement;
                         continue;
@@ -525,7 +525,8 @@ e_scriptresult TScript::loadScript2(QString includeFile, QString parent)
                         if (param != 5)
                             return se_InvalidParamCount;
 
-                        dialog->setGeometry(X, Y, W, H);
+                        if (dialog != NULL)
+                            dialog->setGeometry(X, Y, W, H);
                         keyword.clear();
                         ex = ex_Statement;
                         continue;
@@ -573,6 +574,11 @@ e_scriptresult TScript::loadScript2(QString includeFile, QString parent)
 
                         arg = arg.mid(1);
 
+                        if (dialog == NULL) {
+                            keyword.clear();
+                            ex = ex_Statement;
+                            continue;
+                        }
 
                         if (ex == ex_DialogLabel)
                             dialog->addLabel(oname, X, Y, W, H, arg);
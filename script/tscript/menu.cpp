@@ -36,27 +36,7 @@
  */
 void TScript::createMenu(int &pos, char type)
 {
-    if (type == 'n') {
-        if (rootNicklistMenu)
-            delete rootNicklistMenu;
-        rootNicklistMenu = new QAction(this);
-    }
-    else if (type == 'c') {
-        if (rootChannelMenu)
-            delete rootChannelMenu;
-        rootChannelMenu = new QAction(this);
-    }
-    else if (type == 'q') {
-        if (rootQueryMenu)
-            delete rootQueryMenu;
-        rootQueryMenu = new QAction(this);
-    }
-    else if (type == 's') {
-        if (rootStatusMenu)
-            delete rootStatusMenu;
-        rootStatusMenu = new QAction(this);
-    }
-    else
+    if ((type != 'n') && (type != 'c') && (type != 'q') && (type != 's'))
         return;
 
     int parent = -1;
@@ -122,7 +102,8 @@ void TScript::createMenuIterate(int &pos, char type, int parent)
 
             if (c == '{') {
                 scriptmenu_t st;
-                st.action = new QAction(itemname, this);
+                st.text = itemname;
+                st.separator = false;
                 st.parent = parent;
                 st.haveChildren = true;
 
@@ -151,8 +132,7 @@ void TScript::createMenuIterate(int &pos, char type, int parent)
             if (c == '\n') {
                 if (itemname.toUpper() == "SEP") {
                     scriptmenu_t st;
-                    st.action = new QAction(this);
-                    st.action->setSeparator(true);
+                    st.separator = true;
                     st.parent = parent;
                     st.haveChildren = false;
 
@@ -181,42 +161,24 @@ void TScript::createMenuIterate(int &pos, char type, int parent)
                 continue;
             if (c == '\n') {
                 scriptmenu_t st;
-                st.action = new QAction(itemname, this);
+                st.text = itemname;
+                st.function = fnctname;
+                st.separator = false;
                 st.parent = parent;
                 st.haveChildren = false;
 
-                if (type == 'n') { // nicklist
-                    nicklistMenuMapper.setMapping(st.action, fnctname);
+                if (type == 'n') // nicklist
                     customNicklistMenu.push_back(st);
 
-                    connect(st.action, SIGNAL(triggered()),
-                            &nicklistMenuMapper, SLOT(map()));
-                }
-
-                if (type == 'c') { // channel
-                    channelMenuMapper.setMapping(st.action, fnctname);
+                if (type == 'c') // channel
                     customChannelMenu.push_back(st);
 
-                    connect(st.action, SIGNAL(triggered()),
-                            &channelMenuMapper, SLOT(map()));
-                }
-
-                if (type == 'q') { // query
-                    queryMenuMapper.setMapping(st.action, fnctname);
+                if (type == 'q') // query
                     customQueryMenu.push_back(st);
 
-                    connect(st.action, SIGNAL(triggered()),
-                            &queryMenuMapper, SLOT(map()));
-                }
-
-                if (type == 's') { // status
-                    statusMenuMapper.setMapping(st.action, fnctname);
+                if (type == 's') // status
                     customStatusMenu.push_back(st);
 
-                    connect(st.action, SIGNAL(triggered()),
-                            &statusMenuMapper, SLOT(map()));
-                }
-
                 itemname.clear();
                 fnctname.clear();
                 state = st_ItemName;
@@ -231,36 +193,24 @@ void TScript::createMenuIterate(int &pos, char type, int parent)
 void TScript::resetMenu(QList<scriptmenu_t> &menu)
 {
     // After using this function a menu should be rebuilt, though nothing will crash if it doesn't.
-    QListIterator<scriptmenu_t> i(menu);
-    while (i.hasNext()) {
-        scriptmenu_t sm = i.next();
-        nicklistMenuMapper.removeMappings(sm.action);
-        disconnect(sm.action);
-        delete sm.action;
-    }
     menu.clear();
 }
 
-void TScript::nicklistMenuItemTriggered(QString function)
-{
-    QString r;
-    runf(function, scriptParent->getCurrentNickSelection(), r, true);
-}
-
-void TScript::channelMenuItemTriggered(QString function)
-{
-    QString r;
-    runf(function, QStringList()<<scriptParent->getCurrentWindow(), r, true);
-}
-
-void TScript::queryMenuItemTriggered(QString function)
+/*!
+ * \param type Type of menu (see createMenu())
+ * \param function Function the picked menu item is tied to
+ *
+ * Runs the function of a menu item the user picked.\n
+ * Nicklist items get the selected nicknames as parameters, channel and query items get the active window.
+ */
+void TScript::runMenuItem(char type, QString function)
 {
-    QString r;
-    runf(function, QStringList()<<scriptParent->getCurrentWindow(), r, true);
-}
+    QStringList param;
+    if (type == 'n')
+        param = scriptParent->getCurrentNickSelection();
+    else if ((type == 'c') || (type == 'q'))
+        param << scriptParent->getCurrentWindow();
 
-void TScript::statusMenuItemTriggered(QString function)
-{
     QString r;
-    runf(function, QStringList(), r, true);
+    runf(function, param, r, true);
 }
@@ -22,7 +22,7 @@
 #include "constants.h"
 
 #include "../tscriptparent.h"
-#include <QMessageBox>
+#include "wildcardmatcher.h"
 
 /*!
  * \param function Function name
@@ -181,8 +181,16 @@ e_scriptresult TScript::runf(QString function, QStringList param, QString &resul
     for (int i = 0; i <= scpar.count()-1; ++i)
         localVar.insert(scpar[i], param[i]);
 
+    TScriptProfiler *profiler = scriptParent->getProfiler();
+    bool profile = profiler->isEnabled();
+    if (profile)
+        profiler->enterFunction(name, function);
+
     e_scriptresult res = _runf_private2(pos, localVar, localBinVar, result);
 
+    if (profile)
+        profiler->leaveFunction();
+
     /* Cleaning up this way is dangerous. don't.
     for (int i = 0; i <= scpar.count()-1; ++i)
         variables.remove(scpar[i]);
@@ -247,6 +255,10 @@ e_scriptresult TScript::_runf_private2(int pos, QHash<QString,QString> &localVar
     // "while" level and positions:
     QVector<int> wnl; // while nest level.
     QVector<int> wbp; // contains byte positions of where every while that surrounds the outer nests.
+    QVector<int> wln; // line numbers of every while, so jumping back doesn't skew curLine.
+
+    TScriptProfiler *profiler = scriptParent->getProfiler();
+    bool profile = profiler->isEnabled();
 
     bool setLocalVar = false; // sets to true when 'local' in f.ex. 'local var %test 123' is found.
 
@@ -254,8 +266,11 @@ e_scriptresult TScript::_runf_private2(int pos, QHash<QString,QString> &localVar
     for (int i = pos; i <= scriptstr.length()-1; i++) {
         QChar cc = scriptstr[i];
 
-        if (cc == '\n')
+        if (cc == '\n') {
+            if (profile)
+                profiler->lineDone(name, curLine);
             curLine++;
+        }
 
         if (cc == '\\') { // Escape, skip completely and add to keyword
             ++i;
@@ -337,8 +352,10 @@ e_scriptresult TScript::_runf_private2(int pos, QHash<QString,QString> &localVar
 
                     if (nl == l) { // re-check for loop validity.
                         i = wbp.back();
+                        curLine = wln.back();
                         wnl.pop_back();
                         wbp.pop_back();
+                        wln.pop_back();
                         keyword.clear();
                         ex = ex_Literal;
                         state = st_Literal;
@@ -505,6 +522,7 @@ e_scriptresult TScript::_runf_private2(int pos, QHash<QString,QString> &localVar
             if (keywup == "WHILE") {
                 wbp.push_back(i-6);
                 wnl.push_back(nl);
+                wln.push_back(curLine);
 
                 int pn = 0; // Paranthesis nest
                 bool waitPB = true; // Wait for paranthesis at beginning
@@ -542,6 +560,7 @@ e_scriptresult TScript::_runf_private2(int pos, QHash<QString,QString> &localVar
                 if (ok == false) {
                     wbp.pop_back();
                     wnl.pop_back();
+                    wln.pop_back();
                     state = st_IgnoreNest;
                     ex = ex_Literal;
                     nl_ignore = nl;
@@ -563,6 +582,7 @@ e_scriptresult TScript::_runf_private2(int pos, QHash<QString,QString> &localVar
                 nl_ignore = wnl.back();
                 wbp.pop_back();
                 wnl.pop_back();
+                wln.pop_back();
                 state = st_IgnoreNest;
                 ex = ex_Literal;
 
@@ -574,9 +594,11 @@ e_scriptresult TScript::_runf_private2(int pos, QHash<QString,QString> &localVar
                 if (wnl.size() == 0)
                     return se_ContinueNoWhile;
                 i = wbp.back();
+                curLine = wln.back();
                 nl = wnl.back();
                 wnl.pop_back();
                 wbp.pop_back();
+                wln.pop_back();
                 ex = ex_Literal;
                 state = st_Literal;
 
@@ -987,14 +1009,13 @@ e_scriptresult TScript::_runf_private2(int pos, QHash<QString,QString> &localVar
 
                 int count = 1;
                 QString data;
+                WildcardMatcher wm = WildcardMatcher::cached(QString("*%1*").arg(pattern), Qt::CaseSensitive); // Matches anywhere in the name
                 QHashIterator<QString,QString> i(container);
                 while (i.hasNext()) {
                     i.next();
 
                     QString iname = i.key();
-                    QRegExp rx( pattern );
-                    rx.setPatternSyntax(QRegExp::WildcardUnix);
-                    int rxidx = iname.indexOf(rx);
+                    int rxidx = wm.match(iname) ? 0 : -1;
 
                     if ((index == 0) && (rxidx > -1)) {
                         count++;
@@ -1264,11 +1285,14 @@ e_scriptresult TScript::_runf_private2(int pos, QHash<QString,QString> &localVar
                 bool close = false;   // c
                 bool decline = false; // d
                 bool listen = false;  // l
+                bool linemode = false; // m
                 bool open = false;    // o
+                bool limit = false;   // q
                 bool read = false;    // r
                 bool write = false;   // w
                 bool newline = false; // n
                 bool binary = false;  // b
+                bool secure = false;  // s
                 bool switchfail = false;
 
                 for (int i = 0; i <=sw.length()-1; i++) {
@@ -1290,9 +1314,15 @@ e_scriptresult TScript::_runf_private2(int pos, QHash<QString,QString> &localVar
                         case 'l': // Listen
                             listen = true;
                             break;
+                        case 'm': // Line mode
+                            linemode = true;
+                            break;
                         case 'o': // Open
                             open = true;
                             break;
+                        case 'q': // Write queue limit
+                            limit = true;
+                            break;
                         case 'r': // Read
                             read = true;
                             break;
@@ -1302,6 +1332,9 @@ e_scriptresult TScript::_runf_private2(int pos, QHash<QString,QString> &localVar
                         case 'n': // Newline
                             newline = true;
                             break;
+                        case 's': // Secure (TLS), with open
+                            secure = true;
+                            break;
                         case '-':
                             break;
                         default:
@@ -1313,10 +1346,30 @@ e_scriptresult TScript::_runf_private2(int pos, QHash<QString,QString> &localVar
                     return se_InvalidSwitches;
 
                 // TODO  this is not accurate:
-                int swsum = accept + close + decline + listen + open + write; // These CANNOT be combined.
+                int swsum = accept + close + decline + listen + linemode + open + limit + write; // These CANNOT be combined.
                 if (swsum > 1) // Some of them are combined, stop !
                     return se_InvalidSwitches;
 
+                if (linemode) {
+                    // sock -m name 1|0
+                    if (argsEx.length() == 0)
+                        return se_InvalidParamCount;
+                    sockets.socklinemode(sockname, argsEx.toInt() != 0);
+
+                    keyword.clear();
+                    continue;
+                }
+
+                if (limit) {
+                    // sock -q name bytes
+                    if (argsEx.length() == 0)
+                        return se_InvalidParamCount;
+                    sockets.sockwritelimit(sockname, argsEx.toLongLong());
+
+                    keyword.clear();
+                    continue;
+                }
+
                 if (listen) {
                     if (argsEx.length() == 0)
                         return se_InvalidParamCount;
@@ -1334,7 +1387,9 @@ e_scriptresult TScript::_runf_private2(int pos, QHash<QString,QString> &localVar
                     if (argl.length() < 2)
                         return se_InvalidParamCount;
 
-                    sockets.sockopen(sockname, argl[0], argl[1].toInt());
+                    sockets.sockopen(sockname, argl[0], argl[1].toInt(), secure);
+                    if (sockets.sockerror() == TSE_NOTLS)
+                        emit warning( tr("sock: Cannot open %1 with TLS, the SSL library isn't installed").arg(sockname) );
                     keyword.clear();
                     continue;
                 }
@@ -1370,6 +1425,9 @@ e_scriptresult TScript::_runf_private2(int pos, QHash<QString,QString> &localVar
                         data.append('\n');
 
                     sockets.sockwrite(sockname, &data);
+                    if (sockets.sockerror() == TSE_BUFFERFULL)
+                        emit warning( tr("sock: Output buffer for %1 is full, wait for SockWritable").arg(sockname) );
+
                     keyword.clear();
                     continue;
                 }
@@ -2125,7 +2183,7 @@ e_scriptresult TScript::_runf_private2(int pos, QHash<QString,QString> &localVar
                 extract(file, localVar, localBinVar);
                 extract(function, localVar, localBinVar);
 
-                TScript exec(parent(), scriptParent, dlgParent, file, conList, winList, activeWid, activeConn);
+                TScript exec(parent(), scriptParent, frontEnd, file, conList, winList, activeWid, activeConn);
                 exec.loadScript2();
 
                 connect(&exec, SIGNAL(error(QString)),
@@ -2201,13 +2259,13 @@ e_scriptresult TScript::_runf_private2(int pos, QHash<QString,QString> &localVar
                     }
                 }
 
-                int btn = QMessageBox::question(dlgParent, tr("Script about to load"),
-                                                           tr("The script '%1' is about to load the following script:\n%2\nAllow loading?")
-                                                             .arg(name)
-                                                             .arg(file)
-                                                );
+                QString btn = frontEnd->messageBox("QUESTION", tr("Script about to load"),
+                                                   tr("The script '%1' is about to load the following script:\n%2\nAllow loading?")
+                                                     .arg(name)
+                                                     .arg(file),
+                                                   "q");
 
-                if (btn == QMessageBox::No) {
+                if (btn != "YES") {
                     localVar.insert(codevar, "0");
                     keyword.clear();
                     continue;
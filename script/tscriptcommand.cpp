@@ -21,13 +21,16 @@
 #include "tscriptcommand.h"
 #include "iconnection.h"
 #include "icommand.h"
+#include "icoreevents.h"
 
 #include <QHashIterator>
+#include <QColor>
 
-TScriptCommand::TScriptCommand(QObject *parent, QHash<int,IConnection*> *cl, QHash<int,subwindow_t> *wl, int *aConn, int *aWid) :
+TScriptCommand::TScriptCommand(QObject *parent, QHash<int,IConnection*> *cl, QHash<int,subwindow_t> *wl, IWindowRegistry *wr, int *aConn, int *aWid) :
     QObject(parent),
     conlist(cl),
     winlist(wl),
+    winreg(wr),
     activeConn(aConn),
     activeWid(aWid),
     tstar("***")
@@ -367,13 +370,9 @@ void TScriptCommand::echo(QString target, QString sender, QString text, int type
 {
     // Target is custom window
     if (target[0] == '@') {
-        subwindow_t sw;
-        QHashIterator<int,subwindow_t> i(*winlist);
-        while (i.hasNext()) {
-            sw = i.next().value();
-            if (sw.widget->objectName().toUpper() == target.toUpper())
-                sw.widget->print(sender, text, type);
-        }
+        subwindow_t sw = getCustomWindow(target);
+        if (sw.type != WT_NOTHING)
+            sw.window->print(sender, text, type);
 
         return;
     }
@@ -382,7 +381,7 @@ void TScriptCommand::echo(QString target, QString sender, QString text, int type
         subwindow_t sw = winlist->value(*activeWid);
         if (sw.type >= WT_GRAPHIC)
             sw = winlist->value(*activeConn); // active connection is the previous active one.
-        sw.widget->print(sender, text);
+        sw.window->print(sender, text);
         return;
     }
 
@@ -442,7 +441,7 @@ void TScriptCommand::window(QString name, QString sw)
     if ((drawable == false) && (withinput == true))
           t = WT_TXTINPUT;
 
-     emit RequestWindow(name, t, -1, activate);
+     emit RequestWindow(name, t, WP_CUSTOM, activate);
 
 }
 
@@ -461,14 +460,14 @@ void TScriptCommand::clear(QString window, QString sw)
 
     if (subwin.type >= WT_GRAPHIC) { // Window is a graphic window.
         if (sw == "-l")
-            subwin.widget->picwinPtr()->clear(); // clear current layer
+            subwin.window->picture()->clear(); // clear current layer
         else
-            subwin.widget->picwinPtr()->clearAll(); // clear all layers
+            subwin.window->picture()->clearAll(); // clear all layers
         return;
     }
 
     // Reaching here means a text window to clear.
-    subwin.widget->clear();
+    subwin.window->clear();
 }
 
 void TScriptCommand::paintdot(QString Window, QString X, QString Y, QString Size, QString Color)
@@ -493,8 +492,8 @@ void TScriptCommand::paintdot(QString Window, QString X, QString Y, QString Size
     QPen pn(iColor);
     pn.setWidth(iSize);
 
-    wt.widget->picwinPtr()->setBrushPen(br, pn);
-    wt.widget->picwinPtr()->paintDot(iX, iY);
+    wt.window->picture()->setBrushPen(br, pn);
+    wt.window->picture()->paintDot(iX, iY);
 }
 
 void TScriptCommand::paintline(QString Window, QString X1, QString Y1, QString X2, QString Y2, QString Size, QString Color)
@@ -521,8 +520,8 @@ void TScriptCommand::paintline(QString Window, QString X1, QString Y1, QString X
     QPen pn(iColor);
     pn.setWidth(iSize);
 
-    wt.widget->picwinPtr()->setBrushPen(br, pn);
-    wt.widget->picwinPtr()->paintLine(iX1, iY1, iX2, iY2);
+    wt.window->picture()->setBrushPen(br, pn);
+    wt.window->picture()->paintLine(iX1, iY1, iX2, iY2);
 }
 
 void TScriptCommand::paintrect(QString Window, QString X, QString Y, QString W, QString H, QString Size, QString Color)
@@ -549,8 +548,8 @@ void TScriptCommand::paintrect(QString Window, QString X, QString Y, QString W,
     QPen pn(iColor);
     pn.setWidth(iSize);
 
-    wt.widget->picwinPtr()->setBrushPen(br, pn);
-    wt.widget->picwinPtr()->paintRect(iX, iY, iW, iH);
+    wt.window->picture()->setBrushPen(br, pn);
+    wt.window->picture()->paintRect(iX, iY, iW, iH);
 }
 
 void TScriptCommand::paintimage(QString Window, QString X, QString Y, QString File, bool dontBuffer)
@@ -568,7 +567,7 @@ void TScriptCommand::paintimage(QString Window, QString X, QString Y, QString Fi
     int iX = floor(X.toFloat());
     int iY = floor(Y.toFloat());
 
-    wt.widget->picwinPtr()->paintImage(File, iX, iY, dontBuffer);
+    wt.window->picture()->paintImage(File, iX, iY, dontBuffer);
 }
 
 void TScriptCommand::painttext(QString Window, QString X, QString Y, QString FontSize, QString Color, QString FontName, QString Text)
@@ -594,8 +593,8 @@ void TScriptCommand::painttext(QString Window, QString X, QString Y, QString Fon
     QBrush br(iColor, Qt::SolidPattern);
     QPen pn(iColor);
 
-    wt.widget->picwinPtr()->setBrushPen(br, pn);
-    wt.widget->picwinPtr()->paintText(iX, iY, Font, Text);
+    wt.window->picture()->setBrushPen(br, pn);
+    wt.window->picture()->paintText(iX, iY, Font, Text);
 }
 
 void TScriptCommand::paintfill(QString Window, QString X, QString Y, QString W, QString H, QString Color)
@@ -621,8 +620,8 @@ void TScriptCommand::paintfill(QString Window, QString X, QString Y, QString W,
     QBrush br(iColor, Qt::SolidPattern);
     QPen pn(iColor);
 
-    wt.widget->picwinPtr()->setBrushPen(br, pn);
-    wt.widget->picwinPtr()->paintFill(iX, iY, iW, iH);
+    wt.window->picture()->setBrushPen(br, pn);
+    wt.window->picture()->paintFill(iX, iY, iW, iH);
 }
 
 void TScriptCommand::paintfillpath(QString Window, QString Color, QPainterPath Path)
@@ -642,8 +641,8 @@ void TScriptCommand::paintfillpath(QString Window, QString Color, QPainterPath P
     QBrush br(iColor, Qt::SolidPattern);
     QPen pn(iColor);
 
-    wt.widget->picwinPtr()->setBrushPen(br, pn);
-    wt.widget->picwinPtr()->paintFillPath(Path);
+    wt.window->picture()->setBrushPen(br, pn);
+    wt.window->picture()->paintFillPath(Path);
 }
 
 void TScriptCommand::paintcircle(QString Window, QString X, QString Y, QString R, QString Size, QString Color)
@@ -667,8 +666,8 @@ void TScriptCommand::paintcircle(QString Window, QString X, QString Y, QString R
     QPen pn(Color);
     pn.setWidth(Size.toInt());
 
-    wt.widget->picwinPtr()->setBrushPen(br, pn);
-    wt.widget->picwinPtr()->paintCircle(iX, iY, iR);
+    wt.window->picture()->setBrushPen(br, pn);
+    wt.window->picture()->paintCircle(iX, iY, iR);
 }
 
 void TScriptCommand::paintellipse(QString Window, QString X, QString Y, QString RX, QString RY, QString Size, QString Color)
@@ -693,8 +692,8 @@ void TScriptCommand::paintellipse(QString Window, QString X, QString Y, QString
     QPen pn(Color);
     pn.setWidth(Size.toInt());
 
-    wt.widget->picwinPtr()->setBrushPen(br, pn);
-    wt.widget->picwinPtr()->paintEllipse(iX, iY, iRX, iRY);
+    wt.window->picture()->setBrushPen(br, pn);
+    wt.window->picture()->paintEllipse(iX, iY, iRX, iRY);
 }
 
 void TScriptCommand::paintsetlayer(QString Window, QString Layer)
@@ -710,7 +709,7 @@ void TScriptCommand::paintsetlayer(QString Window, QString Layer)
         return;
     }
 
-    wt.widget->picwinPtr()->setLayer(Layer);
+    wt.window->picture()->setLayer(Layer);
 }
 
 void TScriptCommand::paintdellayer(QString Window, QString Layer)
@@ -726,7 +725,7 @@ void TScriptCommand::paintdellayer(QString Window, QString Layer)
         return;
     }
 
-    wt.widget->picwinPtr()->delLayer(Layer);
+    wt.window->picture()->delLayer(Layer);
 }
 
 void TScriptCommand::paintlayerorder(QString Window, QStringList Layers)
@@ -742,7 +741,7 @@ void TScriptCommand::paintlayerorder(QString Window, QStringList Layers)
         return;
     }
 
-    wt.widget->picwinPtr()->orderLayers(Layers);
+    wt.window->picture()->orderLayers(Layers);
 }
 
 void TScriptCommand::clearimgbuf(QString Window)
@@ -758,7 +757,7 @@ void TScriptCommand::clearimgbuf(QString Window)
         return;
     }
 
-    wt.widget->picwinPtr()->clearImageBuffer();
+    wt.window->picture()->clearImageBuffer();
 }
 
 void TScriptCommand::paintbuffer(QString Window, bool State)
@@ -774,7 +773,7 @@ void TScriptCommand::paintbuffer(QString Window, bool State)
         return;
     }
 
-    wt.widget->picwinPtr()->setViewBuffer(State);
+    wt.window->picture()->setViewBuffer(State);
 }
 
 void TScriptCommand::sockwrite(QString &data)
@@ -790,15 +789,10 @@ void TScriptCommand::sockwrite(QString &data)
 
 subwindow_t TScriptCommand::getCustomWindow(QString name)
 {
-    subwindow_t error;
-    error.type = WT_NOTHING; // Indicates an error.
-
-    QHashIterator<int,subwindow_t> i(*winlist);
-    while (i.hasNext()) {
-        subwindow_t sw = i.next().value();
-        if (sw.widget->objectName().toUpper() == name.toUpper())
-            return sw;
-    }
+    // Custom windows got parent WP_CUSTOM, otherwise look under the active connection.
+    subwindow_t sw = winreg->get(WP_CUSTOM, name);
+    if (sw.type == WT_NOTHING)
+        sw = winreg->get(*activeConn, name);
 
-    return error;
+    return sw; // Type is WT_NOTHING if not found.
 }
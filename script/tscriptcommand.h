@@ -29,6 +29,7 @@
 #include <QPainterPath>
 #include <math.h>
 #include "constants.h"
+#include "iwindowregistry.h"
 
 class IConnection;
 
@@ -37,7 +38,7 @@ class TScriptCommand : public QObject
     Q_OBJECT
 
 public:
-    explicit TScriptCommand(QObject *parent, QHash<int,IConnection*> *cl, QHash<int,subwindow_t> *wl, int *aConn, int *aWid);
+    explicit TScriptCommand(QObject *parent, QHash<int,IConnection*> *cl, QHash<int,subwindow_t> *wl, IWindowRegistry *wr, int *aConn, int *aWid);
     bool parse(QString &command);
 
     void echo(QString target, QString sender, QString text, int type = PT_NORMAL);
@@ -64,6 +65,7 @@ public:
 private:
     QHash<int,IConnection*> *conlist; //!< List of all IRC connections.
     QHash<int,subwindow_t> *winlist; //!< List of all subwindows. Pointer from IdealIRC class.
+    IWindowRegistry *winreg; //!< Name lookup of all subwindows. Pointer from IdealIRC class.
     int *activeConn; //!< Current active connection.
     int *activeWid; //!< Current active window ID.
     subwindow_t getCustomWindow(QString name);
@@ -20,24 +20,22 @@
 
 #include "tscriptinternalfunctions.h"
 #include "math.h"
-#include "iwin.h"
 #include "iconnection.h"
 #include "tscript.h"
+#include "iperf.h"
 
 #include <iostream>
 #include <QDateTime>
 #include <QFontMetrics>
 #include <QDebug>
-#include <QApplication>
-#include <QInputDialog>
-#include <QMessageBox>
+#include <QCoreApplication>
 #include <QFile>
 #include <QDir>
 #include <QFileInfoList>
 
 TScriptInternalFunctions::TScriptInternalFunctions(TSockFactory *sf, QHash<QString,int> *functionindex,
-                                                   QHash<QString,TCustomScriptDialog*> *dlgs, QHash<int,t_sfile> *fl,
-                                                   QHash<int,IConnection*> *cl, QHash<int,subwindow_t> *wl,
+                                                   QHash<QString,ICoreScriptDialog*> *dlgs, QHash<int,t_sfile> *fl,
+                                                   QHash<int,IConnection*> *cl, QHash<int,subwindow_t> *wl, IWindowRegistry *wr,
                                                    int *aWid, int *aConn, TScript *scr, QObject *parent) :
     QObject(parent),
     sockfactory(sf),
@@ -48,6 +46,7 @@ TScriptInternalFunctions::TScriptInternalFunctions(TSockFactory *sf, QHash<QStri
     activeWid(aWid),
     activeConn(aConn),
     winList(wl),
+    winreg(wr),
     conList(cl),
     script(scr)
 {
@@ -73,7 +72,7 @@ bool TScriptInternalFunctions::runFunction(QString function, QStringList param,
     }
 
     if (fn == "ACTIVE") {
-        result = getCustomWindow(*activeWid).widget->objectName();
+        result = getCustomWindow(*activeWid).window->getName();
         return true;
     }
 
@@ -116,15 +115,7 @@ bool TScriptInternalFunctions::runFunction(QString function, QStringList param,
     }
 
     if (fn == "BUTTON") {
-        if (lastbtn == QMessageBox::Ok)
-            result = "OK";
-        if (lastbtn == QMessageBox::Cancel)
-            result = "CANCEL";
-        if (lastbtn == QMessageBox::Yes)
-            result = "YES";
-        if (lastbtn == QMessageBox::No)
-            result = "NO";
-
+        result = lastbtn;
         return true;
     }
 
@@ -193,7 +184,36 @@ bool TScriptInternalFunctions::runFunction(QString function, QStringList param,
         int x = floor( param[1].toFloat() );
         int y = floor( param[2].toFloat() );
 
-        result = sw.widget->picwinPtr()->colorAt(layer, x, y);
+        if (sw.window->picture() == NULL)
+            return false;
+
+        result = sw.window->picture()->colorAt(layer, x, y);
+        return true;
+    }
+
+    if (fn == "CTCPSTAT") {
+        // Returns CTCP counters of the active connection.
+        // $ctcpstat(received|replied|dropped|coalesced)
+        if (param.count() != 1)
+            return false;
+
+        IConnection *con = conList->value(*activeConn, NULL);
+        if (con == NULL)
+            return false;
+
+        CtcpResponder *ctcp = con->getCtcpResponder();
+        QString counter = param[0].toUpper();
+        if (counter == "RECEIVED")
+            result = QString::number(ctcp->getReceived());
+        else if (counter == "REPLIED")
+            result = QString::number(ctcp->getReplied());
+        else if (counter == "DROPPED")
+            result = QString::number(ctcp->getDropped());
+        else if (counter == "COALESCED")
+            result = QString::number(ctcp->getCoalesced());
+        else
+            return false;
+
         return true;
     }
 
@@ -311,7 +331,7 @@ bool TScriptInternalFunctions::runFunction(QString function, QStringList param,
             QString dlg = param[0];
             QString object = param[1];
 
-            QHashIterator<QString,TCustomScriptDialog*> i(*dialogs);
+            QHashIterator<QString,ICoreScriptDialog*> i(*dialogs);
             while (i.hasNext()) {
                 i.next();
                 if (i.key().toUpper() == dlg.toUpper()) {
@@ -327,7 +347,7 @@ bool TScriptInternalFunctions::runFunction(QString function, QStringList param,
             QString object = param[1];
             QString index = param[2];
 
-            QHashIterator<QString,TCustomScriptDialog*> i(*dialogs);
+            QHashIterator<QString,ICoreScriptDialog*> i(*dialogs);
             while (i.hasNext()) {
                 i.next();
                 if (i.key().toUpper() == dlg.toUpper()) {
@@ -475,9 +495,9 @@ bool TScriptInternalFunctions::runFunction(QString function, QStringList param,
             return false;
 
         if (param.count() > 1)
-            result = QString::number( sw.widget->listboxHeight() );
+            result = QString::number( sw.window->listboxHeight() );
         else
-            result = QString::number( sw.widget->height() );
+            result = QString::number( sw.window->getHeight() );
 
         return true;
     }
@@ -525,19 +545,109 @@ bool TScriptInternalFunctions::runFunction(QString function, QStringList param,
         return true;
     }
 
+    if (fn == "IALBANS") {
+        // Returns known bans in a channel that matches nickname.
+        // $ialbans(nickname, #channel, N)
+        // If N is zero, returns amount of matching bans. If N > 0, returns the N'th ban mask.
+        if (param.count() != 3)
+            return false;
+
+        IConnection *con = conList->value(*activeConn, NULL);
+        if (con == NULL)
+            return false;
+
+        QStringList masks = con->ial.bansAffecting(param[0], param[1]);
+        int n = param[2].toInt();
+        if (n == 0)
+            result = QString::number(masks.count());
+        else
+            result = masks.value(n-1);
+
+        return true;
+    }
+
+    if (fn == "IALMATCH") {
+        // Returns nicknames in a channel that matches a hostmask.
+        // $ialmatch(#channel, nick!ident@host, N)
+        // If N is zero, returns amount of matching nicknames. If N > 0, returns the N'th nickname.
+        if (param.count() != 3)
+            return false;
+
+        IConnection *con = conList->value(*activeConn, NULL);
+        if (con == NULL)
+            return false;
+
+        QStringList nicks = con->ial.matchMask(param[0], param[1]);
+        int n = param[2].toInt();
+        if (n == 0)
+            result = QString::number(nicks.count());
+        else
+            result = nicks.value(n-1);
+
+        return true;
+    }
+
+    if (fn == "IGNORE") {
+        // Returns ignored masks.
+        // $ignore(N)
+        // If N is zero, returns amount of ignores. If N > 0, returns the N'th mask.
+        if (param.count() != 1)
+            return false;
+
+        IConnection *con = conList->value(*activeConn, NULL);
+        if ((con == NULL) || (con->getIgnoreList() == NULL))
+            return false;
+
+        QStringList masks = con->getIgnoreList()->masks();
+        int n = param[0].toInt();
+        if (n == 0)
+            result = QString::number(masks.count());
+        else
+            result = masks.value(n-1);
+
+        return true;
+    }
+
+    if (fn == "IGNOREEXPIRE") {
+        // Returns seconds until an ignore expires, 0 if permanent, -1 if not ignored.
+        // $ignoreexpire(mask)
+        if (param.count() != 1)
+            return false;
+
+        IConnection *con = conList->value(*activeConn, NULL);
+        if ((con == NULL) || (con->getIgnoreList() == NULL))
+            return false;
+
+        result = QString::number(con->getIgnoreList()->expires(param[0]));
+        return true;
+    }
+
+    if (fn == "IGNOREHITS") {
+        // Returns amount of messages dropped by an ignore, -1 if not ignored.
+        // $ignorehits(mask)
+        if (param.count() != 1)
+            return false;
+
+        IConnection *con = conList->value(*activeConn, NULL);
+        if ((con == NULL) || (con->getIgnoreList() == NULL))
+            return false;
+
+        result = QString::number(con->getIgnoreList()->hits(param[0]));
+        return true;
+    }
+
     if (fn == "INPUT") {
         // $input(caption, label)
         if (param.count() != 2) {
             return false;
         }
         bool ok = false;
-        QString input = QInputDialog::getText(0, param[0], param[1],
-                                              QLineEdit::Normal, "", &ok);
+        QString input = script->getFrontEnd()->getText(param[0], param[1], &ok);
 
         if (ok)
-            lastbtn = QMessageBox::Ok;
+            lastbtn = "OK";
         else
-            lastbtn = QMessageBox::Cancel;
+            lastbtn = "CANCEL";
 
         result = input;
         return true;
@@ -558,53 +668,18 @@ bool TScriptInternalFunctions::runFunction(QString function, QStringList param,
         // types: critical, info, question, warning
         // buttons default: ok|cancel
         // buttons argument: o=ok, c=cancel, q=yes|no
-        QMessageBox::StandardButtons btn = 0;
-        if (param.count() == 3) {
-            // no buttons, set default (ok|cancel)
-            btn = QMessageBox::Ok | QMessageBox::Cancel;
-        }
-        else if (param.count() == 4) {
-            for (int i = 0; i <= param[3].count()-1; ++i) {
-                char c = param[3][i].toLatin1();
-                switch (c) {
-                    case 'o':
-                        btn |= QMessageBox::Ok;
-                        break;
-                    case 'c':
-                        btn |= QMessageBox::Cancel;
-                        break;
-                    case 'q':
-                        btn |= (QMessageBox::Yes | QMessageBox::No);
-                        break;
-                }
-            }
-        }
-        else
-            return false;
-
-        int b;
-        if (param[0].toUpper() == "CRITICAL")
-            b = QMessageBox::critical(0, param[1], param[2], btn);
-
-        else if (param[0].toUpper() == "INFO")
-            b = QMessageBox::information(0, param[1], param[2], btn);
+        QString btn;
+        if (param.count() == 4)
+            btn = param[3];
+        else if (param.count() != 3)
+            return false; // 3 parameters gets the default (ok|cancel)
 
-        else if (param[0].toUpper() == "QUESTION")
-            b = QMessageBox::question(0, param[1], param[2], btn);
-
-        else if (param[0].toUpper() == "WARNING")
-            b = QMessageBox::warning(0, param[1], param[2], btn);
-
-        if (b == QMessageBox::Ok)
-            result = "OK";
-        if (b == QMessageBox::Cancel)
-            result = "CANCEL";
-        if (b == QMessageBox::Yes)
-            result = "YES";
-        if (b == QMessageBox::No)
-            result = "NO";
+        QString type = param[0].toUpper();
+        if ((type != "CRITICAL") && (type != "INFO") && (type != "QUESTION") && (type != "WARNING"))
+            return false;
 
-        lastbtn = b;
+        result = script->getFrontEnd()->messageBox(type, param[1], param[2], btn);
+        lastbtn = result;
 
         return true;
     }
@@ -633,8 +708,8 @@ bool TScriptInternalFunctions::runFunction(QString function, QStringList param,
             subwindow_t sw = getCustomWindow(*activeWid);
             if (sw.type == WT_NOTHING)
                 return true;
-            if (sw.widget->getSelectedMembers().count() > 0)
-                result = sw.widget->getSelectedMembers().at(0);
+            if (sw.window->getSelectedMembers().count() > 0)
+                result = sw.window->getSelectedMembers().at(0);
             return true;
         }
 
@@ -647,8 +722,8 @@ bool TScriptInternalFunctions::runFunction(QString function, QStringList param,
                 subwindow_t sw = getCustomWindow(param[0]);
                 if (sw.type == WT_NOTHING)
                     return true;
-                if (sw.widget->getSelectedMembers().count() > 0)
-                    result = sw.widget->getSelectedMembers().at(0);
+                if (sw.window->getSelectedMembers().count() > 0)
+                    result = sw.window->getSelectedMembers().at(0);
                 return true;
             }
             else {
@@ -657,11 +732,11 @@ bool TScriptInternalFunctions::runFunction(QString function, QStringList param,
                 if (sw.type == WT_NOTHING)
                     return true;
                 if (N <= 0) {
-                    result = QString::number( sw.widget->getSelectedMembers().count() );
+                    result = QString::number( sw.window->getSelectedMembers().count() );
                     return true;
                 }
-                if (sw.widget->getSelectedMembers().count() >= N)
-                    result = sw.widget->getSelectedMembers().at(N-1);
+                if (sw.window->getSelectedMembers().count() >= N)
+                    result = sw.window->getSelectedMembers().at(N-1);
                 return true;
             }
         }
@@ -677,11 +752,11 @@ bool TScriptInternalFunctions::runFunction(QString function, QStringList param,
             if (sw.type == WT_NOTHING)
                 return true;
             if (N <= 0) {
-                result = QString::number( sw.widget->getSelectedMembers().count() );
+                result = QString::number( sw.window->getSelectedMembers().count() );
                 return true;
             }
-            if (sw.widget->getSelectedMembers().count() >= N)
-                result = sw.widget->getSelectedMembers().at(N-1);
+            if (sw.window->getSelectedMembers().count() >= N)
+                result = sw.window->getSelectedMembers().at(N-1);
             return true;
         }
 
@@ -710,7 +785,7 @@ bool TScriptInternalFunctions::runFunction(QString function, QStringList param,
             result = SKEL_PATH;
 #endif
         if (type == "EXEC")
-            result = QApplication::applicationDirPath();
+            result = QCoreApplication::applicationDirPath();
 
         if (type == "SCRIPT") {
             QString fullfn = script->getPath();
@@ -721,6 +796,15 @@ bool TScriptInternalFunctions::runFunction(QString function, QStringList param,
         return true;
     }
 
+    if (fn == "PERF") {
+        // $perf(counter [, field])
+        // Returns a performance counter, see /perf and IPerf::value() for fields.
+        if ((param.count() < 1) || (param.count() > 2))
+            return false;
+
+        return IPerf::value(param[0], param.value(1), result);
+    }
+
     if (fn == "RAND") {
         // Pseudo-random number generator
         if (param.length() < 2)
@@ -790,6 +874,15 @@ bool TScriptInternalFunctions::runFunction(QString function, QStringList param,
         return true;
     }
 
+    if (fn == "SOCKLINES") {
+        // Returns amount of framed lines waiting to be read, for sockets in line mode
+        if (param.length() < 1)
+            return false;
+
+        result = sockfactory->sockLines(param[0]);
+        return true;
+    }
+
     if (fn == "SOCKLIST") {
         // Find socket names.
         // $socklist(patt_*, pos)
@@ -837,7 +930,7 @@ bool TScriptInternalFunctions::runFunction(QString function, QStringList param,
         subwindow_t sw = winList->value(*activeWid);
         result.clear();
         if ((sw.type == WT_CHANNEL) || (sw.type == WT_PRIVMSG))
-            result = sw.widget->getTarget();
+            result = sw.window->getTarget();
         return true;
     }
 
@@ -922,9 +1015,9 @@ bool TScriptInternalFunctions::runFunction(QString function, QStringList param,
             return false;
 
         if (param.count() > 1)
-            result = QString::number( sw.widget->listboxWidth() );
+            result = QString::number( sw.window->listboxWidth() );
         else
-            result = QString::number( sw.widget->width() );
+            result = QString::number( sw.window->getWidth() );
 
         return true;
     }
@@ -935,17 +1028,12 @@ bool TScriptInternalFunctions::runFunction(QString function, QStringList param,
 
 subwindow_t TScriptInternalFunctions::getCustomWindow(QString name)
 {
-    subwindow_t error;
-    error.type = WT_NOTHING; // Indicates an error.
-
-    QHashIterator<int,subwindow_t> i(*winList);
-    while (i.hasNext()) {
-        subwindow_t sw = i.next().value();
-        if (sw.widget->objectName().toUpper() == name.toUpper())
-            return sw;
-    }
+    // Custom windows got parent WP_CUSTOM, otherwise look under the active connection.
+    subwindow_t sw = winreg->get(WP_CUSTOM, name);
+    if (sw.type == WT_NOTHING)
+        sw = winreg->get(*activeConn, name);
 
-    return error;
+    return sw; // Type is WT_NOTHING if not found.
 }
 
 subwindow_t TScriptInternalFunctions::getCustomWindow(int wid)
@@ -985,6 +1073,5 @@ QString TScriptInternalFunctions::token(QString text, int pos, QChar delim)
 
 QString TScriptInternalFunctions::rand(int lo, int hi)
 {
-    qsrand( rseed++ );
     return QString::number( qrand() % ((hi + 1) - lo) + lo );
 }
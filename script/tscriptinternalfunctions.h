@@ -30,9 +30,11 @@
 #include <QObject>
 #include <QStringList>
 #include <QHash>
+#include <QFile>
 #include "tsockfactory.h"
-#include "tcustomscriptdialog.h"
+#include "icoreevents.h"
 #include "inifile.h"
+#include "iwindowregistry.h"
 
 #include "exprtk/exprtk.hpp"
 
@@ -51,8 +53,8 @@ class TScriptInternalFunctions : public QObject
 
 public:
     explicit TScriptInternalFunctions(TSockFactory *sf, QHash<QString,int> *functionIndex,
-                                      QHash<QString,TCustomScriptDialog*> *dlgs, QHash<int,t_sfile> *fl,
-                                      QHash<int,IConnection*> *cl, QHash<int,subwindow_t> *wl,
+                                      QHash<QString,ICoreScriptDialog*> *dlgs, QHash<int,t_sfile> *fl,
+                                      QHash<int,IConnection*> *cl, QHash<int,subwindow_t> *wl, IWindowRegistry *wr,
                                       int *aWid, int *aConn, TScript *scr, QObject *parent = 0);
 
     bool runFunction(QString function, QStringList param, QString &result);
@@ -64,21 +66,21 @@ private:
     exprtk::parser<double> parser; //!< Specifics for $calc() function, from exprtk library
     TSockFactory *sockfactory; //!< Pointer to the custom sockets manager.
     QHash<QString,int> *fnindex; //!< Pointer to the index of all functions.
-    QHash<QString,TCustomScriptDialog*> *dialogs; //!< Pointer to list of all dialogs.
+    QHash<QString,ICoreScriptDialog*> *dialogs; //!< Pointer to list of all dialogs.
     QHash<int,t_sfile> *files; //!< Pointer to list of all file I/O.
     int fdc; //!< File descriptor counter.
-    uint rseed; //!< Pseudo-random number seed. For $rand()
 
     int *activeWid; //!< Current active window ID.
     int *activeConn; //!< Current active connection.
     QHash<int,subwindow_t> *winList; //!< List of all subwindows. Pointer from IdealIRC class.
+    IWindowRegistry *winreg; //!< Name lookup of all subwindows. Pointer from IdealIRC class.
     QHash<int,IConnection*> *conList; //!< List of all IRC connections.
     subwindow_t getCustomWindow(QString name);
     subwindow_t getCustomWindow(int wid);
 
     TScript *script;
 
-    int lastbtn; //!< Last button pushed within $MsgBox() function.
+    QString lastbtn; //!< Last button pushed within $MsgBox() or $input(). OK, CANCEL, YES or NO.
 
     // ALL functions, I mean -ALL-, even those with integer results, MUST return QString.
     QString sstr(QString text, int start, int stop = -1);
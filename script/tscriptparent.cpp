@@ -22,34 +22,36 @@
 #include <QStringList>
 #include <QUrl>
 #include <QDesktopServices>
-#include <QApplication>
 #include <QVectorIterator>
 #include <QDebug>
+#include <QElapsedTimer>
 #include "tscriptparent.h"
 #include "iconnection.h"
 #include "icommand.h"
-#include "iwin.h"
+#include "iperf.h"
 
 /*!
  * \param parent Pointer to IdealIRC class
- * \param dialogParent Pointer to IdealIRC class
+ * \param fe Front end, used by scripts for dialogs and message boxes
  * \param cfg Pointer to config class (iirc.ini)
  * \param cl Pointer to the list of all connections
  * \param wl Pointer to the list of all subwindows
+ * \param wr Pointer to the name lookup of all subwindows
  * \param aWid Pointer to current active window ID
  * \param aConn pointer to current active connection ID
  */
-TScriptParent::TScriptParent(QObject *parent, QWidget *dialogParent, config *cfg,
+TScriptParent::TScriptParent(QObject *parent, ICoreFrontEnd *fe, config *cfg,
                              QHash<int,IConnection*> *cl, QHash<int,subwindow_t> *wl,
-                             int *aWid, int *aConn) :
+                             IWindowRegistry *wr, int *aWid, int *aConn) :
     QObject(parent),
     conf(cfg),
-    cmdhndl(parent, cl, wl, aConn, aWid),
+    cmdhndl(parent, cl, wl, wr, aConn, aWid),
     activeWid(aWid),
     activeConn(aConn),
     conlist(cl),
     winlist(wl),
-    dlgParent(dialogParent),
+    winreg(wr),
+    frontEnd(fe),
     displayURL(false)
 {
 
@@ -69,7 +71,7 @@ bool TScriptParent::loadScript(QString path, bool starting)
 {
     std::cout << "Loading '" << path.toStdString().c_str() << "'" << std::endl;
 
-    TScript *s = new TScript(this, this, dlgParent, path, conlist, winlist, activeWid, activeConn);
+    TScript *s = new TScript(this, this, frontEnd, path, conlist, winlist, winreg, activeWid, activeConn);
 
     connect(s, SIGNAL(error(QString)),
                this, SLOT(gotScriptError(QString)));
@@ -194,6 +196,7 @@ bool TScriptParent::reloadScript(QString name)
  */
 bool TScriptParent::runevent(e_iircevent event, QStringList param, QString *result)
 {
+    IPerfTimer scriptTimer(pc_Script);
     bool found = false;
     displayURL = true;
 
@@ -235,6 +238,7 @@ bool TScriptParent::runevent(e_iircevent event)
  */
 bool TScriptParent::command(QString cmd)
 {
+    IPerfTimer scriptTimer(pc_Script);
     for (int i = 0; i <= scriptlist.count()-1; i++) {
         TScript *s = scriptlist[i];
         if (s->runCommand(cmd) == true)
@@ -493,92 +497,138 @@ void TScriptParent::runScriptFunction(QString script, QString function)
     }
 }
 
-QList<scriptmenu_t> TScriptParent::getCustomNicklistMenu()
+/*!
+ * \param path Benchmark script
+ * \param iterations Runs of each benchmark function
+ *
+ * Loads a script on its own, not among the loaded scripts, so it gets no events from the
+ * connections and can't be reached by commands. Every function named bench_* is run the given
+ * amount of times, and the time per run is printed to stdout.\n
+ * Every function named benchmsg_* is run once, and what it returns is used as the text of a
+ * te_msg event, dispatched to the script the given amount of times the way the connection does it.\n
+ * Errors go to the status window. Used by the scriptbench tool.
+ * \return false if the script didn't load, had no bench_ or benchmsg_ functions or one of them failed.
+ */
+bool TScriptParent::benchScript(QString path, int iterations)
 {
-    QVectorIterator<TScript*> i(scriptlist);
-    QList<scriptmenu_t> items;
-    while (i.hasNext()) {
-        TScript *script = i.next();
-        items << *(script->getCustomNicklistMenu());
-    }
+    TScript s(this, this, frontEnd, path, conlist, winlist, winreg, activeWid, activeConn);
 
-    return items;
-}
+    connect(&s, SIGNAL(error(QString)),
+               this, SLOT(gotScriptError(QString)));
 
-QList<scriptmenu_t> TScriptParent::getCustomChannelMenu()
-{
-    QVectorIterator<TScript*> i(scriptlist);
-    QList<scriptmenu_t> items;
-    while (i.hasNext()) {
-        TScript *script = i.next();
-        items << *(script->getCustomChannelMenu());
+    connect(&s, SIGNAL(warning(QString)),
+               this, SLOT(gotScriptWarning(QString)));
+
+    int errcode = se_None;
+    if (! loader(&s, &errcode)) {
+        gotScriptError( tr("Unable to load script '%1', error %2 at %3")
+                        .arg(path)
+                        .arg(errcode)
+                        .arg(s.lm(s.getCurrentLine())));
+        return false;
     }
 
-    return items;
-}
+    QStringList functions = s.getFnIndexPtr()->keys();
+    functions.sort();
+
+    int ran = 0;
+    bool ok = true;
+    for (int i = 0; i <= functions.count()-1; i++) {
+        QString fn = functions[i];
+        if (fn.startsWith("BENCHMSG_")) {
+            ran++;
+            if (! benchMsgEvent(&s, fn, iterations))
+                ok = false;
+            continue;
+        }
+        if (! fn.startsWith("BENCH_"))
+            continue;
 
-QList<scriptmenu_t> TScriptParent::getCustomQueryMenu()
-{
-    QVectorIterator<TScript*> i(scriptlist);
-    QList<scriptmenu_t> items;
-    while (i.hasNext()) {
-        TScript *script = i.next();
-        items << *(script->getCustomQueryMenu());
-    }
+        QString result;
+        e_scriptresult r = se_None;
+        QElapsedTimer clock;
+        clock.start();
 
-    return items;
-}
+        int n = 0;
+        for (; n < iterations; n++) {
+            r = s.runf(fn, QStringList(), result, true);
+            if ((r != se_None) && (r != se_RunfDone))
+                break;
+        }
 
-QList<scriptmenu_t> TScriptParent::getCustomStatusMenu()
-{
-    QVectorIterator<TScript*> i(scriptlist);
-    QList<scriptmenu_t> items;
-    while (i.hasNext()) {
-        TScript *script = i.next();
-        items << *(script->getCustomStatusMenu());
-    }
+        qint64 ns = clock.nsecsElapsed();
+        ran++;
 
-    return items;
-}
+        if (n < iterations) {
+            gotScriptError( tr("%1 stopped with error %2 at %3")
+                            .arg(fn.toLower())
+                            .arg(r)
+                            .arg(s.lm(s.getCurrentLine())));
+            ok = false;
+            continue;
+        }
 
-void TScriptParent::populateMenu(QMenu *menu, char type)
-{
-    resetMenuPtrList();
+        QString text = tr("%1: %2 ns/op (%3 runs)")
+                         .arg(fn.toLower())
+                         .arg(ns / iterations)
+                         .arg(iterations);
 
-    QVectorIterator<TScript*> i(scriptlist);
-    while (i.hasNext()) {
-        TScript *script = i.next();
-        QList<scriptmenu_t> *child;
-
-        if (type == 'n')
-            child = script->getCustomNicklistMenu();
-        if (type == 'c')
-            child = script->getCustomChannelMenu();
-        if (type == 'q')
-            child = script->getCustomQueryMenu();
-        if (type == 's')
-            child = script->getCustomStatusMenu();
-
-        populateMenuIterate(menu, type, child, -1);
+        std::cout << "[bench] " << s.getName().toStdString() << " " << text.toStdString() << std::endl;
+    }
+
+    if (ran == 0) {
+        gotScriptError( tr("%1 has no bench_ or benchmsg_ functions").arg(path) );
+        return false;
     }
+
+    return ok;
 }
 
-void TScriptParent::populateMenuIterate(QMenu *menu, char type, QList<scriptmenu_t> *items, int parent)
+/*!
+ * \param s Benchmark script
+ * \param fn Function returning the message text, named benchmsg_*
+ * \param iterations Dispatches of the event
+ *
+ * Helper for benchScript(). Times te_msg dispatch on the script, with the text from fn.
+ * \return false if fn failed or the script has no msg event.
+ */
+bool TScriptParent::benchMsgEvent(TScript *s, QString fn, int iterations)
 {
-    QListIterator<scriptmenu_t> i(*items);
-    for (int idx = 0; i.hasNext(); ++idx) {
-        scriptmenu_t sm = i.next();
-        if (sm.parent != parent)
-            continue;
+    QString text;
+    e_scriptresult r = s->runf(fn, QStringList(), text, true);
+    if ((r != se_None) && (r != se_RunfDone)) {
+        gotScriptError( tr("%1 stopped with error %2 at %3")
+                        .arg(fn.toLower())
+                        .arg(r)
+                        .arg(s->lm(s->getCurrentLine())));
+        return false;
+    }
+
+    // Same parameters as a PRIVMSG in IConnection: nickname, target, text.
+    QStringList param;
+    param << "bench" << "#bench" << text;
+
+    QElapsedTimer clock;
+    clock.start();
 
-        if (sm.haveChildren) {
-            QMenu *subMenu = menu->addMenu(sm.action->text());
-            menuPtrList << subMenu;
-            populateMenuIterate(subMenu, type, items, idx);
+    for (int n = 0; n < iterations; n++) {
+        if (! s->runEvent(te_msg, param)) {
+            gotScriptError( tr("%1: %2 has no msg event")
+                            .arg(fn.toLower())
+                            .arg(s->getName()));
+            return false;
         }
-        else
-            menu->addAction(sm.action);
     }
+
+    qint64 ns = clock.nsecsElapsed();
+
+    QString result = tr("%1: event msg %2 ns/op (%3 runs)")
+                       .arg(fn.toLower())
+                       .arg(ns / iterations)
+                       .arg(iterations);
+
+    std::cout << "[bench] " << s->getName().toStdString() << " " << result.toStdString() << std::endl;
+    return true;
 }
 
 QStringList TScriptParent::getCurrentNickSelection()
@@ -588,21 +638,13 @@ QStringList TScriptParent::getCurrentNickSelection()
     if (sw.type != WT_CHANNEL)
         return QStringList(); // return an empty set if active window isn't a channel.
 
-    return sw.widget->getSelectedMembers();
+    return sw.window->getSelectedMembers();
 }
 
 QString TScriptParent::getCurrentWindow()
 {
     subwindow_t sw = winlist->value(*activeWid);
-    return sw.widget->objectName();
-}
-
-void TScriptParent::resetMenuPtrList()
-{
-    QListIterator<QMenu*> si(menuPtrList);
-    while (si.hasNext())
-        si.next()->deleteLater();
-    menuPtrList.clear();
+    return sw.window->getName();
 }
 
 TScript* TScriptParent::getScriptPtr(QString name)
@@ -26,16 +26,15 @@
 #ifndef TSCRIPTPARENT_H
 #define TSCRIPTPARENT_H
 
-#include <QWidget>
+#include <QObject>
 #include <QStringList>
 #include <QVector>
 #include <QHash>
-#include <QAction>
-#include <QMenu>
 
 #include "config.h"
 #include "tscript.h"
 #include "tscriptcommand.h"
+#include "tscriptprofiler.h"
 #include "constants.h"
 
 class ICommand;
@@ -53,7 +52,7 @@ class TScriptParent : public QObject
     Q_OBJECT
 
 public:
-    TScriptParent(QObject *parent, QWidget *dialogParent, config *cfg, QHash<int,IConnection*> *cl, QHash<int,subwindow_t> *wl, int *aWid, int *aConn);
+    TScriptParent(QObject *parent, ICoreFrontEnd *fe, config *cfg, QHash<int,IConnection*> *cl, QHash<int,subwindow_t> *wl, IWindowRegistry *wr, int *aWid, int *aConn);
     bool command(QString cmd); // Exec any custom commands, returns false if command not found in loaded scripts.
     bool runevent(e_iircevent event, QStringList param, QString *result = nullptr);
     bool runevent(e_iircevent event);
@@ -65,16 +64,14 @@ public:
     void loadAllScripts();
     void getToolbarPtr(QHash<QString,toolbar_t> **tb) { *tb = &toolbar; }
     void runScriptFunction(QString script, QString function);
-    QList<scriptmenu_t> getCustomNicklistMenu(); // Get items from all scripts.
-    QList<scriptmenu_t> getCustomChannelMenu(); // Get items from all scripts.
-    QList<scriptmenu_t> getCustomQueryMenu(); // Get items from all scripts.
-    QList<scriptmenu_t> getCustomStatusMenu(); // Get items from all scripts.
-    void populateMenu(QMenu *menu, char type);
+    bool benchScript(QString path, int iterations);
+    QVector<TScript*> getScripts() { return scriptlist; } //!< \return All loaded scripts, in load order. Windows build their script menus from these.
     QStringList getCurrentNickSelection(); // Gets selected nicknames in active window (used for custom nicklist menu items)
     QString getCurrentWindow(); // Gets the current window that's active
-    void resetMenuPtrList();
     config* getConfPtr() { return conf; }  //!< \return Pointer to the config class (iirc.ini)
     TScript* getScriptPtr(QString name);
+    TScriptProfiler* getProfiler() { return &profiler; } //!< \return Pointer to the script profiler.
+    ICoreFrontEnd* getFrontEnd() { return frontEnd; } //!< \return Pointer to the front end.
 
 signals:
     void refreshToolbar();
@@ -99,22 +96,19 @@ private slots:
   private:
     config *conf; //!< Pointer to the config class (iirc.ini)
     TScriptCommand cmdhndl; //!< Script command parser
+    TScriptProfiler profiler; //!< Collects timing of scripts when enabled.
     int *activeWid; //!< Current active window ID.
     int *activeConn; //!< Current active connection ID.
     QVector<TScript*> scriptlist; //!< List of all scripts loaded.
-    QList<QMenu*> menuPtrList; //!< Used for populating different menus. Reset before use.
     QHash<QString,toolbar_t> toolbar; //!< Custom toolbar items.\n Key: Object name\n Value: Toolbar button specifics.
     QHash<int,IConnection*> *conlist; //!< List of all connections.
     QHash<int,subwindow_t> *winlist; //!< List of all subwindows. Pointer from IdealIRC class.
-    QWidget *dlgParent; //!< Pointer to the IdealIRC class. Used as parent for scriptable dialogs.
+    IWindowRegistry *winreg; //!< Name lookup of all subwindows. Pointer from IdealIRC class.
+    ICoreFrontEnd *frontEnd; //!< Pointer to the front end. Passed on to scripts for dialogs and message boxes.
     bool displayURL;
 
     bool loader(TScript *script, int *errcode = NULL);
-    void populateMenuIterate(QMenu *menu, char type, QList<scriptmenu_t> *items, int parent);
-    QMenu nicklistMenu; //!< The processed nicklist menu, pointer passed to all relevant IWin.
-    QMenu channelMenu; //!< The processed channel menu, pointer passed to all relevant IWin.
-    QMenu statusMenu; //!< The processed status menu, pointer passed to all relevant IWin.
-    QMenu privmsgMenu; //!< The processed query menu, pointer passed to all relevant IWin.
+    bool benchMsgEvent(TScript *s, QString fn, int iterations);
 };
 
 #endif // TSCRIPTPARENT_H
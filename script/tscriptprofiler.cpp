@@ -0,0 +1,284 @@
+/*
+ *   IdealIRC - Internet Relay Chat client
+ *   Copyright (C) 2014  Tom-Andre Barstad
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+
+#include <QObject>
+#include <QFile>
+#include <QList>
+#include <QHashIterator>
+#include <algorithm>
+#include <climits>
+
+#include "tscriptprofiler.h"
+#include "tscriptparent.h"
+#include "iperf.h"
+
+typedef struct T_PROFROW {
+    QString name; //!< What to show in the report
+    t_profentry entry; //!< Stats
+} t_profrow;
+
+static bool exclusiveGreater(const t_profrow &a, const t_profrow &b)
+{
+    return a.entry.exclusive > b.entry.exclusive;
+}
+
+static bool inclusiveGreater(const t_profrow &a, const t_profrow &b)
+{
+    return a.entry.inclusive > b.entry.inclusive;
+}
+
+/*!
+ * \param ns Nanoseconds
+ * \return Milliseconds with three decimals.
+ */
+static QString ms(qint64 ns)
+{
+    return QString::number(ns / 1000000.0, 'f', 3);
+}
+
+TScriptProfiler::TScriptProfiler() :
+    enabled(false)
+{
+}
+
+/*!
+ * \param enable true to start profiling, false to stop.
+ *
+ * Collected stats are kept when stopping, use reset() to clear them.
+ */
+void TScriptProfiler::setEnabled(bool enable)
+{
+    if (enable == enabled)
+        return;
+
+    enabled = enable;
+    stack.clear();
+
+    if (enabled && (! clock.isValid()))
+        clock.start();
+}
+
+/*!
+ * Clears all collected stats.
+ */
+void TScriptProfiler::reset()
+{
+    stack.clear();
+    functions.clear();
+    events.clear();
+    lines.clear();
+}
+
+/*!
+ * \param script Script name
+ * \param function Function name
+ *
+ * Called by TScript::runf() before running a script function.
+ */
+void TScriptProfiler::enterFunction(QString script, QString function)
+{
+    t_profframe frame;
+    frame.script = script;
+    frame.function = function.toLower();
+    frame.start = clock.nsecsElapsed();
+    frame.child = 0;
+    frame.lastLine = frame.start;
+    frame.allocStart = IPerf::allocations();
+
+    stack.push_back(frame);
+}
+
+/*!
+ * Called by TScript::runf() when the function entered last returns.
+ */
+void TScriptProfiler::leaveFunction()
+{
+    if (stack.isEmpty())
+        return; // Profiler got reset while the function ran.
+
+    t_profframe frame = stack.back();
+    stack.pop_back();
+
+    qint64 ns = clock.nsecsElapsed() - frame.start;
+
+    t_profentry &e = functions[frame.script][frame.function];
+    e.calls++;
+    e.inclusive += ns;
+    e.exclusive += ns - frame.child;
+    e.max = qMax(e.max, ns);
+    e.allocs += IPerf::allocations() - frame.allocStart;
+
+    if (! stack.isEmpty())
+        stack.back().child += ns;
+}
+
+/*!
+ * \param script Script name
+ * \param line Internal line number that just finished
+ *
+ * Called by the interpreter for every line it passes.
+ */
+void TScriptProfiler::lineDone(QString script, int line)
+{
+    if (stack.isEmpty())
+        return;
+
+    qint64 now = clock.nsecsElapsed();
+    t_profentry &e = lines[script][line];
+    e.calls++;
+    e.inclusive += now - stack.back().lastLine;
+    stack.back().lastLine = now;
+}
+
+/*!
+ * \param script Script name
+ * \param event The event that ran
+ * \param started elapsed() from before the handler ran
+ *
+ * Called by TScript::runEvent() after running an event handler.
+ */
+void TScriptProfiler::eventDone(QString script, e_iircevent event, qint64 started)
+{
+    qint64 ns = clock.nsecsElapsed() - started;
+
+    t_profentry &e = events[script][event];
+    e.calls++;
+    e.inclusive += ns;
+    e.exclusive += ns;
+    e.max = qMax(e.max, ns);
+}
+
+/*!
+ * \param sp Script parent, for looking up line numbers.
+ * \param top Max amount of rows in each section.
+ *
+ * Functions are sorted by exclusive time, events and lines by total time.
+ * \return Text report of everything collected.
+ */
+QString TScriptProfiler::report(TScriptParent *sp, int top)
+{
+    QList<t_profrow> fnRows;
+    QHashIterator<QString,QHash<QString,t_profentry> > fi(functions);
+    while (fi.hasNext()) {
+        fi.next();
+        QHashIterator<QString,t_profentry> i(fi.value());
+        while (i.hasNext()) {
+            i.next();
+            t_profrow row;
+            row.name = fi.key() + ": " + i.key();
+            row.entry = i.value();
+            fnRows << row;
+        }
+    }
+
+    QList<t_profrow> evRows;
+    QHashIterator<QString,QHash<int,t_profentry> > ei(events);
+    while (ei.hasNext()) {
+        ei.next();
+        QHashIterator<int,t_profentry> i(ei.value());
+        while (i.hasNext()) {
+            i.next();
+            t_profrow row;
+            row.name = ei.key() + ": " + TScript::getEventStr((e_iircevent)i.key());
+            row.entry = i.value();
+            evRows << row;
+        }
+    }
+
+    QList<t_profrow> lineRows;
+    QHashIterator<QString,QHash<int,t_profentry> > li(lines);
+    while (li.hasNext()) {
+        li.next();
+        TScript *script = sp->getScriptPtr(li.key());
+        QHashIterator<int,t_profentry> i(li.value());
+        while (i.hasNext()) {
+            i.next();
+            t_profrow row;
+            if (script != NULL)
+                row.name = li.key() + ": " + script->lm(i.key());
+            else
+                row.name = QObject::tr("%1: internal line %2 (unloaded)").arg(li.key()).arg(i.key());
+            row.entry = i.value();
+            lineRows << row;
+        }
+    }
+
+    std::sort(fnRows.begin(), fnRows.end(), exclusiveGreater);
+    std::sort(evRows.begin(), evRows.end(), inclusiveGreater);
+    std::sort(lineRows.begin(), lineRows.end(), inclusiveGreater);
+
+    QString text;
+    if (! enabled)
+        text += QObject::tr("Profiler is off.") + '\n';
+
+    text += '\n' + QObject::tr("Functions (calls, inclusive ms, exclusive ms, max ms, allocations/call):") + '\n';
+    for (int i = 0; (i < fnRows.count()) && (i < top); ++i) {
+        t_profentry &e = fnRows[i].entry;
+        text += QString("  %1  %2  %3  %4  %5  %6\n")
+                  .arg(fnRows[i].name)
+                  .arg(e.calls)
+                  .arg(ms(e.inclusive))
+                  .arg(ms(e.exclusive))
+                  .arg(ms(e.max))
+                  .arg(QString::number((double)e.allocs / e.calls, 'f', 1));
+    }
+
+    text += '\n' + QObject::tr("Events (calls, total ms, avg ms, max ms):") + '\n';
+    for (int i = 0; (i < evRows.count()) && (i < top); ++i) {
+        t_profentry &e = evRows[i].entry;
+        text += QString("  %1  %2  %3  %4  %5\n")
+                  .arg(evRows[i].name)
+                  .arg(e.calls)
+                  .arg(ms(e.inclusive))
+                  .arg(ms(e.inclusive / (qint64)e.calls))
+                  .arg(ms(e.max));
+    }
+
+    text += '\n' + QObject::tr("Lines (runs, total ms):") + '\n';
+    for (int i = 0; (i < lineRows.count()) && (i < top); ++i) {
+        t_profentry &e = lineRows[i].entry;
+        text += QString("  %1  %2  %3\n")
+                  .arg(lineRows[i].name)
+                  .arg(e.calls)
+                  .arg(ms(e.inclusive));
+    }
+
+    return text;
+}
+
+/*!
+ * \param filename File to write to, replaced if it exists.
+ * \param sp Script parent, for looking up line numbers.
+ *
+ * Writes a report with every row, not only the top ones.
+ * \return true on success, false if the file couldn't be written.
+ */
+bool TScriptProfiler::dump(QString filename, TScriptParent *sp)
+{
+    QFile f(filename);
+    if (! f.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+        return false;
+
+    f.write(report(sp, INT_MAX).toUtf8());
+    f.close();
+
+    return true;
+}
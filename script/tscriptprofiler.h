@@ -0,0 +1,87 @@
+/*
+ *   IdealIRC - Internet Relay Chat client
+ *   Copyright (C) 2014  Tom-Andre Barstad
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+
+/*! \class TScriptProfiler
+ *  \brief Records where time goes in loaded scripts.
+ *
+ * When enabled, every script function call records call count, inclusive and exclusive
+ * wall time and allocations. Event handlers are timed per script and event, and the time
+ * spent on each script line is summed up, which lm() turns into file:line when reporting.\n
+ * Line time is inclusive, the line calling a slow function gets the time of that call as well.\n
+ * Allocations are only counted by the benchmark tools built with CONFIG+=alloccount, see IPerf::allocations().
+ */
+
+#ifndef TSCRIPTPROFILER_H
+#define TSCRIPTPROFILER_H
+
+#include <QString>
+#include <QHash>
+#include <QVector>
+#include <QElapsedTimer>
+
+#include "constants.h"
+
+#define PROFILER_TOP 20 //!< Max amount of rows for each section in a report.
+
+class TScriptParent;
+
+typedef struct T_PROFENTRY {
+    quint64 calls; //!< Times called.
+    qint64 inclusive; //!< Nanoseconds spent, including functions it called.
+    qint64 exclusive; //!< Nanoseconds spent in itself.
+    qint64 max; //!< Nanoseconds of the slowest single call.
+    quint64 allocs; //!< Allocations done, including functions it called.
+} t_profentry;
+
+typedef struct T_PROFFRAME {
+    QString script; //!< Script name
+    QString function; //!< Function name, lower case.
+    qint64 start; //!< When the call started.
+    qint64 child; //!< Nanoseconds spent in functions it called.
+    qint64 lastLine; //!< When the previous line ended.
+    quint64 allocStart; //!< Allocation count when the call started.
+} t_profframe;
+
+class TScriptProfiler
+{
+public:
+    TScriptProfiler();
+    bool isEnabled() { return enabled; } //!< \return true if profiling is on.
+    void setEnabled(bool enable);
+    void reset();
+    qint64 elapsed() { return clock.nsecsElapsed(); } //!< \return Nanoseconds since the profiler was enabled.
+    void enterFunction(QString script, QString function);
+    void leaveFunction();
+    void lineDone(QString script, int line);
+    void eventDone(QString script, e_iircevent event, qint64 started);
+    QString report(TScriptParent *sp, int top = PROFILER_TOP);
+    bool dump(QString filename, TScriptParent *sp);
+
+private:
+    bool enabled; //!< Profiling is on.
+    QElapsedTimer clock; //!< Clock for all timestamps, started when enabled.
+    QVector<t_profframe> stack; //!< Functions currently running, innermost last.
+    QHash<QString,QHash<QString,t_profentry> > functions; //!< Function stats.\n Key: Script name\n Value: Stats per function name
+    QHash<QString,QHash<int,t_profentry> > events; //!< Event handler stats.\n Key: Script name\n Value: Stats per event
+    QHash<QString,QHash<int,t_profentry> > lines; //!< Line stats, only calls and inclusive are used.\n Key: Script name\n Value: Stats per internal line
+};
+
+#endif // TSCRIPTPROFILER_H
@@ -19,16 +19,25 @@
  */
 
 #include "tsock.h"
+#include "itls.h"
 #include <QStringList>
+#include <QTimer>
 #include <QDebug>
 
 TSock::TSock(QTcpSocket *sock, QObject *parent) :
   QObject(parent),
-  listenPort(0)
+  listenPort(0),
+  tlsPort(0),
+  lineMode(false),
+  lastCR(false),
+  lineOverflow(false),
+  readPending(false),
+  writeLimit(TSOCK_DEFAULT_WRITELIMIT),
+  writeBlocked(false)
 {
 
     if (sock == NULL)
-        socket = new QTcpSocket;
+        socket = new QSslSocket; // Works as a plain TCP socket until asked to encrypt.
     else
         socket = sock;
 
@@ -44,6 +53,8 @@ TSock::TSock(QTcpSocket *sock, QObject *parent) :
     connect(socket, SIGNAL(readyRead()),
             this, SLOT(socketDataReady()));
 
+    connect(socket, SIGNAL(bytesWritten(qint64)),
+            this, SLOT(socketBytesWritten(qint64)));
 
     connect(&server, SIGNAL(newConnection()),
             this, SLOT(serverConnection()));
@@ -54,9 +65,39 @@ TSock::~TSock()
     delete socket;
 }
 
-TSOCK_ERR TSock::open(QString hostname, int port)
+/*!
+ * \param hostname Host to connect to
+ * \param port Port
+ * \param tls Encrypt the connection. Sessions are resumed and pins.ini is honoured, see ITls.
+ *
+ * Connects to a host. The sockopen event comes when we're connected, for TLS after the handshake.
+ * \return TSE_NONE on success
+ */
+TSOCK_ERR TSock::open(QString hostname, int port, bool tls)
 {
-    socket->connectToHost(hostname, port);
+    if (! tls) {
+        socket->connectToHost(hostname, port);
+        return TSE_NONE;
+    }
+
+    QSslSocket *ssl = qobject_cast<QSslSocket*>(socket);
+    if ((ssl == NULL) || (! ITls::available()))
+        return TSE_NOTLS;
+
+    tlsHost = hostname;
+    tlsPort = port;
+    ITls::prepare(ssl, hostname, port);
+
+    disconnect(socket, SIGNAL(connected()),
+               this, SLOT(socketConnected()));
+
+    connect(ssl, SIGNAL(encrypted()),
+            this, SLOT(socketEncrypted()));
+
+    connect(ssl, SIGNAL(sslErrors(QList<QSslError>)),
+            this, SLOT(socketSslErrors(QList<QSslError>)));
+
+    ssl->connectToHostEncrypted(hostname, port);
     return TSE_NONE;
 }
 
@@ -98,8 +139,22 @@ TSOCK_ERR TSock::close()
     return TSE_NONE;
 }
 
+/*!
+ * \param data Data to send
+ *
+ * Queues data on the socket's output buffer.\n
+ * If the output buffer already holds data and this write would exceed the write limit,
+ * nothing is written and TSE_BUFFERFULL is returned. A sockwritable event follows once the buffer drains.
+ * \return TSE_NONE on success
+ */
 TSOCK_ERR TSock::write(QByteArray *data)
 {
+    qint64 pending = socket->bytesToWrite();
+    if ((writeLimit > 0) && (pending > 0) && (pending + data->length() > writeLimit)) {
+        writeBlocked = true;
+        return TSE_BUFFERFULL;
+    }
+
     qint64 l = socket->write(*data);
     if (l == -1)
         return TSE_CANNOTWRITE;
@@ -107,13 +162,45 @@ TSOCK_ERR TSock::write(QByteArray *data)
         return TSE_NONE;
 }
 
+QString TSock::bufLen()
+{
+    if (! lineMode)
+        return QString::number( socket->bytesAvailable() );
+
+    qint64 len = inbuf.length();
+    QListIterator<QByteArray> i(lines);
+    while (i.hasNext())
+        len += i.next().length() + 1;
+
+    return QString::number(len);
+}
+
 QByteArray TSock::readBuffer() // Read out entire buffer.
 {
-    return socket->readAll();
+    if (lines.isEmpty() && inbuf.isEmpty())
+        return socket->readAll();
+
+    // Give back what's been framed, followed by anything not yet framed.
+    QByteArray data;
+    while (! lines.isEmpty())
+        data.append( lines.takeFirst() ).append('\n');
+    data.append(inbuf);
+    data.append( socket->readAll() );
+    inbuf.clear();
+    lastCR = false;
+    lineOverflow = false;
+
+    return data;
 }
 
 QString TSock::readBufferLn() // Read out first line (to next \n).
 {
+    if (! lines.isEmpty())
+        return QString( lines.takeFirst() );
+
+    if (lineMode)
+        return QString();
+
     return socket->readLine().replace( QByteArray('\r','\n'),
                                        QByteArray('\0','\0')
                                       );
@@ -130,16 +217,138 @@ void TSock::socketConnected()
     emit eventAvailable(objectName(), te_sockopen, QStringList()<<objectName());
 }
 
+/*!
+ * The TLS handshake is done. A pinned host must have presented the pinned key.
+ */
+void TSock::socketEncrypted()
+{
+    QSslSocket *ssl = qobject_cast<QSslSocket*>(socket);
+
+    if (! ITls::checkPin(ssl, tlsHost)) {
+        socketError(QAbstractSocket::SslHandshakeFailedError);
+        socket->abort();
+        return;
+    }
+
+    ITls::saveSession(ssl, tlsHost, tlsPort);
+    socketConnected();
+}
+
+void TSock::socketSslErrors(const QList<QSslError> &errors)
+{
+    // Unless the host is pinned, the handshake fails and the script gets a sockerror event.
+    ITls::handleErrors(qobject_cast<QSslSocket*>(socket), tlsHost, errors);
+}
+
 void TSock::socketDisconnected()
 {
+    if (! tlsHost.isEmpty())
+        ITls::saveSession(qobject_cast<QSslSocket*>(socket), tlsHost, tlsPort);
+
     emit eventAvailable(objectName(), te_sockclose, QStringList()<<objectName());
 }
 
+/*!
+ * \param enable Turn line mode on or off
+ *
+ * In line mode, TSock reads the socket itself and frames the data into lines.\n
+ * Instead of one sockread event per readyRead, the script gets one sockread event for each
+ * batch of complete lines, and reads them one by one with sock -rn.
+ */
+void TSock::setLineMode(bool enable)
+{
+    lineMode = enable;
+
+    if (lineMode && (socket->bytesAvailable() > 0))
+        socketDataReady();
+}
+
+/*!
+ * Moves everything available on the socket into the input buffer and
+ * splits off the complete lines. CR, LF and CRLF line endings are accepted.\n
+ * Lines longer than TSOCK_MAXLINE are cut, so a peer that never ends its line can't fill our memory.
+ */
+void TSock::frameLines()
+{
+    QByteArray data = socket->readAll();
+    const char *in = data.constData();
+    int len = data.length();
+    int start = 0; // Where the part of the current line in this chunk starts.
+
+    for (int i = 0; i < len; i++) {
+        char c = in[i];
+        if (c != '\r' && c != '\n')
+            continue;
+
+        // A LF right after CR is the end of the same line.
+        bool crlf = (c == '\n' && lastCR && i == start);
+        lastCR = (c == '\r');
+        if (crlf) {
+            start = i + 1;
+            continue;
+        }
+
+        if (! lineOverflow)
+            inbuf.append(in + start, qMin(i - start, TSOCK_MAXLINE - inbuf.length()));
+        start = i + 1;
+        lineOverflow = false;
+
+        lines << inbuf;
+        inbuf.clear();
+    }
+
+    int rest = len - start;
+    if (rest > 0) {
+        lastCR = false;
+        if (! lineOverflow) {
+            int room = TSOCK_MAXLINE - inbuf.length();
+            inbuf.append(in + start, qMin(rest, room));
+            if (rest > room)
+                lineOverflow = true;
+        }
+    }
+}
+
 void TSock::socketDataReady()
 {
+    if (! lineMode) {
+        emit eventAvailable(objectName(), te_sockread, QStringList()<<objectName());
+        return;
+    }
+
+    frameLines();
+
+    // Several readyRead may arrive within the same event loop turn, deliver them as one batch.
+    if ((! lines.isEmpty()) && (! readPending)) {
+        readPending = true;
+        QTimer::singleShot(0, this, SLOT(deliverLines()));
+    }
+}
+
+void TSock::deliverLines()
+{
+    readPending = false;
+    if (lines.isEmpty())
+        return;
+
     emit eventAvailable(objectName(), te_sockread, QStringList()<<objectName());
 }
 
+void TSock::socketBytesWritten(qint64 bytes)
+{
+    Q_UNUSED(bytes);
+
+    if (! writeBlocked)
+        return;
+
+    // Low water mark at half the limit, so the script can refill before the socket runs dry.
+    if (socket->bytesToWrite() > writeLimit/2)
+        return;
+
+    writeBlocked = false;
+    emit eventAvailable(objectName(), te_sockwritable, QStringList()<<objectName());
+}
+
 void TSock::serverConnection()
 {
     emit eventAvailable(objectName(), te_socklisten, QStringList()<<objectName());
@@ -31,10 +31,15 @@
 #include <QObject>
 #include <QTcpServer>
 #include <QTcpSocket>
+#include <QSslSocket>
 #include <QStringList>
+#include <QList>
 
 #include "constants.h"
 
+#define TSOCK_DEFAULT_WRITELIMIT 262144 //!< Default bound of the output buffer, in bytes.
+#define TSOCK_MAXLINE 65536 //!< Line mode: Longer lines are cut here, the rest is thrown away.
+
 enum TSOCK_ERR {
     TSE_NONE = 0, // No error
     TSE_NOSUCHNAME, // No such socket name
@@ -45,7 +50,9 @@ enum TSOCK_ERR {
     TSE_UKWSWITCH, // Unknown sock switch
     TSE_CANNOTBIND, // Cannot bind socket.
     TSE_SOCKINUSE, // Cannot listen, socket in use
-    TSE_NOMORECONNECTIONS // No more (incoming) connections to accept
+    TSE_NOMORECONNECTIONS, // No more (incoming) connections to accept
+    TSE_BUFFERFULL, // Output buffer is full, wait for sockwritable event
+    TSE_NOTLS // TLS requested, but the SSL library isn't available
 };
 
 class TSock : public QObject
@@ -55,22 +62,35 @@ class TSock : public QObject
   public:
     explicit TSock(QTcpSocket *sock = 0, QObject *parent = NULL);
     ~TSock();
-    TSOCK_ERR open(QString hostname, int port);
+    TSOCK_ERR open(QString hostname, int port, bool tls = false);
     TSOCK_ERR listen(int port);
     TSOCK_ERR close();
     TSOCK_ERR write(QByteArray *data);
-    QString bufLen() { return QString::number( socket->bytesAvailable() ); } //!< \return QString, amount of bytes in the input buffer.
+    QString bufLen();
+    QString lineCount() { return QString::number( lines.count() ); } //!< \return QString, amount of framed lines waiting (line mode).
     QByteArray readBuffer(); // Read out entire buffer.
     QString readBufferLn(); // Read out first line (to next \n).
     bool haveConnections() { return server.hasPendingConnections(); } //!< \return true if the TCP server have incoming, but yet unattended connections.
     QTcpSocket *acceptConnection();
     void declineConnection(); // Just a skip.
-
+    void setLineMode(bool enable);
+    void setWriteLimit(qint64 bytes) { writeLimit = bytes; } //!< Bound of the output buffer in bytes, 0 is unbounded.
 
   private:
     int listenPort; // If 0, this is a TCP client
-    QTcpSocket *socket; //!< TCP client.
+    QTcpSocket *socket; //!< TCP client. A QSslSocket unless it came from our TCP server.
+    QString tlsHost; //!< Hostname we connected to with TLS, empty if not using TLS.
+    int tlsPort; //!< Port we connected to with TLS.
     QTcpServer server; //!< TCP server.
+    bool lineMode; //!< If true, incoming data is framed into lines and sockread is emitted once per batch.
+    QByteArray inbuf; //!< Line mode: Incomplete line, waiting for more data. Never longer than TSOCK_MAXLINE.
+    bool lastCR; //!< Line mode: Previous byte was a CR, so a LF following it ends the same line.
+    bool lineOverflow; //!< Line mode: Current line passed TSOCK_MAXLINE, skip bytes until the line ends.
+    QList<QByteArray> lines; //!< Line mode: Complete lines waiting to be read by the script.
+    bool readPending; //!< Line mode: A sockread event is already scheduled for this event loop turn.
+    qint64 writeLimit; //!< Max bytes allowed in the output buffer. 0 is unbounded.
+    bool writeBlocked; //!< A write was refused due to full output buffer, sockwritable is emitted when it drains.
+    void frameLines();
 
   signals:
     void eventAvailable(QString sockname, e_iircevent event, QStringList para);
@@ -79,8 +99,12 @@ class TSock : public QObject
   private slots:
     void socketError(QAbstractSocket::SocketError error);
     void socketConnected();
+    void socketEncrypted();
+    void socketSslErrors(const QList<QSslError> &errors);
     void socketDisconnected();
     void socketDataReady();
+    void socketBytesWritten(qint64 bytes);
+    void deliverLines();
     void serverConnection(); // Connection available.
 
 };
@@ -18,9 +18,9 @@
  *
  */
 
-#include <QHashIterator>
 #include <iostream>
 #include "tsockfactory.h"
+#include "wildcardmatcher.h"
 
 TSockFactory::TSockFactory(QObject *parent) :
   QObject(parent)
@@ -103,7 +103,7 @@ void TSockFactory::sockclose(QString name)
     socket->close();
 }
 
-void TSockFactory::sockopen(QString name, QString host, int port)
+void TSockFactory::sockopen(QString name, QString host, int port, bool tls)
 {
     TSock *socket = NULL;
 
@@ -115,7 +115,7 @@ void TSockFactory::sockopen(QString name, QString host, int port)
 
     socket = new TSock(); // With a name available, create a new socket.
 
-    lastErr = socket->open(host, port); // Opening socket gives error to sockerror()
+    lastErr = socket->open(host, port, tls); // Opening socket gives error to sockerror()
     if (lastErr == 0) {
         socket->setObjectName(name);
         connect(socket, SIGNAL(eventAvailable(QString,e_iircevent,QStringList)),
@@ -126,51 +126,41 @@ void TSockFactory::sockopen(QString name, QString host, int port)
         delete socket; // Errors on opening, delete.
 }
 
+/*!
+ * \param name_patt Wildcard pattern of socket names
+ * \param pos Position of the match to return, starting at 1
+ *
+ * Only the range of names starting with the literal prefix of the pattern is visited,
+ * and the pattern is compiled once through the WildcardMatcher cache.
+ * \return The pos'th matching socket name, or amount of matches if pos is 0.
+ */
 QString TSockFactory::socklist(QString name_patt, int pos)
 {
     // Pos = 0 means return total amount of matching patterns.
 
-    int count = 1;
-    QHashIterator<QString,TSock*> i(slist);
-
     if (pos < 0)
         return QString(); // Negative numbers have nothing here to do.
 
-    while (i.hasNext()) {
-        i.next();
+    WildcardMatcher wm = WildcardMatcher::cached(name_patt.toUpper());
+    QString prefix = wm.prefix();
+    int count = 0;
+
+    QMap<QString,TSock*>::const_iterator i = slist.lowerBound(prefix);
+    for (; i != slist.constEnd(); ++i) {
         QString iname = i.key();
-        QRegExp rx( QRegExp::escape( name_patt.toUpper() ) );
-        rx.setPatternSyntax(QRegExp::WildcardUnix);
-        int idx = iname.indexOf(rx, Qt::CaseInsensitive);
-
-        /*  std::cout << "iname: " << iname.toStdString().c_str() <<
-                       " | rx.pattern(): " << rx.pattern().toStdString().c_str() <<
-                       " | idx: " << idx <<
-                       " | pos: " << pos <<
-                       " | count: " << count <<
-                       " [";*/
-
-        if ((pos == 0) && (idx > -1)) {
-            // std::cout << "x] LIST" << std::endl;
-            count++;
+        if (! iname.startsWith(prefix))
+            break; // Past the range of names with this prefix
+
+        if (! wm.match(iname))
             continue;
-        }
 
-        if (pos > 0) {
-            if ((idx != -1) && (count == pos)) {
-                // std::cout << "x]" << std::endl;
-                return iname;
-            }
-            if ((idx != -1) && (count < pos)) {
-                //  std::cout << " ]" << std::endl;
-                count++;
-            }
-        }
-        //std::cout << " ] UNWANTED" << std::endl;
+        ++count;
+        if (count == pos)
+            return iname;
     }
 
     if (pos == 0)
-        return QString::number( count-1 );
+        return QString::number(count);
     else
         return QString();
 }
@@ -185,6 +175,36 @@ QString TSockFactory::sockBufLen(QString name)
     return socket->bufLen();
 }
 
+QString TSockFactory::sockLines(QString name)
+{
+    TSock *socket = NULL;
+    lastErr = pickSocket(name, &socket);
+    if (lastErr > 0)
+        return "-1"; // Nothing more to do, error is reported at sockerror().
+
+    return socket->lineCount();
+}
+
+void TSockFactory::socklinemode(QString name, bool enable)
+{
+    TSock *socket = NULL;
+    lastErr = pickSocket(name, &socket);
+    if (lastErr > 0)
+        return; // Nothing more to do, error is reported at sockerror().
+
+    socket->setLineMode(enable);
+}
+
+void TSockFactory::sockwritelimit(QString name, qint64 bytes)
+{
+    TSock *socket = NULL;
+    lastErr = pickSocket(name, &socket);
+    if (lastErr > 0)
+        return; // Nothing more to do, error is reported at sockerror().
+
+    socket->setWriteLimit(bytes);
+}
+
 bool TSockFactory::sockAcceptNext(QString name, QString connected_name)
 {
     TSock *socket = NULL;
@@ -230,15 +250,7 @@ bool TSockFactory::sockDeclineNext(QString name)
 
 TSOCK_ERR TSockFactory::pickSocket(QString name, TSock **socket)
 {
-    *socket = NULL; // NULL would mean "not found"
-    QHashIterator<QString,TSock*> i(slist);
-    while (i.hasNext()) {
-        i.next();
-        if (i.key().toUpper() == name.toUpper()) {
-            *socket = i.value();
-            break;
-        }
-    }
+    *socket = slist.value(name.toUpper(), NULL); // NULL would mean "not found"
 
     if (*socket == NULL)
         return TSE_NOSUCHNAME; // Name not found
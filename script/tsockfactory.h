@@ -26,7 +26,7 @@
 #define TSOCKFACTORY_H
 
 #include <QObject>
-#include <QHash>
+#include <QMap>
 #include <QStringList>
 #include "constants.h"
 #include "tsock.h"
@@ -49,16 +49,19 @@ public:
     QString sockreadLn(QString name);
     void sockrename(QString name, QString newname);
     void sockclose(QString name);
-    void sockopen(QString name, QString host, int port);
+    void sockopen(QString name, QString host, int port, bool tls = false);
     QString socklist(QString name_patt, int pos);
     TSOCK_ERR sockerror() { return lastErr; } // Last socket error
     QString sockBufLen(QString name);
+    QString sockLines(QString name);
+    void socklinemode(QString name, bool enable);
+    void sockwritelimit(QString name, qint64 bytes);
     bool sockAcceptNext(QString name, QString connected_name);
     bool sockDeclineNext(QString name);
     bool hasName(QString name); // Does the factory have the given sockname?
 
 private:
-    QHash<QString,TSock*> slist; //!< List of all sockets,\n Key: name\n Value: socket.
+    QMap<QString,TSock*> slist; //!< List of all sockets, sorted so wildcard patterns can range scan by their prefix.\n Key: name in upper case\n Value: socket.
     TSOCK_ERR pickSocket(QString name, TSock **socket);
     TSOCK_ERR lastErr; //!< Last socket error.
 
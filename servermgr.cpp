@@ -224,3 +224,51 @@ QString ServerMgr::getServerDetails(QString name, QString network)
 {
     return ini.ReadIni(network, name);
 }
+
+/*!
+ * \param server Server we're connecting to, hostname:port
+ *
+ * Finds the network the server belongs to, used to fail over to another server of the same network.\n
+ * Servers in the 'NONE' section of servers.ini doesn't belong to a network and has no alternates.
+ * \return Details of the other servers in that network, default server first. Empty if none.
+ */
+QStringList ServerMgr::alternateServers(QString server)
+{
+    QStringList r;
+    QString match = server.split('|').at(0).toLower();
+    QStringList netlist = networkList();
+
+    for (int i = 0; i <= netlist.count()-1; ++i) {
+        QString network = netlist[i];
+        if (network == "NONE")
+            continue;
+
+        int count = ini.CountItems(network);
+        bool found = false;
+        QStringList list;
+
+        for (int j = 1; j <= count; j++) {
+            QString name = ini.ReadIniItem(network, j);
+            QString details = ini.ReadIni(network, j);
+            QString hostport = details.split('|').at(0).toLower();
+
+            if (hostport == match) {
+                found = true;
+                continue;
+            }
+
+            if (list.contains(details))
+                continue; // The default server is usually listed twice.
+
+            if (name == "DEFAULT")
+                list.prepend(details);
+            else
+                list << details;
+        }
+
+        if (found)
+            return list;
+    }
+
+    return r;
+}
@@ -59,6 +59,8 @@ public:
     bool hasServer(QString name, QString network = "NONE");
     // Get server details
     QString getServerDetails(QString name, QString network = "NONE");
+    // Other servers in the network of the given host:port, default server first - empty if it's not in any network
+    QStringList alternateServers(QString server);
 
 private:
     IniFile ini; //!< Opens the servers.ini file through here.
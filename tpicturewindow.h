@@ -41,8 +41,9 @@
 #include <QHash>
 
 #include "constants.h"
+#include "icoreevents.h"
 
-class TPictureWindow : public QWidget
+class TPictureWindow : public QWidget, public ICorePicture
 {
   Q_OBJECT
 
@@ -0,0 +1,204 @@
+/*
+ *   IdealIRC - Internet Relay Chat client
+ *   Copyright (C) 2014  Tom-Andre Barstad
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#include <QHash>
+#include "wildcardmatcher.h"
+
+WildcardMatcher::WildcardMatcher() :
+    cs(Qt::CaseInsensitive),
+    kind(wm_Literal),
+    prefixLen(0)
+{
+}
+
+/*!
+ * \param pattern Wildcard pattern, * matches any amount of characters, ? matches one character.
+ * \param cs Case sensitivity
+ */
+WildcardMatcher::WildcardMatcher(QString pattern, Qt::CaseSensitivity cs) :
+    pattern(pattern),
+    cs(cs),
+    kind(wm_Glob),
+    prefixLen(0)
+{
+    compile();
+}
+
+/*!
+ * Figures out the shape of the pattern, so match() can avoid the glob matcher when possible.
+ */
+void WildcardMatcher::compile()
+{
+    while (pattern.contains("**"))
+        pattern.replace("**", "*");
+
+    prefixLen = pattern.length();
+    for (int i = 0; i < pattern.length(); ++i) {
+        if ((pattern[i] == '*') || (pattern[i] == '?')) {
+            prefixLen = i;
+            break;
+        }
+    }
+
+    int len = pattern.length();
+    int stars = pattern.count('*');
+    bool lead = pattern.startsWith('*');
+    bool trail = pattern.endsWith('*');
+
+    if (pattern.contains('?'))
+        kind = wm_Glob;
+    else if (stars == 0)
+        kind = wm_Literal;
+    else if (pattern == "*")
+        kind = wm_Any;
+    else if ((stars == 1) && trail)
+        kind = wm_Prefix;
+    else if ((stars == 1) && lead)
+        kind = wm_Suffix;
+    else if ((stars == 2) && lead && trail)
+        kind = wm_Contains;
+    else
+        kind = wm_Glob;
+
+    switch (kind) {
+        case wm_Literal:
+            literal = pattern;
+            break;
+
+        case wm_Prefix:
+            literal = pattern.left(len-1);
+            break;
+
+        case wm_Suffix:
+            literal = pattern.mid(1);
+            break;
+
+        case wm_Contains:
+            literal = pattern.mid(1, len-2);
+            break;
+
+        case wm_Glob:
+            if (cs == Qt::CaseInsensitive)
+                folded = pattern.toCaseFolded();
+            break;
+
+        default:
+            break;
+    }
+}
+
+/*!
+ * \param text Text to match
+ * \return true if the entire text matches the pattern.
+ */
+bool WildcardMatcher::match(const QString &text) const
+{
+    switch (kind) {
+        case wm_Any:
+            return true;
+
+        case wm_Literal:
+            return text.compare(literal, cs) == 0;
+
+        case wm_Prefix:
+            return text.startsWith(literal, cs);
+
+        case wm_Suffix:
+            return text.endsWith(literal, cs);
+
+        case wm_Contains:
+            return text.contains(literal, cs);
+
+        default:
+            return globMatch(text);
+    }
+}
+
+/*!
+ * \param text Text to match
+ *
+ * Iterative glob matching. On a mismatch, we go back to the last star and let it eat one more character.
+ * \return true if the entire text matches the pattern.
+ */
+bool WildcardMatcher::globMatch(const QString &text) const
+{
+    bool nocase = (cs == Qt::CaseInsensitive);
+    const QString &pat = nocase ? folded : pattern;
+    int pl = pat.length();
+    int tl = text.length();
+    int pi = 0;
+    int ti = 0;
+    int star = -1; // Position of last star in pattern
+    int mark = 0; // Position in text where the last star started matching
+
+    while (ti < tl) {
+        if ((pi < pl) && (pat[pi] == '*')) {
+            star = pi++;
+            mark = ti;
+            continue;
+        }
+
+        if (pi < pl) {
+            QChar t = nocase ? text[ti].toCaseFolded() : text[ti];
+            if ((pat[pi] == '?') || (pat[pi] == t)) {
+                ++pi;
+                ++ti;
+                continue;
+            }
+        }
+
+        if (star == -1)
+            return false;
+
+        pi = star+1;
+        ti = ++mark;
+    }
+
+    while ((pi < pl) && (pat[pi] == '*'))
+        ++pi;
+
+    return pi == pl;
+}
+
+/*!
+ * \param pattern Wildcard pattern
+ * \param cs Case sensitivity
+ *
+ * Returns a compiled matcher for the pattern, compiling it only the first time it's seen.\n
+ * The cache is emptied when it reaches WM_CACHE_SIZE patterns.
+ * \return Compiled matcher
+ */
+WildcardMatcher WildcardMatcher::cached(const QString &pattern, Qt::CaseSensitivity cs)
+{
+    static QHash<QString,WildcardMatcher> cache;
+
+    QString key = pattern;
+    key.prepend( cs == Qt::CaseSensitive ? 's' : 'i' );
+
+    QHash<QString,WildcardMatcher>::const_iterator i = cache.constFind(key);
+    if (i != cache.constEnd())
+        return i.value();
+
+    if (cache.count() >= WM_CACHE_SIZE)
+        cache.clear();
+
+    WildcardMatcher wm(pattern, cs);
+    cache.insert(key, wm);
+    return wm;
+}
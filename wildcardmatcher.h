@@ -0,0 +1,70 @@
+/*
+ *   IdealIRC - Internet Relay Chat client
+ *   Copyright (C) 2014  Tom-Andre Barstad
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+/*! \class WildcardMatcher
+ *  \brief Matches text against a wildcard pattern using * and ?
+ *
+ * The pattern is compiled once. Common shapes such as "text", "text*", "*text" and "*text*"
+ * are matched with a plain string compare, the rest goes through a small glob matcher.\n
+ * Use WildcardMatcher::cached() for patterns that are evaluated over and over, e.g. from scripts,
+ * so the pattern isn't compiled again on every call.\n
+ * Unlike QRegExp::WildcardUnix, character sets [...] are not supported. IRC masks don't use them.
+ */
+
+#ifndef WILDCARDMATCHER_H
+#define WILDCARDMATCHER_H
+
+#include <QString>
+
+#define WM_CACHE_SIZE 256 //!< Max amount of compiled patterns kept by WildcardMatcher::cached()
+
+class WildcardMatcher
+{
+public:
+    WildcardMatcher();
+    explicit WildcardMatcher(QString pattern, Qt::CaseSensitivity cs = Qt::CaseInsensitive);
+    bool match(const QString &text) const;
+    QString getPattern() const { return pattern; } //!< \return The compiled pattern.
+    QString prefix() const { return pattern.left(prefixLen); } //!< \return Literal text in front of the first wildcard.
+    bool isLiteral() const { return kind == wm_Literal; } //!< \return true if the pattern contains no wildcards.
+
+    static WildcardMatcher cached(const QString &pattern, Qt::CaseSensitivity cs = Qt::CaseInsensitive);
+
+private:
+    enum e_wmkind {
+        wm_Any = 0, // *
+        wm_Literal, // text
+        wm_Prefix,  // text*
+        wm_Suffix,  // *text
+        wm_Contains, // *text*
+        wm_Glob     // anything else
+    };
+
+    void compile();
+    bool globMatch(const QString &text) const;
+
+    QString pattern; //!< The pattern, consecutive stars collapsed.
+    QString literal; //!< Text to compare with for all kinds but wm_Glob.
+    QString folded; //!< Case folded pattern, used by wm_Glob when case insensitive.
+    Qt::CaseSensitivity cs; //!< Case sensitivity.
+    e_wmkind kind; //!< Shape of the pattern, decides how match() works.
+    int prefixLen; //!< Length of the literal text in front of the first wildcard.
+};
+
+#endif // WILDCARDMATCHER_H